@@ -311,8 +311,7 @@ union lc_str {
 #endif 
 };
 
-/***** EPAX_EDIT  cutting file off here *******************/
-#if 0
+typedef int32_t vm_prot_t; /* EPAX_EDIT */
 
 /*
  * The segment load command indicates that a part of this file is to be
@@ -1458,6 +1457,5 @@ struct tlv_descriptor
 	unsigned long	offset;
 };
 
-#endif /* EPAX_EDIT cut file off */
 
 #endif /* _MACHO_LOADER_H_ */
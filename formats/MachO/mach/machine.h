@@ -109,6 +109,7 @@ typedef int32_t	cpu_threadtype_t;/* EPAX_EDIT */
 #define CPU_TYPE_MC98000	((cpu_type_t) 10)
 #define CPU_TYPE_HPPA           ((cpu_type_t) 11)
 #define CPU_TYPE_ARM		((cpu_type_t) 12)
+#define CPU_TYPE_ARM64		(CPU_TYPE_ARM | CPU_ARCH_ABI64) /* EPAX_EDIT */
 #define CPU_TYPE_MC88000	((cpu_type_t) 13)
 #define CPU_TYPE_SPARC		((cpu_type_t) 14)
 #define CPU_TYPE_I860		((cpu_type_t) 15)
@@ -312,6 +313,13 @@ typedef int32_t	cpu_threadtype_t;/* EPAX_EDIT */
 #define CPU_SUBTYPE_ARM_V7F		((cpu_subtype_t) 10) /* Cortex A9 */
 #define CPU_SUBTYPE_ARM_V7K		((cpu_subtype_t) 12) /* Kirkwood40 */
 
+/*
+ *	ARM64 subtypes
+ */
+#define CPU_SUBTYPE_ARM64_ALL		((cpu_subtype_t) 0) /* EPAX_EDIT */
+#define CPU_SUBTYPE_ARM64_V8		((cpu_subtype_t) 1) /* EPAX_EDIT */
+#define CPU_SUBTYPE_ARM64E		((cpu_subtype_t) 2) /* EPAX_EDIT */
+
 #endif /* !__ASSEMBLER__ */
 
 /*
@@ -0,0 +1,222 @@
+/**
+ * @file pe.h
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * The on-disk structures of PE/COFF images, written from the Microsoft PE/COFF
+ * specification. Names follow <winnt.h>. Everything is little-endian.
+ */
+
+#ifndef _EPAX_PE_H_
+#define _EPAX_PE_H_
+
+#include <stdint.h>
+
+#define IMAGE_DOS_SIGNATURE                 0x5a4d      /* MZ */
+#define IMAGE_NT_SIGNATURE                  0x00004550  /* PE\0\0 */
+
+typedef struct {
+    uint16_t e_magic;
+    uint16_t e_cblp;
+    uint16_t e_cp;
+    uint16_t e_crlc;
+    uint16_t e_cparhdr;
+    uint16_t e_minalloc;
+    uint16_t e_maxalloc;
+    uint16_t e_ss;
+    uint16_t e_sp;
+    uint16_t e_csum;
+    uint16_t e_ip;
+    uint16_t e_cs;
+    uint16_t e_lfarlc;
+    uint16_t e_ovno;
+    uint16_t e_res[4];
+    uint16_t e_oemid;
+    uint16_t e_oeminfo;
+    uint16_t e_res2[10];
+    uint32_t e_lfanew;      /* file offset of the NT signature */
+} IMAGE_DOS_HEADER;
+
+#define IMAGE_FILE_MACHINE_I386             0x014c
+#define IMAGE_FILE_MACHINE_ARM              0x01c0
+#define IMAGE_FILE_MACHINE_THUMB            0x01c2
+#define IMAGE_FILE_MACHINE_ARMNT            0x01c4
+#define IMAGE_FILE_MACHINE_AMD64            0x8664
+#define IMAGE_FILE_MACHINE_ARM64            0xaa64
+
+#define IMAGE_FILE_EXECUTABLE_IMAGE         0x0002
+#define IMAGE_FILE_DLL                      0x2000
+
+typedef struct {
+    uint16_t Machine;
+    uint16_t NumberOfSections;
+    uint32_t TimeDateStamp;
+    uint32_t PointerToSymbolTable;
+    uint32_t NumberOfSymbols;
+    uint16_t SizeOfOptionalHeader;
+    uint16_t Characteristics;
+} IMAGE_FILE_HEADER;
+
+typedef struct {
+    uint32_t VirtualAddress;
+    uint32_t Size;
+} IMAGE_DATA_DIRECTORY;
+
+#define IMAGE_NUMBEROF_DIRECTORY_ENTRIES    16
+
+#define IMAGE_DIRECTORY_ENTRY_EXPORT        0
+#define IMAGE_DIRECTORY_ENTRY_IMPORT        1
+#define IMAGE_DIRECTORY_ENTRY_RESOURCE      2
+#define IMAGE_DIRECTORY_ENTRY_EXCEPTION     3
+#define IMAGE_DIRECTORY_ENTRY_SECURITY      4
+#define IMAGE_DIRECTORY_ENTRY_BASERELOC     5
+#define IMAGE_DIRECTORY_ENTRY_DEBUG         6
+
+#define IMAGE_NT_OPTIONAL_HDR32_MAGIC       0x010b
+#define IMAGE_NT_OPTIONAL_HDR64_MAGIC       0x020b
+
+typedef struct {
+    uint16_t Magic;
+    uint8_t  MajorLinkerVersion;
+    uint8_t  MinorLinkerVersion;
+    uint32_t SizeOfCode;
+    uint32_t SizeOfInitializedData;
+    uint32_t SizeOfUninitializedData;
+    uint32_t AddressOfEntryPoint;
+    uint32_t BaseOfCode;
+    uint32_t BaseOfData;
+    uint32_t ImageBase;
+    uint32_t SectionAlignment;
+    uint32_t FileAlignment;
+    uint16_t MajorOperatingSystemVersion;
+    uint16_t MinorOperatingSystemVersion;
+    uint16_t MajorImageVersion;
+    uint16_t MinorImageVersion;
+    uint16_t MajorSubsystemVersion;
+    uint16_t MinorSubsystemVersion;
+    uint32_t Win32VersionValue;
+    uint32_t SizeOfImage;
+    uint32_t SizeOfHeaders;
+    uint32_t CheckSum;
+    uint16_t Subsystem;
+    uint16_t DllCharacteristics;
+    uint32_t SizeOfStackReserve;
+    uint32_t SizeOfStackCommit;
+    uint32_t SizeOfHeapReserve;
+    uint32_t SizeOfHeapCommit;
+    uint32_t LoaderFlags;
+    uint32_t NumberOfRvaAndSizes;
+    IMAGE_DATA_DIRECTORY DataDirectory[IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+} IMAGE_OPTIONAL_HEADER32;
+
+typedef struct {
+    uint16_t Magic;
+    uint8_t  MajorLinkerVersion;
+    uint8_t  MinorLinkerVersion;
+    uint32_t SizeOfCode;
+    uint32_t SizeOfInitializedData;
+    uint32_t SizeOfUninitializedData;
+    uint32_t AddressOfEntryPoint;
+    uint32_t BaseOfCode;
+    uint64_t ImageBase;
+    uint32_t SectionAlignment;
+    uint32_t FileAlignment;
+    uint16_t MajorOperatingSystemVersion;
+    uint16_t MinorOperatingSystemVersion;
+    uint16_t MajorImageVersion;
+    uint16_t MinorImageVersion;
+    uint16_t MajorSubsystemVersion;
+    uint16_t MinorSubsystemVersion;
+    uint32_t Win32VersionValue;
+    uint32_t SizeOfImage;
+    uint32_t SizeOfHeaders;
+    uint32_t CheckSum;
+    uint16_t Subsystem;
+    uint16_t DllCharacteristics;
+    uint64_t SizeOfStackReserve;
+    uint64_t SizeOfStackCommit;
+    uint64_t SizeOfHeapReserve;
+    uint64_t SizeOfHeapCommit;
+    uint32_t LoaderFlags;
+    uint32_t NumberOfRvaAndSizes;
+    IMAGE_DATA_DIRECTORY DataDirectory[IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+} IMAGE_OPTIONAL_HEADER64;
+
+#define IMAGE_SIZEOF_SHORT_NAME             8
+
+#define IMAGE_SCN_CNT_CODE                  0x00000020
+#define IMAGE_SCN_CNT_INITIALIZED_DATA      0x00000040
+#define IMAGE_SCN_CNT_UNINITIALIZED_DATA    0x00000080
+#define IMAGE_SCN_MEM_DISCARDABLE           0x02000000
+#define IMAGE_SCN_MEM_EXECUTE               0x20000000
+#define IMAGE_SCN_MEM_READ                  0x40000000
+#define IMAGE_SCN_MEM_WRITE                 0x80000000
+
+typedef struct {
+    uint8_t  Name[IMAGE_SIZEOF_SHORT_NAME];
+    uint32_t VirtualSize;
+    uint32_t VirtualAddress;
+    uint32_t SizeOfRawData;
+    uint32_t PointerToRawData;
+    uint32_t PointerToRelocations;
+    uint32_t PointerToLinenumbers;
+    uint16_t NumberOfRelocations;
+    uint16_t NumberOfLinenumbers;
+    uint32_t Characteristics;
+} IMAGE_SECTION_HEADER;
+
+typedef struct {
+    uint32_t Characteristics;
+    uint32_t TimeDateStamp;
+    uint16_t MajorVersion;
+    uint16_t MinorVersion;
+    uint32_t Name;
+    uint32_t Base;
+    uint32_t NumberOfFunctions;
+    uint32_t NumberOfNames;
+    uint32_t AddressOfFunctions;     /* RVA of uint32_t[NumberOfFunctions] */
+    uint32_t AddressOfNames;         /* RVA of uint32_t[NumberOfNames], name RVAs */
+    uint32_t AddressOfNameOrdinals;  /* RVA of uint16_t[NumberOfNames], indices into AddressOfFunctions */
+} IMAGE_EXPORT_DIRECTORY;
+
+/*
+ * .pdata entries. On ARM and ARM64 the low two bits of UnwindData are a flag: 0
+ * means UnwindData is the RVA of an .xdata record, whose first word holds the
+ * function length in bits 0-17; otherwise the unwind data is packed into the
+ * entry, with the function length in bits 2-12. Lengths count 2-byte units on ARM
+ * and 4-byte units on ARM64. On ARM the low bit of BeginAddress marks Thumb code.
+ */
+typedef struct {
+    uint32_t BeginAddress;
+    uint32_t UnwindData;
+} IMAGE_ARM_RUNTIME_FUNCTION_ENTRY;
+
+typedef IMAGE_ARM_RUNTIME_FUNCTION_ENTRY IMAGE_ARM64_RUNTIME_FUNCTION_ENTRY;
+
+typedef struct {
+    uint32_t BeginAddress;
+    uint32_t EndAddress;
+    uint32_t UnwindInfoAddress;
+} IMAGE_AMD64_RUNTIME_FUNCTION_ENTRY;
+
+#endif /* _EPAX_PE_H_ */
@@ -31,5 +31,37 @@
 #define __EPAX_Interface_core__ "EPAX.hpp"
 
 #include "Interface.hpp"
+#include "EPAXRange.hpp"
+
+namespace EPAX {
+
+    /*
+     * Ranges over the list queries of Interface.hpp, e.g.
+     *   for (FUNC f : BIN_functions(bin)) for (BBL b : FUNC_blocks(f)) ...
+     */
+#define EPAX_LIST_RANGE(__name__, __list__, __otype__, __etype__, __class__) \
+    static inline Range<__class__> __name__(__otype__ obj){             \
+        __etype__ const* list;                                          \
+        uint32_t count = __list__(obj, &list);                          \
+        return Range<__class__>(list, count);                           \
+    }
+
+    EPAX_LIST_RANGE(BIN_functions,     BIN_funcList,   BIN,  FUNC, Function)
+    EPAX_LIST_RANGE(FUNC_blocks,       FUNC_bblList,   FUNC, BBL,  BasicBlock)
+    EPAX_LIST_RANGE(FUNC_instructions, FUNC_insnList,  FUNC, INSN, Instruction)
+    EPAX_LIST_RANGE(FUNC_loops,        FUNC_loopList,  FUNC, LOOP, Loop)
+    EPAX_LIST_RANGE(LOOP_blocks,       LOOP_bblList,   LOOP, BBL,  BasicBlock)
+    EPAX_LIST_RANGE(BBL_instructions,  BBL_insnList,   BBL,  INSN, Instruction)
+    EPAX_LIST_RANGE(BBL_predecessors,  BBL_sourceList, BBL,  BBL,  BasicBlock)
+    EPAX_LIST_RANGE(BBL_successors,    BBL_targetList, BBL,  BBL,  BasicBlock)
+
+#undef EPAX_LIST_RANGE
+
+    typedef Range<Function>    FUNC_range;
+    typedef Range<BasicBlock>  BBL_range;
+    typedef Range<Instruction> INSN_range;
+    typedef Range<Loop>        LOOP_range;
+
+} // namespace EPAX
 
 #endif // __EPAX_EPAX_hpp__
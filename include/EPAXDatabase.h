@@ -0,0 +1,399 @@
+/**
+ * @file EPAXDatabase.h
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Layout of and reader for the analysis database written by BIN_printDatabaseFile.
+ *
+ * The database is a header followed by fixed-width tables of functions, blocks,
+ * instructions and loops, index arrays for control targets, block edges and loop
+ * members, and a string table. Every record refers to other records by table index
+ * and to strings by string table offset, so the file can be mapped and queried in
+ * place without any parsing. All values are in the byte order of the host that
+ * wrote the file. This reader is header-only and does not need libepax.
+ */
+
+#ifndef __EPAX_EPAXDatabase_h__
+#define __EPAX_EPAXDatabase_h__
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define EPAX_DB_MAGIC "EPAXDB\0\0"
+#define EPAX_DB_MAGIC_SIZE 8
+#define EPAX_DB_VERSION 1
+
+/* marks an absent table index (e.g. a block outside any loop) */
+#define EPAX_DB_NONE 0xffffffff
+
+/* tables, in the order they appear in EPAX_db_header.tables */
+typedef enum {
+    EPAX_db_table_func = 0,
+    EPAX_db_table_bbl,
+    EPAX_db_table_insn,
+    EPAX_db_table_loop,
+    EPAX_db_table_target,  /* uint64_t control target addresses of instructions */
+    EPAX_db_table_edge,    /* uint32_t target block indices of blocks */
+    EPAX_db_table_member,  /* uint32_t member block indices of loops */
+    EPAX_db_table_string,  /* NUL-terminated strings; offset 0 is the empty string */
+    EPAX_db_table_total
+} EPAX_db_table_t;
+
+/* EPAX_db_insn.flags */
+#define EPAX_DB_INSN_BRANCH     0x0001
+#define EPAX_DB_INSN_CONDBRANCH 0x0002
+#define EPAX_DB_INSN_CALL       0x0004
+#define EPAX_DB_INSN_RETURN     0x0008
+#define EPAX_DB_INSN_FALLTHRU   0x0010
+#define EPAX_DB_INSN_FPOP       0x0020
+#define EPAX_DB_INSN_LOAD       0x0040
+#define EPAX_DB_INSN_STORE      0x0080
+
+/* EPAX_db_bbl.flags */
+#define EPAX_DB_BBL_REACHABLE   0x0001
+
+typedef struct {
+    uint64_t offset;       /* file offset of the first entry */
+    uint64_t count;        /* number of entries (bytes for the string table) */
+} EPAX_db_extent;
+
+typedef struct {
+    char magic[EPAX_DB_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t headersize;
+    uint64_t appsize;
+    uint32_t appname;      /* string offset */
+    uint32_t sha1sum;      /* string offset */
+    EPAX_db_extent tables[EPAX_db_table_total];
+} EPAX_db_header;
+
+typedef struct {
+    uint64_t addr;
+    uint64_t size;
+    uint32_t name;         /* string offset */
+    uint32_t firstbbl;
+    uint32_t bblcount;
+    uint32_t firstinsn;
+    uint32_t insncount;
+    uint32_t firstloop;
+    uint32_t loopcount;
+    uint32_t reserved;
+} EPAX_db_func;
+
+typedef struct {
+    uint64_t addr;
+    uint32_t func;
+    uint32_t loop;         /* innermost loop containing the block, or EPAX_DB_NONE */
+    uint32_t firstinsn;
+    uint32_t insncount;
+    uint32_t firstedge;
+    uint32_t edgecount;
+    uint32_t flags;
+    uint32_t reserved;
+} EPAX_db_bbl;
+
+typedef struct {
+    uint64_t addr;
+    uint64_t calltarget;   /* 0 if not a call */
+    uint32_t bbl;
+    uint32_t func;
+    uint32_t size;
+    uint32_t flags;
+    uint32_t cond;         /* string offset of the predicate name, 0 if unpredicated */
+    uint32_t str;          /* string offset of the disassembly; empty if classified from the decode table */
+    uint32_t groups;       /* string offset of the comma-separated instruction groups */
+    uint32_t firsttarget;
+    uint32_t targetcount;
+    uint32_t file;         /* string offset of the source file */
+    uint32_t line;
+    uint16_t srcregbits;
+    uint16_t srcdatabits;
+} EPAX_db_insn;
+
+typedef struct {
+    uint32_t func;
+    uint32_t index;        /* index of the loop within its function */
+    uint32_t depth;
+    uint32_t head;         /* block index */
+    uint32_t tail;         /* block index */
+    uint32_t parent;       /* loop index, or EPAX_DB_NONE */
+    uint32_t firstmember;
+    uint32_t membercount;
+} EPAX_db_loop;
+
+/* an open database */
+typedef struct {
+    const uint8_t* base;
+    uint64_t size;
+    const EPAX_db_header* header;
+} EPAX_db;
+
+static inline const void* EPAX_db_table(const EPAX_db* db, EPAX_db_table_t t){
+    return db->base + db->header->tables[t].offset;
+}
+
+static inline uint64_t EPAX_db_count(const EPAX_db* db, EPAX_db_table_t t){
+    return db->header->tables[t].count;
+}
+
+/* 1 iff [first, first + count) lies within a table of total entries */
+static inline uint32_t EPAX_db_inTable(uint32_t first, uint32_t count, uint64_t total){
+    return first <= total && count <= total - first;
+}
+
+/* 1 iff idx is EPAX_DB_NONE or lies within a table of total entries */
+static inline uint32_t EPAX_db_inTableOrNone(uint32_t idx, uint64_t total){
+    return idx == EPAX_DB_NONE || idx < total;
+}
+
+/*
+ * Checks every index that one record holds into another table, so that the
+ * accessors never leave a table, and that functions are in address order
+ */
+static inline uint32_t EPAX_db_validateIndices(const uint8_t* base, const EPAX_db_header* h){
+    const EPAX_db_func* funcs = (const EPAX_db_func*)(base + h->tables[EPAX_db_table_func].offset);
+    const EPAX_db_bbl* bbls = (const EPAX_db_bbl*)(base + h->tables[EPAX_db_table_bbl].offset);
+    const EPAX_db_insn* insns = (const EPAX_db_insn*)(base + h->tables[EPAX_db_table_insn].offset);
+    const EPAX_db_loop* loops = (const EPAX_db_loop*)(base + h->tables[EPAX_db_table_loop].offset);
+    const uint32_t* edges = (const uint32_t*)(base + h->tables[EPAX_db_table_edge].offset);
+    const uint32_t* members = (const uint32_t*)(base + h->tables[EPAX_db_table_member].offset);
+    uint64_t nfunc = h->tables[EPAX_db_table_func].count;
+    uint64_t nbbl = h->tables[EPAX_db_table_bbl].count;
+    uint64_t ninsn = h->tables[EPAX_db_table_insn].count;
+    uint64_t nloop = h->tables[EPAX_db_table_loop].count;
+    uint64_t i;
+
+    /* records are indexed with uint32_t */
+    for (i = 0; i < EPAX_db_table_string; i++){
+        if (h->tables[i].count > EPAX_DB_NONE){
+            return 0;
+        }
+    }
+
+    for (i = 0; i < nfunc; i++){
+        if (!EPAX_db_inTable(funcs[i].firstbbl, funcs[i].bblcount, nbbl) ||
+            !EPAX_db_inTable(funcs[i].firstinsn, funcs[i].insncount, ninsn) ||
+            !EPAX_db_inTable(funcs[i].firstloop, funcs[i].loopcount, nloop) ||
+            (i > 0 && funcs[i].addr < funcs[i - 1].addr)){
+            return 0;
+        }
+    }
+    for (i = 0; i < nbbl; i++){
+        if (bbls[i].func >= nfunc || !EPAX_db_inTableOrNone(bbls[i].loop, nloop) ||
+            !EPAX_db_inTable(bbls[i].firstinsn, bbls[i].insncount, ninsn) ||
+            !EPAX_db_inTable(bbls[i].firstedge, bbls[i].edgecount, h->tables[EPAX_db_table_edge].count)){
+            return 0;
+        }
+    }
+    for (i = 0; i < ninsn; i++){
+        if (insns[i].bbl >= nbbl || insns[i].func >= nfunc ||
+            !EPAX_db_inTable(insns[i].firsttarget, insns[i].targetcount, h->tables[EPAX_db_table_target].count)){
+            return 0;
+        }
+    }
+    for (i = 0; i < nloop; i++){
+        if (loops[i].func >= nfunc || loops[i].head >= nbbl || loops[i].tail >= nbbl ||
+            !EPAX_db_inTableOrNone(loops[i].parent, nloop) ||
+            !EPAX_db_inTable(loops[i].firstmember, loops[i].membercount, h->tables[EPAX_db_table_member].count)){
+            return 0;
+        }
+    }
+    for (i = 0; i < h->tables[EPAX_db_table_edge].count; i++){
+        if (edges[i] >= nbbl){
+            return 0;
+        }
+    }
+    for (i = 0; i < h->tables[EPAX_db_table_member].count; i++){
+        if (members[i] >= nbbl){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static inline uint32_t EPAX_db_validate(const uint8_t* base, uint64_t size){
+    static const uint64_t entsize[EPAX_db_table_total] = {
+        sizeof(EPAX_db_func), sizeof(EPAX_db_bbl), sizeof(EPAX_db_insn), sizeof(EPAX_db_loop),
+        sizeof(uint64_t), sizeof(uint32_t), sizeof(uint32_t), sizeof(char)
+    };
+    const EPAX_db_header* h = (const EPAX_db_header*)base;
+    uint32_t i;
+
+    if (size < sizeof(EPAX_db_header) || memcmp(h->magic, EPAX_DB_MAGIC, EPAX_DB_MAGIC_SIZE) != 0){
+        return 0;
+    }
+    if (h->version != EPAX_DB_VERSION || h->headersize != sizeof(EPAX_db_header)){
+        return 0;
+    }
+    for (i = 0; i < EPAX_db_table_total; i++){
+        if (h->tables[i].offset > size || h->tables[i].count > (size - h->tables[i].offset) / entsize[i]){
+            return 0;
+        }
+    }
+
+    /* the string table must be terminated so that every lookup is bounded */
+    if (h->tables[EPAX_db_table_string].count == 0 || base[h->tables[EPAX_db_table_string].offset + h->tables[EPAX_db_table_string].count - 1] != '\0'){
+        return 0;
+    }
+    return EPAX_db_validateIndices(base, h);
+}
+
+/**
+ * Maps a database file
+ *
+ * @param path the name of a file written by BIN_printDatabaseFile
+ * @param db (out) the opened database
+ * @return 1 on success, 0 if the file cannot be mapped or is not a valid database
+ */
+static inline uint32_t EPAX_db_open(const char* path, EPAX_db* db){
+    struct stat st;
+    void* m;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        return 0;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size == 0){
+        close(fd);
+        return 0;
+    }
+
+    m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED){
+        return 0;
+    }
+
+    if (!EPAX_db_validate((const uint8_t*)m, st.st_size)){
+        munmap(m, st.st_size);
+        return 0;
+    }
+
+    db->base = (const uint8_t*)m;
+    db->size = st.st_size;
+    db->header = (const EPAX_db_header*)m;
+    return 1;
+}
+
+static inline void EPAX_db_close(EPAX_db* db){
+    if (db->base){
+        munmap((void*)db->base, db->size);
+    }
+    db->base = NULL;
+    db->size = 0;
+    db->header = NULL;
+}
+
+static inline const char* EPAX_db_string(const EPAX_db* db, uint32_t off){
+    if (off >= EPAX_db_count(db, EPAX_db_table_string)){
+        return "";
+    }
+    return (const char*)EPAX_db_table(db, EPAX_db_table_string) + off;
+}
+
+static inline const char* EPAX_db_appname(const EPAX_db* db){
+    return EPAX_db_string(db, db->header->appname);
+}
+
+static inline const char* EPAX_db_sha1sum(const EPAX_db* db){
+    return EPAX_db_string(db, db->header->sha1sum);
+}
+
+static inline uint64_t EPAX_db_countFunc(const EPAX_db* db) { return EPAX_db_count(db, EPAX_db_table_func); }
+static inline uint64_t EPAX_db_countBbl(const EPAX_db* db)  { return EPAX_db_count(db, EPAX_db_table_bbl); }
+static inline uint64_t EPAX_db_countInsn(const EPAX_db* db) { return EPAX_db_count(db, EPAX_db_table_insn); }
+static inline uint64_t EPAX_db_countLoop(const EPAX_db* db) { return EPAX_db_count(db, EPAX_db_table_loop); }
+
+static inline const EPAX_db_func* EPAX_db_funcs(const EPAX_db* db) { return (const EPAX_db_func*)EPAX_db_table(db, EPAX_db_table_func); }
+static inline const EPAX_db_bbl* EPAX_db_bbls(const EPAX_db* db)   { return (const EPAX_db_bbl*)EPAX_db_table(db, EPAX_db_table_bbl); }
+static inline const EPAX_db_insn* EPAX_db_insns(const EPAX_db* db) { return (const EPAX_db_insn*)EPAX_db_table(db, EPAX_db_table_insn); }
+static inline const EPAX_db_loop* EPAX_db_loops(const EPAX_db* db) { return (const EPAX_db_loop*)EPAX_db_table(db, EPAX_db_table_loop); }
+
+static inline const uint64_t* EPAX_db_targets(const EPAX_db* db) { return (const uint64_t*)EPAX_db_table(db, EPAX_db_table_target); }
+static inline const uint32_t* EPAX_db_edges(const EPAX_db* db)   { return (const uint32_t*)EPAX_db_table(db, EPAX_db_table_edge); }
+static inline const uint32_t* EPAX_db_members(const EPAX_db* db) { return (const uint32_t*)EPAX_db_table(db, EPAX_db_table_member); }
+
+/**
+ * Finds the instruction at an address. Functions are stored in address order,
+ * blocks in address order within each function and instructions in address order
+ * within each block, so both steps are binary searches. Where functions overlap,
+ * the one that starts closest below addr is searched.
+ *
+ * @param db an open database
+ * @param addr a virtual address
+ * @return the index of the instruction at addr, or EPAX_DB_NONE
+ */
+static inline uint32_t EPAX_db_findInsn(const EPAX_db* db, uint64_t addr){
+    const EPAX_db_func* funcs = EPAX_db_funcs(db);
+    const EPAX_db_insn* insns = EPAX_db_insns(db);
+    uint32_t lo = 0;
+    uint32_t hi = (uint32_t)EPAX_db_countFunc(db);
+    uint32_t f, end;
+
+    /* the first function that starts after addr */
+    while (lo < hi){
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (funcs[mid].addr <= addr){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0){
+        return EPAX_DB_NONE;
+    }
+    f = lo - 1;
+    if (addr >= funcs[f].addr + funcs[f].size || funcs[f].insncount == 0){
+        return EPAX_DB_NONE;
+    }
+
+    lo = funcs[f].firstinsn;
+    end = funcs[f].firstinsn + funcs[f].insncount;
+    hi = end;
+    while (lo < hi){
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (insns[mid].addr < addr){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < end && insns[lo].addr == addr){
+        return lo;
+    }
+    return EPAX_DB_NONE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EPAX_EPAXDatabase_h__ */
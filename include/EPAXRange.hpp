@@ -0,0 +1,75 @@
+/**
+ * @file EPAXRange.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_EPAXRange_hpp__
+#define __EPAX_EPAXRange_hpp__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace EPAX {
+
+    /**
+     * A view of a contiguous list of objects owned by some container (the functions
+     * of a binary, the instructions of a block, ...). Iterators are plain pointers
+     * into that list, so they are random access and a step costs nothing beyond the
+     * increment. This makes ranges usable with range-based for loops and with the
+     * parallel algorithms, e.g. std::for_each(std::execution::par, r.begin(), r.end(), f).
+     *
+     * A range is invalidated by anything that changes the underlying list. Once a
+     * binary's functions have been found, none of its lists change, so concurrent
+     * traversal by several threads is safe.
+     *
+     * Ranges are also part of the public C++ interface (see EPAX.hpp), where T is one of
+     * the opaque classes behind the BIN, FUNC, BBL, INSN and LOOP handles.
+     */
+    template <typename T> class Range {
+    private:
+        T* const* first;
+        T* const* last;
+
+    public:
+        typedef T* value_type;
+        typedef T* const* iterator;
+        typedef T* const* const_iterator;
+
+        Range() : first(NULL), last(NULL) {}
+        Range(const std::vector<T*>& v) : first(v.size()? &v[0]: NULL), last(v.size()? &v[0] + v.size(): NULL) {}
+        Range(T* const* list, uint32_t count) : first(list), last(list? list + count: NULL) {}
+
+        iterator begin() const { return first; }
+        iterator end() const { return last; }
+
+        uint32_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+
+        T* operator[](uint32_t idx) const { return first[idx]; }
+        T* front() const { return *first; }
+        T* back() const { return *(last - 1); }
+    }; // class Range
+
+} // namespace EPAX
+
+#endif // __EPAX_EPAXRange_hpp__
@@ -0,0 +1,100 @@
+/**
+ * @file EPAXSamples.h
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Format of the sample files written by libepaxsample.so, a sampler that runs
+ * inside the profiled program:
+ *
+ *     LD_PRELOAD=libepaxsample.so EPAX_SAMPLE_HZ=1000 EPAX_SAMPLE_FILE=app.samples ./app
+ *
+ * Each thread has its own timer on the CPU time it consumes, which delivers SIGPROF
+ * to that thread. The signal handler stores the interrupted program counter into a
+ * ring buffer owned by the thread, and a background thread drains the rings to the
+ * file. A program that installs its own SIGPROF handler cannot be sampled this way.
+ * Timers on CPU time are served at the kernel's tick, so rates above its CONFIG_HZ
+ * give fewer samples than asked for.
+ * Programs that the sampled one execs are sampled too; each writes to its own file,
+ * named by appending ".<pid>" to EPAX_SAMPLE_FILE.
+ * `epax samples <file>` maps the samples to functions, blocks and loops.
+ *
+ * The file holds an EPAX_samples_header, then records, each an EPAX_samples_record
+ * followed by `size` bytes. All values are in the byte order of the sampled host.
+ */
+
+#ifndef __EPAX_EPAXSamples_h__
+#define __EPAX_EPAXSamples_h__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define EPAX_SAMPLES_MAGIC 0x53585045 /* "EPXS" */
+#define EPAX_SAMPLES_VERSION 1
+
+/* used when EPAX_SAMPLE_HZ is not set */
+#define EPAX_SAMPLES_DEFAULT_HZ 997
+
+/*
+ * Record types, with their contents:
+ *
+ * EPAX_SAMPLES_PCS    uint64_t pcs[size / 8], sampled from thread `tid`
+ * EPAX_SAMPLES_MAPS   the text of /proc/self/maps. Written shortly after start and
+ *                     at exit; a later record supersedes mappings at the same address
+ * EPAX_SAMPLES_STATS  EPAX_samples_stats, written at exit
+ */
+typedef enum {
+    EPAX_SAMPLES_PCS = 1,
+    EPAX_SAMPLES_MAPS,
+    EPAX_SAMPLES_STATS,
+    EPAX_SAMPLES_total
+} EPAX_samples_type_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t pid;
+    uint32_t hz;
+} EPAX_samples_header;
+
+typedef struct {
+    uint32_t type;
+    uint32_t tid;          /* 0 unless type is EPAX_SAMPLES_PCS */
+    uint64_t size;         /* bytes that follow */
+} EPAX_samples_record;
+
+typedef struct {
+    uint64_t samples;      /* samples written */
+    uint64_t dropped;      /* samples lost because a thread's ring was full */
+    uint64_t threads;      /* threads sampled */
+    uint64_t reserved;
+} EPAX_samples_stats;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EPAX_EPAXSamples_h__ */
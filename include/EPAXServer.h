@@ -0,0 +1,284 @@
+/**
+ * @file EPAXServer.h
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Protocol of the analysis server started by `epax -s <socket>`, and a small
+ * header-only client.
+ *
+ * A client connects to the server's Unix-domain stream socket and sends requests,
+ * each an EPAX_srv_request followed by `size` bytes of payload. The server answers
+ * every request, in order, with an EPAX_srv_response followed by `size` bytes of
+ * payload. Requests may be pipelined: a client can write any number of them before
+ * reading the responses, and the tag of each request is echoed in its response.
+ * All values are in the byte order of the host running the server.
+ *
+ * Binaries are named by handles returned from EPAX_SRV_LOAD. ELF, Mach-O (the ARM
+ * slice of a universal file) and PE binaries are served; archives are not. A new
+ * binary is first analyzed by a separate `epax -k` process, and is refused with
+ * EPAX_SRV_ELOAD if that fails. A handle stays valid for the life of the server; a
+ * binary evicted from the server's memory budget is restored from the server's
+ * analysis cache the next time a request names it.
+ */
+
+#ifndef __EPAX_EPAXServer_h__
+#define __EPAX_EPAXServer_h__
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define EPAX_SRV_MAGIC 0x51585045 /* "EPXQ" */
+
+/* the largest payload the server accepts */
+#define EPAX_SRV_MAX_PAYLOAD (64 * 1024 * 1024)
+
+/* marks an absent index (e.g. an address outside any loop) */
+#define EPAX_SRV_NONE 0xffffffff
+
+/*
+ * Request types, with their payloads:
+ *
+ * EPAX_SRV_LOAD     the path of a binary (not NUL-terminated)
+ *                   -> EPAX_srv_binary
+ * EPAX_SRV_RESOLVE  uint32_t handle, uint32_t count, uint64_t addrs[count]
+ *                   -> EPAX_srv_table, EPAX_srv_loc[count], strings
+ * EPAX_SRV_FUNCS    uint32_t handle
+ *                   -> EPAX_srv_table, EPAX_srv_func[count], strings
+ * EPAX_SRV_CFG      uint32_t handle, uint32_t function index
+ *                   -> EPAX_srv_cfg, EPAX_srv_bbl[bblcount], uint32_t edges[edgecount],
+ *                      EPAX_srv_loop[loopcount], uint32_t members[membercount]
+ *
+ * A string is named by its offset into the strings that end the payload, and is
+ * NUL-terminated. Offset 0 is the empty string.
+ */
+typedef enum {
+    EPAX_SRV_LOAD = 1,
+    EPAX_SRV_RESOLVE,
+    EPAX_SRV_FUNCS,
+    EPAX_SRV_CFG,
+    EPAX_SRV_total
+} EPAX_srv_op_t;
+
+/* EPAX_srv_response.status; only EPAX_SRV_OK responses carry a payload */
+typedef enum {
+    EPAX_SRV_OK = 0,
+    EPAX_SRV_EBADREQ,      /* malformed payload */
+    EPAX_SRV_EOP,          /* unknown request type */
+    EPAX_SRV_EHANDLE,      /* unknown handle or function index */
+    EPAX_SRV_ELOAD         /* the binary cannot be read or analyzed, or its format is not supported */
+} EPAX_srv_status_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t op;
+    uint32_t tag;          /* chosen by the client, echoed in the response */
+    uint32_t size;         /* payload bytes that follow */
+} EPAX_srv_request;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t status;
+    uint32_t tag;
+    uint32_t size;
+} EPAX_srv_response;
+
+typedef struct {
+    uint32_t handle;
+    uint32_t format;       /* EPAX::BinaryFormat */
+    uint32_t funccount;
+    uint32_t reserved;
+    uint64_t filesize;
+} EPAX_srv_binary;
+
+/* heads the payload of EPAX_SRV_RESOLVE and EPAX_SRV_FUNCS */
+typedef struct {
+    uint32_t count;
+    uint32_t strsize;      /* bytes of strings after the records */
+} EPAX_srv_table;
+
+typedef struct {
+    uint64_t funcaddr;
+    uint64_t bbladdr;
+    uint32_t func;         /* function index, or EPAX_SRV_NONE if addr is in no function */
+    uint32_t bbl;          /* block index within the function, or EPAX_SRV_NONE */
+    uint32_t loop;         /* loop index within the function, or EPAX_SRV_NONE */
+    uint32_t loopdepth;
+    uint32_t name;         /* string offset of the function name */
+    uint32_t file;         /* string offset of the source file */
+    uint32_t line;         /* 0 if unknown */
+    uint32_t reserved;
+} EPAX_srv_loc;
+
+typedef struct {
+    uint64_t addr;
+    uint64_t size;
+    uint32_t name;         /* string offset */
+    uint32_t bblcount;
+    uint32_t insncount;
+    uint32_t loopcount;
+} EPAX_srv_func;
+
+typedef struct {
+    uint32_t bblcount;
+    uint32_t edgecount;
+    uint32_t loopcount;
+    uint32_t membercount;
+} EPAX_srv_cfg;
+
+typedef struct {
+    uint64_t addr;
+    uint32_t size;
+    uint32_t insncount;
+    uint32_t firstedge;    /* target block indices are edges[firstedge, firstedge + edgecount) */
+    uint32_t edgecount;
+    uint32_t loop;         /* loop index, or EPAX_SRV_NONE */
+    uint32_t reserved;
+} EPAX_srv_bbl;
+
+typedef struct {
+    uint32_t head;         /* block index */
+    uint32_t tail;         /* block index */
+    uint32_t depth;
+    uint32_t reserved;
+    uint32_t firstmember;  /* member block indices are members[firstmember, firstmember + membercount) */
+    uint32_t membercount;
+} EPAX_srv_loop;
+
+/**
+ * Connects to a server
+ *
+ * @param path the server's socket
+ * @return a connected descriptor, or -1 with errno set
+ */
+static inline int EPAX_srv_connect(const char* path){
+    struct sockaddr_un sa;
+    int fd;
+    if (strlen(path) >= sizeof(sa.sun_path)){
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0){
+        return -1;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    strcpy(sa.sun_path, path);
+    if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Reads exactly size bytes
+ *
+ * @return 1 on success, 0 on error or end of file
+ */
+static inline uint32_t EPAX_srv_read(int fd, void* buf, uint64_t size){
+    uint64_t done = 0;
+    while (done < size){
+        ssize_t r = read(fd, (char*)buf + done, size - done);
+        if (r < 0 && errno == EINTR){
+            continue;
+        }
+        if (r <= 0){
+            return 0;
+        }
+        done += r;
+    }
+    return 1;
+}
+
+/**
+ * Writes exactly size bytes
+ *
+ * @return 1 on success, 0 on error
+ */
+static inline uint32_t EPAX_srv_write(int fd, const void* buf, uint64_t size){
+    uint64_t done = 0;
+    while (done < size){
+        ssize_t r = write(fd, (const char*)buf + done, size - done);
+        if (r < 0 && errno == EINTR){
+            continue;
+        }
+        if (r <= 0){
+            return 0;
+        }
+        done += r;
+    }
+    return 1;
+}
+
+/**
+ * Sends one request. Requests can be sent back to back without waiting for responses.
+ *
+ * @param fd a descriptor from EPAX_srv_connect
+ * @param op an EPAX_srv_op_t
+ * @param tag a value echoed in the response
+ * @param payload the request payload
+ * @param size the size of payload
+ * @return 1 on success, 0 on error
+ */
+static inline uint32_t EPAX_srv_send(int fd, uint32_t op, uint32_t tag, const void* payload, uint32_t size){
+    EPAX_srv_request req;
+    req.magic = EPAX_SRV_MAGIC;
+    req.op = op;
+    req.tag = tag;
+    req.size = size;
+    return EPAX_srv_write(fd, &req, sizeof(req)) && EPAX_srv_write(fd, payload, size);
+}
+
+/**
+ * Receives the header of the next response. Its payload must then be read in full
+ * with EPAX_srv_read before the next response.
+ *
+ * @param fd a descriptor from EPAX_srv_connect
+ * @param res (out) the response header
+ * @return 1 on success, 0 on error or if the server closed the connection
+ */
+static inline uint32_t EPAX_srv_recv(int fd, EPAX_srv_response* res){
+    if (!EPAX_srv_read(fd, res, sizeof(EPAX_srv_response))){
+        return 0;
+    }
+    return res->magic == EPAX_SRV_MAGIC;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EPAX_EPAXServer_h__ */
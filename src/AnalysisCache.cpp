@@ -0,0 +1,517 @@
+/**
+ * @file AnalysisCache.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "AnalysisCache.hpp"
+#include "BasicBlock.hpp"
+#include "ControlFlow.hpp"
+#include "DataStruct.hpp"
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "Loop.hpp"
+#include "Symbol.hpp"
+
+#include <stdio.h>
+#include <iterator>
+
+namespace EPAX {
+
+#define CACHE_MAGIC "EPAXCACH"
+#define CACHE_MAGIC_SIZE (8)
+#define CACHE_VERSION (1)
+#define CACHE_SUFFIX ".epaxcache"
+#define CACHE_NO_SYMBOL (0xffffffff)
+
+    typedef enum {
+        CachedInsnFlag_CondBranch   = 0x001,
+        CachedInsnFlag_UncondBranch = 0x002,
+        CachedInsnFlag_Fallthrough  = 0x004,
+        CachedInsnFlag_TouchesPC    = 0x008,
+        CachedInsnFlag_Return       = 0x010,
+        CachedInsnFlag_Call         = 0x020,
+        CachedInsnFlag_Fpop         = 0x040,
+        CachedInsnFlag_Load         = 0x080,
+        CachedInsnFlag_Store        = 0x100
+    } CachedInsnFlag;
+
+    CachedInstruction::CachedInstruction(uint64_t a, uint32_t s, Function* func)
+        : Instruction(a, INVALID_PTR, func),
+          flags(0), condition(PredCondition_INVALID), branchtarget(INVALID_ADDRESS), fallthrough(INVALID_ADDRESS),
+          srcregbits(0), srcdatabits(0)
+    {
+        setMemorySize(s);
+        setBasicBlock(INVALID_PTR);
+    }
+
+    bool CachedInstruction::isConditionalBranch(){
+        return (flags & CachedInsnFlag_CondBranch) != 0;
+    }
+
+    bool CachedInstruction::isUnconditionalBranch(){
+        return (flags & CachedInsnFlag_UncondBranch) != 0;
+    }
+
+    bool CachedInstruction::hasFallthrough(){
+        return (flags & CachedInsnFlag_Fallthrough) != 0;
+    }
+
+    bool CachedInstruction::touchesPC(){
+        return (flags & CachedInsnFlag_TouchesPC) != 0;
+    }
+
+    bool CachedInstruction::isReturn(){
+        return (flags & CachedInsnFlag_Return) != 0;
+    }
+
+    bool CachedInstruction::isCall(){
+        return (flags & CachedInsnFlag_Call) != 0;
+    }
+
+    bool CachedInstruction::isFpop(){
+        return (flags & CachedInsnFlag_Fpop) != 0;
+    }
+
+    bool CachedInstruction::isLoad(){
+        return (flags & CachedInsnFlag_Load) != 0;
+    }
+
+    bool CachedInstruction::isStore(){
+        return (flags & CachedInsnFlag_Store) != 0;
+    }
+
+    uint32_t CachedInstruction::getControlTargets(std::vector<uint64_t>& tgts){
+        tgts.insert(tgts.end(), targets.begin(), targets.end());
+        return targets.size();
+    }
+
+    uint32_t CachedInstruction::getGroupNames(std::vector<std::string>& cls){
+        cls.insert(cls.end(), groups.begin(), groups.end());
+        return groups.size();
+    }
+
+    void CachedInstruction::print(std::ostream& stream){
+        stream << HEX(getMemoryAddress()) << TAB << rep << ENDL;
+    }
+
+    /**
+     * Serializes fixed-width values and strings into a byte buffer
+     */
+    class CacheWriter {
+    public:
+        std::string buf;
+
+        template<typename T> void put(T v) { buf.append((const char*)&v, sizeof(T)); }
+        void putString(const std::string& s) { put<uint32_t>(s.size()); buf.append(s); }
+    }; // class CacheWriter
+
+    /**
+     * Reads values back out of a cache buffer. Any read past the end of the buffer
+     * marks the reader as failed, so a truncated or corrupt entry is simply ignored.
+     */
+    class CacheReader {
+    private:
+        const char* buf;
+        uint64_t size;
+        uint64_t cur;
+        bool ok;
+
+    public:
+        CacheReader(const char* b, uint64_t s) : buf(b), size(s), cur(0), ok(true) {}
+
+        bool good() { return ok; }
+
+        template<typename T> T get(){
+            T v = 0;
+            if (!ok || cur + sizeof(T) > size){
+                ok = false;
+                return v;
+            }
+            memcpy(&v, buf + cur, sizeof(T));
+            cur += sizeof(T);
+            return v;
+        }
+
+        std::string getString(){
+            uint32_t len = get<uint32_t>();
+            if (!ok || cur + len > size){
+                ok = false;
+                return std::string();
+            }
+            std::string s(buf + cur, len);
+            cur += len;
+            return s;
+        }
+
+        bool getMagic(){
+            if (size < CACHE_MAGIC_SIZE || memcmp(buf, CACHE_MAGIC, CACHE_MAGIC_SIZE) != 0){
+                ok = false;
+            }
+            cur += CACHE_MAGIC_SIZE;
+            return ok;
+        }
+    }; // class CacheReader
+
+    AnalysisCache::AnalysisCache(BaseBinary* b, std::string d)
+        : binary(b), dir(d)
+    {
+    }
+
+    void AnalysisCache::makeKey(){
+        if (key.size() > 0){
+            return;
+        }
+
+        std::string id = binary->getBuildID();
+        if (id.size() > 0){
+            key = "buildid-" + id;
+        } else {
+            key = "sha1-" + binary->getContentHash();
+        }
+
+        // a linear sweep finds functions that symbols alone do not
+        if (binary->isLinearSweep()){
+            key.append("-sweep");
+        }
+
+        // the decode table fills in attributes differently than the disassembler
+        if (binary->isFastDecode()){
+            key.append("-fast");
+        }
+
+        path = dir;
+        if (path.size() > 0 && path[path.size() - 1] != '/'){
+            path.append("/");
+        }
+        path.append(key);
+        path.append(CACHE_SUFFIX);
+    }
+
+    bool AnalysisCache::store(std::vector<Function*>& funcs){
+        makeKey();
+        CacheWriter w;
+
+        w.buf.append(CACHE_MAGIC, CACHE_MAGIC_SIZE);
+        w.put<uint32_t>(CACHE_VERSION);
+        w.putString(key);
+        w.put<uint64_t>(binary->getFileSize());
+
+        // locate each function's symbol by (table, index) so it can be relinked on load
+        std::map<Symbol*, std::pair<uint32_t, uint32_t> > symloc;
+        for (std::vector<Function*>::const_iterator it = funcs.begin(); it != funcs.end(); it++){
+            if (IS_VALID_PTR((*it)->getSymbol())){
+                for (uint32_t t = 0; t < binary->countSymbolTables(); t++){
+                    SymbolTable* symt = binary->getSymbolTable(t);
+                    for (uint32_t i = 0; i < symt->countSymbols(); i++){
+                        symloc[symt->getSymbol(i)] = std::pair<uint32_t, uint32_t>(t, i);
+                    }
+                }
+                break;
+            }
+        }
+
+        w.put<uint32_t>(funcs.size());
+        for (std::vector<Function*>::const_iterator it = funcs.begin(); it != funcs.end(); it++){
+            Function* f = (*it);
+
+            Symbol* sym = f->getSymbol();
+            if (IS_VALID_PTR(sym) && symloc.count(sym) > 0){
+                w.put<uint32_t>(symloc[sym].first);
+                w.put<uint32_t>(symloc[sym].second);
+            } else {
+                w.put<uint32_t>(CACHE_NO_SYMBOL);
+                w.put<uint32_t>(CACHE_NO_SYMBOL);
+            }
+
+            w.put<uint64_t>(f->getFileOffset());
+            w.put<uint64_t>(f->getFileSize());
+            w.put<uint64_t>(f->getMemoryAddress());
+            w.put<uint64_t>(f->getMemorySize());
+            w.put<uint8_t>(f->isV8());
+
+            ControlFlow* cfg = f->getControlFlow();
+            uint32_t nbbs = (IS_VALID_PTR(cfg)? cfg->countBasicBlocks(): 0);
+            w.put<uint8_t>(IS_VALID_PTR(cfg));
+            w.put<uint32_t>(nbbs);
+
+            for (uint32_t b = 0; b < nbbs; b++){
+                BasicBlock* bb = cfg->getBasicBlock(b);
+                w.put<uint64_t>(bb->getMemoryAddress());
+                w.put<uint8_t>(bb->isReachable());
+
+                w.put<uint32_t>(bb->countInstructions());
+                for (uint32_t i = 0; i < bb->countInstructions(); i++){
+                    Instruction* insn = bb->getInstruction(i);
+
+                    uint32_t flags = 0;
+                    if (insn->isConditionalBranch())   flags |= CachedInsnFlag_CondBranch;
+                    if (insn->isUnconditionalBranch()) flags |= CachedInsnFlag_UncondBranch;
+                    if (insn->hasFallthrough())        flags |= CachedInsnFlag_Fallthrough;
+                    if (insn->touchesPC())             flags |= CachedInsnFlag_TouchesPC;
+                    if (insn->isReturn())              flags |= CachedInsnFlag_Return;
+                    if (insn->isCall())                flags |= CachedInsnFlag_Call;
+                    if (insn->isFpop())                flags |= CachedInsnFlag_Fpop;
+                    if (insn->isLoad())                flags |= CachedInsnFlag_Load;
+                    if (insn->isStore())               flags |= CachedInsnFlag_Store;
+
+                    w.put<uint64_t>(insn->getMemoryAddress());
+                    w.put<uint32_t>(insn->getMemorySize());
+                    w.put<uint32_t>(flags);
+                    w.put<uint32_t>(insn->getCondition());
+                    w.put<uint64_t>(insn->getBranchTarget());
+                    w.put<uint64_t>(insn->fallthroughTarget());
+                    w.put<uint32_t>(insn->getSourceRegisterSizeInBits());
+                    w.put<uint32_t>(insn->getSourceDatatypeSizeInBits());
+
+                    std::vector<uint64_t> tgts;
+                    insn->getControlTargets(tgts);
+                    w.put<uint32_t>(tgts.size());
+                    for (std::vector<uint64_t>::const_iterator tit = tgts.begin(); tit != tgts.end(); tit++){
+                        w.put<uint64_t>(*tit);
+                    }
+
+                    w.putString(insn->stringRep());
+
+                    std::vector<std::string> groups;
+                    insn->getGroupNames(groups);
+                    w.put<uint32_t>(groups.size());
+                    for (std::vector<std::string>::const_iterator git = groups.begin(); git != groups.end(); git++){
+                        w.putString(*git);
+                    }
+                }
+
+                w.put<uint32_t>(bb->countTargets());
+                for (uint32_t t = 0; t < bb->countTargets(); t++){
+                    w.put<uint32_t>(bb->getTarget(t)->getIndex());
+                }
+            }
+
+            uint32_t nloops = (IS_VALID_PTR(cfg)? cfg->countLoops(): 0);
+            w.put<uint32_t>(nloops);
+            for (uint32_t l = 0; l < nloops; l++){
+                Loop* lp = cfg->getLoop(l);
+                w.put<uint32_t>(lp->head()->getIndex());
+                w.put<uint32_t>(lp->tail()->getIndex());
+                w.put<uint32_t>(lp->getDepth());
+                w.put<uint32_t>(lp->countBasicBlocks());
+                for (uint32_t b = 0; b < nbbs; b++){
+                    if (lp->hasBasicBlock(b)){
+                        w.put<uint32_t>(b);
+                    }
+                }
+            }
+        }
+
+        char pidstr[32];
+        sprintf(pidstr, ".%d.tmp", (int)getpid());
+        std::string tmp = path + pidstr;
+
+        std::ofstream out(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.is_open()){
+            EPAXWarn << "cannot write analysis cache entry " << tmp << ENDL;
+            return false;
+        }
+        out.write(w.buf.data(), w.buf.size());
+        out.close();
+
+        if (out.fail() || rename(tmp.c_str(), path.c_str()) != 0){
+            EPAXWarn << "cannot write analysis cache entry " << path << ENDL;
+            unlink(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // a loop record, held until the whole function has been read and checked
+    typedef struct {
+        uint32_t head;
+        uint32_t tail;
+        uint32_t depth;
+        dyn_bitset* members;
+    } CachedLoop;
+
+    bool AnalysisCache::load(std::vector<Function*>& funcs){
+        makeKey();
+        std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+        if (!in.is_open()){
+            return false;
+        }
+
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+
+        CacheReader r(contents.data(), contents.size());
+        if (!r.getMagic() || r.get<uint32_t>() != CACHE_VERSION || r.getString() != key || r.get<uint64_t>() != binary->getFileSize()){
+            return false;
+        }
+
+        uint32_t nfuncs = r.get<uint32_t>();
+        for (uint32_t fidx = 0; fidx < nfuncs && r.good(); fidx++){
+            uint32_t symt = r.get<uint32_t>();
+            uint32_t symi = r.get<uint32_t>();
+            uint64_t foff = r.get<uint64_t>();
+            uint64_t fsize = r.get<uint64_t>();
+            uint64_t addr = r.get<uint64_t>();
+            uint64_t msize = r.get<uint64_t>();
+            bool isv8 = r.get<uint8_t>();
+
+            Symbol* sym = INVALID_PTR;
+            if (symt != CACHE_NO_SYMBOL){
+                SymbolTable* table = binary->getSymbolTable(symt);
+                if (!IS_VALID_PTR(table) || symi >= table->countSymbols()){
+                    return false;
+                }
+                sym = table->getSymbol(symi);
+            }
+
+            Function* f = new Function(binary, foff, fsize, addr, fidx, sym, isv8);
+            f->setMemorySize(msize);
+            funcs.push_back(f);
+
+            bool hascfg = r.get<uint8_t>();
+            uint32_t nbbs = r.get<uint32_t>();
+
+            std::vector<BasicBlock*> bbs;
+            std::vector<std::vector<uint32_t> > edges;
+            for (uint32_t b = 0; b < nbbs && r.good(); b++){
+                BasicBlock* bb = new BasicBlock(f, r.get<uint64_t>(), b);
+                bbs.push_back(bb);
+                if (!r.get<uint8_t>()){
+                    bb->setUnreachable();
+                }
+
+                uint32_t ninsns = r.get<uint32_t>();
+                for (uint32_t i = 0; i < ninsns && r.good(); i++){
+                    uint64_t iaddr = r.get<uint64_t>();
+                    uint32_t isize = r.get<uint32_t>();
+
+                    CachedInstruction* insn = new CachedInstruction(iaddr, isize, f);
+                    insn->flags = r.get<uint32_t>();
+                    insn->condition = (PredCondition)r.get<uint32_t>();
+                    insn->branchtarget = r.get<uint64_t>();
+                    insn->fallthrough = r.get<uint64_t>();
+                    insn->srcregbits = r.get<uint32_t>();
+                    insn->srcdatabits = r.get<uint32_t>();
+
+                    uint32_t ntgts = r.get<uint32_t>();
+                    for (uint32_t t = 0; t < ntgts && r.good(); t++){
+                        insn->targets.push_back(r.get<uint64_t>());
+                    }
+
+                    insn->rep = r.getString();
+
+                    uint32_t ngroups = r.get<uint32_t>();
+                    for (uint32_t g = 0; g < ngroups && r.good(); g++){
+                        insn->groups.push_back(r.getString());
+                    }
+
+                    if (insn->condition >= PredCondition_total){
+                        insn->condition = PredCondition_INVALID;
+                    }
+
+                    bb->addInstruction(insn);
+                    insn->setBasicBlock(bb);
+                }
+
+                edges.push_back(std::vector<uint32_t>());
+                uint32_t ntgts = r.get<uint32_t>();
+                for (uint32_t t = 0; t < ntgts && r.good(); t++){
+                    edges.back().push_back(r.get<uint32_t>());
+                }
+            }
+
+            // loops are written even without a CFG (as a count of 0), so they are read
+            // and checked before anything is built from this function's records
+            bool valid = r.good();
+            for (uint32_t b = 0; b < edges.size() && valid; b++){
+                for (std::vector<uint32_t>::const_iterator it = edges[b].begin(); it != edges[b].end(); it++){
+                    if ((*it) >= bbs.size()){
+                        valid = false;
+                    }
+                }
+            }
+
+            std::vector<CachedLoop> loops;
+            uint32_t nloops = r.get<uint32_t>();
+            for (uint32_t l = 0; l < nloops && r.good() && valid; l++){
+                CachedLoop lp;
+                lp.head = r.get<uint32_t>();
+                lp.tail = r.get<uint32_t>();
+                lp.depth = r.get<uint32_t>();
+                lp.members = new dyn_bitset(nbbs);
+                lp.members->clear();
+                loops.push_back(lp);
+
+                uint32_t nmembers = r.get<uint32_t>();
+                for (uint32_t m = 0; m < nmembers && r.good() && valid; m++){
+                    uint32_t b = r.get<uint32_t>();
+                    if (b >= nbbs){
+                        valid = false;
+                    } else {
+                        lp.members->set(b);
+                    }
+                }
+                if (lp.head >= nbbs || lp.tail >= nbbs || !lp.members->has(lp.head) || !lp.members->has(lp.tail)){
+                    valid = false;
+                }
+            }
+
+            if (!r.good() || !valid || (!hascfg && (bbs.size() || loops.size()))){
+                for (std::vector<BasicBlock*>::const_iterator it = bbs.begin(); it != bbs.end(); it++){
+                    delete (*it);
+                }
+                for (std::vector<CachedLoop>::const_iterator it = loops.begin(); it != loops.end(); it++){
+                    delete (*it).members;
+                }
+                return false;
+            }
+
+            if (!hascfg){
+                continue;
+            }
+
+            ControlFlow* cfg = new ControlFlow(f, bbs, false);
+            f->setControlFlow(cfg);
+
+            for (uint32_t b = 0; b < bbs.size(); b++){
+                for (std::vector<uint32_t>::const_iterator it = edges[b].begin(); it != edges[b].end(); it++){
+                    bbs[b]->addTarget(bbs[*it]);
+                    bbs[*it]->addSource(bbs[b]);
+                }
+            }
+
+            for (uint32_t l = 0; l < loops.size(); l++){
+                cfg->addLoop(new Loop(cfg, loops[l].head, loops[l].tail, loops[l].depth, loops[l].members, l));
+            }
+        }
+
+        if (!r.good()){
+            return false;
+        }
+
+        EPAXOut << "Restored " << DEC(funcs.size()) << " functions from analysis cache " << path << ENDL;
+        return true;
+    }
+
+} // namespace EPAX
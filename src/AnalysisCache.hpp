@@ -0,0 +1,127 @@
+/**
+ * @file AnalysisCache.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_AnalysisCache_hpp__
+#define __EPAX_AnalysisCache_hpp__
+
+#include "BaseClass.hpp"
+#include "Instruction.hpp"
+
+namespace EPAX {
+
+    class BaseBinary;
+    class Function;
+
+    /**
+     * An instruction restored from the analysis cache. It answers every query from
+     * the attributes recorded when the instruction was originally disassembled.
+     */
+    class CachedInstruction : public Instruction {
+    private:
+        uint32_t flags;
+        PredCondition condition;
+        uint64_t branchtarget;
+        uint64_t fallthrough;
+        std::vector<uint64_t> targets;
+        uint32_t srcregbits;
+        uint32_t srcdatabits;
+        std::string rep;
+        std::vector<std::string> groups;
+
+        friend class AnalysisCache;
+
+    public:
+        CachedInstruction(uint64_t a, uint32_t s, Function* func);
+        virtual ~CachedInstruction() {}
+
+        PredCondition getCondition() { return condition; }
+
+        bool isConditionalBranch();
+        bool isUnconditionalBranch();
+        bool hasFallthrough();
+        bool touchesPC();
+        bool isReturn();
+        bool isCall();
+        uint64_t fallthroughTarget() { return fallthrough; }
+        uint64_t getBranchTarget() { return branchtarget; }
+        uint32_t getControlTargets(std::vector<uint64_t>& tgts);
+
+        bool isFpop();
+        bool isLoad();
+        bool isStore();
+
+        uint32_t getSourceRegisterSizeInBits() { return srcregbits; }
+        uint32_t getSourceDatatypeSizeInBits() { return srcdatabits; }
+
+        std::string stringRep() { return rep; }
+        void print(std::ostream& stream = std::cout);
+
+        uint32_t getGroupNames(std::vector<std::string>& cls);
+    }; // class CachedInstruction
+
+    /**
+     * Persistent on-disk store for the functions, blocks, edges, loops and instruction
+     * attributes of one binary. Entries live in a cache directory and are keyed by the
+     * binary's build-id when it has one, or by the SHA-1 of its contents otherwise.
+     * The key also names the decoding modes of the binary, so it is made when the cache
+     * is first used rather than when it is created.
+     */
+    class AnalysisCache {
+    private:
+        BaseBinary* binary;
+        std::string dir;
+        std::string key;
+        std::string path;
+
+        void makeKey();
+
+    public:
+        AnalysisCache(BaseBinary* b, std::string d);
+        virtual ~AnalysisCache() {}
+
+        std::string getKey() { makeKey(); return key; }
+        std::string getPath() { makeKey(); return path; }
+
+        /**
+         * Restores the functions of the binary from the cache
+         *
+         * @param funcs (out) the restored functions
+         * @return true iff a valid cache entry was found and fully restored
+         */
+        bool load(std::vector<Function*>& funcs);
+
+        /**
+         * Writes the functions of the binary to the cache. Entries are written to a
+         * temporary file and renamed into place, so concurrent writers are safe.
+         *
+         * @param funcs the analyzed functions of the binary
+         * @return true iff the entry was written
+         */
+        bool store(std::vector<Function*>& funcs);
+    }; // class AnalysisCache
+
+} // namespace EPAX
+
+#endif // __EPAX_AnalysisCache_hpp__
+
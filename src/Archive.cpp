@@ -0,0 +1,158 @@
+/**
+ * @file Archive.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "Archive.hpp"
+#include "InputFile.hpp"
+
+#define ARMAG "!<arch>\n"
+#define SARMAG 8
+#define ARFMAG "`\n"
+
+namespace EPAX {
+
+    // the header of each member, from <ar.h>; every field is space-padded text
+    typedef struct {
+        char ar_name[16];
+        char ar_date[12];
+        char ar_uid[6];
+        char ar_gid[6];
+        char ar_mode[8];
+        char ar_size[10];
+        char ar_fmag[2];
+    } ar_hdr;
+
+    // a space-padded decimal field; false if it holds anything else
+    static bool parseDecimal(const char* f, uint32_t len, uint64_t& v){
+        v = 0;
+        uint32_t i = 0;
+        for (; i < len && f[i] >= '0' && f[i] <= '9'; i++){
+            v = v * 10 + (f[i] - '0');
+        }
+        if (i == 0){
+            return false;
+        }
+        for (; i < len; i++){
+            if (f[i] != ' '){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static std::string trimName(const char* f, uint32_t len){
+        uint32_t n = len;
+        while (n > 0 && f[n - 1] == ' '){
+            n--;
+        }
+        return std::string(f, n);
+    }
+
+    bool Archive::isArchive(std::string n){
+        InputFile in(n);
+        char magic[SARMAG];
+        if (in.getFileSize() < SARMAG){
+            return false;
+        }
+        in.getBytes(0, SARMAG, (rawbyte_t*)magic);
+        return (memcmp(magic, ARMAG, SARMAG) == 0);
+    }
+
+    Archive::Archive(std::string n)
+        : NameBase(n)
+    {
+        InputFile in(n);
+        char magic[SARMAG];
+        EPAXAssert(in.getFileSize() >= SARMAG, getName() << " is not an archive");
+        in.getBytes(0, SARMAG, (rawbyte_t*)magic);
+        EPAXAssert(memcmp(magic, ARMAG, SARMAG) == 0, getName() << " is not an archive");
+
+        std::string longnames;
+        uint64_t cur = SARMAG;
+        while (cur + sizeof(ar_hdr) <= in.getFileSize()){
+            ar_hdr hdr;
+            in.getBytes(cur, sizeof(ar_hdr), (rawbyte_t*)&hdr);
+
+            uint64_t size;
+            if (memcmp(hdr.ar_fmag, ARFMAG, 2) != 0 || !parseDecimal(hdr.ar_size, sizeof(hdr.ar_size), size)
+                || size > in.getFileSize() - cur - sizeof(ar_hdr)){
+                EPAXWarn << getName() << ": malformed member header at offset " << DEC(cur) << "; ignoring the rest of the archive" << ENDL;
+                break;
+            }
+
+            ArchiveMember m;
+            m.offset = cur + sizeof(ar_hdr);
+            m.size = size;
+
+            std::string name = trimName(hdr.ar_name, sizeof(hdr.ar_name));
+            bool skip = false;
+            uint64_t idx;
+            if (name == "/" || name == "/SYM64/" || name == "__.SYMDEF" || name == "__.SYMDEF SORTED"){
+                // symbol index
+                skip = true;
+            } else if (name == "//"){
+                // System V/GNU table of names longer than 15 characters
+                longnames.resize(size);
+                if (size > 0){
+                    in.getBytes(m.offset, size, (rawbyte_t*)&longnames[0]);
+                }
+                skip = true;
+            } else if (name.size() > 1 && name[0] == '/' && parseDecimal(name.c_str() + 1, name.size() - 1, idx)){
+                // offset into the long name table, where names end with "/\n"
+                if (idx < longnames.size()){
+                    size_t end = longnames.find_first_of("/\n", idx);
+                    name = longnames.substr(idx, (end == std::string::npos? std::string::npos: end - idx));
+                }
+            } else if (name.compare(0, 3, "#1/") == 0 && parseDecimal(name.c_str() + 3, name.size() - 3, idx) && idx <= size){
+                // BSD: the name is the first idx bytes of the member
+                std::string bsd(idx, '\0');
+                if (idx > 0){
+                    in.getBytes(m.offset, idx, (rawbyte_t*)&bsd[0]);
+                }
+                name = bsd.substr(0, bsd.find('\0'));
+                m.offset += idx;
+                m.size -= idx;
+                skip = (name == "__.SYMDEF" || name == "__.SYMDEF SORTED");
+            } else if (name.size() > 0 && name[name.size() - 1] == '/'){
+                // GNU terminates short names with '/'
+                name.erase(name.size() - 1);
+            }
+
+            if (!skip){
+                m.name = name;
+                members.push_back(m);
+            }
+
+            // members start on even offsets
+            cur += sizeof(ar_hdr) + size + (size & 1);
+        }
+    }
+
+    ArchiveMember* Archive::getMember(uint32_t idx){
+        EPAXCheck(idx < members.size(), "Invalid archive member index " << DEC(idx));
+        return &members[idx];
+    }
+
+} // namespace EPAX
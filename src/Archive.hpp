@@ -0,0 +1,67 @@
+/**
+ * @file Archive.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_Archive_hpp__
+#define __EPAX_Archive_hpp__
+
+#include "BaseClass.hpp"
+
+namespace EPAX {
+
+    // a member's contents are the bytes [offset, offset + size) of the archive
+    struct ArchiveMember {
+        std::string name;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    /**
+     * A static library in `ar` format. Only the member headers are read, so listing
+     * the members of an archive costs one small read per member. Each member can then
+     * be analyzed as a binary of its own through a window of the archive (see the
+     * windowed InputFile). The System V/GNU long name table and the BSD `#1/<len>`
+     * names are understood; the archive symbol tables are skipped. Thin archives,
+     * whose members live in separate files, are not supported.
+     */
+    class Archive : public NameBase {
+    private:
+        std::vector<ArchiveMember> members;
+
+    public:
+        Archive(std::string n);
+        virtual ~Archive() {}
+
+        /**
+         * @param n the name of a file
+         * @return whether n begins with the `ar` magic
+         */
+        static bool isArchive(std::string n);
+
+        uint32_t countMembers() { return members.size(); }
+        ArchiveMember* getMember(uint32_t idx);
+    }; // class Archive
+
+} // namespace EPAX
+
+#endif // __EPAX_Archive_hpp__
@@ -24,7 +24,9 @@
 
 #include "EPAXCommonInternal.hpp"
 
+#include "AnalysisCache.hpp"
 #include "BaseClass.hpp"
+#include "Hash.hpp"
 #include "InputFile.hpp"
 #include "Function.hpp"
 #include "Symbol.hpp"
@@ -55,17 +57,47 @@ namespace EPAX {
         return (a >= addr && a < addr + size);
     }
 
+    static void initRecursiveLock(pthread_mutex_t* m){
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(m, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+
     BaseBinary::BaseBinary(std::string n)
         : NameBase(n),
-          inputfile(INVALID_PTR),
+          inputfile(INVALID_PTR), owninput(true),
           foundfunctions(false), functions(INVALID_PTR),
-          foundsymbols(false), symtabs(INVALID_PTR), strtabs(INVALID_PTR)
+          foundsymbols(false), symtabs(INVALID_PTR), strtabs(INVALID_PTR),
+          cache(INVALID_PTR),
+          readyfunctions(false), readysymbols(false),
+          linearsweep(false), fastdecode(false)
     {
+        initRecursiveLock(&lazylock);
         inputfile = new InputFile(getName());
     }
 
+    BaseBinary::BaseBinary(InputFile* f, bool own)
+        : NameBase(f->getName()),
+          inputfile(f), owninput(own),
+          foundfunctions(false), functions(INVALID_PTR),
+          foundsymbols(false), symtabs(INVALID_PTR), strtabs(INVALID_PTR),
+          cache(INVALID_PTR),
+          readyfunctions(false), readysymbols(false),
+          linearsweep(false), fastdecode(false)
+    {
+        initRecursiveLock(&lazylock);
+    }
+
     BaseBinary::~BaseBinary(){
-        if (IS_VALID_PTR(inputfile)){
+        pthread_mutex_destroy(&lazylock);
+
+        if (IS_VALID_PTR(cache)){
+            delete cache;
+        }
+
+        if (IS_VALID_PTR(inputfile) && owninput){
             delete inputfile;
         }
 
@@ -101,15 +133,104 @@ namespace EPAX {
     }
 
     void BaseBinary::lazyFunctions(){
+        if (__atomic_load_n(&readyfunctions, __ATOMIC_ACQUIRE)){
+            return;
+        }
+
+        // a nested call from within findFunctions sees foundfunctions already set and
+        // returns without publishing readyfunctions; only the outermost call does that
+        pthread_mutex_lock(&lazylock);
         if (!foundfunctions){
-            findFunctions();
+            if (!loadCachedFunctions()){
+                findFunctions();
+
+                if (IS_VALID_PTR(cache)){
+                    cache->store(*functions);
+                }
+            }
+
+            for (std::vector<Function*>::const_iterator it = functions->begin(); it != functions->end(); it++){
+                Function* f = (*it);
+                functionindex.add(f->getMemoryAddress(), f->getMemoryAddress() + f->getMemorySize(), f);
+            }
+            functionindex.build();
+
+            __atomic_store_n(&readyfunctions, true, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&lazylock);
+    }
+
+    bool BaseBinary::loadCachedFunctions(){
+        if (!IS_VALID_PTR(cache)){
+            return false;
+        }
+
+        std::vector<Function*>* funcs = new std::vector<Function*>();
+        if (!cache->load(*funcs)){
+            while (funcs->size()){
+                delete funcs->back();
+                funcs->pop_back();
+            }
+            delete funcs;
+            return false;
+        }
+
+        functions = funcs;
+        foundfunctions = true;
+        return true;
+    }
+
+    void BaseBinary::setCache(AnalysisCache* c){
+        EPAXAssert(!foundfunctions, "The analysis cache must be attached before functions are found");
+        if (IS_VALID_PTR(cache)){
+            delete cache;
         }
+        cache = c;
+    }
+
+    void BaseBinary::setLinearSweep(bool s){
+        EPAXAssert(!foundfunctions, "Linear sweep must be selected before functions are found");
+        linearsweep = s;
+    }
+
+    void BaseBinary::setFastDecode(bool f){
+        EPAXAssert(!foundfunctions, "Fast decoding must be selected before functions are found");
+        fastdecode = f;
+    }
+
+    const std::string& BaseBinary::getContentHash(){
+        pthread_mutex_lock(&lazylock);
+        if (contenthash.size() == 0){
+            contenthash = SHA1::hashFile(inputfile);
+        }
+        pthread_mutex_unlock(&lazylock);
+        return contenthash;
+    }
+
+    uint32_t BaseBinary::countSymbolTables(){
+        lazySymbols();
+        return symtabs->size();
+    }
+
+    SymbolTable* BaseBinary::getSymbolTable(uint32_t idx){
+        lazySymbols();
+        if (idx < symtabs->size()){
+            return (*symtabs)[idx];
+        }
+        return INVALID_PTR;
     }
 
     void BaseBinary::lazySymbols(){
+        if (__atomic_load_n(&readysymbols, __ATOMIC_ACQUIRE)){
+            return;
+        }
+
+        pthread_mutex_lock(&lazylock);
         if (!foundsymbols){
             findSymbols();
+            __atomic_store_n(&readysymbols, true, __ATOMIC_RELEASE);
         }
+        pthread_mutex_unlock(&lazylock);
     }
 
     Function* BaseBinary::getFirstFunction(){
@@ -127,18 +248,30 @@ namespace EPAX {
         return functions->size();
     }
 
+    Function* BaseBinary::getFunction(uint32_t idx){
+        lazyFunctions();
+        EPAXCheck(idx < functions->size(), "Invalid function index " << DEC(idx));
+        return (*functions)[idx];
+    }
+
+    const std::vector<Function*>& BaseBinary::getFunctions(){
+        lazyFunctions();
+        return (*functions);
+    }
+
     Function* BaseBinary::getNextFunction(Function* f){
-        EPAXAssert(foundfunctions, "Call getFirstFunction() before calling this");
-        EPAXAssert(f->getBinary()->getID() == getID(), "The Function passed in is not from this binary");
+        EPAXCheck(foundfunctions, "Call getFirstFunction() before calling this");
+        EPAXCheck(f->getBinary()->getID() == getID(), "The Function passed in is not from this binary");
+        EPAXCheck(f->getIndex() + 1 < functions->size(), "No function follows " << DEC(f->getIndex()));
 
-        return functions->at(f->getIndex() + 1);
+        return (*functions)[f->getIndex() + 1];
     }
 
 
     bool BaseBinary::isLastFunction(Function* f){
-        EPAXAssert(foundfunctions, "Call firstfunction() before calling this");
-        EPAXAssert(IS_VALID_PTR(f), "Null pointer found");
-        EPAXAssert(f->getBinary()->getID() == getID(), "The Function passed in is not from this binary");
+        EPAXCheck(foundfunctions, "Call firstfunction() before calling this");
+        EPAXCheck(IS_VALID_PTR(f), "Null pointer found");
+        EPAXCheck(f->getBinary()->getID() == getID(), "The Function passed in is not from this binary");
 
         if (functions->size() == f->getIndex() + 1){
             return true;
@@ -153,14 +286,8 @@ namespace EPAX {
     Function* BaseBinary::findFunctionAt(uint64_t addr){
         lazyFunctions();
 
-        // TODO: binary search... they are sorted
-        for (std::vector<Function*>::const_iterator it = functions->begin(); it != functions->end(); it++){
-            Function* func = (*it);
-            if (IS_VALID_PTR(func) && (func->getMemoryAddress() == addr || func->inRange(addr))){
-                return func;
-            }
-        }
-        return INVALID_PTR;
+        // functions are added in index order, so overlaps resolve to the lowest index
+        return functionindex.find(addr);
     }
 
 } // namespace EPAX
@@ -27,9 +27,11 @@
 #define __EPAX_BaseClass_hpp__
 
 #include "Binary.hpp"
+#include "DataStruct.hpp"
 
 namespace EPAX {
 
+    class AnalysisCache;
     class BaseBinary;
     class Function;
     class InputFile;
@@ -37,6 +39,7 @@ namespace EPAX {
     class StringTable;
     class Symbol;
     class SymbolTable;
+    struct CodeRegion;
 
 
     class FileBase {
@@ -136,6 +139,7 @@ namespace EPAX {
          * The image file
          */
         InputFile* inputfile;
+        bool owninput;
 
         /**
          * Finds and internally stores all functions in the image
@@ -146,6 +150,7 @@ namespace EPAX {
         void lazyFunctions();
         bool foundfunctions;
         std::vector<Function*>* functions;
+        AddressIndex<Function> functionindex;
 
         /**
          * Finds and internally stores all symbols in the image
@@ -158,8 +163,41 @@ namespace EPAX {
         std::vector<SymbolTable*>* symtabs;
         std::vector<StringTable*>* strtabs;
 
+        /**
+         * Persistent store of analysis results, consulted before findFunctions
+         */
+        AnalysisCache* cache;
+        bool loadCachedFunctions();
+
+        std::string contenthash;
+
+        /**
+         * Serializes lazy initialization so that a binary can be queried by several
+         * threads. It is recursive because finding functions also finds symbols.
+         * readyfunctions/readysymbols are set, with release semantics, once the
+         * corresponding lists are complete; readers that see them set take no lock.
+         */
+        pthread_mutex_t lazylock;
+        bool readyfunctions;
+        bool readysymbols;
+
+        // decode executable sections in one linear sweep, where the format supports it
+        bool linearsweep;
+
+        // classify AArch64 instructions from a decode table, leaving full decodes for later
+        bool fastdecode;
+
     public:
         BaseBinary(std::string n);
+
+        /**
+         * Constructs a binary from bytes that need not be a whole file on disk, e.g.
+         * part of a file, a buffer in memory or a region of a live process
+         *
+         * @param f the bytes of the binary; the binary is named after it
+         * @param own whether the binary deletes f when it is destroyed
+         */
+        BaseBinary(InputFile* f, bool own);
         virtual ~BaseBinary();
 
         static const char* getFormatName(BinaryFormat f);
@@ -174,9 +212,14 @@ namespace EPAX {
         virtual bool is64Bit() = 0;
         virtual bool isExecutable() = 0;
 
+        // whether the code of the binary runs on this host, so that it can be traced here
+        virtual bool isHostCode() { return false; }
+
         virtual uint64_t functionEndAddress(Function* f, Function* nextf) = 0;
 
         uint32_t countFunctions();
+        Function* getFunction(uint32_t idx);
+        const std::vector<Function*>& getFunctions();
         Function* getFirstFunction();
         Function* getNextFunction(Function* f);
         bool isLastFunction(Function* f);
@@ -187,6 +230,51 @@ namespace EPAX {
         
         virtual uint64_t getFileSize();
 
+        /**
+         * Gets the SHA-1 digest of the file contents; computed once per binary
+         *
+         * @return the hex SHA-1 digest of the image file
+         */
+        const std::string& getContentHash();
+
+        /**
+         * Gets the build-id recorded in the image by the linker
+         *
+         * @return the hex build-id, or an empty string if the image has none
+         */
+        virtual std::string getBuildID() { return std::string(); }
+
+        void setCache(AnalysisCache* c);
+
+        /**
+         * Selects decoding each executable section once, in a linear sweep, instead of
+         * each function on its own (see LinearSweep). Only ELF supports this; other
+         * formats ignore it. Must be set before functions are found.
+         */
+        void setLinearSweep(bool s);
+        bool isLinearSweep() { return linearsweep; }
+
+        /**
+         * Selects classifying AArch64 instructions from a decode table (see FastInstruction)
+         * instead of fully disassembling them. The text of an instruction is then decoded
+         * only when asked for, a function at a time, and group names come from the table.
+         * Other instruction sets ignore it. Must be set before functions are found.
+         */
+        void setFastDecode(bool f);
+        bool isFastDecode() { return fastdecode; }
+
+        uint32_t countSymbolTables();
+        SymbolTable* getSymbolTable(uint32_t idx);
+
+        /**
+         * Finds the code and data regions overlapping [a, a + s), as marked by the
+         * binary's symbols (e.g. ARM mapping symbols), clipped to [a, a + s) and in
+         * address order. Valid once symbols have been found.
+         *
+         * @return false if nothing in [a, a + s) is marked
+         */
+        virtual bool findCodeRegions(uint64_t a, uint64_t s, std::vector<CodeRegion>& regions) { return false; }
+
         virtual uint32_t getID() { return 0; } // TODO: should be some kind of unique id
         virtual bool insideTextRange(uint64_t a) = 0;
 
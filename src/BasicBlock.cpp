@@ -41,7 +41,7 @@ namespace EPAX {
     }
 
     BasicBlock::~BasicBlock(){
-        for (std::vector<Instruction*>::const_iterator it = instructions.begin(); it != instructions.end(); it++){
+        for (std::vector<Instruction*>::const_iterator it = insns.begin(); it != insns.end(); it++){
             Instruction* insn = (*it);
             delete insn;
         }
@@ -70,25 +70,25 @@ namespace EPAX {
     }
 
     Instruction* BasicBlock::head(){
-        if (instructions.size() == 0){
+        if (insns.size() == 0){
             return INVALID_PTR;
         }
-        return instructions.front();
+        return insns.front();
     }
 
     Instruction* BasicBlock::tail(){
-        if (instructions.size() == 0){
+        if (insns.size() == 0){
             return INVALID_PTR;
         }
-        return instructions.back();
+        return insns.back();
     }
 
     Instruction* BasicBlock::findInstruction(uint64_t addr){
-        if (instructions.size() == 0 || !inRange(addr)){
+        if (insns.size() == 0 || !inRange(addr)){
             return INVALID_PTR;
         }
         // TODO: binary search?
-        for (std::vector<Instruction*>::const_iterator it = instructions.begin(); it != instructions.end(); it++){
+        for (std::vector<Instruction*>::const_iterator it = insns.begin(); it != insns.end(); it++){
             Instruction* insn = (*it);
             if (insn->inRange(addr)){
                 return insn;
@@ -99,8 +99,8 @@ namespace EPAX {
     
     void BasicBlock::print(std::ostream& stream){
         uint64_t addr = 0;
-        if (instructions.size() > 0){
-            addr = instructions.front()->getMemoryAddress();
+        if (insns.size() > 0){
+            addr = insns.front()->getMemoryAddress();
         }
 
         stream << "";
@@ -126,7 +126,7 @@ namespace EPAX {
         }
         stream << " }" << ENDL;
         /*
-        for (std::vector<Instruction*>::const_iterator it = instructions.begin(); it != instructions.end(); it++){
+        for (std::vector<Instruction*>::const_iterator it = insns.begin(); it != insns.end(); it++){
             Instruction* insn = (*it);
             insn->print(stream);
         }
@@ -134,17 +134,17 @@ namespace EPAX {
     }
 
     uint32_t BasicBlock::countInstructions(){
-        return instructions.size();
+        return insns.size();
     }
 
     void BasicBlock::addInstruction(Instruction* i){
-        instructions.push_back(i);
+        insns.push_back(i);
         setMemorySize(getMemorySize() + i->getMemorySize());
     }
 
     Instruction* BasicBlock::getInstruction(uint32_t idx){
-        if (idx < instructions.size()){
-            return instructions[idx];
+        if (idx < insns.size()){
+            return insns[idx];
         }
         return INVALID_PTR;
     }
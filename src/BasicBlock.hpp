@@ -27,6 +27,7 @@
 #define __EPAX_BasicBlock_hpp__
 
 #include "BaseClass.hpp"
+#include "EPAXRange.hpp"
 
 namespace EPAX {
 
@@ -37,7 +38,7 @@ namespace EPAX {
 
     class BasicBlock : public MemoryBase, public IndexBase, public EPAXExport {
     private:
-        std::vector<Instruction*> instructions;
+        std::vector<Instruction*> insns;
 
         std::vector<BasicBlock*> sources;
         std::vector<BasicBlock*> targets;
@@ -66,6 +67,10 @@ namespace EPAX {
         BasicBlock* getSource(uint32_t idx);
         BasicBlock* getTarget(uint32_t idx);
 
+        Range<Instruction> instructions() { return Range<Instruction>(insns); }
+        Range<BasicBlock> predecessors() { return Range<BasicBlock>(sources); }
+        Range<BasicBlock> successors() { return Range<BasicBlock>(targets); }
+
         bool isReachable() { return reachable; }
         void setUnreachable() { reachable = false; }
 
@@ -24,25 +24,55 @@
 
 #include "EPAXCommonInternal.hpp"
 
+#include "AnalysisCache.hpp"
+#include "Archive.hpp"
 #include "Binary.hpp"
 #include "ElfBinary.hpp"
 #include "Function.hpp"
+#include "InputFile.hpp"
 #include "Instruction.hpp"
 #include "LineInformation.hpp"
 #include "MachOBinary.hpp"
+#include "PEBinary.hpp"
+#include "Sampler.hpp"
 
 namespace EPAX {
 
     Binary::Binary(std::string n)
         : EPAXExport(EPAXExportClass_BIN), binary(INVALID_PTR), lineinfo(INVALID_PTR)
     {
-        construct(n, BinaryFormat_undefined);
+        construct(n, BinaryFormat_undefined, std::string(), SLICE_DEFAULT);
     }
 
     Binary::Binary(std::string n, BinaryFormat f)
         : EPAXExport(EPAXExportClass_BIN), binary(INVALID_PTR), lineinfo(INVALID_PTR)
     {
-        construct(n, f);
+        construct(n, f, std::string(), SLICE_DEFAULT);
+    }
+
+    Binary::Binary(std::string n, std::string cachedir)
+        : EPAXExport(EPAXExportClass_BIN), binary(INVALID_PTR), lineinfo(INVALID_PTR)
+    {
+        construct(n, BinaryFormat_undefined, cachedir, SLICE_DEFAULT);
+    }
+
+    Binary::Binary(std::string n, uint32_t cputype, std::string cachedir)
+        : EPAXExport(EPAXExportClass_BIN), binary(INVALID_PTR), lineinfo(INVALID_PTR)
+    {
+        construct(n, BinaryFormat_undefined, cachedir, cputype);
+    }
+
+    Binary::Binary(std::string n, ArchiveMember* member, std::string cachedir)
+        : EPAXExport(EPAXExportClass_BIN), binary(INVALID_PTR), lineinfo(INVALID_PTR)
+    {
+        load(new InputFile(n, member->offset, member->size), BinaryFormat_undefined, cachedir);
+        binary->setName(n + "(" + member->name + ")");
+    }
+
+    Binary::Binary(InputFile* in, std::string cachedir)
+        : EPAXExport(EPAXExportClass_BIN), binary(INVALID_PTR), lineinfo(INVALID_PTR)
+    {
+        load(in, BinaryFormat_undefined, cachedir);
     }
 
     Binary::~Binary(){
@@ -128,8 +158,16 @@ namespace EPAX {
 
     // TODO: write the ARMv8 version of this function (see examples/pcsample.cpp for some useful bits)
 #else // HAVE_ARMV7_NATIVE
+    // runs the program under the sampler and reports where it spent its time; does not return
     void Binary::runBasic(int argc, char* argv[]){
-	EPAXDie("ARMv7 Native support not enabled. You cannot run executables.");
+        std::vector<char*> args(argv, argv + argc);
+        args.push_back(NULL);
+
+        Sampler sampler(this);
+        EPAXAssert(sampler.launch(&args[0]), "cannot start " << argv[0]);
+        int32_t ret = sampler.run();
+        sampler.report(std::cout);
+        exit(ret < 0? 1: ret);
     }
 #endif // HAVE_ARMV7_NATIVE
 
@@ -137,28 +175,43 @@ namespace EPAX {
         return BaseBinary::getFormatName(format);
     }
 
-    void Binary::construct(std::string n, BinaryFormat f){
-        if (f == BinaryFormat_undefined){
-            f = detectFormat(n);
+    void Binary::construct(std::string n, BinaryFormat f, std::string cachedir, uint32_t cputype){
+        MachO::FatArch slice;
+        slice.offset = 0;
+        slice.size = 0;
+        bool fat = MachO::MachOBinary::selectSlice(n, (int32_t)cputype, slice);
+        if (fat){
+            EPAXOut << "Using the slice for cpu type " << HEX(slice.cputype) << " at offset " << HEX(slice.offset) << " of " << n << ENDL;
+        } else {
+            std::vector<MachO::FatArch> archs;
+            EPAXAssert(!MachO::MachOBinary::findFatArchs(n, archs), n << " has no slice for cpu type " << HEX(cputype));
         }
 
-        format = f;
-        EPAXOut << "File " << n << " is a " << getFormatName() << " file" << ENDL;
+        load((fat? new InputFile(n, slice.offset, slice.size): new InputFile(n)), f, cachedir);
+    }
+
+    // takes over in; detects the format of its bytes if f is undefined
+    void Binary::load(InputFile* in, BinaryFormat f, std::string cachedir){
+        format = (f == BinaryFormat_undefined? detectFormat(in): f);
+        EPAXOut << "File " << in->getName() << " is a " << getFormatName() << " file" << ENDL;
 
-        EPAXAssert(format != BinaryFormat_undefined, "Cannot determine format of " << n << ". Try specifying it manually.");
+        EPAXAssert(format != BinaryFormat_undefined, "Cannot determine format of " << in->getName() << ". Try specifying it manually.");
 
         switch (format){
         case BinaryFormat_Elf32:
-            binary = new Elf::ElfBinary32(n);
+            binary = new Elf::ElfBinary32(in, true);
             break;
         case BinaryFormat_Elf64:
-            binary = new Elf::ElfBinary64(n);
+            binary = new Elf::ElfBinary64(in, true);
             break;
         case BinaryFormat_MachO32:
-            binary = new MachO::MachOBinary32(n);
+            binary = new MachO::MachOBinary32(in, true);
             break;
         case BinaryFormat_MachO64:
-            binary = new MachO::MachOBinary64(n);
+            binary = new MachO::MachOBinary64(in, true);
+            break;
+        case BinaryFormat_PE:
+            binary = new PE::PEBinary(in, true);
             break;
         default:
             EPAXDie("Unimplemented binary format " << getFormatName() << " given.");
@@ -166,6 +219,10 @@ namespace EPAX {
 
         EPAXOut << "Program entry point at vaddr " << HEX(binary->getStartAddr()) << ENDL;
 
+        if (cachedir.size() > 0){
+            binary->setCache(new AnalysisCache(binary, cachedir));
+        }
+
         lineinfo = new LineInformation(binary);
 
         binary->describe();
@@ -173,13 +230,24 @@ namespace EPAX {
     }
 
     BinaryFormat Binary::detectFormat(std::string n){
+        MachO::FatArch slice;
+        bool fat = MachO::MachOBinary::selectSlice(n, (int32_t)SLICE_DEFAULT, slice);
+
+        InputFile* in = (fat? new InputFile(n, slice.offset, slice.size): new InputFile(n));
+        BinaryFormat f = detectFormat(in);
+        delete in;
+
+        return f;
+    }
+
+    BinaryFormat Binary::detectFormat(InputFile* in){
         BinaryFormat f = BinaryFormat_undefined;
         BaseBinary* bin;
 
 #define VERIFY_SINGLE_FORMAT(__fmt__) EPAXAssert(f == BinaryFormat_undefined, "This binary appears to be valid for two formats: " << BaseBinary::getFormatName(__fmt__) << " and " << BaseBinary::getFormatName(f));
 
         // check for Elf32
-        bin = new Elf::ElfBinary32(n);
+        bin = new Elf::ElfBinary32(in, false);
         if (bin->verify()){
             VERIFY_SINGLE_FORMAT(BinaryFormat_Elf32);
             f = BinaryFormat_Elf32;
@@ -187,7 +255,7 @@ namespace EPAX {
         delete bin;
 
         // check for Elf64
-        bin = new Elf::ElfBinary64(n);
+        bin = new Elf::ElfBinary64(in, false);
         if (bin->verify()){
             VERIFY_SINGLE_FORMAT(BinaryFormat_Elf64);
             f = BinaryFormat_Elf64;
@@ -195,7 +263,7 @@ namespace EPAX {
         delete bin;
 
         // check for MachO32
-        bin = new MachO::MachOBinary32(n);
+        bin = new MachO::MachOBinary32(in, false);
         if (bin->verify()){
             VERIFY_SINGLE_FORMAT(BinaryFormat_MachO32);
             f = BinaryFormat_MachO32;
@@ -203,13 +271,21 @@ namespace EPAX {
         delete bin;
 
         // check for MachO64
-        bin = new MachO::MachOBinary64(n);
+        bin = new MachO::MachOBinary64(in, false);
         if (bin->verify()){
             VERIFY_SINGLE_FORMAT(BinaryFormat_MachO64);
             f = BinaryFormat_MachO64;
         }
         delete bin;
 
+        // check for PE
+        bin = new PE::PEBinary(in, false);
+        if (bin->verify()){
+            VERIFY_SINGLE_FORMAT(BinaryFormat_PE);
+            f = BinaryFormat_PE;
+        }
+        delete bin;
+
         return f;
     }
 
@@ -248,16 +324,46 @@ namespace EPAX {
         return binary->countFunctions();
     }
 
+    Function* Binary::getFunction(uint32_t idx){
+        EPAXAssert(IS_VALID_PTR(binary), "Binary is not valid");
+        return binary->getFunction(idx);
+    }
+
+    Range<Function> Binary::functions(){
+        EPAXAssert(IS_VALID_PTR(binary), "Binary is not valid");
+        return Range<Function>(binary->getFunctions());
+    }
+
     bool Binary::isExecutable(){
         EPAXAssert(IS_VALID_PTR(binary), "Binary is not valid");
         return binary->isExecutable();
     }
 
-    uint32_t Binary::getFileSize(){
+    bool Binary::isHostCode(){
+        EPAXAssert(IS_VALID_PTR(binary), "Binary is not valid");
+        return binary->isHostCode();
+    }
+
+    void Binary::setLinearSweep(bool s){
+        EPAXAssert(IS_VALID_PTR(binary), "Binary is not valid");
+        binary->setLinearSweep(s);
+    }
+
+    void Binary::setFastDecode(bool f){
+        EPAXAssert(IS_VALID_PTR(binary), "Binary is not valid");
+        binary->setFastDecode(f);
+    }
+
+    uint64_t Binary::getFileSize(){
         EPAXAssert(IS_VALID_PTR(binary), "Binary is not valid");
         return binary->getFileSize();
     }
 
+    const std::string& Binary::getContentHash(){
+        EPAXAssert(IS_VALID_PTR(binary), "Binary is not valid");
+        return binary->getContentHash();
+    }
+
     bool Binary::hasDebugLineInfo(){
         if (IS_VALID_PTR(lineinfo)){
             return lineinfo->hasInformation();
@@ -26,6 +26,8 @@
 #ifndef __EPAX_Binary_hpp__
 #define __EPAX_Binary_hpp__
 
+#include "EPAXRange.hpp"
+
 namespace EPAX {
 
     /**
@@ -41,8 +43,13 @@ namespace EPAX {
         BinaryFormat_total
     } BinaryFormat;
 
+    // selects the ARM slice of a universal Mach-O file; matches EPAX_SLICE_DEFAULT in Interface.hpp
+#define SLICE_DEFAULT (0xffffffff)
+
     class BaseBinary;
     class Function;
+    struct ArchiveMember;
+    class InputFile;
     class LineInformation;
 
     /**
@@ -56,7 +63,8 @@ namespace EPAX {
         BaseBinary* binary;
         LineInformation* lineinfo;
 
-        void construct(std::string n, BinaryFormat f);
+        void construct(std::string n, BinaryFormat f, std::string cachedir, uint32_t cputype);
+        void load(InputFile* in, BinaryFormat f, std::string cachedir);
 
         /**
          * Emits an Binary instance to disk.
@@ -83,6 +91,46 @@ namespace EPAX {
          */
         Binary(std::string n, BinaryFormat f);
 
+        /**
+         * Constructs an Binary object whose analysis is persisted in a cache directory.
+         * If the directory already holds an entry for this binary's contents, functions,
+         * blocks and loops are restored from it instead of being recomputed.
+         *
+         * @param n  The name of a file. Format will be set based on the file's contents.
+         * @param cachedir  The analysis cache directory.
+         */
+        Binary(std::string n, std::string cachedir);
+
+        /**
+         * Constructs an Binary object from one slice of a universal Mach-O file. Only
+         * the fat header and the selected slice are read. Other files are used whole.
+         *
+         * @param n  The name of a file. Format will be set based on the file's contents.
+         * @param cputype  The Mach-O CPU type of the slice, or SLICE_DEFAULT for the ARM slice.
+         * @param cachedir  The analysis cache directory, or empty for none.
+         */
+        Binary(std::string n, uint32_t cputype, std::string cachedir);
+
+        /**
+         * Constructs an Binary object from a member of a static archive. Only the
+         * member is read. The binary is named archive(member).
+         *
+         * @param n  The name of an archive.
+         * @param member  The member.
+         * @param cachedir  The analysis cache directory, or empty for none.
+         */
+        Binary(std::string n, ArchiveMember* member, std::string cachedir);
+
+        /**
+         * Constructs an Binary object from bytes that need not be a file on disk, e.g.
+         * an image in a memory buffer (MemorySource) or a region of a live process
+         * (ProcessSource). The binary is named after in.
+         *
+         * @param in  The bytes of the binary. The Binary takes it over.
+         * @param cachedir  The analysis cache directory, or empty for none.
+         */
+        Binary(InputFile* in, std::string cachedir);
+
         /**
          * Destroys an Binary instance. Should not be called directly.
          */
@@ -91,12 +139,20 @@ namespace EPAX {
         void runBasic(int argc, char* argv[]);
 
         /**
-         * Attempts to guess the format of an binary file
+         * Attempts to guess the format of an binary file. For a universal Mach-O file
+         * this is the format of its ARM slice.
          *
          * @return the format of the binary file, or BinaryFormat_undefined(0) if the format cannot be found
          */
         static BinaryFormat detectFormat(std::string n);
 
+        /**
+         * Attempts to guess the format of the bytes of in, which is only read
+         *
+         * @return the format, or BinaryFormat_undefined(0) if the format cannot be found
+         */
+        static BinaryFormat detectFormat(InputFile* in);
+
         uint64_t getStartAddr();
         std::string getName();
 
@@ -122,6 +178,21 @@ namespace EPAX {
          */
         uint32_t countFunctions();
 
+        /**
+         * Gets a function by its index in the binary
+         *
+         * @param idx a function index, less than countFunctions()
+         * @return the function at index idx
+         */
+        Function* getFunction(uint32_t idx);
+
+        /**
+         * Gets all functions in the binary, in index order
+         *
+         * @return a range over the functions of the binary
+         */
+        Range<Function> functions();
+
         /**
          * Gets the first function in the binary
          *
@@ -151,10 +222,40 @@ namespace EPAX {
 
         bool isExecutable();
 
+        /**
+         * Checks whether the binary holds code for the instruction set of this host
+         *
+         * @return true iff the binary can be run and traced on this host
+         */
+        bool isHostCode();
+
+        /**
+         * Selects decoding each executable section in one linear sweep (see
+         * BaseBinary::setLinearSweep). Must be called before functions are asked for.
+         *
+         * @param s whether to decode in a linear sweep
+         */
+        void setLinearSweep(bool s);
+
+        /**
+         * Selects classifying AArch64 instructions from a decode table (see
+         * BaseBinary::setFastDecode). Must be called before functions are asked for.
+         *
+         * @param f whether to classify from the decode table
+         */
+        void setFastDecode(bool f);
+
         void printStaticFile(std::string& fname);
         void printStaticFile(const char* fname);
 
-        uint32_t getFileSize();
+        uint64_t getFileSize();
+
+        /**
+         * Gets the hex SHA-1 digest of the binary's contents
+         *
+         * @return the content hash of the binary
+         */
+        const std::string& getContentHash();
 
         bool hasDebugLineInfo();
         uint32_t getDebugLineNumber(uint64_t addr);
@@ -0,0 +1,131 @@
+/**
+ * @file BlockCounter.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "BasicBlock.hpp"
+#include "Binary.hpp"
+#include "BlockCounter.hpp"
+#include "Function.hpp"
+
+namespace EPAX {
+
+    static bool compareBlockAddress(BasicBlock* a, BasicBlock* b){
+        return a->getMemoryAddress() < b->getMemoryAddress();
+    }
+
+    static bool compareCounts(const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b){
+        if (a.first != b.first){
+            return a.first > b.first;
+        }
+        return a.second < b.second;
+    }
+
+    bool BlockCounter::compareAddress(BasicBlock* a, uint64_t addr){
+        return a->getMemoryAddress() < addr;
+    }
+
+    BlockCounter::BlockCounter(Binary* b, uint32_t m)
+        : Tracer(b, 0), maxhits(m)
+    {
+        Range<Function> funcs = binary->functions();
+        for (Range<Function>::iterator it = funcs.begin(); it != funcs.end(); it++){
+            Range<BasicBlock> bbs = (*it)->blocks();
+            blocks.insert(blocks.end(), bbs.begin(), bbs.end());
+        }
+        std::stable_sort(blocks.begin(), blocks.end(), compareBlockAddress);
+        counts.resize(blocks.size(), 0);
+    }
+
+    BlockCounter::~BlockCounter(){
+    }
+
+    void BlockCounter::started(){
+        std::vector<uint64_t> addrs;
+        for (std::vector<BasicBlock*>::const_iterator it = blocks.begin(); it != blocks.end(); it++){
+            if (addrs.empty() || addrs.back() != (*it)->getMemoryAddress()){
+                addrs.push_back((*it)->getMemoryAddress());
+            }
+        }
+        if (!insertBreakpoints(addrs)){
+            EPAXWarn << "cannot write the code of process " << DEC(pid) << "; no blocks are counted" << ENDL;
+        }
+    }
+
+    bool BlockCounter::hit(pid_t tid, uint64_t addr){
+        std::vector<BasicBlock*>::const_iterator it = std::lower_bound(blocks.begin(), blocks.end(), addr, compareAddress);
+        if (it == blocks.end() || (*it)->getMemoryAddress() != addr){
+            return false;
+        }
+
+        uint64_t& c = counts[it - blocks.begin()];
+        c++;
+        return (maxhits == 0 || c < maxhits);
+    }
+
+    uint64_t BlockCounter::getCount(BasicBlock* bb){
+        std::vector<BasicBlock*>::const_iterator it = std::lower_bound(blocks.begin(), blocks.end(), bb->getMemoryAddress(), compareAddress);
+        for ( ; it != blocks.end() && (*it)->getMemoryAddress() == bb->getMemoryAddress(); it++){
+            if ((*it) == bb){
+                return counts[it - blocks.begin()];
+            }
+        }
+        return 0;
+    }
+
+    void BlockCounter::report(std::ostream& stream){
+        uint32_t executed = 0;
+        std::map<Function*, uint32_t> covered;
+        std::vector<std::pair<uint64_t, uint32_t> > sorted;
+        for (uint32_t i = 0; i < blocks.size(); i++){
+            if (counts[i] > 0){
+                executed++;
+                covered[blocks[i]->getFunction()]++;
+                sorted.push_back(std::make_pair(counts[i], i));
+            }
+        }
+        std::sort(sorted.begin(), sorted.end(), compareCounts);
+
+        stream << "# binary " << getName() << ENDL;
+        stream << "# blocks " << DEC(executed) << " of " << DEC(blocks.size()) << " executed" << TAB
+               << "functions " << DEC(covered.size()) << " of " << DEC(binary->countFunctions()) << " executed" << TAB
+               << "maxhits " << DEC(maxhits) << ENDL;
+
+        stream << "# func <blocks executed> <blocks> <func> <addr> <name>" << ENDL;
+        for (std::map<Function*, uint32_t>::const_iterator it = covered.begin(); it != covered.end(); it++){
+            Function* f = it->first;
+            stream << "func" << TAB << DEC(it->second) << TAB << DEC(f->countBasicBlocks()) << TAB << DEC(f->getIndex()) << TAB
+                   << HEX(f->getMemoryAddress()) << TAB << f->getName() << ENDL;
+        }
+
+        stream << "# bbl <count> <func> <bbl> <addr>" << ENDL;
+        for (std::vector<std::pair<uint64_t, uint32_t> >::const_iterator it = sorted.begin(); it != sorted.end(); it++){
+            BasicBlock* bb = blocks[it->second];
+            stream << "bbl" << TAB << DEC(it->first) << TAB << DEC(bb->getFunction()->getIndex()) << TAB << DEC(bb->getIndex()) << TAB
+                   << HEX(bb->getMemoryAddress()) << ENDL;
+        }
+        stream << std::dec;
+    }
+
+} // namespace EPAX
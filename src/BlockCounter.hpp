@@ -0,0 +1,87 @@
+/**
+ * @file BlockCounter.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_BlockCounter_hpp__
+#define __EPAX_BlockCounter_hpp__
+
+#include "BaseClass.hpp"
+#include "Tracer.hpp"
+
+namespace EPAX {
+
+    class BasicBlock;
+
+    /**
+     * Counts how often each basic block of a Binary runs in a process, with a software
+     * breakpoint on the first instruction of every block. The breakpoints are placed
+     * before the program runs, with one write to the process per page of code. When a
+     * block has been counted maxhits times its breakpoint is removed, so that the block
+     * then runs at full speed; with maxhits 1 this measures coverage at the cost of one
+     * trap per executed block.
+     *
+     * A breakpoint kept in place is stepped over with every other thread held, so that
+     * counts are exact, but each counted execution stops the whole process.
+     */
+    class BlockCounter : public Tracer {
+    private:
+        uint32_t maxhits;
+
+        // the blocks, sorted by address, and their counts
+        std::vector<BasicBlock*> blocks;
+        std::vector<uint64_t> counts;
+
+        static bool compareAddress(BasicBlock* a, uint64_t addr);
+
+    protected:
+        void started();
+        bool hit(pid_t tid, uint64_t addr);
+
+    public:
+        /**
+         * @param b the binary run by the process
+         * @param m the count after which a block's breakpoint is removed, or 0 to count every execution
+         */
+        BlockCounter(Binary* b, uint32_t m = 0);
+        virtual ~BlockCounter();
+
+        /**
+         * Gets the number of times a block ran, as far as it was counted
+         *
+         * @param bb a block of the binary
+         * @return the count of bb, which can pass maxhits by threads that reached it together
+         */
+        uint64_t getCount(BasicBlock* bb);
+
+        /**
+         * Writes the coverage of each function that ran and the count of each block
+         * that ran, sorted by decreasing count
+         *
+         * @param stream where to write the report
+         */
+        void report(std::ostream& stream = std::cout);
+    }; // class BlockCounter
+
+} // namespace EPAX
+
+#endif // __EPAX_BlockCounter_hpp__
@@ -39,6 +39,17 @@ namespace EPAX {
         initialize(bbs);
     }
 
+    ControlFlow::ControlFlow(Function* f, std::vector<BasicBlock*> bbs, bool analyze)
+        : EPAXExport(EPAXExportClass_CFG),
+          function(f)
+    {
+        if (analyze){
+            initialize(bbs);
+        } else {
+            addBasicBlocks(bbs);
+        }
+    }
+
     ControlFlow::~ControlFlow(){ 
         for (std::vector<BasicBlock*>::const_iterator it = basicblocks.begin(); it != basicblocks.end(); it++){
             BasicBlock* bb = (*it);
@@ -47,7 +58,7 @@ namespace EPAX {
             }
         }
 
-        for (std::vector<Loop*>::const_iterator it = loops.begin(); it != loops.end(); it++){
+        for (std::vector<Loop*>::const_iterator it = looplist.begin(); it != looplist.end(); it++){
             Loop* lp = (*it);
             if (IS_VALID_PTR(lp)){
                 delete lp;
@@ -139,6 +150,23 @@ namespace EPAX {
         EPAXAssert(backedg.size() % 2 == 0, "Expecting back edges to come in head/tail pairs");
     }
     
+    void ControlFlow::addBasicBlocks(std::vector<BasicBlock*>& bbs){
+        for (std::vector<BasicBlock*>::const_iterator it = bbs.begin(); it != bbs.end(); it++){
+            BasicBlock* bb = (*it);
+            basicblocks.push_back(bb);
+
+            for (uint32_t j = 0; j < bb->countInstructions(); j++){
+                Instruction* insn = bb->getInstruction(j);
+                insn->setIndex(j);
+                insns.push_back(insn);
+            }
+        }
+    }
+
+    void ControlFlow::addLoop(Loop* lp){
+        looplist.push_back(lp);
+    }
+
     void ControlFlow::initialize(std::vector<BasicBlock*> bbs){
         if (bbs.size() < 1){
             return;
@@ -146,19 +174,10 @@ namespace EPAX {
 
         uint32_t bcount = bbs.size();
         std::map<uint64_t, uint32_t> bb_map;
-        uint32_t i = 0;
         for (uint32_t i = 0; i < bcount; i++){
-            BasicBlock* bb = bbs[i];
-
-            bb_map[bb->head()->getMemoryAddress()] = i;
-            basicblocks.push_back(bb);
-
-            for (uint32_t j = 0; j < bb->countInstructions(); j++){
-                Instruction* insn = bb->getInstruction(j);
-                insn->setIndex(j);
-                instructions.push_back(insn);
-            }
+            bb_map[bbs[i]->head()->getMemoryAddress()] = i;
         }
+        addBasicBlocks(bbs);
 
         for (std::vector<BasicBlock*>::const_iterator it = bbs.begin(); it != bbs.end(); it++){
             BasicBlock* bb = (*it);
@@ -237,19 +256,19 @@ namespace EPAX {
 
                 // TODO: get correct depth
                 // TODO: add exit nodes
-                loops.push_back(new Loop(this, head->getIndex(), tail->getIndex(), 0, members, loopidx++));
+                looplist.push_back(new Loop(this, head->getIndex(), tail->getIndex(), 0, members, loopidx++));
             }
         }
 
-        for (uint32_t i = 0; i < loops.size(); i++){
+        for (uint32_t i = 0; i < looplist.size(); i++){
             uint32_t d = 1;
-            for (uint32_t j = 0; j < loops.size(); j++){
+            for (uint32_t j = 0; j < looplist.size(); j++){
                 if (i == j) continue;
-                if (loops[i]->isChildOf(loops[j])){
+                if (looplist[i]->isChildOf(looplist[j])){
                     d++;
                 }
             }
-            loops[i]->setDepth(d);
+            looplist[i]->setDepth(d);
         }
 
         for (std::vector<dyn_bitset*>::const_iterator it = dominators.begin(); it != dominators.end(); it++){
@@ -283,9 +302,9 @@ namespace EPAX {
     }
 
     Loop* ControlFlow::getParentOf(Loop* loop){
-        for (uint32_t i = 0; i < loops.size(); i++){
-            if (loop->isChildOf(loops[i]) && loop->getDepth() == loops[i]->getDepth() + 1){
-                return loops[i];
+        for (uint32_t i = 0; i < looplist.size(); i++){
+            if (loop->isChildOf(looplist[i]) && loop->getDepth() == looplist[i]->getDepth() + 1){
+                return looplist[i];
             }
         }
         return INVALID_PTR;
@@ -314,12 +333,12 @@ namespace EPAX {
     }
 
     uint32_t ControlFlow::countInstructions(){
-        return instructions.size();
+        return insns.size();
     }
 
     Instruction* ControlFlow::findInstruction(uint64_t addr){
         // TODO: should binary search
-        for (std::vector<Instruction*>::const_iterator it = instructions.begin(); it != instructions.end(); it++){
+        for (std::vector<Instruction*>::const_iterator it = insns.begin(); it != insns.end(); it++){
             Instruction* insn = (*it);
             if (insn->inRange(addr)){
                 return insn;
@@ -329,14 +348,14 @@ namespace EPAX {
     }
 
     Instruction* ControlFlow::getInstruction(uint32_t idx){
-        if (idx < instructions.size()){
-            return instructions[idx];
+        if (idx < insns.size()){
+            return insns[idx];
         }
         return INVALID_PTR;
     }
 
     uint32_t ControlFlow::countLoops(){
-        return loops.size();
+        return looplist.size();
     }
 
     Loop* ControlFlow::findLoop(uint64_t addr){
@@ -348,10 +367,10 @@ namespace EPAX {
         uint32_t bidx = bb->getIndex();
         uint32_t maxd = 0;
         Loop* lp = INVALID_PTR;
-        for (uint32_t i = 0; i < loops.size(); i++){
-            if (loops[i]->hasBasicBlock(bidx)){
-                if (0 == maxd || loops[i]->getDepth() > maxd){
-                    lp = loops[i];
+        for (uint32_t i = 0; i < looplist.size(); i++){
+            if (looplist[i]->hasBasicBlock(bidx)){
+                if (0 == maxd || looplist[i]->getDepth() > maxd){
+                    lp = looplist[i];
                     maxd = lp->getDepth();
                 }
             }
@@ -360,8 +379,8 @@ namespace EPAX {
     }
 
     Loop* ControlFlow::getLoop(uint32_t idx){
-        if (idx < loops.size()){
-            return loops[idx];
+        if (idx < looplist.size()){
+            return looplist[idx];
         }
         return INVALID_PTR;
     }
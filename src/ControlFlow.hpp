@@ -26,6 +26,7 @@
 #define __EPAX_ControlFlow_hpp__
 
 #include "BaseClass.hpp"
+#include "EPAXRange.hpp"
 
 namespace EPAX {
 
@@ -38,17 +39,27 @@ namespace EPAX {
     private:
         Function* function;
         std::vector<BasicBlock*> basicblocks;
-        std::vector<Loop*> loops;
+        std::vector<Loop*> looplist;
 
         // all instructions in the cfg. their IndexBase index is kept per-block
-        std::vector<Instruction*> instructions;
+        std::vector<Instruction*> insns;
 
         void initialize(std::vector<BasicBlock*> bbs);
+        void addBasicBlocks(std::vector<BasicBlock*>& bbs);
 
     public:
         ControlFlow(Function* f, std::vector<BasicBlock*> bbs);
+
+        /**
+         * Constructs a ControlFlow from blocks whose edges and loops are already known
+         * (e.g. restored from the analysis cache). No analysis is performed; the caller
+         * supplies edges on the blocks and adds loops with addLoop.
+         */
+        ControlFlow(Function* f, std::vector<BasicBlock*> bbs, bool analyze);
         virtual ~ControlFlow();
 
+        void addLoop(Loop* lp);
+
         Function* getFunction() { return function; }
 
         void print(std::ostream& stream = std::cout);
@@ -67,6 +78,10 @@ namespace EPAX {
         Loop* getLoop(uint32_t idx);
         Loop* getParentOf(Loop* loop);
 
+        Range<BasicBlock> blocks() { return Range<BasicBlock>(basicblocks); }
+        Range<Instruction> instructions() { return Range<Instruction>(insns); }
+        Range<Loop> loops() { return Range<Loop>(looplist); }
+
     }; // class ControlFlow
 
 } // namespace EPAX
@@ -68,7 +68,7 @@ namespace EPAX {
         }
 
         void set(uint32_t idx){
-            EPAXAssert(idx < _size, "Invalid dyn_bitset index given");
+            EPAXCheck(idx < _size, "Invalid dyn_bitset index given");
             __set_bit(idx);
         }
 
@@ -79,7 +79,7 @@ namespace EPAX {
         }
 
         bool has(uint32_t idx){
-            EPAXAssert(idx < _size, "Invalid dyn_bitset index given");
+            EPAXCheck(idx < _size, "Invalid dyn_bitset index given");
             return __has_bit(idx);
         }
 
@@ -130,6 +130,141 @@ namespace EPAX {
         }
     };
 
+    /**
+     * A table of NUL-terminated strings in which each distinct string is stored once.
+     * Strings are named by their offset into the table; offset 0 is the empty string.
+     */
+    class StringPool {
+    private:
+        std::map<std::string, uint32_t> offsets;
+
+    public:
+        std::string table;
+
+        StringPool() { table.push_back('\0'); }
+
+        uint32_t add(const std::string& s){
+            if (s.size() == 0){
+                return 0;
+            }
+            std::map<std::string, uint32_t>::const_iterator it = offsets.find(s);
+            if (it != offsets.end()){
+                return it->second;
+            }
+            uint32_t off = table.size();
+            table.append(s);
+            table.push_back('\0');
+            offsets[s] = off;
+            return off;
+        }
+    }; // class StringPool
+
+    /**
+     * Maps addresses to the objects whose [start, end) ranges contain them. Ranges may
+     * overlap; where they do, an address resolves to the range that was added first.
+     * Call build() once all ranges have been added. find() is then a binary search
+     * over disjoint segments and does not modify the index.
+     */
+    template <class T> class AddressIndex {
+    private:
+        typedef struct {
+            uint64_t start;
+            uint64_t end;
+            uint32_t order;
+            T* obj;
+        } AddressRange;
+
+        static bool compareStart(const AddressRange& a, const AddressRange& b){
+            if (a.start != b.start){
+                return a.start < b.start;
+            }
+            return a.order < b.order;
+        }
+
+        std::vector<AddressRange> ranges;
+
+        // the disjoint segments, sorted by start
+        std::vector<uint64_t> starts;
+        std::vector<uint64_t> ends;
+        std::vector<T*> objs;
+
+        void addSegment(uint64_t start, uint64_t end, T* obj){
+            if (objs.size() && objs.back() == obj && ends.back() == start){
+                ends.back() = end;
+                return;
+            }
+            starts.push_back(start);
+            ends.push_back(end);
+            objs.push_back(obj);
+        }
+
+    public:
+        AddressIndex() {}
+
+        void add(uint64_t start, uint64_t end, T* obj){
+            AddressRange r;
+            r.start = start;
+            r.end = (end > start? end: start + 1);
+            r.order = ranges.size();
+            r.obj = obj;
+            ranges.push_back(r);
+        }
+
+        void build(){
+            starts.clear();
+            ends.clear();
+            objs.clear();
+
+            std::sort(ranges.begin(), ranges.end(), compareStart);
+
+            // sweep over the range boundaries, keeping the ranges that have started in
+            // a heap ordered by when they were added. the top of the heap owns the
+            // addresses up to its end or the next start, whichever comes first
+            std::priority_queue<std::pair<uint32_t, uint32_t>, std::vector<std::pair<uint32_t, uint32_t> >, std::greater<std::pair<uint32_t, uint32_t> > > active;
+            uint32_t next = 0;
+            uint64_t cur = 0;
+            while (next < ranges.size() || !active.empty()){
+                if (active.empty()){
+                    cur = ranges[next].start;
+                }
+                while (next < ranges.size() && ranges[next].start <= cur){
+                    active.push(std::make_pair(ranges[next].order, next));
+                    next++;
+                }
+                while (!active.empty() && ranges[active.top().second].end <= cur){
+                    active.pop();
+                }
+                if (active.empty()){
+                    continue;
+                }
+
+                AddressRange& owner = ranges[active.top().second];
+                uint64_t end = owner.end;
+                if (next < ranges.size() && ranges[next].start < end){
+                    end = ranges[next].start;
+                }
+                addSegment(cur, end, owner.obj);
+                cur = end;
+            }
+
+            ranges.clear();
+        }
+
+        T* find(uint64_t addr) const {
+            std::vector<uint64_t>::const_iterator it = std::upper_bound(starts.begin(), starts.end(), addr);
+            if (it == starts.begin()){
+                return INVALID_PTR;
+            }
+            uint32_t idx = (it - starts.begin()) - 1;
+            if (addr < ends[idx]){
+                return objs[idx];
+            }
+            return INVALID_PTR;
+        }
+
+        uint32_t countSegments() const { return starts.size(); }
+    }; // class AddressIndex
+
 } // namespace EPAX
 
 #endif // __EPAX_Loop_hpp__
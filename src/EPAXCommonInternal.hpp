@@ -48,6 +48,7 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include <iostream>
 #include <iomanip>
@@ -59,6 +60,7 @@
 #include <stack>
 #include <set>
 #include <algorithm>
+#include <queue>
 
 #ifdef HAVE_CXX11
 #include <unordered_map>
@@ -81,22 +83,20 @@ template<typename K, typename V> struct fastmap { typedef std::map<K, V> map; };
 #define HEX(__n__) std::hex << "0x" << (__n__)
 
 #define BACKTRACE_LIMIT 64
-static void* _backtraceArray[BACKTRACE_LIMIT];
-static size_t _backtraceSize;
-static char** _backtraceStrings;
-static int _arrayBacktraceIterator;
 
 #define EPAXErr std::cerr << EPAX_PREFACE
 #define EPAXOut std::cout << EPAX_PREFACE
 #define EPAXWarn EPAXErr << " warning: "
 
+// the backtrace buffers are local to the failing block so that concurrent failures don't share them
 #ifdef HAVE_EXECINFO_H
 #include <execinfo.h>
 #define EPAXAssert(__stmt__, __msg__)                                   \
-    if (!(__stmt__)){ _backtraceSize = backtrace(_backtraceArray, BACKTRACE_LIMIT); _backtraceStrings = backtrace_symbols(_backtraceArray, _backtraceSize); \
+    if (!(__stmt__)){ void* _backtraceArray[BACKTRACE_LIMIT]; int _backtraceSize = backtrace(_backtraceArray, BACKTRACE_LIMIT); \
+        char** _backtraceStrings = backtrace_symbols(_backtraceArray, _backtraceSize); \
         EPAXErr << "Assert failure: " << __PRETTY_FUNCTION__ << " at " << __FILE__ << ":" << __LINE__ << ENDL; \
         EPAXErr << __msg__ << ENDL;                                     \
-        for (_arrayBacktraceIterator = 0; _arrayBacktraceIterator < _backtraceSize; _arrayBacktraceIterator++){ EPAXErr << TAB << _backtraceStrings[_arrayBacktraceIterator] << ENDL; } \
+        for (int _i = 0; _i < _backtraceSize; _i++){ EPAXErr << TAB << _backtraceStrings[_i] << ENDL; } \
         free(_backtraceStrings);                                        \
         exit(1); }
 #else // HAVE_EXECINFO_H
@@ -107,6 +107,16 @@ static int _arrayBacktraceIterator;
         exit(1); }
 #endif // HAVE_EXECINFO_H
 
+/*
+ * EPAXCheck is for invariants on hot internal paths (container indices and the like).
+ * It is an EPAXAssert in checked builds and compiles to nothing in release builds
+ * (configure --enable-release, or make EPAX_BUILD=release).
+ */
+#ifdef EPAX_RELEASE
+#define EPAXCheck(__stmt__, __msg__)
+#else
+#define EPAXCheck(__stmt__, __msg__) EPAXAssert(__stmt__, __msg__)
+#endif
 
 #define EPAXDie(__msg__) EPAXAssert(false, __msg__)
 #define ShouldNotArrive EPAXDie("This function is not yet implemented")
@@ -122,6 +132,7 @@ typedef enum {
     EPAXExportClass_INSN,
     EPAXExportClass_SYM,
     EPAXExportClass_FLOW,
+    EPAXExportClass_SFILE,
     EPAXExportClass_total
 } EPAXExportClass;
 
@@ -135,9 +146,54 @@ public:
     EPAXExportClass getClass() { return expclass; }
 }; // class EPAXExport
 
-#define EPAXVerifyType(__type__, __obj__)\
-    EPAXAssert(IS_VALID_PTR(__obj__), "invalid object (NULL) found instead of " # __type__);\
-    EPAXAssert(__obj__->getClass() == EPAXExportClass_ ## __type__, "Non-" # __type__ << " object found");
+/*
+ * Errors reported by the interface in validating mode. These match the EPAX_ERROR_*
+ * values in Interface.hpp.
+ */
+typedef enum {
+    EPAXError_none = 0,
+    EPAXError_null,
+    EPAXError_type,
+    EPAXError_argument,
+    EPAXError_total
+} EPAXError;
+
+/*
+ * Validating mode is opt-in (EPAX_setValidation, or $EPAX_VALIDATE). In that mode an
+ * interface call given a bad object records an EPAXError, which EPAX_lastError reports,
+ * and returns a zero value (NULL, 0, false or "") instead of exiting. Only the object
+ * checks (EPAXVerifyType) honor it; EPAXAssert and EPAXCheck still exit.
+ */
+extern bool EPAXValidating;
+extern void EPAXSetError(EPAXError e);
+
+template <typename T> static inline EPAXError EPAXCheckObject(T* obj, EPAXExportClass cls){
+    if (!IS_VALID_PTR(obj)){
+        return EPAXError_null;
+    }
+    if (obj->getClass() != cls){
+        return EPAXError_type;
+    }
+    return EPAXError_none;
+}
+
+// converts to the zero value of whatever an interface function returns
+struct EPAXErrorValue {
+    template <typename T> operator T() const { return T(); }
+};
+
+#define __EPAXVerifyType(__type__, __obj__, __ret__)                    \
+    if (EPAXValidating){                                                \
+        EPAXError _err = EPAXCheckObject(__obj__, EPAXExportClass_ ## __type__); \
+        if (_err != EPAXError_none){ EPAXSetError(_err); return __ret__; } \
+    } else {                                                            \
+        EPAXCheck(IS_VALID_PTR(__obj__), "invalid object (NULL) found instead of " # __type__); \
+        EPAXCheck(__obj__->getClass() == EPAXExportClass_ ## __type__, "Non-" # __type__ << " object found"); \
+    }
+
+// EPAXVerifyTypeVoid is for interface functions that return nothing
+#define EPAXVerifyType(__type__, __obj__) __EPAXVerifyType(__type__, __obj__, EPAXErrorValue())
+#define EPAXVerifyTypeVoid(__type__, __obj__) __EPAXVerifyType(__type__, __obj__, )
 
 #define __do_not_call__ EPAXAssert(false, "This function cannot be called.")
 #define ALIGN_PWR2(__addr, __exp) (__addr & ~((1 << __exp) - 1))
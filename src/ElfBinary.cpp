@@ -29,7 +29,9 @@
 #include "Binary.hpp"
 #include "ElfBinary.hpp"
 #include "Function.hpp"
+#include "Hash.hpp"
 #include "InputFile.hpp"
+#include "LinearSweep.hpp"
 
 namespace EPAX {
 
@@ -44,11 +46,27 @@ namespace EPAX {
 #define PHDR32_ENTRY ((Elf32_Phdr*)entry)
 #define PHDR64_ENTRY ((Elf64_Phdr*)entry)
 
+// bytes of a symbol table read at a time
+#define SYMBOL_WINDOW_SIZE (1024 * 1024)
+
+// the largest note section searched for a build ID; real ones hold a few small notes
+#define MAX_NOTE_SECTION_SIZE (16 * 1024)
+
         ElfBinary::ElfBinary(std::string n)
             : BaseBinary(n),
               fileheader(INVALID_PTR),
               foundsections(false), sections(INVALID_PTR),
-              foundsegments(false), segments(INVALID_PTR)
+              foundsegments(false), segments(INVALID_PTR),
+              coderegions(INVALID_PTR)
+        {
+        }
+
+        ElfBinary::ElfBinary(InputFile* f, bool own)
+            : BaseBinary(f, own),
+              fileheader(INVALID_PTR),
+              foundsections(false), sections(INVALID_PTR),
+              foundsegments(false), segments(INVALID_PTR),
+              coderegions(INVALID_PTR)
         {
         }
 
@@ -73,6 +91,9 @@ namespace EPAX {
                 delete segments;
 	    }
 
+            if (IS_VALID_PTR(coderegions)){
+                delete coderegions;
+            }
         }
 
         bool ElfBinary::insideTextRange(uint64_t a){
@@ -133,6 +154,18 @@ namespace EPAX {
             fileheader = new FileHeader64(this, 0);
         }
 
+        ElfBinary32::ElfBinary32(InputFile* f, bool own)
+            : ElfBinary(f, own)
+        {
+            fileheader = new FileHeader32(this, 0);
+        }
+
+        ElfBinary64::ElfBinary64(InputFile* f, bool own)
+            : ElfBinary(f, own)
+        {
+            fileheader = new FileHeader64(this, 0);
+        }
+
         bool ElfBinary::is32Bit(){
             return (getFormat() == BinaryFormat_Elf32);
         }
@@ -146,6 +179,16 @@ namespace EPAX {
         }
 
         uint64_t ElfBinary::vaddrToFile(uint64_t v){
+            if (isRelocatable()){
+                for (std::vector<SectionHeader*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                    SectionHeader* h = (*it);
+                    if (h->isAlloc() && h->getType() != SHT_NOBITS && h->inRange(v)){
+                        return h->getFileOffset() + (v - h->getLoadAddress());
+                    }
+                }
+                return 0;
+            }
+
             for (std::vector<ProgramHeader*>::const_iterator it = segments->begin(); it != segments->end(); it++){
                 ProgramHeader* h = (ProgramHeader*)(*it);
                 if (h->isValidVaddr(v)){
@@ -161,7 +204,7 @@ namespace EPAX {
                 return;
             }
 
-            findSymbols();
+            lazySymbols();
 
             functions = new std::vector<Function*>();
             foundfunctions = true;
@@ -198,9 +241,13 @@ namespace EPAX {
                 }
             }
 
-            for (std::vector<Function*>::const_iterator it = functions->begin(); it != functions->end(); it++){
-                Function* f = (*it);
-                f->disassemble();
+            if (linearsweep){
+                sweepFunctions();
+            } else {
+                for (std::vector<Function*>::const_iterator it = functions->begin(); it != functions->end(); it++){
+                    Function* f = (*it);
+                    f->disassemble();
+                }
             }
 
 
@@ -213,6 +260,74 @@ namespace EPAX {
             }
         }
 
+        // decodes each executable section once and forms the functions from slices of it.
+        // code that no function symbol covers becomes an unnamed function
+        void ElfBinary::sweepFunctions(){
+            if (functions->size() == 0){
+                return;
+            }
+            bool isv8 = (fileheader->getBits() == 64);
+
+            uint32_t swept = 0;
+            std::vector<Function*> found;
+            for (std::vector<SectionHeader*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                SectionHeader* h = (*it);
+                if (!h->isText() || h->getSize() == 0){
+                    continue;
+                }
+
+                uint64_t addr = h->getLoadAddress();
+                LinearSweep sweep(this, h->getFileOffset(), h->getSize(), addr, isv8);
+
+                std::vector<Function*> mine;
+                for (std::vector<Function*>::const_iterator fit = functions->begin(); fit != functions->end(); fit++){
+                    if (h->inRange((*fit)->getMemoryAddress())){
+                        mine.push_back(*fit);
+                    }
+                }
+
+                // without mapping symbols, each function's symbol gives its mode
+                std::vector<CodeRegion> regions;
+                if (findCodeRegions(addr, h->getSize(), regions)){
+                    for (std::vector<CodeRegion>::const_iterator rit = regions.begin(); rit != regions.end(); rit++){
+                        sweep.addMark(rit->start, rit->mode);
+                    }
+                } else {
+                    for (std::vector<Function*>::const_iterator fit = mine.begin(); fit != mine.end(); fit++){
+                        sweep.addMark((*fit)->getMemoryAddress(), (*fit)->disassembleMode());
+                    }
+                }
+
+                sweep.decode(mine.size()? mine.front(): functions->front());
+                swept += sweep.countInstructions();
+
+                for (std::vector<Function*>::const_iterator fit = mine.begin(); fit != mine.end(); fit++){
+                    if (!sweep.slice(*fit)){
+                        (*fit)->disassemble();
+                    }
+                }
+
+                uint64_t start, end;
+                uint64_t next = addr;
+                while (sweep.findUnclaimed(next, start, end)){
+                    Function* f = new Function(this, h->getFileOffset() + (start - addr), end - start, start, 0, INVALID_PTR, isv8);
+                    sweep.slice(f);
+                    found.push_back(f);
+                    next = end;
+                }
+            }
+
+            EPAXOut << "Linear sweep decoded " << DEC(swept) << " instructions and found " << DEC(found.size()) << " functions without symbols" << ENDL;
+
+            if (found.size()){
+                functions->insert(functions->end(), found.begin(), found.end());
+                std::stable_sort(functions->begin(), functions->end(), compareMemory);
+                for (uint32_t i = 0; i < functions->size(); i++){
+                    (*functions)[i]->setIndex(i);
+                }
+            }
+        }
+
         void ElfBinary::printFunctions(std::ostream& stream){
             stream << ENDL;
             stream << "Printing all functions in " << getName() << ENDL;
@@ -243,8 +358,12 @@ namespace EPAX {
             strtabs = new std::vector<StringTable*>();
             foundsymbols = true;
 
-            findSections();
-            findSegments();
+            if (!foundsections){
+                findSections();
+            }
+            if (!foundsegments){
+                findSegments();
+            }
 
             // find string tables
             uint32_t cur = 0;
@@ -274,11 +393,145 @@ namespace EPAX {
                 if (h->isSymbol()){
                     ElfStringTable* st = findStringtable(h->getSectionLink());
 
-                    symtabs->push_back(new ElfSymbolTable(this, h->getFileOffset(), h->getSize(), h->getVirtAddr(), h->getSize(), cur, h->getName(), st));
+                    ElfSymbolTable* symt = new ElfSymbolTable(this, h->getFileOffset(), h->getSize(), h->getVirtAddr(), h->getSize(), cur, h->getName(), st);
+                    if (isRelocatable()){
+                        for (uint32_t i = 0; i < symt->countSymbols(); i++){
+                            ElfSymbol* sym = (ElfSymbol*)symt->getSymbol(i);
+                            if (sym->getSection() != SHN_UNDEF && sym->getSection() < SHN_LORESERVE && sym->getSection() < sections->size()){
+                                sym->setBase((*sections)[sym->getSection()]->getLoadAddress());
+                            }
+                        }
+                    }
+                    symtabs->push_back(symt);
                     //symtabs->back()->print();
                 }
                 cur++;
             }
+
+            indexMappingSymbols();
+        }
+
+        static bool compareMappingSymbols(ElfSymbol* s1, ElfSymbol* s2){
+            if (s1->getSection() != s2->getSection()){
+                return s1->getSection() < s2->getSection();
+            }
+            return s1->getAddress() < s2->getAddress();
+        }
+
+        static bool compareRegionStart(const CodeRegion& r1, const CodeRegion& r2){
+            return r1.start < r2.start;
+        }
+
+        static bool compareRegionEnd(uint64_t a, const CodeRegion& r){
+            return a < r.end;
+        }
+
+        // each mapping symbol marks a region that runs to the next one in its section,
+        // or to the end of the section
+        void ElfBinary::indexMappingSymbols(){
+            coderegions = new std::vector<CodeRegion>();
+
+            std::vector<ElfSymbol*> mapsyms;
+            for (std::vector<SymbolTable*>::const_iterator it = symtabs->begin(); it != symtabs->end(); it++){
+                ElfSymbolTable* symt = (ElfSymbolTable*)(*it);
+                for (uint32_t i = 0; i < symt->countSymbols(); i++){
+                    ElfSymbol* s = (ElfSymbol*)symt->getSymbol(i);
+                    if (s->isMappingSymbol() && s->getSection() != SHN_UNDEF && s->getSection() < sections->size()){
+                        mapsyms.push_back(s);
+                    }
+                }
+            }
+            std::stable_sort(mapsyms.begin(), mapsyms.end(), compareMappingSymbols);
+
+            for (uint32_t i = 0; i < mapsyms.size(); i++){
+                ElfSymbol* s = mapsyms[i];
+                SectionHeader* h = (*sections)[s->getSection()];
+
+                CodeRegion r;
+                r.start = s->getAddress();
+                r.end = h->getLoadAddress() + h->getSize();
+                r.mode = s->getMappingMode();
+                if (i + 1 < mapsyms.size() && mapsyms[i + 1]->getSection() == s->getSection()){
+                    r.end = mapsyms[i + 1]->getAddress();
+                }
+
+                // superseded by a later symbol at the same address, or outside its section
+                if (r.start >= r.end || !h->inRange(r.start)){
+                    continue;
+                }
+
+                if (coderegions->size() && coderegions->back().end == r.start && coderegions->back().mode == r.mode){
+                    coderegions->back().end = r.end;
+                } else {
+                    coderegions->push_back(r);
+                }
+            }
+            std::sort(coderegions->begin(), coderegions->end(), compareRegionStart);
+        }
+
+        bool ElfBinary::findCodeRegions(uint64_t a, uint64_t s, std::vector<CodeRegion>& regions){
+            if (!IS_VALID_PTR(coderegions)){
+                return false;
+            }
+
+            bool found = false;
+            std::vector<CodeRegion>::const_iterator it = std::upper_bound(coderegions->begin(), coderegions->end(), a, compareRegionEnd);
+            for ( ; it != coderegions->end() && it->start < a + s; it++){
+                CodeRegion r = (*it);
+                if (r.start < a){
+                    r.start = a;
+                }
+                if (r.end > a + s){
+                    r.end = a + s;
+                }
+                regions.push_back(r);
+                found = true;
+            }
+            return found;
+        }
+
+        std::string ElfBinary::getBuildID(){
+            pthread_mutex_lock(&lazylock);
+            if (!foundsections){
+                findSections();
+            }
+            pthread_mutex_unlock(&lazylock);
+
+            for (std::vector<SectionHeader*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                SectionHeader* h = (*it);
+                if (!h->isNote()){
+                    continue;
+                }
+
+                // the size is untrusted, so bound it before allocating
+                uint64_t size = h->getSize();
+                if (size > MAX_NOTE_SECTION_SIZE || h->getFileOffset() > getFileSize() || size > getFileSize() - h->getFileOffset()){
+                    continue;
+                }
+                rawbyte_t* buf = new rawbyte_t[size];
+                getInputFile()->getBytes(h->getFileOffset(), size, buf);
+
+                // Elf32_Nhdr and Elf64_Nhdr share a layout
+                uint64_t cur = 0;
+                while (cur + sizeof(Elf32_Nhdr) <= size){
+                    Elf32_Nhdr* note = (Elf32_Nhdr*)(buf + cur);
+                    uint64_t name = cur + sizeof(Elf32_Nhdr);
+                    uint64_t desc = name + ((note->n_namesz + 3) & ~3);
+                    uint64_t next = desc + ((note->n_descsz + 3) & ~3);
+                    if (next > size){
+                        break;
+                    }
+
+                    if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 && memcmp(buf + name, "GNU", 4) == 0){
+                        std::string id = toHexString((uint8_t*)(buf + desc), note->n_descsz);
+                        delete[] buf;
+                        return id;
+                    }
+                    cur = next;
+                }
+                delete[] buf;
+            }
+            return std::string();
         }
 
         void ElfBinary::findSections(){
@@ -300,6 +553,28 @@ namespace EPAX {
                     sections->push_back(new SectionHeader64(this, off + (i * sz), sz, i));
                 }
             }
+
+            if (isRelocatable()){
+                layoutSections();
+            }
+        }
+
+        // places the allocated sections of a relocatable object in section order, each
+        // at its alignment, so that every section has an address of its own
+        void ElfBinary::layoutSections(){
+            uint64_t cur = 0;
+            for (std::vector<SectionHeader*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                SectionHeader* h = (*it);
+                if (!h->isAlloc()){
+                    continue;
+                }
+                uint64_t align = h->getAlignment();
+                if (align > 1){
+                    cur = (cur + align - 1) & ~(align - 1);
+                }
+                h->setLoadAddress(cur);
+                cur += h->getSize();
+            }
         }
 
         void ElfBinary::findSegments(){
@@ -459,10 +734,30 @@ namespace EPAX {
             return false;
         }
 
+        // a 64-bit host also runs the 32-bit code of its family
+        bool ElfBinary::isHostCode(){
+            uint32_t isa = fileheader->getISA();
+#if defined(__x86_64__)
+            return (isa == EM_X86_64 || isa == EM_386);
+#elif defined(__i386__)
+            return (isa == EM_386);
+#elif defined(__aarch64__)
+            return (isa == EM_AARCH64 || isa == EM_ARM);
+#elif defined(__arm__)
+            return (isa == EM_ARM);
+#else
+            return false;
+#endif
+        }
+
         bool ElfBinary::isExecutable(){
             return (fileheader->getFileType() == ET_EXEC);
         }
 
+        bool ElfBinary::isRelocatable(){
+            return (fileheader->getFileType() == ET_REL);
+        }
+
         void FileHeader::describe(){
             EPAXOut << "format=elf" << TAB;
             std::cout << "bits=" << DEC(getBits()) << TAB;
@@ -503,7 +798,8 @@ namespace EPAX {
 
         ElfSymbol::ElfSymbol(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i)
             : Symbol(b, o, s, i),
-              entry(INVALID_PTR)
+              entry(INVALID_PTR),
+              base(0)
         {
         }
 
@@ -515,7 +811,7 @@ namespace EPAX {
 
         void ElfStringTable::print(std::ostream& stream){
             stream << "ElfStringTable scn=" << DEC(getIndex()) << ENDL;
-            uint32_t cur = 1;
+            uint64_t cur = 1;
             while (cur < getFileSize()){
                 char* t = getStringAt(cur);
                 stream << TAB << "[" << DEC(cur) << "]" << TAB << t << ENDL;
@@ -547,18 +843,18 @@ namespace EPAX {
                       << ENDL;
         }
 
-        ElfSymbol32::ElfSymbol32(BaseBinary* b, uint64_t o, uint32_t i)
+        ElfSymbol32::ElfSymbol32(BaseBinary* b, uint64_t o, uint32_t i, const rawbyte_t* e)
             : ElfSymbol(b, o, sizeof(Elf32_Sym), i)
         {
             entry = (rawbyte_t*)new Elf32_Sym();
-            getInputFile()->getBytes(o, getFileSize(), entry);
+            memcpy(entry, e, getFileSize());
         }
 
-        ElfSymbol64::ElfSymbol64(BaseBinary* b, uint64_t o, uint32_t i)
+        ElfSymbol64::ElfSymbol64(BaseBinary* b, uint64_t o, uint32_t i, const rawbyte_t* e)
             : ElfSymbol(b, o, sizeof(Elf64_Sym), i)
         {
             entry = (rawbyte_t*)new Elf64_Sym();
-            getInputFile()->getBytes(o, getFileSize(), entry);
+            memcpy(entry, e, getFileSize());
         }
 
         uint64_t ElfSymbol32::getNameIndex(){
@@ -577,11 +873,11 @@ namespace EPAX {
             return SYM64_ENTRY->st_value;
         }
 
-        uint32_t ElfSymbol32::getSize(){
+        uint64_t ElfSymbol32::getSize(){
             return SYM32_ENTRY->st_size;
         }
 
-        uint32_t ElfSymbol64::getSize(){
+        uint64_t ElfSymbol64::getSize(){
             return SYM64_ENTRY->st_size;
         }
 
@@ -628,9 +924,29 @@ namespace EPAX {
         uint64_t ElfSymbol::getFunctionAddress(){
             EPAXAssert(isFunction(), "This may only call this for function symbols");
             if (isThumbFunction()){
-                return getValue() - 1;
+                return base + getValue() - 1;
             } else {
-                return getValue();
+                return base + getValue();
+            }
+        }
+
+        bool ElfSymbol::isMappingSymbol(){
+            if (getType() != STT_NOTYPE){
+                return false;
+            }
+            std::string n = getName();
+            return (n.size() >= 2 && n[0] == '$' && strchr("atxd", n[1]) != NULL && (n.size() == 2 || n[2] == '.'));
+        }
+
+        DisasmMode ElfSymbol::getMappingMode(){
+            switch (getName()[1]){
+            case 'a':
+            case 'x':
+                return DisasmMode_ARM;
+            case 't':
+                return DisasmMode_THUMB2;
+            default:
+                return DisasmMode_INVLD;
             }
         }
 
@@ -661,32 +977,47 @@ namespace EPAX {
             stringtab = st;
             EPAXAssert(IS_VALID_PTR(stringtab), "A symbol table in ELF requires a valid string table");
 
-            uint32_t tablesize = 0;
+            uint64_t entsize = (is32Bit()? sizeof(Elf32_Sym): sizeof(Elf64_Sym));
+            uint64_t count = getFileSize() / entsize;
+            EPAXAssert(count * entsize == getFileSize(), "Symbol table size (" << DEC(count * entsize) << ") does not match expected size (" << DEC(getFileSize()) << ")");
+
             symbols = new std::vector<Symbol*>();
+            symbols->reserve(count);
 
-            uint32_t cur = 0;
-            while (tablesize < getFileSize()){
-                ElfSymbol* e;
-                if (is32Bit()){
-                    e = new ElfSymbol32(getBinary(), getFileOffset() + tablesize, cur);
-                } else {
-                    e = new ElfSymbol64(getBinary(), getFileOffset() + tablesize, cur);
-                }
-                tablesize += e->getFileSize();
-                e->setName(st->getStringAt(e->getNameIndex()));
+            // read the table a window at a time, so that a large table is neither read
+            // one entry per call nor held whole
+            uint64_t perwindow = SYMBOL_WINDOW_SIZE / entsize;
+            rawbyte_t* window = new rawbyte_t[perwindow * entsize];
 
-                symbols->push_back(e);
-                cur++;
+            for (uint64_t first = 0; first < count; first += perwindow){
+                uint64_t n = count - first;
+                if (n > perwindow){
+                    n = perwindow;
+                }
+                uint64_t o = getFileOffset() + first * entsize;
+                getInputFile()->getBytes(o, n * entsize, window);
+
+                for (uint64_t j = 0; j < n; j++){
+                    ElfSymbol* e;
+                    if (is32Bit()){
+                        e = new ElfSymbol32(getBinary(), o + j * entsize, first + j, window + j * entsize);
+                    } else {
+                        e = new ElfSymbol64(getBinary(), o + j * entsize, first + j, window + j * entsize);
+                    }
+                    e->setName(st->getStringAt(e->getNameIndex()));
+                    symbols->push_back(e);
+                }
             }
 
-            EPAXAssert(tablesize == getFileSize(), "Symbol table size (" << DEC(tablesize) << ") does not match expected size (" << DEC(getFileSize()) << ")");
+            delete[] window;
         }
 
         SectionHeader::SectionHeader(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i)
             : FileBase(b, o, s),
               NameBase(),
               IndexBase(i),
-              entry(INVALID_PTR)
+              entry(INVALID_PTR),
+              placed(false), loadaddr(0)
         {
         }
 
@@ -732,7 +1063,7 @@ namespace EPAX {
         void SectionHeader::print(std::ostream& stream){
             stream << "ELF_SHDR [" << std::setw(2) << DEC(getIndex()) << "]"
                       << TAB << std::setw(18) << getName() 
-                      << TAB << HEX(getVirtAddr())
+                      << TAB << HEX(getLoadAddress())
                       << TAB << HEX(getSize())
                       << TAB << HEX(getFileOffset())
                       << TAB << std::setw(4) << DEC(getAlignment())
@@ -742,12 +1073,19 @@ namespace EPAX {
         }
 
         bool SectionHeader::inRange(uint64_t a){
-            if (a >= getVirtAddr() && a < getVirtAddr() + getSize()){
+            if (a >= getLoadAddress() && a < getLoadAddress() + getSize()){
                 return true;
             }
             return false;
         }
 
+        uint64_t SectionHeader::getLoadAddress(){
+            if (placed){
+                return loadaddr;
+            }
+            return getVirtAddr();
+        }
+
         bool SectionHeader::isText(){
             return (getType() == SHT_PROGBITS && isExec());
         }
@@ -772,6 +1110,10 @@ namespace EPAX {
             return (getType() == SHT_SYMTAB || getType() == SHT_DYNSYM);
         }
 
+        bool SectionHeader::isNote(){
+            return (getType() == SHT_NOTE);
+        }
+
         bool SectionHeader::isRead(){
             return true;
         }
@@ -943,11 +1285,11 @@ namespace EPAX {
             return PHDR64_ENTRY->p_flags;
         }
 
-        uint32_t ProgramHeader32::getAlignment(){
+        uint64_t ProgramHeader32::getAlignment(){
             return PHDR32_ENTRY->p_align;
         }
 
-        uint32_t ProgramHeader64::getAlignment(){
+        uint64_t ProgramHeader64::getAlignment(){
             return PHDR64_ENTRY->p_align;
         }
 
@@ -27,6 +27,7 @@
 #define __EPAX_ElfBinary_hpp__
 
 #include "BaseClass.hpp"
+#include "Instruction.hpp"
 #include "Section.hpp"
 #include "Symbol.hpp"
 
@@ -47,9 +48,22 @@ namespace EPAX {
             std::vector<SectionHeader*>* sections;
             bool foundsegments;
             std::vector<ProgramHeader*>* segments;
+
+            // regions marked by ARM mapping symbols, in address order
+            std::vector<CodeRegion>* coderegions;
+
+            void layoutSections();
+            void indexMappingSymbols();
+            void sweepFunctions();
         
         public:
             ElfBinary(std::string n);
+
+            /**
+             * Constructs an image from bytes other than a whole file, e.g. a member of
+             * an archive or an image in memory. Every read is relative to f.
+             */
+            ElfBinary(InputFile* f, bool own);
             virtual ~ElfBinary();
 
             virtual BinaryFormat getFormat() = 0;
@@ -69,9 +83,21 @@ namespace EPAX {
             bool is64Bit();
 
             bool isExecutable();
+            bool isHostCode();
+
+            /**
+             * A relocatable object (ET_REL) has no program headers and its sections are
+             * all at address 0. Its allocated sections are laid out one after another,
+             * as a linker would place them, and symbols are resolved relative to the
+             * section that holds them.
+             */
+            bool isRelocatable();
+
+            std::string getBuildID();
 
             ElfStringTable* findStringtable(uint32_t i);
             bool insideTextRange(uint64_t a);
+            bool findCodeRegions(uint64_t a, uint64_t s, std::vector<CodeRegion>& regions);
 
             void printSections(std::ostream& stream = std::cout);
             void printFunctions(std::ostream& stream = std::cout);
@@ -84,6 +110,7 @@ namespace EPAX {
         class ElfBinary32 : public ElfBinary {
         public:
             ElfBinary32(std::string n);
+            ElfBinary32(InputFile* f, bool own);
             virtual ~ElfBinary32() {}
 
             BinaryFormat getFormat() { return BinaryFormat_Elf32; }
@@ -92,6 +119,7 @@ namespace EPAX {
         class ElfBinary64 : public ElfBinary {
         public:
             ElfBinary64(std::string n);
+            ElfBinary64(InputFile* f, bool own);
             virtual ~ElfBinary64() {}
 
             BinaryFormat getFormat() { return BinaryFormat_Elf64; }
@@ -173,6 +201,9 @@ namespace EPAX {
         protected:
             rawbyte_t* entry;
 
+            // the address of the symbol's section, for section-relative values in ET_REL
+            uint64_t base;
+
         public:
             ElfSymbol(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i);
             virtual ~ElfSymbol();
@@ -182,7 +213,7 @@ namespace EPAX {
             virtual uint64_t getNameIndex() = 0;
             virtual uint64_t getValue() = 0;
             virtual uint32_t getSection() = 0;
-            virtual uint32_t getSize() = 0;
+            virtual uint64_t getSize() = 0;
             virtual uint32_t getType() = 0;
             virtual uint32_t getBinding() = 0;
             virtual uint64_t getVisibility() = 0;
@@ -190,17 +221,36 @@ namespace EPAX {
             bool isFunction();
             bool isThumbFunction();
             uint64_t getFunctionAddress();
+
+            /**
+             * ARM mapping symbols ($a, $t, $x and $d, optionally followed by .suffix)
+             * mark where ARM, Thumb or AArch64 code, or data, starts
+             */
+            bool isMappingSymbol();
+
+            /**
+             * @return the mode of the code a mapping symbol marks, or DisasmMode_INVLD for data
+             */
+            DisasmMode getMappingMode();
+
+            // the value, plus the section address for ET_REL
+            uint64_t getAddress() { return base + getValue(); }
+
+            void setBase(uint64_t b) { base = b; }
         }; // class ElfSymbol
 
         class ElfSymbol32 : public ElfSymbol {
         public:
-            ElfSymbol32(BaseBinary* b, uint64_t o, uint32_t i);
+            /**
+             * @param e the entry as read from the file; it is copied
+             */
+            ElfSymbol32(BaseBinary* b, uint64_t o, uint32_t i, const rawbyte_t* e);
             virtual ~ElfSymbol32() {}
 
             uint64_t getNameIndex();
             uint64_t getValue();
             uint32_t getSection();
-            uint32_t getSize();
+            uint64_t getSize();
             uint32_t getType();
             uint32_t getBinding();
             uint64_t getVisibility();
@@ -209,13 +259,13 @@ namespace EPAX {
 
         class ElfSymbol64 : public ElfSymbol {
         public:
-            ElfSymbol64(BaseBinary* b, uint64_t o, uint32_t i);
+            ElfSymbol64(BaseBinary* b, uint64_t o, uint32_t i, const rawbyte_t* e);
             virtual ~ElfSymbol64() {}
 
             uint64_t getNameIndex();
             uint64_t getValue();
             uint32_t getSection();
-            uint32_t getSize();
+            uint64_t getSize();
             uint32_t getType();
             uint32_t getBinding();
             uint64_t getVisibility();
@@ -251,6 +301,9 @@ namespace EPAX {
         protected:
             rawbyte_t* entry;
 
+            bool placed;
+            uint64_t loadaddr;
+
         public:
             SectionHeader(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i);
             virtual ~SectionHeader();
@@ -263,6 +316,7 @@ namespace EPAX {
             bool isDebug();
             bool isString();
             bool isSymbol();
+            bool isNote();
 
             bool isRead();
             bool isWrite();
@@ -272,6 +326,13 @@ namespace EPAX {
 
             bool inRange(uint64_t a);
 
+            /**
+             * Gets the address of the section: sh_addr, or in a relocatable object the
+             * address it was given by ElfBinary::layoutSections
+             */
+            uint64_t getLoadAddress();
+            void setLoadAddress(uint64_t a) { loadaddr = a; placed = true; }
+
             virtual uint64_t getNameIndex() = 0;
             virtual uint64_t getType() = 0;
             virtual uint64_t getVirtAddr() = 0;
@@ -335,7 +396,7 @@ namespace EPAX {
             virtual uint64_t getMSize() = 0;
             virtual uint32_t getSegmentType() = 0;
             virtual uint64_t getFlags() = 0;
-            virtual uint32_t getAlignment() = 0;
+            virtual uint64_t getAlignment() = 0;
             virtual uint64_t getFOffset() = 0;
         }; // class ProgramHeader
 
@@ -350,7 +411,7 @@ namespace EPAX {
             uint64_t getMSize();
             uint32_t getSegmentType();
             uint64_t getFlags();
-            uint32_t getAlignment();
+            uint64_t getAlignment();
             uint64_t getFOffset();
         }; // class ProgramHeader32
 
@@ -365,7 +426,7 @@ namespace EPAX {
             uint64_t getMSize();
             uint32_t getSegmentType();
             uint64_t getFlags();
-            uint32_t getAlignment();
+            uint64_t getAlignment();
             uint64_t getFOffset();
         }; // class ProgramHeader32
 
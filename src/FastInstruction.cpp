@@ -0,0 +1,500 @@
+/**
+ * @file FastInstruction.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "FastInstruction.hpp"
+#include "Function.hpp"
+
+// bits [28:25] of an A64 instruction select its top-level encoding group
+#define FAST_GROUP(w) (((w) >> 25) & 0xf)
+
+#define FAST_BIT_L (0x00400000)
+#define FAST_BIT_V (0x04000000)
+
+namespace EPAX {
+
+    typedef enum {
+        FastFlag_CondBranch   = 0x001,
+        FastFlag_UncondBranch = 0x002,
+        FastFlag_Fallthrough  = 0x004,
+        FastFlag_TouchesPC    = 0x008,
+        FastFlag_Return       = 0x010,
+        FastFlag_Call         = 0x020,
+        FastFlag_Fpop         = 0x040,
+        FastFlag_Load         = 0x080,
+        FastFlag_Store        = 0x100,
+        FastFlag_Neon         = 0x200,
+        FastFlag_Batched      = 0x400  // not in the table; set once the function's batch decode ran
+    } FastFlag;
+
+    // where a branch target is encoded
+    typedef enum {
+        FastTarget_None,
+        FastTarget_Imm26,     // B, BL
+        FastTarget_Imm19,     // B.cond, CBZ, CBNZ
+        FastTarget_Imm14      // TBZ, TBNZ
+    } FastTarget;
+
+    // where the operand widths are encoded
+    typedef enum {
+        FastWidth_None,
+        FastWidth_SF,         // sf: 32 or 64-bit general registers
+        FastWidth_Size,       // size of a general register access
+        FastWidth_Register,   // load/store register: size, or opc<1>:size for SIMD&FP registers
+        FastWidth_Literal,    // load literal: opc
+        FastWidth_Pair,       // load/store pair: opc
+        FastWidth_Structure,  // SIMD load/store structure: Q and size
+        FastWidth_ScalarFP,   // ftype
+        FastWidth_ScalarSIMD, // size
+        FastWidth_VectorFP,   // Q and sz
+        FastWidth_VectorSIMD  // Q and size
+    } FastWidth;
+
+    // instructions w with (w & mask) == value take the attributes of the row. if set,
+    // loadbit makes the instruction a load when it is set in w and a store otherwise,
+    // and fpbit makes it an FP/SIMD operation when it is set in w
+    typedef struct {
+        uint32_t mask;
+        uint32_t value;
+        uint32_t flags;
+        uint32_t loadbit;
+        uint32_t fpbit;
+        FastTarget target;
+        FastWidth width;
+    } FastDecodeRow;
+
+    // each table is searched in order, and ends with a row that matches anything
+
+    static const FastDecodeRow otherRows[] = {
+        { 0x00000000, 0x00000000, 0, 0, 0, FastTarget_None, FastWidth_None }
+    };
+
+    static const FastDecodeRow sveRows[] = {
+        { 0x00000000, 0x00000000, FastFlag_Fpop, 0, 0, FastTarget_None, FastWidth_None }
+    };
+
+    static const FastDecodeRow immediateRows[] = {
+        { 0x1f000000, 0x10000000, FastFlag_TouchesPC, 0, 0, FastTarget_None, FastWidth_None },                                            // ADR, ADRP
+        { 0x00000000, 0x00000000, 0, 0, 0, FastTarget_None, FastWidth_SF }
+    };
+
+    static const FastDecodeRow branchRows[] = {
+        { 0xfc000000, 0x14000000, FastFlag_UncondBranch | FastFlag_TouchesPC, 0, 0, FastTarget_Imm26, FastWidth_None },                   // B
+        { 0xfc000000, 0x94000000, FastFlag_UncondBranch | FastFlag_Call | FastFlag_Fallthrough | FastFlag_TouchesPC, 0, 0, FastTarget_Imm26, FastWidth_None }, // BL
+        { 0xff000000, 0x54000000, FastFlag_CondBranch | FastFlag_Fallthrough | FastFlag_TouchesPC, 0, 0, FastTarget_Imm19, FastWidth_None }, // B.cond
+        { 0x7e000000, 0x34000000, FastFlag_CondBranch | FastFlag_Fallthrough | FastFlag_TouchesPC, 0, 0, FastTarget_Imm19, FastWidth_SF },   // CBZ, CBNZ
+        { 0x7e000000, 0x36000000, FastFlag_CondBranch | FastFlag_Fallthrough | FastFlag_TouchesPC, 0, 0, FastTarget_Imm14, FastWidth_None }, // TBZ, TBNZ
+        { 0xffe00000, 0xd6400000, FastFlag_UncondBranch | FastFlag_Return | FastFlag_TouchesPC, 0, 0, FastTarget_None, FastWidth_None },  // RET, RETAA, RETAB
+        { 0xffe00000, 0xd6800000, FastFlag_UncondBranch | FastFlag_Return | FastFlag_TouchesPC, 0, 0, FastTarget_None, FastWidth_None },  // ERET
+        { 0xfee00000, 0xd6200000, FastFlag_UncondBranch | FastFlag_Call | FastFlag_Fallthrough | FastFlag_TouchesPC, 0, 0, FastTarget_None, FastWidth_None }, // BLR, BLRAA, ...
+        { 0xfee00000, 0xd6000000, FastFlag_UncondBranch | FastFlag_TouchesPC, 0, 0, FastTarget_None, FastWidth_None },                    // BR, BRAA, ...
+        { 0x00000000, 0x00000000, 0, 0, 0, FastTarget_None, FastWidth_None }                                                              // system, exceptions
+    };
+
+    static const FastDecodeRow memoryRows[] = {
+        { 0xbe000000, 0x0c000000, FastFlag_Fpop | FastFlag_Neon, FAST_BIT_L, 0, FastTarget_None, FastWidth_Structure },                                  // SIMD load/store structures
+        { 0x3f000000, 0x08000000, 0, FAST_BIT_L, 0, FastTarget_None, FastWidth_Size },                                                   // exclusive, ordered, CAS
+        { 0x3b000000, 0x18000000, FastFlag_Load, 0, FAST_BIT_V, FastTarget_None, FastWidth_Literal },                                    // load literal
+        { 0x3a000000, 0x28000000, 0, FAST_BIT_L, FAST_BIT_V, FastTarget_None, FastWidth_Pair },                                          // load/store pair
+        { 0x3f200c00, 0x38200000, FastFlag_Load | FastFlag_Store, 0, 0, FastTarget_None, FastWidth_Size },                               // atomic memory operations
+        { 0x3e800000, 0x38800000, FastFlag_Load, 0, 0, FastTarget_None, FastWidth_Size },                                                // sign-extending loads, PRFM
+        { 0x3a000000, 0x38000000, 0, FAST_BIT_L, FAST_BIT_V, FastTarget_None, FastWidth_Register },                                      // load/store register
+        { 0x00000000, 0x00000000, 0, 0, 0, FastTarget_None, FastWidth_None }
+    };
+
+    static const FastDecodeRow registerRows[] = {
+        { 0x00000000, 0x00000000, 0, 0, 0, FastTarget_None, FastWidth_SF }
+    };
+
+    static const FastDecodeRow simdRows[] = {
+        { 0x5e000000, 0x1e000000, FastFlag_Fpop, 0, 0, FastTarget_None, FastWidth_ScalarFP },                                            // scalar floating-point
+        { 0xde000000, 0x5e000000, FastFlag_Fpop | FastFlag_Neon, 0, 0, FastTarget_None, FastWidth_ScalarSIMD },                                          // SIMD scalar
+        { 0x9f20c400, 0x0e20c400, FastFlag_Fpop | FastFlag_Neon, 0, 0, FastTarget_None, FastWidth_VectorFP },                                            // SIMD three same, floating-point
+        { 0x9e000000, 0x0e000000, FastFlag_Fpop | FastFlag_Neon, 0, 0, FastTarget_None, FastWidth_VectorSIMD },                                          // SIMD vector
+        { 0x00000000, 0x00000000, FastFlag_Fpop, 0, 0, FastTarget_None, FastWidth_None }
+    };
+
+    // indexed by FAST_GROUP
+    static const FastDecodeRow* const decodeGroups[16] = {
+        otherRows,      // 0000 reserved, SME
+        otherRows,      // 0001 unallocated
+        sveRows,        // 0010 SVE
+        otherRows,      // 0011 unallocated
+        memoryRows,     // 0100
+        registerRows,   // 0101
+        memoryRows,     // 0110
+        simdRows,       // 0111
+        immediateRows,  // 1000
+        immediateRows,  // 1001
+        branchRows,     // 1010
+        branchRows,     // 1011
+        memoryRows,     // 1100
+        registerRows,   // 1101
+        memoryRows,     // 1110
+        simdRows        // 1111
+    };
+
+    static const FastDecodeRow* findRow(uint32_t w){
+        const FastDecodeRow* row = decodeGroups[FAST_GROUP(w)];
+        while ((w & row->mask) != row->value){
+            row++;
+        }
+        return row;
+    }
+
+    static uint64_t decodeTarget(uint64_t addr, uint32_t w, FastTarget target){
+        int64_t imm;
+        switch (target){
+        case FastTarget_Imm26:
+            imm = (int32_t)(w << 6) >> 6;
+            break;
+        case FastTarget_Imm19:
+            imm = (int32_t)(w << 8) >> 13;
+            break;
+        case FastTarget_Imm14:
+            imm = (int32_t)(w << 13) >> 18;
+            break;
+        default:
+            return INVALID_ADDRESS;
+        }
+        return addr + (imm * 4);
+    }
+
+    static void decodeWidths(uint32_t w, FastWidth width, uint32_t& reg, uint32_t& data){
+        static const uint32_t ftypeBits[4] = { 32, 64, 0, 16 };
+
+        uint32_t top = (w >> 30);
+        uint32_t q = (w >> 30) & 1;
+        uint32_t size = (w >> 22) & 3;
+        bool v = (w & FAST_BIT_V) != 0;
+
+        reg = 0;
+        data = 0;
+        switch (width){
+        case FastWidth_SF:
+            reg = (w >> 31)? 64: 32;
+            data = reg;
+            break;
+        case FastWidth_Size:
+            reg = 8 << top;
+            data = reg;
+            break;
+        case FastWidth_Register:
+            reg = v? (8 << ((((w >> 23) & 1) << 2) | top)): (8 << top);
+            data = reg;
+            break;
+        case FastWidth_Literal:
+            reg = v? (32 << top): (top == 1? 64: 32);
+            data = reg;
+            break;
+        case FastWidth_Pair:
+            reg = v? (32 << top): ((top & 2)? 64: 32);
+            data = reg;
+            break;
+        case FastWidth_Structure:
+            reg = q? 128: 64;
+            data = 8 << ((w >> 10) & 3);
+            break;
+        case FastWidth_ScalarFP:
+            reg = ftypeBits[size];
+            data = reg;
+            break;
+        case FastWidth_ScalarSIMD:
+            reg = 8 << size;
+            data = reg;
+            break;
+        case FastWidth_VectorFP:
+            reg = q? 128: 64;
+            data = (size & 1)? 64: 32;
+            break;
+        case FastWidth_VectorSIMD:
+            reg = q? 128: 64;
+            data = 8 << size;
+            break;
+        default:
+            break;
+        }
+    }
+
+    // full decodes of single instructions share one set of disassembler handles, and
+    // every instruction's full decode is handed over under fulllock
+    static std::vector<void*> fullhandlers;
+    static pthread_mutex_t fulllock = PTHREAD_MUTEX_INITIALIZER;
+
+    // batched decodes use disassembler handles of their own thread, so they do not wait on fulllock
+    static pthread_key_t threadhandlerkey;
+    static pthread_once_t threadhandleronce = PTHREAD_ONCE_INIT;
+
+    static void deleteThreadHandlers(void* h){
+        std::vector<void*>* handlers = (std::vector<void*>*)h;
+        Instruction::freedisasm(*handlers);
+        delete handlers;
+    }
+
+    static void createThreadHandlerKey(){
+        pthread_key_create(&threadhandlerkey, deleteThreadHandlers);
+    }
+
+    static std::vector<void*>& getThreadHandlers(){
+        pthread_once(&threadhandleronce, createThreadHandlerKey);
+        std::vector<void*>* handlers = (std::vector<void*>*)pthread_getspecific(threadhandlerkey);
+        if (handlers == NULL){
+            handlers = new std::vector<void*>();
+            pthread_setspecific(threadhandlerkey, handlers);
+        }
+        return *handlers;
+    }
+
+    static bool compareAddress(FastInstruction* a, FastInstruction* b){
+        return (a->getMemoryAddress() < b->getMemoryAddress());
+    }
+
+    FastInstruction::FastInstruction(uint64_t a, uint32_t w, Function* func)
+        : Instruction(a, INVALID_PTR, func),
+          word(w), flags(0), condition(PredCondition_AL), branchtarget(INVALID_ADDRESS),
+          srcregbits(0), srcdatabits(0),
+          full(INVALID_PTR)
+    {
+        setMemorySize(4);
+        setBasicBlock(INVALID_PTR);
+
+        const FastDecodeRow* row = findRow(w);
+        flags = row->flags;
+        if (row->loadbit){
+            flags |= (w & row->loadbit)? FastFlag_Load: FastFlag_Store;
+        }
+        if (row->fpbit && (w & row->fpbit)){
+            flags |= FastFlag_Fpop;
+        }
+
+        // B.cond; the AArch64 condition codes are numbered as PredCondition, with NV as AL
+        if (row->target == FastTarget_Imm19 && (w & 0xff000000) == 0x54000000){
+            condition = (PredCondition)(w & 0xf);
+            if (condition > PredCondition_AL){
+                condition = PredCondition_AL;
+            }
+        }
+
+        branchtarget = decodeTarget(a, w, row->target);
+        decodeWidths(w, row->width, srcregbits, srcdatabits);
+    }
+
+    FastInstruction::~FastInstruction(){
+        if (IS_VALID_PTR(full)){
+            delete full;
+        }
+    }
+
+    void FastInstruction::classify(rawbyte_t* buf, uint64_t addr, const uint32_t size, std::vector<Instruction*>& insns, fastmap<uint64_t, uint32_t>::map& insn_map, Function* func){
+        for (uint32_t cur = 0; cur + 4 <= size; cur += 4){
+            // A64 instructions are little-endian whatever the byte order of data
+            const uint8_t* b = (const uint8_t*)(buf + cur);
+            uint32_t w = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+
+            insn_map[addr + cur] = insns.size();
+            insns.push_back(new FastInstruction(addr + cur, w, func));
+        }
+    }
+
+    void FastInstruction::decodeFunction(Function* func){
+        std::vector<FastInstruction*> insns;
+        for (uint32_t i = 0; i < func->countInstructions(); i++){
+            FastInstruction* f = dynamic_cast<FastInstruction*>(func->getInstruction(i));
+            if (f != NULL){
+                insns.push_back(f);
+            }
+        }
+        std::sort(insns.begin(), insns.end(), compareAddress);
+
+        // decode each run of adjacent instructions with one call, from the words already held
+        std::vector<Instruction*> decoded;
+        std::vector<rawbyte_t> bytes;
+        std::vector<void*>& handlers = getThreadHandlers();
+        for (uint32_t i = 0; i < insns.size(); ){
+            uint32_t j = i + 1;
+            while (j < insns.size() && insns[j]->getMemoryAddress() == insns[j-1]->getMemoryAddress() + 4){
+                j++;
+            }
+
+            bytes.resize((j - i) * 4);
+            for (uint32_t k = i; k < j; k++){
+                for (uint32_t b = 0; b < 4; b++){
+                    bytes[(k - i) * 4 + b] = (insns[k]->word >> (b * 8)) & 0xff;
+                }
+            }
+
+            fastmap<uint64_t, uint32_t>::map insn_map;
+            Instruction::disassemble(&bytes[0], insns[i]->getMemoryAddress(), bytes.size(), decoded, insn_map, DisasmMode_ARM, func, handlers, true);
+            i = j;
+        }
+
+        // hand each decode to its instruction; another thread may have been first
+        std::vector<Instruction*> unused;
+        pthread_mutex_lock(&fulllock);
+        uint32_t cur = 0;
+        for (std::vector<Instruction*>::const_iterator it = decoded.begin(); it != decoded.end(); it++){
+            while (cur < insns.size() && insns[cur]->getMemoryAddress() < (*it)->getMemoryAddress()){
+                cur++;
+            }
+            if (cur < insns.size() && insns[cur]->getMemoryAddress() == (*it)->getMemoryAddress() && !IS_VALID_PTR(insns[cur]->full)){
+                insns[cur]->full = (*it);
+            } else {
+                unused.push_back(*it);
+            }
+        }
+        for (std::vector<FastInstruction*>::const_iterator it = insns.begin(); it != insns.end(); it++){
+            (*it)->flags |= FastFlag_Batched;
+        }
+        pthread_mutex_unlock(&fulllock);
+
+        for (std::vector<Instruction*>::const_iterator it = unused.begin(); it != unused.end(); it++){
+            delete (*it);
+        }
+    }
+
+    Instruction* FastInstruction::getFull(){
+        // the first instruction of a function to be asked for decodes the whole function
+        pthread_mutex_lock(&fulllock);
+        bool batch = (!IS_VALID_PTR(full) && !(flags & FastFlag_Batched) && IS_VALID_PTR(function));
+        pthread_mutex_unlock(&fulllock);
+        if (batch){
+            decodeFunction(function);
+        }
+
+        pthread_mutex_lock(&fulllock);
+        if (!IS_VALID_PTR(full)){
+            rawbyte_t bytes[4];
+            for (uint32_t i = 0; i < 4; i++){
+                bytes[i] = (word >> (i * 8)) & 0xff;
+            }
+
+            std::vector<Instruction*> insns;
+            fastmap<uint64_t, uint32_t>::map insn_map;
+            Instruction::disassemble(bytes, getMemoryAddress(), 4, insns, insn_map, DisasmMode_ARM, function, fullhandlers, true);
+            for (uint32_t i = 0; i < insns.size(); i++){
+                if (i == 0){
+                    full = insns[i];
+                } else {
+                    delete insns[i];
+                }
+            }
+        }
+        pthread_mutex_unlock(&fulllock);
+        return full;
+    }
+
+    bool FastInstruction::isConditionalBranch(){
+        return (flags & FastFlag_CondBranch) != 0;
+    }
+
+    bool FastInstruction::isUnconditionalBranch(){
+        return (flags & FastFlag_UncondBranch) != 0;
+    }
+
+    bool FastInstruction::hasFallthrough(){
+        return (flags & (FastFlag_UncondBranch | FastFlag_Fallthrough)) != FastFlag_UncondBranch;
+    }
+
+    bool FastInstruction::touchesPC(){
+        return (flags & FastFlag_TouchesPC) != 0;
+    }
+
+    bool FastInstruction::isReturn(){
+        return (flags & FastFlag_Return) != 0;
+    }
+
+    bool FastInstruction::isCall(){
+        return (flags & FastFlag_Call) != 0;
+    }
+
+    bool FastInstruction::isFpop(){
+        return (flags & FastFlag_Fpop) != 0;
+    }
+
+    bool FastInstruction::isLoad(){
+        return (flags & FastFlag_Load) != 0;
+    }
+
+    bool FastInstruction::isStore(){
+        return (flags & FastFlag_Store) != 0;
+    }
+
+    uint64_t FastInstruction::fallthroughTarget(){
+        if (hasFallthrough()){
+            return getMemoryAddress() + getMemorySize();
+        }
+        return INVALID_ADDRESS;
+    }
+
+    // a call's target is another function's, so only its fallthrough stays in this one
+    uint32_t FastInstruction::getControlTargets(std::vector<uint64_t>& tgts){
+        uint32_t count = 0;
+        if (!isCall() && branchtarget != INVALID_ADDRESS){
+            tgts.push_back(branchtarget);
+            count++;
+        }
+        if (hasFallthrough()){
+            tgts.push_back(fallthroughTarget());
+            count++;
+        }
+        return count;
+    }
+
+    std::string FastInstruction::stringRep(){
+        Instruction* f = getFull();
+        if (IS_VALID_PTR(f)){
+            return f->stringRep();
+        }
+        return std::string();
+    }
+
+    void FastInstruction::print(std::ostream& stream){
+        stream << HEX(getMemoryAddress()) << TAB << stringRep() << ENDL;
+    }
+
+    // the groups the table can tell apart, named as the disassembler names them
+    uint32_t FastInstruction::getGroupNames(std::vector<std::string>& cls){
+        uint32_t count = 0;
+        if (isCall()){
+            cls.push_back("call");
+            count++;
+        } else if (isReturn()){
+            cls.push_back("ret");
+            count++;
+        } else if (isBranch()){
+            cls.push_back("jump");
+            count++;
+        }
+        if (flags & FastFlag_Neon){
+            cls.push_back("neon");
+            count++;
+        } else if (flags & FastFlag_Fpop){
+            cls.push_back("fparmv8");
+            count++;
+        }
+        return count;
+    }
+
+} // namespace EPAX
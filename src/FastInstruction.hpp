@@ -0,0 +1,93 @@
+/**
+ * @file FastInstruction.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_FastInstruction_hpp__
+#define __EPAX_FastInstruction_hpp__
+
+#include "BaseClass.hpp"
+#include "Instruction.hpp"
+
+namespace EPAX {
+
+    class Function;
+
+    /**
+     * An AArch64 instruction classified from a decode table instead of the full
+     * disassembler. The table gives what block formation and the static counts need:
+     * the kind of branch and its target, loads and stores, FP/SIMD and operand widths.
+     * Group names also come from the table, so they are coarser than the disassembler's
+     * (jump, call, ret, neon and fparmv8 only). The text of the instruction comes from a
+     * full decode, done for all instructions of its function the first time the text of
+     * any of them is asked for.
+     */
+    class FastInstruction : public Instruction {
+    private:
+        uint32_t word;
+        uint32_t flags;
+        PredCondition condition;
+        uint64_t branchtarget;
+        uint32_t srcregbits;
+        uint32_t srcdatabits;
+        Instruction* full;
+
+        Instruction* getFull();
+        static void decodeFunction(Function* func);
+
+    public:
+        FastInstruction(uint64_t a, uint32_t w, Function* func);
+        virtual ~FastInstruction();
+
+        /**
+         * Classifies the AArch64 instructions in buf, as Instruction::disassemble would decode them
+         */
+        static void classify(rawbyte_t* buf, uint64_t addr, const uint32_t size, std::vector<Instruction*>& insns, fastmap<uint64_t, uint32_t>::map& insn_map, Function* func);
+
+        PredCondition getCondition() { return condition; }
+
+        bool isConditionalBranch();
+        bool isUnconditionalBranch();
+        bool hasFallthrough();
+        bool touchesPC();
+        bool isReturn();
+        bool isCall();
+        uint64_t fallthroughTarget();
+        uint64_t getBranchTarget() { return branchtarget; }
+        uint32_t getControlTargets(std::vector<uint64_t>& tgts);
+
+        bool isFpop();
+        bool isLoad();
+        bool isStore();
+
+        uint32_t getSourceRegisterSizeInBits() { return srcregbits; }
+        uint32_t getSourceDatatypeSizeInBits() { return srcdatabits; }
+
+        std::string stringRep();
+        void print(std::ostream& stream = std::cout);
+
+        uint32_t getGroupNames(std::vector<std::string>& cls);
+    }; // class FastInstruction
+
+} // namespace EPAX
+
+#endif // __EPAX_FastInstruction_hpp__
@@ -26,13 +26,52 @@
 
 #include "BasicBlock.hpp"
 #include "ControlFlow.hpp"
+#include "FastInstruction.hpp"
 #include "Function.hpp"
 #include "InputFile.hpp"
 #include "Instruction.hpp"
 #include "Symbol.hpp"
 
+// sets of disassembler handles kept for reuse, per instruction set family
+#define HANDLER_POOL_SIZE (64)
+
 namespace EPAX {
 
+    // handles of destroyed functions, indexed by isARMv8; guarded by poollock
+    static std::vector<std::vector<void*> > handlerpool[2];
+    static pthread_mutex_t poollock = PTHREAD_MUTEX_INITIALIZER;
+
+    // takes a set of handles that a destroyed function left behind, if there is one
+    static void acquireHandlers(std::vector<void*>& h, bool isv8){
+        pthread_mutex_lock(&poollock);
+        std::vector<std::vector<void*> >& pool = handlerpool[isv8? 1: 0];
+        if (pool.size()){
+            h.swap(pool.back());
+            pool.pop_back();
+        }
+        pthread_mutex_unlock(&poollock);
+    }
+
+    // keeps h for the next function to disassemble, or frees it if enough are kept already
+    static void releaseHandlers(std::vector<void*>& h, bool isv8){
+        if (h.empty()){
+            return;
+        }
+
+        pthread_mutex_lock(&poollock);
+        std::vector<std::vector<void*> >& pool = handlerpool[isv8? 1: 0];
+        bool keep = (pool.size() < HANDLER_POOL_SIZE);
+        if (keep){
+            pool.push_back(std::vector<void*>());
+            pool.back().swap(h);
+        }
+        pthread_mutex_unlock(&poollock);
+
+        if (!keep){
+            Instruction::freedisasm(h);
+        }
+    }
+
     DetachedText::DetachedText(BaseBinary* b, uint64_t o, uint64_t s, uint64_t a, uint32_t i)
         : FileBase(b, o, s),
           MemoryBase(a, s),
@@ -41,36 +80,103 @@ namespace EPAX {
     }
 
     DisasmMode Function::disassembleMode(){
+        if (isDetached()){
+            return mode;
+        }
+
         Symbol* sym = getSymbol();
         if (IS_VALID_PTR(sym) && sym->isThumbFunction()){
             return DisasmMode_THUMB2;
         }
-        return DisasmMode_ARM;
+        return mode;
     }
 
     void Function::disasm(std::vector<BasicBlock*>& bbs){
-        if (getFileOffset() == 0){
+        if (getFileOffset() == 0 && !isDetached()){
             return;
         }
 
-        uint32_t limit = getMemorySize();
-        rawbyte_t* buf = new rawbyte_t[limit];
-        getInputFile()->getBytes(getFileOffset(), limit, buf);
+        // the decoders take 32-bit sizes; a larger function is a bogus symbol size
+        uint64_t limit = getMemorySize();
+        if (limit > 0xffffffff){
+            EPAXWarn << "Only decoding the first 4 GB of function " << getName() << " (size " << HEX(limit) << ")" << ENDL;
+            limit = 0xffffffff;
+        }
+
+        // decode in place if the bytes are already in memory
+        rawbyte_t* copy = NULL;
+        rawbyte_t* buf = (rawbyte_t*)detached;
+        if (!IS_VALID_PTR(buf)){
+            buf = (rawbyte_t*)getInputFile()->getView(getFileOffset(), limit);
+        }
+        if (buf == NULL){
+            copy = new rawbyte_t[limit];
+            getInputFile()->getBytes(getFileOffset(), limit, copy);
+            buf = copy;
+        }
 
         std::vector<Instruction*> insns;
         fastmap<uint64_t, uint32_t>::map insn_map;
 
         DisasmMode mode = disassembleMode();
+        if (handlers.empty() && !isFastDecode()){
+            acquireHandlers(handlers, isARMv8);
+        }
+
+        // mapping symbols split the function into code of either instruction set and
+        // literal pools, which are not decoded
+        std::vector<CodeRegion> regions;
+        if (!isDetached()){
+            getBinary()->findCodeRegions(getMemoryAddress(), limit, regions);
+        }
+
+        if (regions.empty()){
+            disasmRange(buf, getMemoryAddress(), getMemoryAddress() + limit, mode, insns, insn_map);
+        } else {
+            uint64_t cur = getMemoryAddress();
+            for (std::vector<CodeRegion>::const_iterator it = regions.begin(); it != regions.end(); it++){
+                if (it->start > cur){
+                    disasmRange(buf, cur, it->start, mode, insns, insn_map);
+                }
+                if (it->mode != DisasmMode_INVLD){
+                    disasmRange(buf, it->start, it->end, it->mode, insns, insn_map);
+                }
+                cur = it->end;
+            }
+            if (cur < getMemoryAddress() + limit){
+                disasmRange(buf, cur, getMemoryAddress() + limit, mode, insns, insn_map);
+            }
+        }
 
-        // TODO: seems like this should be a member of Function instead
-        if (isARMv8){
-            Instruction::disassemble(buf, getMemoryAddress(), limit, insns, insn_map, mode, this, handlers, isARMv8);
-        }  else {
-            Instruction::disassemble(buf, getMemoryAddress(), limit, insns, insn_map, mode, this, handlers, isARMv8);
+        if (copy != NULL){
+            delete[] copy;
         }
 
-        delete[] buf;
+        formBlocks(insns, insn_map, bbs);
+    }
+
+    // decodes [start, end) of the function, whose bytes begin at buf, and appends the result to insns
+    void Function::disasmRange(rawbyte_t* buf, uint64_t start, uint64_t end, DisasmMode mode, std::vector<Instruction*>& insns, fastmap<uint64_t, uint32_t>::map& insn_map){
+        std::vector<Instruction*> region;
+        fastmap<uint64_t, uint32_t>::map region_map;
+        if (isFastDecode()){
+            FastInstruction::classify(buf + (start - getMemoryAddress()), start, end - start, region, region_map, this);
+        } else {
+            Instruction::disassemble(buf + (start - getMemoryAddress()), start, end - start, region, region_map, mode, this, handlers, isARMv8);
+        }
 
+        for (std::vector<Instruction*>::const_iterator it = region.begin(); it != region.end(); it++){
+            insn_map[(*it)->getMemoryAddress()] = insns.size();
+            insns.push_back(*it);
+        }
+    }
+
+    bool Function::isFastDecode(){
+        return isARMv8 && !isDetached() && getBinary()->isFastDecode();
+    }
+
+    // partitions insns, which are in address order and indexed by insn_map, into basic blocks
+    void Function::formBlocks(std::vector<Instruction*>& insns, fastmap<uint64_t, uint32_t>::map& insn_map, std::vector<BasicBlock*>& bbs){
         // no instructions found
         if (insns.size() == 0){
             return;
@@ -87,16 +193,17 @@ namespace EPAX {
 
             if (insn->isBranch()){
 
-                // the instruction after a branch is a leader
+                // the instruction after a branch is a leader. either address can miss
+                // an instruction, e.g. when it falls in a literal pool
                 uint64_t ft = insn->getMemoryAddress() + insn->getMemorySize();
 
-                if (inRange(ft)){
+                if (inRange(ft) && insn_map.count(ft)){
                     leaders[insn_map[ft]] = true;
                 }
 
                 // branch target is a leader
                 uint64_t tgt = insn->getBranchTarget();
-                if (inRange(tgt)){
+                if (inRange(tgt) && insn_map.count(tgt)){
                     leaders[insn_map[tgt]] = true;
                 }
             }
@@ -127,20 +234,53 @@ namespace EPAX {
           SymbolBase(y),
           EPAXExport(EPAXExportClass_FUNC),
           controlflow(INVALID_PTR),
-          isARMv8(isv8)
+          isARMv8(isv8),
+          detached(INVALID_PTR), mode(DisasmMode_ARM)
     {
         if (IS_VALID_PTR(getSymbol())){
             EPAXAssert(getSymbol()->isFunction(), "Functions have to be tied to function symbols");
         }
     }
 
+    Function::Function(const rawbyte_t* bytes, uint64_t s, uint64_t a, DisasmMode m, bool isv8)
+        : DetachedText(INVALID_PTR, 0, s, a, 0),
+          SymbolBase(INVALID_PTR),
+          EPAXExport(EPAXExportClass_FUNC),
+          controlflow(INVALID_PTR),
+          isARMv8(isv8),
+          detached(bytes), mode(m)
+    {
+        EPAXAssert(IS_VALID_PTR(detached), "Detached functions need instruction bytes");
+    }
+
     Function::~Function(){
-        Instruction::freedisasm(handlers);
+        releaseHandlers(handlers, isARMv8);
         if (IS_VALID_PTR(controlflow)){
             delete controlflow;
         }
     }
 
+    Range<BasicBlock> Function::blocks(){
+        if (IS_VALID_PTR(controlflow)){
+            return controlflow->blocks();
+        }
+        return Range<BasicBlock>();
+    }
+
+    Range<Instruction> Function::instructions(){
+        if (IS_VALID_PTR(controlflow)){
+            return controlflow->instructions();
+        }
+        return Range<Instruction>();
+    }
+
+    Range<Loop> Function::loops(){
+        if (IS_VALID_PTR(controlflow)){
+            return controlflow->loops();
+        }
+        return Range<Loop>();
+    }
+
     void Function::disassemble(){
         std::vector<BasicBlock*> bbs;
         disasm(bbs);
@@ -148,6 +288,23 @@ namespace EPAX {
         //print();
     }
 
+    void Function::disassemble(std::vector<Instruction*>& insns){
+        fastmap<uint64_t, uint32_t>::map insn_map;
+        for (uint32_t i = 0; i < insns.size(); i++){
+            insns[i]->setFunction(this);
+            insn_map[insns[i]->getMemoryAddress()] = i;
+        }
+
+        std::vector<BasicBlock*> bbs;
+        formBlocks(insns, insn_map, bbs);
+        controlflow = new ControlFlow(this, bbs);
+    }
+
+    void Function::setControlFlow(ControlFlow* c){
+        EPAXAssert(!IS_VALID_PTR(controlflow), "Function " << getName() << " already has a ControlFlow");
+        controlflow = c;
+    }
+
     void Function::printHeader(std::ostream& stream){
         stream << "FUNC [" << std::setw(2) << "ID" << "]"
                << TAB << "VIRTADDR"
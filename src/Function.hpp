@@ -28,12 +28,14 @@
 
 #include "BaseClass.hpp"
 #include "Instruction.hpp"
+#include "EPAXRange.hpp"
 
 namespace EPAX {
 
     class BaseBinary;
     class BasicBlock;
     class ControlFlow;
+    class Loop;
     class Symbol;
 
     class DetachedText : public FileBase, public MemoryBase, public IndexBase {
@@ -52,17 +54,44 @@ namespace EPAX {
     private:
         bool isARMv8;
         ControlFlow* controlflow;
+
+        // the caller's buffer of a function built from raw bytes
+        const rawbyte_t* detached;
+        // the instruction set when the symbol (if any) does not say otherwise
+        DisasmMode mode;
+
         void disasm(std::vector<BasicBlock*>& bbs);
-        DisasmMode disassembleMode();
+        void disasmRange(rawbyte_t* buf, uint64_t start, uint64_t end, DisasmMode mode, std::vector<Instruction*>& insns, fastmap<uint64_t, uint32_t>::map& insn_map);
+        void formBlocks(std::vector<Instruction*>& insns, fastmap<uint64_t, uint32_t>::map& insn_map, std::vector<BasicBlock*>& bbs);
 
     public:
         Function(BaseBinary* b, uint64_t o, uint64_t s, uint64_t a, uint32_t i, Symbol* y, bool isv8);
+
+        /**
+         * Constructs a function that belongs to no binary from raw instruction bytes,
+         * which are decoded in place and so must outlive the function
+         *
+         * @param bytes the instruction bytes
+         * @param s the size of bytes
+         * @param a the address of the first byte
+         * @param m the instruction set (DisasmMode_ARM or DisasmMode_THUMB2; ignored if isv8)
+         * @param isv8 whether the bytes are AArch64 code
+         */
+        Function(const rawbyte_t* bytes, uint64_t s, uint64_t a, DisasmMode m, bool isv8);
         virtual ~Function();
 
+        bool isDetached() { return IS_VALID_PTR(detached); }
+
+        // whether the instructions are classified from the decode table (see FastInstruction)
+        bool isFastDecode();
+
         void print(std::ostream& stream = std::cout);
         static void printHeader(std::ostream& stream = std::cout);
 
         ControlFlow* getControlFlow() { return controlflow; }
+        void setControlFlow(ControlFlow* c);
+
+        bool isV8() { return isARMv8; }
 
         uint32_t countBasicBlocks();
         BasicBlock* findBasicBlock(uint64_t addr);
@@ -72,7 +101,27 @@ namespace EPAX {
         Instruction* findInstruction(uint64_t addr);
         Instruction* getInstruction(uint32_t idx);
 
+        Range<BasicBlock> blocks();
+        Range<Instruction> instructions();
+        Range<Loop> loops();
+
+        DisasmMode disassembleMode();
+
+        /**
+         * Sets the instruction set for a function whose symbol cannot give it, e.g. one
+         * found only through a table of function starts that marks Thumb code
+         */
+        void setDisassembleMode(DisasmMode m) { mode = m; }
+
         void disassemble();
+
+        /**
+         * Builds blocks and control flow from instructions that were already decoded,
+         * e.g. by a LinearSweep of the function's section. The function takes them over.
+         *
+         * @param insns the function's instructions, in address order
+         */
+        void disassemble(std::vector<Instruction*>& insns);
     }; // class Function
 
 } // namespace EPAX
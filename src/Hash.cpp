@@ -0,0 +1,161 @@
+/**
+ * @file Hash.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "Hash.hpp"
+#include "InputFile.hpp"
+
+namespace EPAX {
+
+#define ROTL32(__v, __n) (((__v) << (__n)) | ((__v) >> (32 - (__n))))
+#define HASH_CHUNK_SIZE (1 << 20)
+
+    std::string toHexString(const uint8_t* data, uint32_t size){
+        static const char* digits = "0123456789abcdef";
+        std::string s;
+        for (uint32_t i = 0; i < size; i++){
+            s.push_back(digits[data[i] >> 4]);
+            s.push_back(digits[data[i] & 0xf]);
+        }
+        return s;
+    }
+
+    SHA1::SHA1()
+        : length(0), used(0)
+    {
+        state[0] = 0x67452301;
+        state[1] = 0xefcdab89;
+        state[2] = 0x98badcfe;
+        state[3] = 0x10325476;
+        state[4] = 0xc3d2e1f0;
+    }
+
+    void SHA1::transform(const uint8_t* b){
+        uint32_t w[80];
+        for (uint32_t i = 0; i < 16; i++){
+            w[i] = ((uint32_t)b[i*4] << 24) | ((uint32_t)b[i*4+1] << 16) | ((uint32_t)b[i*4+2] << 8) | (uint32_t)b[i*4+3];
+        }
+        for (uint32_t i = 16; i < 80; i++){
+            uint32_t t = w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16];
+            w[i] = ROTL32(t, 1);
+        }
+
+        uint32_t a = state[0], bb = state[1], c = state[2], d = state[3], e = state[4];
+        for (uint32_t i = 0; i < 80; i++){
+            uint32_t f, k;
+            if (i < 20){
+                f = (bb & c) | (~bb & d);
+                k = 0x5a827999;
+            } else if (i < 40){
+                f = bb ^ c ^ d;
+                k = 0x6ed9eba1;
+            } else if (i < 60){
+                f = (bb & c) | (bb & d) | (c & d);
+                k = 0x8f1bbcdc;
+            } else {
+                f = bb ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+            uint32_t t = ROTL32(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = ROTL32(bb, 30);
+            bb = a;
+            a = t;
+        }
+
+        state[0] += a;
+        state[1] += bb;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    void SHA1::update(const void* data, uint64_t size){
+        const uint8_t* p = (const uint8_t*)data;
+        length += size;
+
+        while (size > 0){
+            uint32_t n = 64 - used;
+            if (n > size){
+                n = size;
+            }
+            memcpy(block + used, p, n);
+            used += n;
+            p += n;
+            size -= n;
+
+            if (used == 64){
+                transform(block);
+                used = 0;
+            }
+        }
+    }
+
+    std::string SHA1::hexdigest(){
+        uint64_t bits = length * 8;
+
+        uint8_t pad = 0x80;
+        update(&pad, 1);
+        pad = 0;
+        while (used != 56){
+            update(&pad, 1);
+        }
+
+        uint8_t lenbytes[8];
+        for (uint32_t i = 0; i < 8; i++){
+            lenbytes[i] = (uint8_t)(bits >> (56 - i * 8));
+        }
+        update(lenbytes, 8);
+
+        uint8_t digest[20];
+        for (uint32_t i = 0; i < 5; i++){
+            digest[i*4]   = (uint8_t)(state[i] >> 24);
+            digest[i*4+1] = (uint8_t)(state[i] >> 16);
+            digest[i*4+2] = (uint8_t)(state[i] >> 8);
+            digest[i*4+3] = (uint8_t)(state[i]);
+        }
+        return toHexString(digest, sizeof(digest));
+    }
+
+    std::string SHA1::hashFile(InputFile* f){
+        SHA1 h;
+        uint64_t size = f->getFileSize();
+        rawbyte_t* buf = new rawbyte_t[HASH_CHUNK_SIZE];
+
+        for (uint64_t off = 0; off < size; off += HASH_CHUNK_SIZE){
+            uint64_t n = size - off;
+            if (n > HASH_CHUNK_SIZE){
+                n = HASH_CHUNK_SIZE;
+            }
+            f->getBytes(off, n, buf);
+            h.update(buf, n);
+        }
+
+        delete[] buf;
+        return h.hexdigest();
+    }
+
+} // namespace EPAX
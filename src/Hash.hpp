@@ -0,0 +1,67 @@
+/**
+ * @file Hash.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_Hash_hpp__
+#define __EPAX_Hash_hpp__
+
+#include "EPAXCommonInternal.hpp"
+
+namespace EPAX {
+
+    class InputFile;
+
+    /**
+     * Incremental SHA-1, used to identify file contents (e.g. for the analysis cache).
+     */
+    class SHA1 {
+    private:
+        uint32_t state[5];
+        uint64_t length;
+        uint8_t block[64];
+        uint32_t used;
+
+        void transform(const uint8_t* b);
+
+    public:
+        SHA1();
+        virtual ~SHA1() {}
+
+        void update(const void* data, uint64_t size);
+        std::string hexdigest();
+
+        /**
+         * Hashes the entire contents of an input file
+         *
+         * @param f an InputFile
+         * @return the hex SHA-1 digest of f
+         */
+        static std::string hashFile(InputFile* f);
+    }; // class SHA1
+
+    extern std::string toHexString(const uint8_t* data, uint32_t size);
+
+} // namespace EPAX
+
+#endif // __EPAX_Hash_hpp__
+
@@ -25,40 +25,213 @@
 #include "EPAXCommonInternal.hpp"
 #include "InputFile.hpp"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sstream>
+
+// pages a ProcessSource keeps before it starts over
+#define PROCESS_CACHE_PAGES (4096)
+
 namespace EPAX {
 
+    // pread until size bytes are read; false if any of them cannot be
+    static bool readFully(int fd, uint64_t offset, uint64_t size, rawbyte_t* buffer){
+        uint64_t done = 0;
+        while (done < size){
+            ssize_t r = pread(fd, buffer + done, size - done, offset + done);
+            if (r < 0 && errno == EINTR){
+                continue;
+            }
+            if (r <= 0){
+                return false;
+            }
+            done += r;
+        }
+        return true;
+    }
+
+    FileSource::FileSource(std::string n)
+        : fd(-1), filesize(0)
+    {
+        fd = open(n.c_str(), O_RDONLY);
+        EPAXAssert(fd >= 0, n << " is not a valid file.");
+
+        struct stat st;
+        EPAXAssert(fstat(fd, &st) == 0, "Cannot stat " << n << ".");
+        filesize = st.st_size;
+    }
+
+    FileSource::~FileSource(){
+        if (fd >= 0){
+            close(fd);
+        }
+    }
+
+    bool FileSource::read(uint64_t offset, uint64_t size, rawbyte_t* buffer){
+        return readFully(fd, offset, size, buffer);
+    }
+
+    MemorySource::MemorySource(const rawbyte_t* d, uint64_t s)
+        : data(d), datasize(s)
+    {
+        EPAXAssert(IS_VALID_PTR(data) || datasize == 0, "Memory source has no buffer.");
+    }
+
+    MemorySource::~MemorySource(){
+    }
+
+    bool MemorySource::read(uint64_t offset, uint64_t size, rawbyte_t* buffer){
+        const rawbyte_t* p = view(offset, size);
+        if (p == NULL){
+            return false;
+        }
+        memcpy(buffer, p, size);
+        return true;
+    }
+
+    const rawbyte_t* MemorySource::view(uint64_t offset, uint64_t size){
+        if (offset > datasize || size > datasize - offset){
+            return NULL;
+        }
+        return data + offset;
+    }
+
+    ProcessSource::ProcessSource(pid_t p)
+        : pid(p), memfd(-1), pagesize(sysconf(_SC_PAGESIZE))
+    {
+        pthread_mutex_init(&pagelock, NULL);
+
+        std::stringstream ss;
+        ss << "/proc/" << DEC(pid) << "/mem";
+        memfd = open(ss.str().c_str(), O_RDONLY | O_CLOEXEC);
+        EPAXAssert(memfd >= 0, "Cannot open the memory of process " << DEC(pid) << ".");
+    }
+
+    ProcessSource::~ProcessSource(){
+        dropPages();
+        pthread_mutex_destroy(&pagelock);
+        if (memfd >= 0){
+            close(memfd);
+        }
+    }
+
+    // call with pagelock held
+    void ProcessSource::dropPages(){
+        for (std::map<uint64_t, rawbyte_t*>::iterator it = pages.begin(); it != pages.end(); it++){
+            delete[] it->second;
+        }
+        pages.clear();
+    }
+
+    // the page holding addr, read from the process if it is not held yet; call with pagelock held
+    rawbyte_t* ProcessSource::getPage(uint64_t addr){
+        uint64_t start = addr - (addr % pagesize);
+        std::map<uint64_t, rawbyte_t*>::iterator it = pages.find(start);
+        if (it != pages.end()){
+            return it->second;
+        }
+
+        rawbyte_t* page = new rawbyte_t[pagesize];
+        if (!readFully(memfd, start, pagesize, page)){
+            delete[] page;
+            return NULL;
+        }
+
+        if (pages.size() >= PROCESS_CACHE_PAGES){
+            dropPages();
+        }
+        pages[start] = page;
+        return page;
+    }
+
+    bool ProcessSource::read(uint64_t offset, uint64_t size, rawbyte_t* buffer){
+        bool ok = true;
+
+        pthread_mutex_lock(&pagelock);
+        uint64_t done = 0;
+        while (done < size){
+            uint64_t addr = offset + done;
+            rawbyte_t* page = getPage(addr);
+            if (page == NULL){
+                ok = false;
+                break;
+            }
+
+            uint64_t inpage = addr % pagesize;
+            uint64_t n = pagesize - inpage;
+            if (n > size - done){
+                n = size - done;
+            }
+            memcpy(buffer + done, page + inpage, n);
+            done += n;
+        }
+        pthread_mutex_unlock(&pagelock);
+
+        return ok;
+    }
+
+    void ProcessSource::invalidate(){
+        pthread_mutex_lock(&pagelock);
+        dropPages();
+        pthread_mutex_unlock(&pagelock);
+    }
+
     InputFile::InputFile(std::string n)
-        : NameBase(n)
+        : NameBase(n), source(INVALID_PTR), base(0), filesize(0)
     {
-        handle.open(getName().c_str(), std::ios::in | std::ios::binary);
+        source = new FileSource(n);
+        filesize = source->getSize();
+    }
+
+    InputFile::InputFile(std::string n, uint64_t o, uint64_t s)
+        : NameBase(n), source(INVALID_PTR), base(0), filesize(0)
+    {
+        source = new FileSource(n);
+        setWindow(o, s);
+    }
+
+    InputFile::InputFile(ByteSource* src, std::string n)
+        : NameBase(n), source(src), base(0), filesize(0)
+    {
+        EPAXAssert(IS_VALID_PTR(source), "No byte source given for " << n << ".");
+        filesize = source->getSize();
+    }
+
+    InputFile::InputFile(ByteSource* src, std::string n, uint64_t o, uint64_t s)
+        : NameBase(n), source(src), base(0), filesize(0)
+    {
+        EPAXAssert(IS_VALID_PTR(source), "No byte source given for " << n << ".");
+        setWindow(o, s);
+    }
 
-        EPAXAssert(handle.is_open(), getName() << " is not a valid file.");
+    void InputFile::setWindow(uint64_t o, uint64_t s){
+        uint64_t limit = source->getSize();
+        EPAXAssert(o <= limit && s <= limit - o, "Byte range [" << std::dec << o << "," << (o + s) << ") is not within " << getName() << ".");
+        base = o;
+        filesize = s;
     }
 
     InputFile::~InputFile(){
-        if (handle.is_open()){
-            handle.close();
+        if (IS_VALID_PTR(source)){
+            delete source;
         }
     }
 
     uint64_t InputFile::getFileSize(){
-        handle.seekg(0, std::ios::beg);
-        uint64_t b = handle.tellg();
-
-        handle.seekg(0, std::ios::end);
-        uint64_t e = handle.tellg();
-
-        return (e - b);
+        return filesize;
     }
 
     uint64_t InputFile::getBytes(uint64_t offset, uint64_t size, rawbyte_t* buffer){
-        std::streampos pos(offset);
-        if (handle.tellg() != pos){
-            handle.seekg(offset);
-        }
-        handle.read(buffer, size);
-        EPAXAssert(!handle.fail(), "Cannot read byte range [" << std::dec << offset << "," << (offset + size) << ") in " << getName() << ".");
+        bool ok = (offset <= filesize && size <= filesize - offset);
+        EPAXAssert(ok && source->read(base + offset, size, buffer), "Cannot read byte range [" << std::dec << offset << "," << (offset + size) << ") in " << getName() << ".");
         return size;
     }
 
+    const rawbyte_t* InputFile::getView(uint64_t offset, uint64_t size){
+        if (offset > filesize || size > filesize - offset){
+            return NULL;
+        }
+        return source->view(base + offset, size);
+    }
+
 } // namespace EPAX
@@ -29,17 +29,155 @@
 
 namespace EPAX {
 
+    /**
+     * Where the bytes of an InputFile come from. A source is addressed by offset and
+     * must allow reads from any number of threads at once.
+     */
+    class ByteSource {
+    public:
+        virtual ~ByteSource() {}
+
+        virtual uint64_t getSize() = 0;
+
+        /**
+         * Reads size bytes at offset
+         *
+         * @return false if any of the bytes cannot be read
+         */
+        virtual bool read(uint64_t offset, uint64_t size, rawbyte_t* buffer) = 0;
+
+        /**
+         * Gets the bytes at offset without copying them, if the source holds them in memory
+         *
+         * @return a pointer that stays valid for the life of the source, or NULL
+         */
+        virtual const rawbyte_t* view(uint64_t offset, uint64_t size) { return NULL; }
+    }; // class ByteSource
+
+    /**
+     * A file on disk, read with pread
+     */
+    class FileSource : public ByteSource {
+    private:
+        int fd;
+        uint64_t filesize;
+
+    public:
+        /**
+         * @param n the name of the file
+         */
+        FileSource(std::string n);
+        virtual ~FileSource();
+
+        uint64_t getSize() { return filesize; }
+        bool read(uint64_t offset, uint64_t size, rawbyte_t* buffer);
+    }; // class FileSource
+
+    /**
+     * A buffer supplied by the caller, which must outlive the source. Nothing is copied
+     * until a read asks for it.
+     */
+    class MemorySource : public ByteSource {
+    private:
+        const rawbyte_t* data;
+        uint64_t datasize;
+
+    public:
+        MemorySource(const rawbyte_t* d, uint64_t s);
+        virtual ~MemorySource();
+
+        uint64_t getSize() { return datasize; }
+        bool read(uint64_t offset, uint64_t size, rawbyte_t* buffer);
+        const rawbyte_t* view(uint64_t offset, uint64_t size);
+    }; // class MemorySource
+
+    /**
+     * The address space of a live process, read through /proc/<pid>/mem; offsets are
+     * virtual addresses. Pages are read the first time they are asked for and kept,
+     * so reading a region piecemeal touches the process once per page. Reading another
+     * process's memory needs the same permission as attaching to it with ptrace.
+     */
+    class ProcessSource : public ByteSource {
+    private:
+        pid_t pid;
+        int memfd;
+        uint64_t pagesize;
+
+        // guards pages
+        pthread_mutex_t pagelock;
+        std::map<uint64_t, rawbyte_t*> pages;
+
+        rawbyte_t* getPage(uint64_t addr);
+        void dropPages();
+
+    public:
+        /**
+         * @param p the process id
+         */
+        ProcessSource(pid_t p);
+        virtual ~ProcessSource();
+
+        uint64_t getSize() { return 0xffffffffffffffffULL; }
+        bool read(uint64_t offset, uint64_t size, rawbyte_t* buffer);
+
+        /**
+         * Forgets the pages read so far, e.g. after the process has rewritten code it generated
+         */
+        void invalidate();
+    }; // class ProcessSource
+
+    /**
+     * A read-only file, or a window of one. Any number of threads can read from one
+     * InputFile at once. Offsets given to a window are relative to its start, so a
+     * member of a container (e.g. a slice of a fat Mach-O file) reads like a file of its
+     * own and nothing outside it is read. The bytes come from a file on disk unless
+     * some other ByteSource is given.
+     */
     class InputFile : public NameBase {
     private:
-        std::ifstream handle;
+        ByteSource* source;
+        uint64_t base;
+        uint64_t filesize;
+
+        void setWindow(uint64_t o, uint64_t s);
 
     public:
         InputFile(std::string n);
+
+        /**
+         * @param n the name of a file
+         * @param o the file offset of the window
+         * @param s the size of the window
+         */
+        InputFile(std::string n, uint64_t o, uint64_t s);
+
+        /**
+         * @param src the source of the bytes, which the InputFile takes over
+         * @param n a name for the bytes, used in messages and as the name of a binary built from them
+         */
+        InputFile(ByteSource* src, std::string n);
+
+        /**
+         * @param src the source of the bytes, which the InputFile takes over
+         * @param n a name for the bytes
+         * @param o the offset of the window in src
+         * @param s the size of the window
+         */
+        InputFile(ByteSource* src, std::string n, uint64_t o, uint64_t s);
         virtual ~InputFile();
 
+        uint64_t getBase() { return base; }
+
         uint64_t getBytes(uint64_t offset, uint64_t size, rawbyte_t* buffer);
         uint64_t getFileSize();
-    }; // class BinaryInputFile
+
+        /**
+         * Gets bytes without copying them, if the source allows it
+         *
+         * @return a pointer valid for the life of this InputFile, or NULL
+         */
+        const rawbyte_t* getView(uint64_t offset, uint64_t size);
+    }; // class InputFile
 
 } // namespace EPAX
 
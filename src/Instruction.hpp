@@ -66,6 +66,15 @@ namespace EPAX {
         DisasmMode_INVLD = -1,
     } DisasmMode;
 
+    /**
+     * A run of code in one instruction set, or of data if mode is DisasmMode_INVLD
+     */
+    struct CodeRegion {
+        uint64_t start;
+        uint64_t end;
+        DisasmMode mode;
+    };
+
     class Instruction : public MemoryBase, public IndexBase, public EPAXExport {
     protected:
         bool disasm_res;
@@ -89,6 +98,7 @@ namespace EPAX {
         void setBasicBlock(BasicBlock* bb){ basicblock = bb; }
         BasicBlock* getBasicBlock() { return basicblock; }
         Function* getFunction() { return function; }
+        void setFunction(Function* f) { function = f; }
 
         virtual const char* const getConditionName();
         virtual PredCondition getCondition() = 0;
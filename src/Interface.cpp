@@ -25,32 +25,166 @@
 #include "EPAXCommonInternal.hpp"
 #include "Interface.hpp"
 #include "Interface.h"
+#include "EPAXDatabase.h"
 
+#include "Archive.hpp"
 #include "BasicBlock.hpp"
 #include "Binary.hpp"
+#include "BlockCounter.hpp"
 #include "ControlFlow.hpp"
+#include "DataStruct.hpp"
 #include "Function.hpp"
+#include "InputFile.hpp"
 #include "Instruction.hpp"
 #include "Loop.hpp"
+#include "LoopProfiler.hpp"
+#include "Sampler.hpp"
 #include "Symbol.hpp"
 #include "Section.hpp"
+#include "Server.hpp"
+#include "StaticFile.hpp"
 
 #include <iostream>
 #include <fstream>
+#include <sys/stat.h>
+
+bool EPAXValidating = (getenv("EPAX_VALIDATE") != NULL);
+
+// per thread, so that one thread's failure is not reported to another
+static __thread EPAXError lasterror = EPAXError_none;
+
+void EPAXSetError(EPAXError e){
+    lasterror = e;
+}
 
 namespace EPAX {
 
+    void EPAX_setValidation(bool on){
+        EPAXValidating = on;
+    }
+
+    uint32_t EPAX_lastError(){
+        uint32_t e = lasterror;
+        lasterror = EPAXError_none;
+        return e;
+    }
+
+    bool EPAX_serve(std::string socketPath, uint64_t memBudget, std::string epaxProgram){
+        Server server(socketPath, memBudget, epaxProgram);
+        return server.run();
+    }
+
+    std::string EPAX_errorString(uint32_t err){
+        static const char* strs[EPAXError_total] = {
+            "no error",
+            "NULL object",
+            "object of the wrong type",
+            "invalid argument"
+        };
+        if (err < EPAXError_total){
+            return std::string(strs[err]);
+        }
+        return std::string("unknown error");
+    }
+
     BIN BIN_create(std::string fileName){
+        const char* cachedir = getenv("EPAX_CACHE_DIR");
+        if (cachedir != NULL && cachedir[0] != '\0'){
+            return BIN_createCached(fileName, std::string(cachedir));
+        }
         return new Binary(fileName, BinaryFormat_undefined);
     }
 
+    BIN BIN_createCached(std::string fileName, std::string cacheDir){
+        return new Binary(fileName, cacheDir);
+    }
+
+    BIN BIN_createSlice(std::string fileName, uint32_t cpuType, std::string cacheDir){
+        return new Binary(fileName, cpuType, cacheDir);
+    }
+
+    // the archive whose members were last asked for, kept so that walking the members
+    // of an archive reads its headers once rather than once per member. A worker forked
+    // after the archive was listed inherits it. It is parsed again if the file changes.
+    static pthread_mutex_t archivelock = PTHREAD_MUTEX_INITIALIZER;
+    static Archive* lastarchive = INVALID_PTR;
+    static struct stat laststat;
+
+    // the parsed archive for fileName; archivelock is held until unlockArchive
+    static Archive* lockArchive(std::string fileName){
+        pthread_mutex_lock(&archivelock);
+
+        struct stat st;
+        if (stat(fileName.c_str(), &st) != 0){
+            memset(&st, 0, sizeof(st));
+        }
+        if (IS_VALID_PTR(lastarchive) && lastarchive->getName() == fileName &&
+            st.st_dev == laststat.st_dev && st.st_ino == laststat.st_ino &&
+            st.st_size == laststat.st_size && st.st_mtime == laststat.st_mtime){
+            return lastarchive;
+        }
+
+        if (IS_VALID_PTR(lastarchive)){
+            delete lastarchive;
+        }
+        lastarchive = new Archive(fileName);
+        laststat = st;
+        return lastarchive;
+    }
+
+    static void unlockArchive(){
+        pthread_mutex_unlock(&archivelock);
+    }
+
+    uint32_t BIN_countMembers(std::string fileName){
+        if (!Archive::isArchive(fileName)){
+            return 0;
+        }
+        uint32_t n = lockArchive(fileName)->countMembers();
+        unlockArchive();
+        return n;
+    }
+
+    uint32_t BIN_listMembers(std::string fileName, std::vector<std::string>& names){
+        names.clear();
+        if (!Archive::isArchive(fileName)){
+            return 0;
+        }
+        Archive* a = lockArchive(fileName);
+        for (uint32_t i = 0; i < a->countMembers(); i++){
+            names.push_back(a->getMember(i)->name);
+        }
+        unlockArchive();
+        return names.size();
+    }
+
+    std::string BIN_getMemberName(std::string fileName, uint32_t idx){
+        std::string name = lockArchive(fileName)->getMember(idx)->name;
+        unlockArchive();
+        return name;
+    }
+
+    BIN BIN_createMember(std::string fileName, uint32_t idx, std::string cacheDir){
+        ArchiveMember member = *(lockArchive(fileName)->getMember(idx));
+        unlockArchive();
+        return new Binary(fileName, &member, cacheDir);
+    }
+
+    BIN BIN_createFromMemory(const void* buffer, uint64_t size, std::string name, std::string cacheDir){
+        return new Binary(new InputFile(new MemorySource((const rawbyte_t*)buffer, size), name), cacheDir);
+    }
+
+    BIN BIN_createFromProcess(uint32_t pid, uint64_t addr, uint64_t size, std::string name, std::string cacheDir){
+        return new Binary(new InputFile(new ProcessSource(pid), name, addr, size), cacheDir);
+    }
+
     std::string BIN_getName(BIN bin){
         EPAXVerifyType(BIN, bin);
         return bin->getName();
     }
 
     void BIN_destroy(BIN bin){
-        EPAXVerifyType(BIN, bin);
+        EPAXVerifyTypeVoid(BIN, bin);
 
         delete bin;
         bin = NULL;
@@ -58,7 +192,7 @@ namespace EPAX {
 
     // does not return
     void BIN_run(BIN bin, int argc, char* argv[]){
-        EPAXVerifyType(BIN, bin);
+        EPAXVerifyTypeVoid(BIN, bin);
 
         EPAXAssert(BIN_isExecutable(bin), "This function only operates on executable binaries");
 	bin->runBasic(argc, argv);
@@ -66,6 +200,69 @@ namespace EPAX {
         ShouldNotArrive;
     }
 
+    int32_t BIN_profile(BIN bin, uint32_t pid, char** argv, uint32_t hz, uint32_t seconds, std::string outFile){
+        EPAXVerifyType(BIN, bin);
+
+        Sampler sampler(bin, (hz? hz: SAMPLER_DEFAULT_HZ));
+        if (pid? !sampler.attach((pid_t)pid): !sampler.launch(argv)){
+            return -1;
+        }
+        int32_t ret = sampler.run(seconds);
+
+        if (outFile.size()){
+            std::ofstream out(outFile.c_str());
+            EPAXAssert(out.is_open(), "cannot open " << outFile << " for writing");
+            sampler.report(out);
+        } else {
+            sampler.report(std::cout);
+        }
+        return ret;
+    }
+
+    int32_t BIN_countBbls(BIN bin, uint32_t pid, char** argv, uint32_t maxHits, uint32_t seconds, std::string outFile){
+        EPAXVerifyType(BIN, bin);
+
+        BlockCounter counter(bin, maxHits);
+        if (pid? !counter.attach((pid_t)pid): !counter.launch(argv)){
+            return -1;
+        }
+        int32_t ret = counter.run(seconds);
+
+        if (outFile.size()){
+            std::ofstream out(outFile.c_str());
+            EPAXAssert(out.is_open(), "cannot open " << outFile << " for writing");
+            counter.report(out);
+        } else {
+            counter.report(std::cout);
+        }
+        return ret;
+    }
+
+    int32_t BIN_profileLoops(BIN bin, uint32_t pid, char** argv, uint32_t maxInvocations, uint32_t seconds, std::string outFile){
+        EPAXVerifyType(BIN, bin);
+
+        // trip counts need the head breakpoint of a loop to stay in place
+        if (!Tracer::canStepOver()){
+            EPAXErr << "loops cannot be profiled on this host, which cannot step over a breakpoint" << ENDL;
+            return -1;
+        }
+
+        LoopProfiler profiler(bin, (maxInvocations? maxInvocations: LOOP_PROFILE_INVOCATIONS));
+        if (pid? !profiler.attach((pid_t)pid): !profiler.launch(argv)){
+            return -1;
+        }
+        int32_t ret = profiler.run(seconds);
+
+        if (outFile.size()){
+            std::ofstream out(outFile.c_str());
+            EPAXAssert(out.is_open(), "cannot open " << outFile << " for writing");
+            profiler.report(out);
+        } else {
+            profiler.report(std::cout);
+        }
+        return ret;
+    }
+
     FUNC BIN_firstFunc(BIN bin){
         EPAXVerifyType(BIN, bin);
 
@@ -101,13 +298,28 @@ namespace EPAX {
         return bin->isExecutable();
     }
 
-    uint32_t BIN_fileSize(BIN bin){
+    void BIN_setLinearSweep(BIN bin, bool on){
+        EPAXVerifyTypeVoid(BIN, bin);
+        bin->setLinearSweep(on);
+    }
+
+    void BIN_setFastDecode(BIN bin, bool on){
+        EPAXVerifyTypeVoid(BIN, bin);
+        bin->setFastDecode(on);
+    }
+
+    uint64_t BIN_fileSize(BIN bin){
         EPAXVerifyType(BIN, bin);
         return bin->getFileSize();
     }
 
-    void BIN_printStaticFile(BIN bin, std::string fname){
+    std::string BIN_contentHash(BIN bin){
         EPAXVerifyType(BIN, bin);
+        return bin->getContentHash();
+    }
+
+    void BIN_printStaticFile(BIN bin, std::string fname){
+        EPAXVerifyTypeVoid(BIN, bin);
 
         EPAXOut << "Printing static file to " << fname << ENDL;
 
@@ -131,7 +343,7 @@ namespace EPAX {
         //staticfile << "# memopbyte      = " << DEC(membyte) << ENDL;
         staticfile << "# fpops          = " << "???" << ENDL;
         staticfile << "# insns          = " << DEC(insncount) << ENDL;
-        //staticfile << "# sha1sum        = " << sha1str << ENDL;
+        staticfile << "# sha1sum        = " << BIN_contentHash(bin) << ENDL;
         staticfile << "# <sequence> <vaddr> <funcname> <funcid> <bbid> <line>" << ENDL;
         staticfile << "# +str <mnemonic> [<and> <ops>]" << ENDL;
         staticfile << "# +isa <groups> <bytes>" << ENDL;
@@ -170,9 +382,12 @@ namespace EPAX {
                                << TAB << BIN_debugFileName(bin, INSN_addr(insn)) << ":" << BIN_debugLineNumber(bin, INSN_addr(insn))
                                << ENDL;
 
-                    staticfile << TAB << "+str"
-                               << TAB << INSN_string(insn)
-                               << ENDL;
+                    // text would force a full decode of a table-classified instruction
+                    if (!func->isFastDecode()){
+                        staticfile << TAB << "+str"
+                                   << TAB << INSN_string(insn)
+                                   << ENDL;
+                    }
 
                     std::vector<std::string> groups;
                     INSN_groupNames(insn, groups);
@@ -272,6 +487,209 @@ namespace EPAX {
         bin->printStaticFile(fname);
     }
 
+    static bool compareBblAddr(BBL a, BBL b){
+        return a->getMemoryAddress() < b->getMemoryAddress();
+    }
+
+    template <typename T> static void writeDatabaseTable(std::ofstream& out, EPAX_db_extent& ext, const T* data, uint64_t count){
+        ext.offset = out.tellp();
+        ext.count = count;
+        if (count > 0){
+            out.write((const char*)data, count * sizeof(T));
+        }
+        // keep every table 8-byte aligned so records can be used in place
+        static const char pad[8] = { 0 };
+        uint64_t over = (count * sizeof(T)) % 8;
+        if (over){
+            out.write(pad, 8 - over);
+        }
+    }
+
+    void BIN_printDatabaseFile(BIN bin, std::string fname){
+        EPAXVerifyTypeVoid(BIN, bin);
+
+        EPAXOut << "Printing analysis database to " << fname << ENDL;
+
+        StringPool strings;
+        std::vector<EPAX_db_func> funcs;
+        std::vector<EPAX_db_bbl> bbls;
+        std::vector<EPAX_db_insn> insns;
+        std::vector<EPAX_db_loop> loops;
+        std::vector<uint64_t> targets;
+        std::vector<uint32_t> edges;
+        std::vector<uint32_t> members;
+
+        EPAX_db_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, EPAX_DB_MAGIC, EPAX_DB_MAGIC_SIZE);
+        header.version = EPAX_DB_VERSION;
+        header.headersize = sizeof(header);
+        header.appsize = BIN_fileSize(bin);
+        header.appname = strings.add(BIN_getName(bin));
+        header.sha1sum = strings.add(BIN_contentHash(bin));
+
+        for (FUNC func = BIN_firstFunc(bin); IS_VALID_PTR(func); func = BIN_nextFunc(bin, func)){
+            uint32_t funcid = funcs.size();
+            CFG cfg = FUNC_cfg(func);
+
+            EPAX_db_func f;
+            memset(&f, 0, sizeof(f));
+            f.addr = FUNC_addr(func);
+            f.size = FUNC_size(func);
+            f.name = strings.add(FUNC_name(func));
+            f.firstbbl = bbls.size();
+            f.firstinsn = insns.size();
+            f.firstloop = loops.size();
+
+            // blocks are emitted in address order so instructions can be searched
+            std::vector<BBL> order;
+            uint32_t nbbls = (IS_VALID_PTR(cfg)? cfg->countBasicBlocks(): 0);
+            for (uint32_t i = 0; i < nbbls; i++){
+                order.push_back(cfg->getBasicBlock(i));
+            }
+            std::stable_sort(order.begin(), order.end(), compareBblAddr);
+
+            std::vector<uint32_t> bblid(nbbls);
+            for (uint32_t i = 0; i < nbbls; i++){
+                bblid[order[i]->getIndex()] = f.firstbbl + i;
+            }
+
+            uint32_t nloops = (IS_VALID_PTR(cfg)? cfg->countLoops(): 0);
+            std::map<LOOP, uint32_t> loopid;
+            for (uint32_t i = 0; i < nloops; i++){
+                loopid[cfg->getLoop(i)] = f.firstloop + i;
+            }
+
+            for (std::vector<BBL>::const_iterator bit = order.begin(); bit != order.end(); bit++){
+                BBL bbl = (*bit);
+
+                EPAX_db_bbl b;
+                memset(&b, 0, sizeof(b));
+                b.addr = bbl->getMemoryAddress();
+                b.func = funcid;
+                b.loop = (IS_VALID_PTR(bbl->getLoop())? loopid[bbl->getLoop()]: EPAX_DB_NONE);
+                b.firstinsn = insns.size();
+                b.insncount = bbl->countInstructions();
+                b.firstedge = edges.size();
+                b.edgecount = bbl->countTargets();
+                b.flags = (bbl->isReachable()? EPAX_DB_BBL_REACHABLE: 0);
+
+                for (uint32_t i = 0; i < bbl->countTargets(); i++){
+                    edges.push_back(bblid[bbl->getTarget(i)->getIndex()]);
+                }
+
+                for (uint32_t i = 0; i < bbl->countInstructions(); i++){
+                    INSN insn = bbl->getInstruction(i);
+
+                    EPAX_db_insn n;
+                    memset(&n, 0, sizeof(n));
+                    n.addr = INSN_addr(insn);
+                    n.calltarget = INSN_callTarget(insn);
+                    n.bbl = bbls.size();
+                    n.func = funcid;
+                    n.size = INSN_size(insn);
+
+                    if (insn->isBranch())              n.flags |= EPAX_DB_INSN_BRANCH;
+                    if (insn->isConditionalBranch())   n.flags |= EPAX_DB_INSN_CONDBRANCH;
+                    if (insn->isCall())                n.flags |= EPAX_DB_INSN_CALL;
+                    if (insn->isReturn())              n.flags |= EPAX_DB_INSN_RETURN;
+                    if (insn->hasFallthrough())        n.flags |= EPAX_DB_INSN_FALLTHRU;
+                    if (insn->isFpop())                n.flags |= EPAX_DB_INSN_FPOP;
+                    if (insn->isLoad())                n.flags |= EPAX_DB_INSN_LOAD;
+                    if (insn->isStore())               n.flags |= EPAX_DB_INSN_STORE;
+
+                    std::string condname = INSN_condName(insn);
+                    if (condname.compare("INVALID") != 0){
+                        n.cond = strings.add(condname);
+                    }
+                    if (!func->isFastDecode()){
+                        n.str = strings.add(INSN_string(insn));
+                    }
+
+                    std::vector<std::string> groups;
+                    INSN_groupNames(insn, groups);
+                    std::string grouplist;
+                    for (uint32_t g = 0; g < groups.size(); g++){
+                        if (g > 0){
+                            grouplist.append(",");
+                        }
+                        grouplist.append(groups[g]);
+                    }
+                    n.groups = strings.add(grouplist);
+
+                    std::vector<uint64_t> tlist;
+                    INSN_targets(insn, tlist);
+                    n.firsttarget = targets.size();
+                    for (std::vector<uint64_t>::const_iterator it = tlist.begin(); it != tlist.end(); it++){
+                        if (INVALID_ADDRESS != (*it)){
+                            targets.push_back(*it);
+                        }
+                    }
+                    n.targetcount = targets.size() - n.firsttarget;
+
+                    if (BIN_hasDebugLineInfo(bin)){
+                        n.file = strings.add(BIN_debugFileName(bin, n.addr));
+                        n.line = BIN_debugLineNumber(bin, n.addr);
+                    }
+                    n.srcregbits = INSN_sourceRegisterSizeInBits(insn);
+                    n.srcdatabits = INSN_sourceDatatypeSizeInBits(insn);
+
+                    insns.push_back(n);
+                }
+
+                bbls.push_back(b);
+            }
+
+            for (uint32_t i = 0; i < nloops; i++){
+                LOOP loop = cfg->getLoop(i);
+
+                EPAX_db_loop l;
+                memset(&l, 0, sizeof(l));
+                l.func = funcid;
+                l.index = LOOP_index(loop);
+                l.depth = LOOP_depth(loop);
+                l.head = bblid[loop->head()->getIndex()];
+                l.tail = bblid[loop->tail()->getIndex()];
+                LOOP parent = LOOP_parent(loop);
+                l.parent = (IS_VALID_PTR(parent)? loopid[parent]: EPAX_DB_NONE);
+                l.firstmember = members.size();
+                for (uint32_t b = 0; b < nbbls; b++){
+                    if (loop->hasBasicBlock(b)){
+                        members.push_back(bblid[b]);
+                    }
+                }
+                l.membercount = members.size() - l.firstmember;
+
+                loops.push_back(l);
+            }
+
+            f.bblcount = bbls.size() - f.firstbbl;
+            f.insncount = insns.size() - f.firstinsn;
+            f.loopcount = loops.size() - f.firstloop;
+            funcs.push_back(f);
+        }
+
+        std::ofstream out(fname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        EPAXAssert(out.is_open(), "Cannot open analysis database " << fname << " for writing");
+
+        // the header is rewritten once the table extents are known
+        out.write((const char*)&header, sizeof(header));
+        writeDatabaseTable(out, header.tables[EPAX_db_table_func], funcs.data(), funcs.size());
+        writeDatabaseTable(out, header.tables[EPAX_db_table_bbl], bbls.data(), bbls.size());
+        writeDatabaseTable(out, header.tables[EPAX_db_table_insn], insns.data(), insns.size());
+        writeDatabaseTable(out, header.tables[EPAX_db_table_loop], loops.data(), loops.size());
+        writeDatabaseTable(out, header.tables[EPAX_db_table_target], targets.data(), targets.size());
+        writeDatabaseTable(out, header.tables[EPAX_db_table_edge], edges.data(), edges.size());
+        writeDatabaseTable(out, header.tables[EPAX_db_table_member], members.data(), members.size());
+        writeDatabaseTable(out, header.tables[EPAX_db_table_string], strings.table.data(), strings.table.size());
+
+        out.seekp(0);
+        out.write((const char*)&header, sizeof(header));
+        out.close();
+
+        EPAXAssert(!out.fail(), "Failed writing analysis database " << fname);
+    }
+
     FUNC BIN_findFuncAt(BIN bin, uint64_t addr){
         EPAXVerifyType(BIN, bin);
         return bin->findFunctionAt(addr);
@@ -292,18 +710,46 @@ namespace EPAX {
         return bin->getDebugLineFile(addr);
     }
 
-    FUNC FUNC_create(uint8_t* bytes, uint32_t size){
-        ShouldNotArrive; // TODO        
-        return INVALID_PTR;
+    FUNC FUNC_create(uint8_t* bytes, uint32_t size, uint64_t addr, uint32_t mode){
+        if (EPAXValidating && bytes == NULL){
+            EPAXSetError(EPAXError_null);
+            return INVALID_PTR;
+        }
+        EPAXCheck(bytes != NULL, "invalid buffer (NULL) given to FUNC_create");
+
+        const rawbyte_t* buf = (const rawbyte_t*)bytes;
+        Function* f;
+        switch (mode){
+        case EPAX_MODE_ARM:
+            f = new Function(buf, size, addr, DisasmMode_ARM, false);
+            break;
+        case EPAX_MODE_THUMB:
+            f = new Function(buf, size, addr, DisasmMode_THUMB2, false);
+            break;
+        case EPAX_MODE_AARCH64:
+            f = new Function(buf, size, addr, DisasmMode_ARM, true);
+            break;
+        default:
+            if (EPAXValidating){
+                EPAXSetError(EPAXError_argument);
+                return INVALID_PTR;
+            }
+            EPAXDie("Unknown instruction set " << DEC(mode) << " given to FUNC_create");
+            return INVALID_PTR;
+        }
+
+        f->disassemble();
+        return f;
     }
 
     void FUNC_destroy(FUNC func){
-        EPAXVerifyType(FUNC, func);
-        ShouldNotArrive; // TODO
+        EPAXVerifyTypeVoid(FUNC, func);
+        EPAXAssert(func->isDetached(), "Function " << func->getName() << " was not created with FUNC_create");
+        delete func;
     }
 
     void FUNC_print(FUNC func){
-        EPAXVerifyType(FUNC, func);
+        EPAXVerifyTypeVoid(FUNC, func);
         func->print();
     }
 
@@ -312,7 +758,7 @@ namespace EPAX {
         return func->getName();
     }
 
-    uint32_t FUNC_size(FUNC func){
+    uint64_t FUNC_size(FUNC func){
         EPAXVerifyType(FUNC, func);
         return func->getMemorySize(); // TODO: count up real bytes used in instructions?
     }
@@ -322,6 +768,11 @@ namespace EPAX {
         return func->getMemoryAddress();
     }
 
+    uint64_t FUNC_fileOffset(FUNC func){
+        EPAXVerifyType(FUNC, func);
+        return func->getFileOffset();
+    }
+
     std::string FUNC_secName(FUNC func){
         EPAXVerifyType(FUNC, func);
         ShouldNotArrive; // TODO
@@ -466,7 +917,7 @@ namespace EPAX {
         return INVALID_PTR;
     }
 
-    uint32_t LOOP_size(LOOP loop){
+    uint64_t LOOP_size(LOOP loop){
         EPAXVerifyType(LOOP, loop);
         return loop->getSize();
     }
@@ -483,7 +934,7 @@ namespace EPAX {
 
     BBL LOOP_firstBbl(LOOP loop){
         EPAXVerifyType(LOOP, loop);
-        return loop->getBasicBlock(0);
+        return loop->getFirstBasicBlock();
     }
 
     BBL LOOP_nextBbl(LOOP loop, BBL bbl){
@@ -842,19 +1293,415 @@ namespace EPAX {
         return count;
     }
 
+    static inline uint32_t insnAttributes(Instruction* insn){
+        uint32_t a = 0;
+        if (insn->isBranch())              a |= EPAX_ATTR_BRANCH;
+        if (insn->isConditionalBranch())   a |= EPAX_ATTR_CONDBRANCH;
+        if (insn->isCall())                a |= EPAX_ATTR_CALL;
+        if (insn->isReturn())              a |= EPAX_ATTR_RETURN;
+        if (insn->hasFallthrough())        a |= EPAX_ATTR_FALLTHROUGH;
+        if (insn->isFpop())                a |= EPAX_ATTR_FPOP;
+        if (insn->isLoad())                a |= EPAX_ATTR_LOAD;
+        if (insn->isStore())               a |= EPAX_ATTR_STORE;
+        PredCondition c = insn->getCondition();
+        if (c != PredCondition_INVALID && c != PredCondition_AL){
+            a |= EPAX_ATTR_PREDICATED;
+        }
+        return a;
+    }
+
+    static inline uint32_t bblLoopId(BasicBlock* bb){
+        Loop* lp = bb->getLoop();
+        return (IS_VALID_PTR(lp)? lp->getIndex(): EPAX_ID_NONE);
+    }
+
+    // fills the columns of func's blocks starting at entry cur
+    static uint32_t fillBblInfo(Function* func, uint32_t cur, uint32_t funcid, uint64_t* addrs, uint64_t* sizes, uint32_t* insnCounts, uint32_t* funcIds, uint32_t* loopIds){
+        uint32_t nbbls = func->countBasicBlocks();
+        for (uint32_t i = 0; i < nbbls; i++, cur++){
+            BasicBlock* bb = func->getBasicBlock(i);
+            if (addrs) addrs[cur] = bb->getMemoryAddress();
+            if (sizes) sizes[cur] = bb->getMemorySize();
+            if (insnCounts) insnCounts[cur] = bb->countInstructions();
+            if (funcIds) funcIds[cur] = funcid;
+            if (loopIds) loopIds[cur] = bblLoopId(bb);
+        }
+        return nbbls;
+    }
+
+    // fills the columns of func's instructions starting at entry cur; block ids start at bblbase
+    static uint32_t fillInsnInfo(Function* func, uint32_t cur, uint32_t funcid, uint32_t bblbase, uint64_t* addrs, uint64_t* sizes, uint32_t* attrs, uint32_t* funcIds, uint32_t* bblIds, uint32_t* loopIds){
+        uint32_t start = cur;
+        uint32_t nbbls = func->countBasicBlocks();
+        for (uint32_t i = 0; i < nbbls; i++){
+            BasicBlock* bb = func->getBasicBlock(i);
+            uint32_t loopid = bblLoopId(bb);
+            uint32_t ninsns = bb->countInstructions();
+            for (uint32_t j = 0; j < ninsns; j++, cur++){
+                Instruction* insn = bb->getInstruction(j);
+                if (addrs) addrs[cur] = insn->getMemoryAddress();
+                if (sizes) sizes[cur] = insn->getMemorySize();
+                if (attrs) attrs[cur] = insnAttributes(insn);
+                if (funcIds) funcIds[cur] = funcid;
+                if (bblIds) bblIds[cur] = bblbase + i;
+                if (loopIds) loopIds[cur] = loopid;
+            }
+        }
+        return cur - start;
+    }
+
+    uint32_t BIN_countBbl(BIN bin){
+        EPAXVerifyType(BIN, bin);
+        uint32_t c = 0;
+        uint32_t nfuncs = bin->countFunctions();
+        for (uint32_t i = 0; i < nfuncs; i++){
+            c += bin->getFunction(i)->countBasicBlocks();
+        }
+        return c;
+    }
+
+    uint32_t BIN_countInsn(BIN bin){
+        EPAXVerifyType(BIN, bin);
+        uint32_t c = 0;
+        uint32_t nfuncs = bin->countFunctions();
+        for (uint32_t i = 0; i < nfuncs; i++){
+            c += bin->getFunction(i)->countInstructions();
+        }
+        return c;
+    }
+
+    uint32_t BIN_funcInfo(BIN bin, uint64_t* addrs, uint64_t* sizes, uint32_t* bblCounts, uint32_t* insnCounts){
+        EPAXVerifyType(BIN, bin);
+        uint32_t nfuncs = bin->countFunctions();
+        for (uint32_t i = 0; i < nfuncs; i++){
+            Function* f = bin->getFunction(i);
+            if (addrs) addrs[i] = f->getMemoryAddress();
+            if (sizes) sizes[i] = f->getMemorySize();
+            if (bblCounts) bblCounts[i] = f->countBasicBlocks();
+            if (insnCounts) insnCounts[i] = f->countInstructions();
+        }
+        return nfuncs;
+    }
+
+    uint32_t BIN_bblInfo(BIN bin, uint64_t* addrs, uint64_t* sizes, uint32_t* insnCounts, uint32_t* funcIds, uint32_t* loopIds){
+        EPAXVerifyType(BIN, bin);
+        uint32_t cur = 0;
+        uint32_t nfuncs = bin->countFunctions();
+        for (uint32_t i = 0; i < nfuncs; i++){
+            cur += fillBblInfo(bin->getFunction(i), cur, i, addrs, sizes, insnCounts, funcIds, loopIds);
+        }
+        return cur;
+    }
+
+    uint32_t BIN_insnInfo(BIN bin, uint64_t* addrs, uint64_t* sizes, uint32_t* attrs, uint32_t* funcIds, uint32_t* bblIds, uint32_t* loopIds){
+        EPAXVerifyType(BIN, bin);
+        uint32_t cur = 0;
+        uint32_t bblbase = 0;
+        uint32_t nfuncs = bin->countFunctions();
+        for (uint32_t i = 0; i < nfuncs; i++){
+            Function* f = bin->getFunction(i);
+            cur += fillInsnInfo(f, cur, i, bblbase, addrs, sizes, attrs, funcIds, bblIds, loopIds);
+            bblbase += f->countBasicBlocks();
+        }
+        return cur;
+    }
+
+    uint32_t FUNC_bblInfo(FUNC func, uint64_t* addrs, uint64_t* sizes, uint32_t* insnCounts, uint32_t* loopIds){
+        EPAXVerifyType(FUNC, func);
+        return fillBblInfo(func, 0, func->getIndex(), addrs, sizes, insnCounts, NULL, loopIds);
+    }
+
+    uint32_t FUNC_insnInfo(FUNC func, uint64_t* addrs, uint64_t* sizes, uint32_t* attrs, uint32_t* bblIds, uint32_t* loopIds){
+        EPAXVerifyType(FUNC, func);
+        return fillInsnInfo(func, 0, func->getIndex(), 0, addrs, sizes, attrs, NULL, bblIds, loopIds);
+    }
+
+    template <typename T> static uint32_t listRange(Range<T> r, T* const** list){
+        *list = r.begin();
+        return r.size();
+    }
+
+    uint32_t BIN_funcList(BIN bin, FUNC const** list){
+        *list = NULL;
+        EPAXVerifyType(BIN, bin);
+        return listRange(bin->functions(), list);
+    }
+
+    uint32_t FUNC_bblList(FUNC func, BBL const** list){
+        *list = NULL;
+        EPAXVerifyType(FUNC, func);
+        return listRange(func->blocks(), list);
+    }
+
+    uint32_t FUNC_insnList(FUNC func, INSN const** list){
+        *list = NULL;
+        EPAXVerifyType(FUNC, func);
+        return listRange(func->instructions(), list);
+    }
+
+    uint32_t FUNC_loopList(FUNC func, LOOP const** list){
+        *list = NULL;
+        EPAXVerifyType(FUNC, func);
+        return listRange(func->loops(), list);
+    }
+
+    uint32_t LOOP_bblList(LOOP loop, BBL const** list){
+        *list = NULL;
+        EPAXVerifyType(LOOP, loop);
+        return listRange(loop->blocks(), list);
+    }
+
+    uint32_t BBL_insnList(BBL bbl, INSN const** list){
+        *list = NULL;
+        EPAXVerifyType(BBL, bbl);
+        return listRange(bbl->instructions(), list);
+    }
+
+    uint32_t BBL_sourceList(BBL bbl, BBL const** list){
+        *list = NULL;
+        EPAXVerifyType(BBL, bbl);
+        return listRange(bbl->predecessors(), list);
+    }
+
+    uint32_t BBL_targetList(BBL bbl, BBL const** list){
+        *list = NULL;
+        EPAXVerifyType(BBL, bbl);
+        return listRange(bbl->successors(), list);
+    }
+
+    uint32_t FUNC_countEdges(FUNC func){
+        EPAXVerifyType(FUNC, func);
+        uint32_t c = 0;
+        uint32_t nbbls = func->countBasicBlocks();
+        for (uint32_t i = 0; i < nbbls; i++){
+            c += func->getBasicBlock(i)->countTargets();
+        }
+        return c;
+    }
+
+    uint32_t FUNC_edges(FUNC func, uint32_t* srcIds, uint32_t* dstIds){
+        EPAXVerifyType(FUNC, func);
+        uint32_t cur = 0;
+        uint32_t nbbls = func->countBasicBlocks();
+        for (uint32_t i = 0; i < nbbls; i++){
+            BasicBlock* bb = func->getBasicBlock(i);
+            uint32_t ntgts = bb->countTargets();
+            for (uint32_t j = 0; j < ntgts; j++, cur++){
+                if (srcIds) srcIds[cur] = i;
+                if (dstIds) dstIds[cur] = bb->getTarget(j)->getIndex();
+            }
+        }
+        return cur;
+    }
+
+    uint32_t INSN_attrs(INSN insn){
+        EPAXVerifyType(INSN, insn);
+        return insnAttributes(insn);
+    }
+
+    template <typename T> static const T* SFILE_column(const std::vector<T>& v){
+        return (v.size()? &v[0]: NULL);
+    }
+
+    SFILE SFILE_open(std::string fileName, std::string fields){
+        return new StaticFile(fileName, StaticFile::parseFields(fields));
+    }
+
+    void SFILE_close(SFILE sfile){
+        EPAXVerifyTypeVoid(SFILE, sfile);
+        delete sfile;
+    }
+
+    uint64_t SFILE_countInsn(SFILE sfile){
+        EPAXVerifyType(SFILE, sfile);
+        return sfile->countInstructions();
+    }
+
+    std::string SFILE_header(SFILE sfile, std::string key){
+        EPAXVerifyType(SFILE, sfile);
+        return sfile->getHeader(key);
+    }
+
+    const uint64_t* SFILE_addrs(SFILE sfile){
+        EPAXVerifyType(SFILE, sfile);
+        return SFILE_column(sfile->getAddresses());
+    }
+
+    const uint32_t* SFILE_funcIds(SFILE sfile){
+        EPAXVerifyType(SFILE, sfile);
+        return SFILE_column(sfile->getFunctionIds());
+    }
+
+    const uint32_t* SFILE_bblIds(SFILE sfile){
+        EPAXVerifyType(SFILE, sfile);
+        return SFILE_column(sfile->getBlockIds());
+    }
+
+    const uint32_t* SFILE_lines(SFILE sfile){
+        EPAXVerifyType(SFILE, sfile);
+        return SFILE_column(sfile->getLines());
+    }
+
+    const uint32_t* SFILE_sizes(SFILE sfile){
+        EPAXVerifyType(SFILE, sfile);
+        return SFILE_column(sfile->getSizes());
+    }
+
+    const uint8_t* SFILE_counts(SFILE sfile){
+        EPAXVerifyType(SFILE, sfile);
+        return SFILE_column(sfile->getCounts());
+    }
+
+    const uint32_t* SFILE_loopIds(SFILE sfile){
+        EPAXVerifyType(SFILE, sfile);
+        return SFILE_column(sfile->getLoopIds());
+    }
+
+    const uint32_t* SFILE_loopDepths(SFILE sfile){
+        EPAXVerifyType(SFILE, sfile);
+        return SFILE_column(sfile->getLoopDepths());
+    }
+
+    const uint64_t* SFILE_callTargets(SFILE sfile){
+        EPAXVerifyType(SFILE, sfile);
+        return SFILE_column(sfile->getCallTargets());
+    }
+
+    std::string SFILE_funcName(SFILE sfile, uint64_t idx){
+        EPAXVerifyType(SFILE, sfile);
+        EPAXAssert(idx < sfile->countInstructions(), "Invalid instruction index " << DEC(idx));
+        return sfile->getString(sfile->getFunctionNames()[idx]);
+    }
+
+    std::string SFILE_insnString(SFILE sfile, uint64_t idx){
+        EPAXVerifyType(SFILE, sfile);
+        EPAXAssert(sfile->hasField(StaticField_str), "+str records were not read from " << sfile->getName());
+        EPAXAssert(idx < sfile->countInstructions(), "Invalid instruction index " << DEC(idx));
+        return sfile->getString(sfile->getStrings()[idx]);
+    }
+
+    uint32_t SFILE_targets(SFILE sfile, uint64_t idx, std::vector<uint64_t>& tlist){
+        EPAXVerifyType(SFILE, sfile);
+        return sfile->getTargets(idx, tlist);
+    }
+
 } // namespace EPAX
 
+/*
+ * Strings returned through the C interface are held per thread, so a returned
+ * pointer is valid until the same thread's next call that returns a string.
+ */
+typedef struct {
+    std::string str;
+    std::vector<std::string> strs;
+} ThreadStrings;
+
+static pthread_key_t threadstringkey;
+static pthread_once_t threadstringonce = PTHREAD_ONCE_INIT;
+
+static void deleteThreadStrings(void* ts){
+    delete (ThreadStrings*)ts;
+}
+
+static void createThreadStringKey(){
+    pthread_key_create(&threadstringkey, deleteThreadStrings);
+}
+
+static ThreadStrings* getThreadStrings(){
+    pthread_once(&threadstringonce, createThreadStringKey);
+    ThreadStrings* ts = (ThreadStrings*)pthread_getspecific(threadstringkey);
+    if (ts == NULL){
+        ts = new ThreadStrings();
+        pthread_setspecific(threadstringkey, ts);
+    }
+    return ts;
+}
+
+static const char* threadString(const std::string& str){
+    ThreadStrings* ts = getThreadStrings();
+    ts->str = str;
+    return ts->str.c_str();
+}
+
 /* these C implementations are just a thin layer around the C++ implementations */
 extern "C" {
 
+    void EPAX_setValidation(uint32_t on){
+        EPAX::EPAX_setValidation(on != 0);
+    }
+
+    uint32_t EPAX_lastError(){
+        return EPAX::EPAX_lastError();
+    }
+
+    uint32_t EPAX_serve(const char* socketPath, uint64_t memBudget, const char* epaxProgram){
+        return (uint32_t)EPAX::EPAX_serve(std::string(socketPath), memBudget, std::string(epaxProgram));
+    }
+
+    const char* EPAX_errorString(uint32_t err){
+        return threadString(EPAX::EPAX_errorString(err));
+    }
+
     EPAX_bin EPAX_bin_create(const char* fileName){
         std::string s(fileName);
         return (EPAX_bin)EPAX::BIN_create(s);
     }
 
+    EPAX_bin EPAX_bin_createCached(const char* fileName, const char* cacheDir){
+        std::string s(fileName);
+        std::string d(cacheDir);
+        return (EPAX_bin)EPAX::BIN_createCached(s, d);
+    }
+
+    EPAX_bin EPAX_bin_createSlice(const char* fileName, uint32_t cpuType, const char* cacheDir){
+        std::string s(fileName);
+        std::string d(cacheDir);
+        return (EPAX_bin)EPAX::BIN_createSlice(s, cpuType, d);
+    }
+
+    uint32_t EPAX_bin_countMembers(const char* fileName){
+        std::string s(fileName);
+        return EPAX::BIN_countMembers(s);
+    }
+
+    uint32_t EPAX_bin_listMembers(const char* fileName, char** names){
+        EPAXAssert(IS_VALID_PTR(names), "NULL pointer cannot be passed for output parameter");
+        // the names are held per thread and valid until the thread's next call
+        std::vector<std::string>& strs = getThreadStrings()->strs;
+        std::string s(fileName);
+        EPAX::BIN_listMembers(s, strs);
+
+        for (uint32_t i = 0; i < strs.size(); i++){
+            names[i] = (char*)(strs[i].c_str());
+        }
+        return strs.size();
+    }
+
+    const char* EPAX_bin_getMemberName(const char* fileName, uint32_t idx){
+        std::string s(fileName);
+        return threadString(EPAX::BIN_getMemberName(s, idx));
+    }
+
+    EPAX_bin EPAX_bin_createMember(const char* fileName, uint32_t idx, const char* cacheDir){
+        std::string s(fileName);
+        std::string d(cacheDir);
+        return (EPAX_bin)EPAX::BIN_createMember(s, idx, d);
+    }
+
+    EPAX_bin EPAX_bin_createFromMemory(const void* buffer, uint64_t size, const char* name, const char* cacheDir){
+        std::string s(name);
+        std::string d(cacheDir);
+        return (EPAX_bin)EPAX::BIN_createFromMemory(buffer, size, s, d);
+    }
+
+    EPAX_bin EPAX_bin_createFromProcess(uint32_t pid, uint64_t addr, uint64_t size, const char* name, const char* cacheDir){
+        std::string s(name);
+        std::string d(cacheDir);
+        return (EPAX_bin)EPAX::BIN_createFromProcess(pid, addr, size, s, d);
+    }
+
     const char* EPAX_bin_getName(EPAX_bin bin){
-        std::string s(EPAX::BIN_getName((EPAX::BIN)bin));
-        return s.c_str();
+        return threadString(EPAX::BIN_getName((EPAX::BIN)bin));
     }
 
     void EPAX_bin_destroy(EPAX_bin bin){
@@ -865,6 +1712,18 @@ extern "C" {
         EPAX::BIN_run((EPAX::BIN)bin, argc, argv);
     }
 
+    int32_t EPAX_bin_profile(EPAX_bin bin, uint32_t pid, char** argv, uint32_t hz, uint32_t seconds, const char* outFile){
+        return EPAX::BIN_profile((EPAX::BIN)bin, pid, argv, hz, seconds, std::string(outFile));
+    }
+
+    int32_t EPAX_bin_countBbls(EPAX_bin bin, uint32_t pid, char** argv, uint32_t maxHits, uint32_t seconds, const char* outFile){
+        return EPAX::BIN_countBbls((EPAX::BIN)bin, pid, argv, maxHits, seconds, std::string(outFile));
+    }
+
+    int32_t EPAX_bin_profileLoops(EPAX_bin bin, uint32_t pid, char** argv, uint32_t maxInvocations, uint32_t seconds, const char* outFile){
+        return EPAX::BIN_profileLoops((EPAX::BIN)bin, pid, argv, maxInvocations, seconds, std::string(outFile));
+    }
+
     EPAX_func EPAX_bin_firstFunc(EPAX_bin bin){
         return (EPAX_func)EPAX::BIN_firstFunc((EPAX::BIN)bin);
     }
@@ -885,21 +1744,53 @@ extern "C" {
         return (uint32_t)EPAX::BIN_isExecutable((EPAX::BIN)bin);
     }
 
-    uint32_t EPAX_bin_fileSize(EPAX_bin bin){
+    void EPAX_bin_setLinearSweep(EPAX_bin bin, uint32_t on){
+        EPAX::BIN_setLinearSweep((EPAX::BIN)bin, on != 0);
+    }
+
+    void EPAX_bin_setFastDecode(EPAX_bin bin, uint32_t on){
+        EPAX::BIN_setFastDecode((EPAX::BIN)bin, on != 0);
+    }
+
+    uint64_t EPAX_bin_fileSize(EPAX_bin bin){
         return EPAX::BIN_fileSize((EPAX::BIN)bin);
     }
 
+    const char* EPAX_bin_contentHash(EPAX_bin bin){
+        // the digest is memoized by the binary, so the pointer stays valid for its lifetime
+        EPAX::BIN b = (EPAX::BIN)bin;
+        EPAXVerifyType(BIN, b);
+        return b->getContentHash().c_str();
+    }
+
     void EPAX_bin_printStaticFile(EPAX_bin bin, const char* fname){
         std::string s(fname);
         EPAX::BIN_printStaticFile((EPAX::BIN)bin, s);
     }
 
-    EPAX_func EPAX_bin_fundFunc(EPAX_bin bin, uint64_t addr){
+    void EPAX_bin_printDatabaseFile(EPAX_bin bin, const char* fname){
+        std::string s(fname);
+        EPAX::BIN_printDatabaseFile((EPAX::BIN)bin, s);
+    }
+
+    EPAX_func EPAX_bin_findFuncAt(EPAX_bin bin, uint64_t addr){
         return (EPAX_func)EPAX::BIN_findFuncAt((EPAX::BIN)bin, addr);
     }
 
-    EPAX_func EPAX_func_create(uint8_t* bytes, uint32_t size){
-        return (EPAX_func)EPAX::FUNC_create(bytes, size);
+    uint32_t EPAX_bin_hasDebugLineInfo(EPAX_bin bin){
+        return (uint32_t)EPAX::BIN_hasDebugLineInfo((EPAX::BIN)bin);
+    }
+
+    uint32_t EPAX_bin_debugLineNumber(EPAX_bin bin, uint64_t addr){
+        return EPAX::BIN_debugLineNumber((EPAX::BIN)bin, addr);
+    }
+
+    const char* EPAX_bin_debugFileName(EPAX_bin bin, uint64_t addr){
+        return threadString(EPAX::BIN_debugFileName((EPAX::BIN)bin, addr));
+    }
+
+    EPAX_func EPAX_func_create(uint8_t* bytes, uint32_t size, uint64_t addr, uint32_t mode){
+        return (EPAX_func)EPAX::FUNC_create(bytes, size, addr, mode);
     }
 
     void EPAX_func_destroy(EPAX_func func){
@@ -911,11 +1802,10 @@ extern "C" {
     }
 
     const char* EPAX_func_name(EPAX_func func){
-        std::string s = EPAX::FUNC_name((EPAX::FUNC)func);
-        return s.c_str();
+        return threadString(EPAX::FUNC_name((EPAX::FUNC)func));
     }
 
-    uint32_t EPAX_func_size(EPAX_func func){
+    uint64_t EPAX_func_size(EPAX_func func){
         return EPAX::FUNC_size((EPAX::FUNC)func);
     }
 
@@ -923,9 +1813,12 @@ extern "C" {
         return EPAX::FUNC_addr((EPAX::FUNC)func);
     }
 
+    uint64_t EPAX_func_fileOffset(EPAX_func func){
+        return EPAX::FUNC_fileOffset((EPAX::FUNC)func);
+    }
+
     const char* EPAX_func_secName(EPAX_func func){
-        std::string s = EPAX::FUNC_secName((EPAX::FUNC)func);
-        return s.c_str();
+        return threadString(EPAX::FUNC_secName((EPAX::FUNC)func));
     }
 
     EPAX_bin EPAX_func_bin(EPAX_func func){
@@ -1020,7 +1913,7 @@ extern "C" {
         return (EPAX_func)EPAX::LOOP_func((EPAX::LOOP)loop);
     }
 
-    uint32_t EPAX_loop_size(EPAX_loop loop){
+    uint64_t EPAX_loop_size(EPAX_loop loop){
         return EPAX::LOOP_size((EPAX::LOOP)loop);
     }
 
@@ -1241,8 +2134,7 @@ extern "C" {
     }
 
     const char* EPAX_insn_string(EPAX_insn insn){
-        std::string s = EPAX::INSN_string((EPAX::INSN)insn);
-        return s.c_str();
+        return threadString(EPAX::INSN_string((EPAX::INSN)insn));
     }
 
     uint64_t EPAX_insn_callTarget(EPAX_insn insn){
@@ -1274,8 +2166,7 @@ extern "C" {
     }
 
     const char* EPAX_insn_condName(EPAX_insn insn){
-        std::string s(EPAX::INSN_condName((EPAX::INSN)insn));
-        return s.c_str();
+        return threadString(EPAX::INSN_condName((EPAX::INSN)insn));
     }
 
     uint32_t EPAX_insn_fallsThrough(EPAX_insn insn){
@@ -1292,7 +2183,9 @@ extern "C" {
 
     uint32_t EPAX_insn_groupNames(EPAX_insn insn, char** groups){
         EPAXAssert(IS_VALID_PTR(groups), "NULL pointer cannot be passed for output parameter");
-        std::vector<std::string> grps;
+        // the names are held per thread and valid until the thread's next call
+        std::vector<std::string>& grps = getThreadStrings()->strs;
+        grps.clear();
         EPAX::INSN_groupNames((EPAX::INSN)insn, grps);
 
         for (uint32_t i = 0; i < grps.size(); i++){
@@ -1308,5 +2201,151 @@ extern "C" {
 
         return grps.size();
     }
+
+    uint32_t EPAX_bin_countBbl(EPAX_bin bin){
+        return EPAX::BIN_countBbl((EPAX::BIN)bin);
+    }
+
+    uint32_t EPAX_bin_countInsn(EPAX_bin bin){
+        return EPAX::BIN_countInsn((EPAX::BIN)bin);
+    }
+
+    uint32_t EPAX_bin_funcInfo(EPAX_bin bin, uint64_t* addrs, uint64_t* sizes, uint32_t* bblCounts, uint32_t* insnCounts){
+        return EPAX::BIN_funcInfo((EPAX::BIN)bin, addrs, sizes, bblCounts, insnCounts);
+    }
+
+    uint32_t EPAX_bin_bblInfo(EPAX_bin bin, uint64_t* addrs, uint64_t* sizes, uint32_t* insnCounts, uint32_t* funcIds, uint32_t* loopIds){
+        return EPAX::BIN_bblInfo((EPAX::BIN)bin, addrs, sizes, insnCounts, funcIds, loopIds);
+    }
+
+    uint32_t EPAX_bin_insnInfo(EPAX_bin bin, uint64_t* addrs, uint64_t* sizes, uint32_t* attrs, uint32_t* funcIds, uint32_t* bblIds, uint32_t* loopIds){
+        return EPAX::BIN_insnInfo((EPAX::BIN)bin, addrs, sizes, attrs, funcIds, bblIds, loopIds);
+    }
+
+    uint32_t EPAX_func_bblInfo(EPAX_func func, uint64_t* addrs, uint64_t* sizes, uint32_t* insnCounts, uint32_t* loopIds){
+        return EPAX::FUNC_bblInfo((EPAX::FUNC)func, addrs, sizes, insnCounts, loopIds);
+    }
+
+    uint32_t EPAX_func_insnInfo(EPAX_func func, uint64_t* addrs, uint64_t* sizes, uint32_t* attrs, uint32_t* bblIds, uint32_t* loopIds){
+        return EPAX::FUNC_insnInfo((EPAX::FUNC)func, addrs, sizes, attrs, bblIds, loopIds);
+    }
+
+    uint32_t EPAX_func_countEdges(EPAX_func func){
+        return EPAX::FUNC_countEdges((EPAX::FUNC)func);
+    }
+
+    uint32_t EPAX_func_edges(EPAX_func func, uint32_t* srcIds, uint32_t* dstIds){
+        return EPAX::FUNC_edges((EPAX::FUNC)func, srcIds, dstIds);
+    }
+
+    uint32_t EPAX_insn_attrs(EPAX_insn insn){
+        return EPAX::INSN_attrs((EPAX::INSN)insn);
+    }
+
+    uint32_t EPAX_bin_funcList(EPAX_bin bin, EPAX_func const** list){
+        return EPAX::BIN_funcList((EPAX::BIN)bin, (EPAX::FUNC const**)list);
+    }
+
+    uint32_t EPAX_func_bblList(EPAX_func func, EPAX_bbl const** list){
+        return EPAX::FUNC_bblList((EPAX::FUNC)func, (EPAX::BBL const**)list);
+    }
+
+    uint32_t EPAX_func_insnList(EPAX_func func, EPAX_insn const** list){
+        return EPAX::FUNC_insnList((EPAX::FUNC)func, (EPAX::INSN const**)list);
+    }
+
+    uint32_t EPAX_func_loopList(EPAX_func func, EPAX_loop const** list){
+        return EPAX::FUNC_loopList((EPAX::FUNC)func, (EPAX::LOOP const**)list);
+    }
+
+    uint32_t EPAX_loop_bblList(EPAX_loop loop, EPAX_bbl const** list){
+        return EPAX::LOOP_bblList((EPAX::LOOP)loop, (EPAX::BBL const**)list);
+    }
+
+    uint32_t EPAX_bbl_insnList(EPAX_bbl bbl, EPAX_insn const** list){
+        return EPAX::BBL_insnList((EPAX::BBL)bbl, (EPAX::INSN const**)list);
+    }
+
+    uint32_t EPAX_bbl_sourceList(EPAX_bbl bbl, EPAX_bbl const** list){
+        return EPAX::BBL_sourceList((EPAX::BBL)bbl, (EPAX::BBL const**)list);
+    }
+
+    uint32_t EPAX_bbl_targetList(EPAX_bbl bbl, EPAX_bbl const** list){
+        return EPAX::BBL_targetList((EPAX::BBL)bbl, (EPAX::BBL const**)list);
+    }
+
+    EPAX_sfile EPAX_sfile_open(const char* fileName, const char* fields){
+        std::string s(fileName);
+        std::string f(fields);
+        return (EPAX_sfile)EPAX::SFILE_open(s, f);
+    }
+
+    void EPAX_sfile_close(EPAX_sfile sfile){
+        EPAX::SFILE_close((EPAX::SFILE)sfile);
+    }
+
+    uint64_t EPAX_sfile_countInsn(EPAX_sfile sfile){
+        return EPAX::SFILE_countInsn((EPAX::SFILE)sfile);
+    }
+
+    const char* EPAX_sfile_header(EPAX_sfile sfile, const char* key){
+        return threadString(EPAX::SFILE_header((EPAX::SFILE)sfile, std::string(key)));
+    }
+
+    const uint64_t* EPAX_sfile_addrs(EPAX_sfile sfile){
+        return EPAX::SFILE_addrs((EPAX::SFILE)sfile);
+    }
+
+    const uint32_t* EPAX_sfile_funcIds(EPAX_sfile sfile){
+        return EPAX::SFILE_funcIds((EPAX::SFILE)sfile);
+    }
+
+    const uint32_t* EPAX_sfile_bblIds(EPAX_sfile sfile){
+        return EPAX::SFILE_bblIds((EPAX::SFILE)sfile);
+    }
+
+    const uint32_t* EPAX_sfile_lines(EPAX_sfile sfile){
+        return EPAX::SFILE_lines((EPAX::SFILE)sfile);
+    }
+
+    const uint32_t* EPAX_sfile_sizes(EPAX_sfile sfile){
+        return EPAX::SFILE_sizes((EPAX::SFILE)sfile);
+    }
+
+    const uint8_t* EPAX_sfile_counts(EPAX_sfile sfile){
+        return EPAX::SFILE_counts((EPAX::SFILE)sfile);
+    }
+
+    const uint32_t* EPAX_sfile_loopIds(EPAX_sfile sfile){
+        return EPAX::SFILE_loopIds((EPAX::SFILE)sfile);
+    }
+
+    const uint32_t* EPAX_sfile_loopDepths(EPAX_sfile sfile){
+        return EPAX::SFILE_loopDepths((EPAX::SFILE)sfile);
+    }
+
+    const uint64_t* EPAX_sfile_callTargets(EPAX_sfile sfile){
+        return EPAX::SFILE_callTargets((EPAX::SFILE)sfile);
+    }
+
+    const char* EPAX_sfile_funcName(EPAX_sfile sfile, uint64_t idx){
+        return threadString(EPAX::SFILE_funcName((EPAX::SFILE)sfile, idx));
+    }
+
+    const char* EPAX_sfile_insnString(EPAX_sfile sfile, uint64_t idx){
+        return threadString(EPAX::SFILE_insnString((EPAX::SFILE)sfile, idx));
+    }
+
+    uint32_t EPAX_sfile_targets(EPAX_sfile sfile, uint64_t idx, uint64_t* tlist){
+        EPAXAssert(IS_VALID_PTR(tlist), "NULL pointer cannot be passed for output parameter");
+        std::vector<uint64_t> tv;
+        uint32_t res = EPAX::SFILE_targets((EPAX::SFILE)sfile, idx, tv);
+
+        uint32_t cur = 0;
+        for (std::vector<uint64_t>::const_iterator it = tv.begin(); it != tv.end(); it++, cur++){
+            tlist[cur] = (*it);
+        }
+        return res;
+    }
 }
 
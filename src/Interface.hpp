@@ -40,6 +40,7 @@ namespace EPAX {
     class BasicBlock;
     class Instruction;
     class Symbol;
+    class StaticFile;
     class FlowEquation; // TODO: DNE. will represent a scheme for general data flow analysis, a la http://en.wikipedia.org/wiki/Data-flow_analysis
     // TODO: do we really want stl in this interface? (std::string and std::vector)
     // TODO: "const" for input params, label all params as in/out?
@@ -53,15 +54,160 @@ namespace EPAX {
     typedef Instruction*   INSN;
     typedef Symbol*        SYM;
     typedef FlowEquation*  FLOW;
+    typedef StaticFile*    SFILE;
+
+    // errors reported by EPAX_lastError
+#define EPAX_ERROR_NONE 0
+#define EPAX_ERROR_NULL 1
+#define EPAX_ERROR_TYPE 2
+#define EPAX_ERROR_ARGUMENT 3
+
+    /**
+     * Turns validating mode on or off. It is off by default, unless $EPAX_VALIDATE is
+     * set. In validating mode a call given a NULL object, or an object of the wrong
+     * kind, or an argument out of its allowed values, records an error for EPAX_lastError
+     * and returns NULL, 0, false or an empty string. Otherwise checked builds exit on such a call and release builds do not
+     * check at all. Validating mode covers only the objects passed to the interface;
+     * other internal checks, such as those on a corrupt binary or an out-of-range
+     * index, still exit in checked builds.
+     *
+     * @param on whether to validate objects passed to the interface
+     */
+    extern void EPAX_setValidation(bool on);
+
+    /**
+     * Gets and clears the last error recorded by this thread in validating mode
+     *
+     * @return one of the EPAX_ERROR_* values
+     */
+    extern uint32_t EPAX_lastError();
+
+    /**
+     * Describes an error
+     *
+     * @param err one of the EPAX_ERROR_* values
+     * @return a description of err
+     */
+    extern std::string EPAX_errorString(uint32_t err);
+
+    /**
+     * Runs an analysis server on a Unix-domain socket. Clients load binaries and query
+     * them using the protocol in EPAXServer.h. Analyzed binaries stay resident until
+     * memBudget is exceeded, after which the least recently used are evicted. Each new
+     * binary is first analyzed by running the epax program, so that a binary that
+     * cannot be analyzed is refused rather than ending the server.
+     *
+     * @param socketPath the path of the socket to create
+     * @param memBudget the memory budget in bytes for resident binaries, or 0 for no limit
+     * @param epaxProgram the path of the epax program, or "" to find it on $PATH
+     * @return only if the socket cannot be set up, in which case false
+     */
+    extern bool EPAX_serve(std::string socketPath, uint64_t memBudget, std::string epaxProgram);
 
     /**
      * Creates a BIN object
      * 
-     * @param fileName The name of a binary file. Allowed formats are: ELF, MachO
+     * @param fileName The name of a binary file. Allowed formats are: ELF, MachO, PE
      * @return a BIN object created using the input parameter
      */
     extern BIN BIN_create(std::string fileName);
 
+    /**
+     * Creates a BIN object whose analysis is kept in a persistent cache. Entries are
+     * keyed by the binary's build-id, or by the SHA-1 of its contents, so an unchanged
+     * binary is restored from the cache rather than being disassembled again.
+     * BIN_create uses the directory named by $EPAX_CACHE_DIR in the same way.
+     *
+     * @param fileName The name of a binary file. Allowed formats are: ELF, MachO, PE
+     * @param cacheDir The directory holding analysis cache entries
+     * @return a BIN object created using the input parameters
+     */
+    extern BIN BIN_createCached(std::string fileName, std::string cacheDir);
+
+    // selects the ARM slice (or failing that the ARM64 slice, or failing that the first)
+#define EPAX_SLICE_DEFAULT 0xffffffff
+
+    /**
+     * Creates a BIN object from one slice of a universal (fat) Mach-O file. Only the
+     * fat header and the selected slice are read, however large the file. Other files
+     * are used whole. BIN_create and BIN_createCached use the EPAX_SLICE_DEFAULT slice.
+     *
+     * @param fileName The name of a binary file
+     * @param cpuType The Mach-O cpu type of the slice (e.g. 12 for ARM, 0x0100000c for
+     *     ARM64), or EPAX_SLICE_DEFAULT
+     * @param cacheDir The directory holding analysis cache entries, or "" for none
+     * @return a BIN object created using the input parameters
+     */
+    extern BIN BIN_createSlice(std::string fileName, uint32_t cpuType, std::string cacheDir);
+
+    /**
+     * Counts the members of a static archive (.a). Archive symbol tables are not counted.
+     *
+     * @param fileName The name of a file
+     * @return the number of members, or 0 if fileName is not an archive
+     */
+    extern uint32_t BIN_countMembers(std::string fileName);
+
+    /**
+     * Gets the names of all members of a static archive (.a), reading its member
+     * headers once. Archive symbol tables are not listed. The archive is kept, so
+     * that creating its members with BIN_createMember does not read the headers again,
+     * including in a process forked after this call.
+     *
+     * @param fileName The name of a file
+     * @param names (out) the members' names, in index order
+     * @return the number of members, or 0 if fileName is not an archive
+     */
+    extern uint32_t BIN_listMembers(std::string fileName, std::vector<std::string>& names);
+
+    /**
+     * Gets the name of a member of a static archive
+     *
+     * @param fileName The name of an archive
+     * @param idx a member index, less than BIN_countMembers(fileName)
+     * @return the member's name
+     */
+    extern std::string BIN_getMemberName(std::string fileName, uint32_t idx);
+
+    /**
+     * Creates a BIN object from one member of a static archive, e.g. a relocatable
+     * object. Only that member is read, so the members of an archive can be analyzed
+     * concurrently. The BIN is named archive(member).
+     *
+     * @param fileName The name of an archive
+     * @param idx a member index, less than BIN_countMembers(fileName)
+     * @param cacheDir The directory holding analysis cache entries, or "" for none
+     * @return a BIN object created using the input parameters
+     */
+    extern BIN BIN_createMember(std::string fileName, uint32_t idx, std::string cacheDir);
+
+    /**
+     * Creates a BIN object from an image held in memory, e.g. one received over a
+     * socket. The image is read in place, so the buffer must outlive the BIN.
+     *
+     * @param buffer the image, laid out as it would be in a file
+     * @param size the size of buffer
+     * @param name a name for the BIN
+     * @param cacheDir The directory holding analysis cache entries, or "" for none
+     * @return a BIN object created using the input parameters
+     */
+    extern BIN BIN_createFromMemory(const void* buffer, uint64_t size, std::string name, std::string cacheDir);
+
+    /**
+     * Creates a BIN object from a region of the address space of a live process, read
+     * through /proc/<pid>/mem one page at a time as the analysis needs it. The region
+     * must hold an image laid out as it would be in a file (e.g. an unpacked image),
+     * not one mapped by segments. Needs the same permission as attaching to pid.
+     *
+     * @param pid the process id
+     * @param addr the address of the region
+     * @param size the size of the region
+     * @param name a name for the BIN
+     * @param cacheDir The directory holding analysis cache entries, or "" for none
+     * @return a BIN object created using the input parameters
+     */
+    extern BIN BIN_createFromProcess(uint32_t pid, uint64_t addr, uint64_t size, std::string name, std::string cacheDir);
+
 
     /**
      * returns the name of a BIN object
@@ -81,6 +227,8 @@ namespace EPAX {
 
     /**
      * Runs a the program represented by BIN with arguments; does not return.
+     * Except on ARMv7 hosts, the program runs under the sampler of BIN_profile and
+     * its report is printed when the program exits.
      *
      * @param bin a BIN object for which BIN_isExecutable returns true
      * @param argc the number of program arguments
@@ -89,6 +237,54 @@ namespace EPAX {
      */
     extern void BIN_run(BIN bin, int argc, char** argv);
 
+    /**
+     * Profiles a process running the program represented by BIN. The program counter
+     * of each of its threads is sampled with ptrace at a fixed rate, and a report of
+     * the samples per loop, function and basic block is written when sampling stops.
+     *
+     * @param bin a BIN object
+     * @param pid a running process to attach to, or 0 to start argv
+     * @param argv the program and its arguments, NULL-terminated; used only if pid is 0
+     * @param hz samples per second, or 0 for the default
+     * @param seconds detach after this long and leave the process running, or 0 to sample until it exits
+     * @param outFile where to write the report, or an empty string for standard output
+     * @return the exit status of the process, or -1 if it could not be traced or was detached
+     */
+    extern int32_t BIN_profile(BIN bin, uint32_t pid, char** argv, uint32_t hz, uint32_t seconds, std::string outFile);
+
+    /**
+     * Counts the executions of each basic block of BIN in a process, using a software
+     * breakpoint at the start of every block, and writes a report of the counts and of
+     * the coverage of each function when tracing stops.
+     *
+     * @param bin a BIN object
+     * @param pid a running process to attach to, or 0 to start argv
+     * @param argv the program and its arguments, NULL-terminated; used only if pid is 0
+     * @param maxHits the count at which a block stops being counted, or 0 for none; 1 measures coverage only
+     * @param seconds detach after this long and leave the process running, or 0 to trace until it exits
+     * @param outFile where to write the report, or an empty string for standard output
+     * @return the exit status of the process, or -1 if it could not be traced or was detached
+     */
+    extern int32_t BIN_countBbls(BIN bin, uint32_t pid, char** argv, uint32_t maxHits, uint32_t seconds, std::string outFile);
+
+    /**
+     * Measures the trip counts of the loops of BIN in a process, using software
+     * breakpoints on the head of each loop and on the targets of its exit edges, and
+     * writes a report of the invocations, iterations and trip count histogram of each
+     * loop when tracing stops. A loop stops being profiled once it has been invoked
+     * maxInvocations times. Not available on 32-bit ARM hosts, which cannot step over
+     * a breakpoint to keep it in place.
+     *
+     * @param bin a BIN object
+     * @param pid a running process to attach to, or 0 to start argv
+     * @param argv the program and its arguments, NULL-terminated; used only if pid is 0
+     * @param maxInvocations the invocations profiled per loop, or 0 for the default
+     * @param seconds detach after this long and leave the process running, or 0 to trace until it exits
+     * @param outFile where to write the report, or an empty string for standard output
+     * @return the exit status of the process, or -1 if it could not be traced or was detached
+     */
+    extern int32_t BIN_profileLoops(BIN bin, uint32_t pid, char** argv, uint32_t maxInvocations, uint32_t seconds, std::string outFile);
+
     /**
      * Gets the first function in a BIN object
      *
@@ -131,17 +327,49 @@ namespace EPAX {
      */
     extern bool BIN_isExecutable(BIN bin);
 
+    /**
+     * Selects decoding each executable section of a BIN once, in a linear sweep, instead
+     * of each function on its own. This finds functions that have no symbol. Only ELF
+     * supports it; other formats ignore it. It must be called before anything asks for
+     * the functions of bin, and it only affects bin.
+     *
+     * @param bin a BIN
+     * @param on whether to decode bin in a linear sweep
+     */
+    extern void BIN_setLinearSweep(BIN bin, bool on);
+
+    /**
+     * Selects classifying the AArch64 instructions of a BIN from a decode table instead
+     * of fully disassembling them. The text of an instruction is then decoded, a function
+     * at a time, only when asked for, and group names come from the table. Other
+     * instruction sets ignore it. It must be called before anything asks for the
+     * functions of bin, and it only affects bin.
+     *
+     * @param bin a BIN
+     * @param on whether to classify the instructions of bin from the decode table
+     */
+    extern void BIN_setFastDecode(BIN bin, bool on);
+
     /**
      * Find the file size of a BIN
      *
      * @param bin a BIN
      * @return the size of the file used to create bin
      */
-    extern uint32_t BIN_fileSize(BIN bin);
+    extern uint64_t BIN_fileSize(BIN bin);
+
+    /**
+     * Find the SHA-1 digest of the contents of a BIN
+     *
+     * @param bin a BIN
+     * @return the hex SHA-1 digest of the file used to create bin
+     */
+    extern std::string BIN_contentHash(BIN bin);
 
     /**
      * Print a static file containing detailed information about the structures
-     * found in a BIN
+     * found in a BIN. The +str text of instructions classified from the decode table
+     * (BIN_setFastDecode) is left out, so that writing the file does not decode them.
      *
      * @param bin a BIN
      * @param fname the name of the output file to catch static analysis
@@ -149,6 +377,18 @@ namespace EPAX {
      */
     extern void BIN_printStaticFile(BIN bin, std::string fname);
 
+    /**
+     * Print a binary analysis database holding the functions, blocks, instructions
+     * and loops of a BIN as fixed-width tables. The file can be mapped and queried
+     * in place, without parsing, using the reader in EPAXDatabase.h. Instructions
+     * classified from the decode table (BIN_setFastDecode) get empty text.
+     *
+     * @param bin a BIN
+     * @param fname the name of the output database file
+     * @return none
+     */
+    extern void BIN_printDatabaseFile(BIN bin, std::string fname);
+
     /**
      * Find the function at a given virtual address
      *
@@ -156,27 +396,66 @@ namespace EPAX {
      * @param addr a virtual address
      * @return the FUNC at addr in bin
      */
-    extern FUNC BIN_findFunc(BIN bin, uint64_t addr);
+    extern FUNC BIN_findFuncAt(BIN bin, uint64_t addr);
+
+    /**
+     * Tells whether a BIN carries debug line information
+     *
+     * @param bin a BIN
+     * @return true iff source lines can be found for addresses in bin
+     */
+    extern bool BIN_hasDebugLineInfo(BIN bin);
+
+    /**
+     * Find the source line of a given virtual address
+     *
+     * @param bin a BIN
+     * @param addr a virtual address
+     * @return the source line number of addr, or 0 if it is unknown
+     */
+    extern uint32_t BIN_debugLineNumber(BIN bin, uint64_t addr);
+
+    /**
+     * Find the source file of a given virtual address
+     *
+     * @param bin a BIN
+     * @param addr a virtual address
+     * @return the name of the source file containing addr
+     */
+    extern std::string BIN_debugFileName(BIN bin, uint64_t addr);
+
+    // instruction sets for FUNC_create
+#define EPAX_MODE_ARM     0
+#define EPAX_MODE_THUMB   1
+#define EPAX_MODE_AARCH64 2
 
     /**
      * Generate a function using the supplied bytes. Note that the size of the function
      * found may be smaller than the size of the input buffer supplied. Use FUNC_size
      * on the returned FUNC to find its size.
      *
+     * The bytes are decoded where they are, so the buffer must not change or go away
+     * until FUNC_destroy. The function belongs to no BIN. Disassembler handles are
+     * recycled from destroyed functions, so creating and destroying functions at a
+     * high rate (e.g. for code emitted by a JIT) is cheap.
+     *
      * @param bytes a buffer of raw instruction bytes
      * @param size the size of the buffer
-     * @return a FUNC generated using the bytes supplied in buf
+     * @param addr the address of the first byte, used for branch targets
+     * @param mode EPAX_MODE_ARM, EPAX_MODE_THUMB or EPAX_MODE_AARCH64
+     * @return a FUNC generated using the bytes supplied in buf, or NULL in validating
+     * mode if bytes is NULL or mode is unknown
      */
-    extern FUNC FUNC_create(uint8_t* bytes, uint32_t size);
+    extern FUNC FUNC_create(uint8_t* bytes, uint32_t size, uint64_t addr, uint32_t mode);
 
     /**
      * Destroy a function; note that it is an error to destroy a function that was
      * not created with FUNC_create
      *
-     * @param func a FUNC object that was created with FUNC_Create
+     * @param func a FUNC object that was created with FUNC_create
      * @return none
      */
-    extern void FUNC_Destroy(FUNC func);
+    extern void FUNC_destroy(FUNC func);
 
     /**
      * Print a FUNC
@@ -200,7 +479,7 @@ namespace EPAX {
      * @param func a FUNC object
      * @return the size of func in bytes
      */
-    extern uint32_t FUNC_size(FUNC func);
+    extern uint64_t FUNC_size(FUNC func);
 
     /**
      * Get the virtual address of a FUNC
@@ -210,6 +489,14 @@ namespace EPAX {
      */
     extern uint64_t FUNC_addr(FUNC func);
 
+    /**
+     * Get the offset of a FUNC in its file
+     * 
+     * @param func a FUNC object
+     * @return the file offset of the first byte of func
+     */
+    extern uint64_t FUNC_fileOffset(FUNC func);
+
     /**
      * Get the name of the section that contains a FUNC
      *
@@ -402,7 +689,7 @@ namespace EPAX {
      * @param loop a LOOP object
      * @return the size in bytes of loop
      */
-    extern uint32_t LOOP_size(LOOP loop);
+    extern uint64_t LOOP_size(LOOP loop);
 
     /**
      * Get the number of BBL objects in a LOOP
@@ -811,6 +1098,41 @@ namespace EPAX {
      */
     extern bool INSN_isMemop(INSN insn);
 
+    /**
+     * Does an INSN read memory
+     *
+     * @param insn an INSN object
+     * @return true iff insn loads from memory
+     */
+    extern bool INSN_isLoad(INSN insn);
+
+    /**
+     * Does an INSN write memory
+     *
+     * @param insn an INSN object
+     * @return true iff insn stores to memory
+     */
+    extern bool INSN_isStore(INSN insn);
+
+    /**
+     * Get the names of the instruction groups (e.g. vfp, neon) an INSN belongs to. AArch64
+     * instructions classified from the decode table only report the
+     * groups jump, call, ret, neon and fparmv8 (see BIN_setFastDecode)
+     *
+     * @param insn an INSN object
+     * @param groups (out) the group names of insn
+     * @return the number of groups insn belongs to
+     */
+    extern uint32_t INSN_groupNames(INSN insn, std::vector<std::string>& groups);
+
+    /**
+     * Count the instruction groups an INSN belongs to
+     *
+     * @param insn an INSN object
+     * @return the number of groups insn belongs to
+     */
+    extern uint32_t INSN_groupCount(INSN insn);
+
     /**
      * Get the size in of an INSN in bytes
      *
@@ -864,6 +1186,346 @@ namespace EPAX {
     extern std::string INSN_mnemonic(INSN insn);
     */
 
+    /**
+     * Bulk queries. These fill caller-provided arrays with one entry per function, block
+     * or instruction, and cost a single call regardless of size. Size the arrays with
+     * the matching count query (BIN_countFunc, BIN_countBbl, BIN_countInsn, FUNC_countBbl,
+     * FUNC_countInsn, FUNC_countEdges). Any array may be NULL to skip that column.
+     * Loop ids are the index of the innermost loop within its function (see LOOP_index),
+     * or EPAX_ID_NONE outside of loops.
+     */
+#define EPAX_ID_NONE          0xffffffff
+
+#define EPAX_ATTR_BRANCH      0x0001
+#define EPAX_ATTR_CONDBRANCH  0x0002
+#define EPAX_ATTR_CALL        0x0004
+#define EPAX_ATTR_RETURN      0x0008
+#define EPAX_ATTR_FALLTHROUGH 0x0010
+#define EPAX_ATTR_FPOP        0x0020
+#define EPAX_ATTR_LOAD        0x0040
+#define EPAX_ATTR_STORE       0x0080
+#define EPAX_ATTR_PREDICATED  0x0100
+
+    /**
+     * Count the basic blocks in a BIN
+     *
+     * @param bin a BIN
+     * @return the number of basic blocks in all functions of bin
+     */
+    extern uint32_t BIN_countBbl(BIN bin);
+
+    /**
+     * Count the instructions in a BIN
+     *
+     * @param bin a BIN
+     * @return the number of instructions in all functions of bin
+     */
+    extern uint32_t BIN_countInsn(BIN bin);
+
+    /**
+     * Describe every function of a BIN
+     *
+     * @param bin a BIN
+     * @param addrs (out) the address of each function
+     * @param sizes (out) the size in bytes of each function
+     * @param bblCounts (out) the number of blocks in each function
+     * @param insnCounts (out) the number of instructions in each function
+     * @return the number of functions described
+     */
+    extern uint32_t BIN_funcInfo(BIN bin, uint64_t* addrs, uint64_t* sizes, uint32_t* bblCounts, uint32_t* insnCounts);
+
+    /**
+     * Describe every basic block of a BIN, in function order
+     *
+     * @param bin a BIN
+     * @param addrs (out) the address of each block
+     * @param sizes (out) the size in bytes of each block
+     * @param insnCounts (out) the number of instructions in each block
+     * @param funcIds (out) the index of the function containing each block
+     * @param loopIds (out) the loop id of each block
+     * @return the number of blocks described
+     */
+    extern uint32_t BIN_bblInfo(BIN bin, uint64_t* addrs, uint64_t* sizes, uint32_t* insnCounts, uint32_t* funcIds, uint32_t* loopIds);
+
+    /**
+     * Describe every instruction of a BIN, in function order
+     *
+     * @param bin a BIN
+     * @param addrs (out) the address of each instruction
+     * @param sizes (out) the size in bytes of each instruction
+     * @param attrs (out) the EPAX_ATTR_* flags of each instruction
+     * @param funcIds (out) the index of the function containing each instruction
+     * @param bblIds (out) the binary-wide index of the block containing each instruction
+     * @param loopIds (out) the loop id of each instruction
+     * @return the number of instructions described
+     */
+    extern uint32_t BIN_insnInfo(BIN bin, uint64_t* addrs, uint64_t* sizes, uint32_t* attrs, uint32_t* funcIds, uint32_t* bblIds, uint32_t* loopIds);
+
+    /**
+     * Describe every basic block of a FUNC
+     *
+     * @param func a FUNC
+     * @param addrs (out) the address of each block
+     * @param sizes (out) the size in bytes of each block
+     * @param insnCounts (out) the number of instructions in each block
+     * @param loopIds (out) the loop id of each block
+     * @return the number of blocks described
+     */
+    extern uint32_t FUNC_bblInfo(FUNC func, uint64_t* addrs, uint64_t* sizes, uint32_t* insnCounts, uint32_t* loopIds);
+
+    /**
+     * Describe every instruction of a FUNC
+     *
+     * @param func a FUNC
+     * @param addrs (out) the address of each instruction
+     * @param sizes (out) the size in bytes of each instruction
+     * @param attrs (out) the EPAX_ATTR_* flags of each instruction
+     * @param bblIds (out) the index within func of the block containing each instruction
+     * @param loopIds (out) the loop id of each instruction
+     * @return the number of instructions described
+     */
+    extern uint32_t FUNC_insnInfo(FUNC func, uint64_t* addrs, uint64_t* sizes, uint32_t* attrs, uint32_t* bblIds, uint32_t* loopIds);
+
+    /**
+     * Count the control flow edges between the basic blocks of a FUNC
+     *
+     * @param func a FUNC
+     * @return the number of block-to-block edges in func
+     */
+    extern uint32_t FUNC_countEdges(FUNC func);
+
+    /**
+     * List the control flow edges between the basic blocks of a FUNC
+     *
+     * @param func a FUNC
+     * @param srcIds (out) the index within func of the source block of each edge
+     * @param dstIds (out) the index within func of the target block of each edge
+     * @return the number of edges listed
+     */
+    extern uint32_t FUNC_edges(FUNC func, uint32_t* srcIds, uint32_t* dstIds);
+
+    /**
+     * Get the attributes of an INSN
+     *
+     * @param insn an INSN object
+     * @return the EPAX_ATTR_* flags of insn
+     */
+    extern uint32_t INSN_attrs(INSN insn);
+
+    /**
+     * List queries. These expose the lists an object already keeps, in index order,
+     * without a call per element. A list stays valid as long as the object that owns
+     * it. EPAX.hpp wraps each of these as a range for C++ range-based for loops.
+     */
+
+    /**
+     * Get the list of functions in a BIN
+     *
+     * @param bin a BIN
+     * @param list (out) the first function, or NULL if there are none
+     * @return the number of functions in list
+     */
+    extern uint32_t BIN_funcList(BIN bin, FUNC const** list);
+
+    /**
+     * Get the list of basic blocks in a FUNC
+     *
+     * @param func a FUNC
+     * @param list (out) the first block, or NULL if there are none
+     * @return the number of blocks in list
+     */
+    extern uint32_t FUNC_bblList(FUNC func, BBL const** list);
+
+    /**
+     * Get the list of instructions in a FUNC
+     *
+     * @param func a FUNC
+     * @param list (out) the first instruction, or NULL if there are none
+     * @return the number of instructions in list
+     */
+    extern uint32_t FUNC_insnList(FUNC func, INSN const** list);
+
+    /**
+     * Get the list of loops in a FUNC
+     *
+     * @param func a FUNC
+     * @param list (out) the first loop, or NULL if there are none
+     * @return the number of loops in list
+     */
+    extern uint32_t FUNC_loopList(FUNC func, LOOP const** list);
+
+    /**
+     * Get the list of basic blocks in a LOOP
+     *
+     * @param loop a LOOP
+     * @param list (out) the first member block, or NULL if there are none
+     * @return the number of blocks in list
+     */
+    extern uint32_t LOOP_bblList(LOOP loop, BBL const** list);
+
+    /**
+     * Get the list of instructions in a BBL
+     *
+     * @param bbl a BBL
+     * @param list (out) the first instruction, or NULL if there are none
+     * @return the number of instructions in list
+     */
+    extern uint32_t BBL_insnList(BBL bbl, INSN const** list);
+
+    /**
+     * Get the list of blocks that flow into a BBL
+     *
+     * @param bbl a BBL
+     * @param list (out) the first source block, or NULL if there are none
+     * @return the number of blocks in list
+     */
+    extern uint32_t BBL_sourceList(BBL bbl, BBL const** list);
+
+    /**
+     * Get the list of blocks that a BBL flows into
+     *
+     * @param bbl a BBL
+     * @param list (out) the first target block, or NULL if there are none
+     * @return the number of blocks in list
+     */
+    extern uint32_t BBL_targetList(BBL bbl, BBL const** list);
+
+    /**
+     * Reads a static file written by BIN_printStaticFile. The file is mapped and parsed
+     * in parallel into per-column arrays; only the records named in fields are read.
+     *
+     * @param fileName the name of a static file
+     * @param fields comma-separated record names to read (e.g. "str,flw,lpi"), or empty for all
+     * @return an SFILE holding the parsed columns
+     */
+    extern SFILE SFILE_open(std::string fileName, std::string fields);
+
+    /**
+     * frees all memory associated with an SFILE object
+     *
+     * @param sfile an SFILE
+     * @return none
+     */
+    extern void SFILE_close(SFILE sfile);
+
+    /**
+     * Count the instruction records of an SFILE
+     *
+     * @param sfile an SFILE
+     * @return the number of instructions in sfile
+     */
+    extern uint64_t SFILE_countInsn(SFILE sfile);
+
+    /**
+     * Get a value from the header of an SFILE
+     *
+     * @param sfile an SFILE
+     * @param key a header key (e.g. appname, sha1sum)
+     * @return the value of key, or an empty string if it is not present
+     */
+    extern std::string SFILE_header(SFILE sfile, std::string key);
+
+    /**
+     * Get the address column of an SFILE. Like all columns, the array holds one entry
+     * per instruction and stays valid until the SFILE is closed.
+     *
+     * @param sfile an SFILE
+     * @return the virtual address of each instruction
+     */
+    extern const uint64_t* SFILE_addrs(SFILE sfile);
+
+    /**
+     * Get the function id column of an SFILE
+     *
+     * @param sfile an SFILE
+     * @return the function id of each instruction
+     */
+    extern const uint32_t* SFILE_funcIds(SFILE sfile);
+
+    /**
+     * Get the block id column of an SFILE
+     *
+     * @param sfile an SFILE
+     * @return the block id of each instruction
+     */
+    extern const uint32_t* SFILE_bblIds(SFILE sfile);
+
+    /**
+     * Get the source line column of an SFILE
+     *
+     * @param sfile an SFILE
+     * @return the source line of each instruction
+     */
+    extern const uint32_t* SFILE_lines(SFILE sfile);
+
+    /**
+     * Get the instruction size column (+isa) of an SFILE
+     *
+     * @param sfile an SFILE
+     * @return the size in bytes of each instruction, or NULL if +isa was not read
+     */
+    extern const uint32_t* SFILE_sizes(SFILE sfile);
+
+    /**
+     * Get the operation count column (+cnt) of an SFILE
+     *
+     * @param sfile an SFILE
+     * @return a bitmask per instruction of 1:branch, 2:fp, 4:load, 8:store, or NULL if +cnt was not read
+     */
+    extern const uint8_t* SFILE_counts(SFILE sfile);
+
+    /**
+     * Get the loop id column (+lpi) of an SFILE
+     *
+     * @param sfile an SFILE
+     * @return the loop id of each instruction (0xffffffff outside loops), or NULL if +lpi was not read
+     */
+    extern const uint32_t* SFILE_loopIds(SFILE sfile);
+
+    /**
+     * Get the loop depth column (+lpi) of an SFILE
+     *
+     * @param sfile an SFILE
+     * @return the loop depth of each instruction, or NULL if +lpi was not read
+     */
+    extern const uint32_t* SFILE_loopDepths(SFILE sfile);
+
+    /**
+     * Get the call target column (+ipa) of an SFILE
+     *
+     * @param sfile an SFILE
+     * @return the call target of each instruction (0 if not a call), or NULL if +ipa was not read
+     */
+    extern const uint64_t* SFILE_callTargets(SFILE sfile);
+
+    /**
+     * Get the function name of an instruction in an SFILE
+     *
+     * @param sfile an SFILE
+     * @param idx an instruction index
+     * @return the name of the function containing instruction idx
+     */
+    extern std::string SFILE_funcName(SFILE sfile, uint64_t idx);
+
+    /**
+     * Get the disassembly (+str) of an instruction in an SFILE
+     *
+     * @param sfile an SFILE
+     * @param idx an instruction index
+     * @return the string representation of instruction idx
+     */
+    extern std::string SFILE_insnString(SFILE sfile, uint64_t idx);
+
+    /**
+     * Get the control targets (+flw) of an instruction in an SFILE
+     *
+     * @param sfile an SFILE
+     * @param idx an instruction index
+     * @param tlist (out) the control targets of instruction idx
+     * @return the number of control targets
+     */
+    extern uint32_t SFILE_targets(SFILE sfile, uint64_t idx, std::vector<uint64_t>& tlist);
+
 } // namespace EPAX
 
 #endif // __EPAX_Interface_hpp__
@@ -0,0 +1,174 @@
+/**
+ * @file LinearSweep.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+#include "FastInstruction.hpp"
+#include "Function.hpp"
+#include "InputFile.hpp"
+#include "LinearSweep.hpp"
+
+namespace EPAX {
+
+    static bool compareMarks(const std::pair<uint64_t, DisasmMode>& m1, const std::pair<uint64_t, DisasmMode>& m2){
+        return (m1.first < m2.first);
+    }
+
+    LinearSweep::LinearSweep(BaseBinary* b, uint64_t o, uint64_t s, uint64_t a, bool isv8)
+        : FileBase(b, o, s),
+          MemoryBase(a, s),
+          isARMv8(isv8)
+    {
+    }
+
+    LinearSweep::~LinearSweep(){
+        for (uint32_t i = 0; i < insns.size(); i++){
+            if (!claimed[i] && IS_VALID_PTR(insns[i])){
+                delete insns[i];
+            }
+        }
+    }
+
+    void LinearSweep::addMark(uint64_t a, DisasmMode m){
+        if (inRange(a)){
+            marks.push_back(std::pair<uint64_t, DisasmMode>(a, m));
+        }
+    }
+
+    void LinearSweep::decode(Function* owner){
+        uint64_t size = getFileSize();
+        if (size > 0xffffffff){
+            EPAXWarn << "Only sweeping the first 4 GB of the section at " << HEX(getMemoryAddress()) << ENDL;
+            size = 0xffffffff;
+        }
+
+        std::stable_sort(marks.begin(), marks.end(), compareMarks);
+        if (marks.size() == 0 || marks.front().first != getMemoryAddress()){
+            marks.insert(marks.begin(), std::pair<uint64_t, DisasmMode>(getMemoryAddress(), DisasmMode_ARM));
+        }
+
+        rawbyte_t* copy = NULL;
+        rawbyte_t* buf = (rawbyte_t*)getInputFile()->getView(getFileOffset(), size);
+        if (buf == NULL){
+            copy = new rawbyte_t[size];
+            getInputFile()->getBytes(getFileOffset(), size, copy);
+            buf = copy;
+        }
+
+        std::vector<void*> handlers;
+        for (uint32_t i = 0; i < marks.size(); i++){
+            uint64_t start = marks[i].first;
+            uint64_t end = (i + 1 < marks.size()? marks[i + 1].first: getMemoryAddress() + size);
+
+            // data, or a mark superseded by another at the same address
+            if (marks[i].second == DisasmMode_INVLD || end <= start){
+                continue;
+            }
+
+            std::vector<Instruction*> region;
+            fastmap<uint64_t, uint32_t>::map region_map;
+            if (isARMv8 && getBinary()->isFastDecode()){
+                FastInstruction::classify(buf + (start - getMemoryAddress()), start, end - start, region, region_map, owner);
+            } else {
+                Instruction::disassemble(buf + (start - getMemoryAddress()), start, end - start, region, region_map, marks[i].second, owner, handlers, isARMv8);
+            }
+
+            for (std::vector<Instruction*>::const_iterator it = region.begin(); it != region.end(); it++){
+                insns.push_back(*it);
+                addrs.push_back((*it)->getMemoryAddress());
+                claimed.push_back(false);
+            }
+        }
+        Instruction::freedisasm(handlers);
+
+        if (copy != NULL){
+            delete[] copy;
+        }
+    }
+
+    // the index of the first instruction at or after a
+    uint32_t LinearSweep::lowerBound(uint64_t a){
+        return std::lower_bound(addrs.begin(), addrs.end(), a) - addrs.begin();
+    }
+
+    bool LinearSweep::slice(Function* f){
+        uint64_t start = f->getMemoryAddress();
+        uint64_t end = start + f->getMemorySize();
+
+        uint32_t first = lowerBound(start);
+        uint32_t last = first;
+        bool free = true;
+        while (last < insns.size() && addrs[last] < end){
+            free = free && !claimed[last];
+            last++;
+        }
+
+        // overlaps a function that already has these instructions; drop the copies
+        // f would share, since f will decode its own
+        if (!free){
+            for (uint32_t i = first; i < last; i++){
+                if (!claimed[i]){
+                    delete insns[i];
+                    insns[i] = INVALID_PTR;
+                    claimed[i] = true;
+                }
+            }
+            return false;
+        }
+
+        std::vector<Instruction*> mine(insns.begin() + first, insns.begin() + last);
+        for (uint32_t i = first; i < last; i++){
+            claimed[i] = true;
+        }
+        f->disassemble(mine);
+        return true;
+    }
+
+    uint32_t LinearSweep::countUnclaimed(){
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < claimed.size(); i++){
+            if (!claimed[i]){
+                n++;
+            }
+        }
+        return n;
+    }
+
+    bool LinearSweep::findUnclaimed(uint64_t a, uint64_t& start, uint64_t& end){
+        uint32_t i = lowerBound(a);
+        while (i < insns.size() && claimed[i]){
+            i++;
+        }
+        if (i == insns.size()){
+            return false;
+        }
+
+        start = addrs[i];
+        end = addrs[i] + insns[i]->getMemorySize();
+        for (i++; i < insns.size() && !claimed[i] && addrs[i] == end; i++){
+            end += insns[i]->getMemorySize();
+        }
+        return true;
+    }
+
+} // namespace EPAX
@@ -0,0 +1,106 @@
+/**
+ * @file LinearSweep.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_LinearSweep_hpp__
+#define __EPAX_LinearSweep_hpp__
+
+#include "BaseClass.hpp"
+#include "Instruction.hpp"
+
+namespace EPAX {
+
+    class Function;
+
+    /**
+     * Decodes an executable section once, in a single linear sweep, into one table of
+     * instructions. The section is read with one read and split into regions by marks
+     * (ARM mapping symbols, or function starts when there are none); each code region
+     * is decoded in its own mode and data regions are skipped. Functions are then
+     * formed from slices of the table, so bytes shared by aliased symbols are decoded
+     * once and code between symbols is decoded too.
+     */
+    class LinearSweep : public FileBase, public MemoryBase {
+    private:
+        bool isARMv8;
+        std::vector<std::pair<uint64_t, DisasmMode> > marks;
+
+        // decoded instructions in address order, and their addresses. claimed ones belong
+        // to a function, or were dropped (NULL) because their function was decoded apart
+        std::vector<Instruction*> insns;
+        std::vector<uint64_t> addrs;
+        std::vector<bool> claimed;
+
+        uint32_t lowerBound(uint64_t a);
+
+    public:
+        /**
+         * @param b the binary
+         * @param o the file offset of the section
+         * @param s the size of the section
+         * @param a the address of the section
+         * @param isv8 whether the section holds AArch64 code
+         */
+        LinearSweep(BaseBinary* b, uint64_t o, uint64_t s, uint64_t a, bool isv8);
+        virtual ~LinearSweep();
+
+        /**
+         * Records that code in mode m, or data if m is DisasmMode_INVLD, starts at a
+         * and runs to the next mark. Bytes before the first mark are ARM (or AArch64) code.
+         */
+        void addMark(uint64_t a, DisasmMode m);
+
+        /**
+         * Decodes every code region
+         *
+         * @param owner a function of the binary, handed to the decoder
+         */
+        void decode(Function* owner);
+
+        /**
+         * Hands f the instructions in its range. This fails if they have been handed to
+         * another function already (overlapping symbols), in which case f should be
+         * disassembled on its own.
+         *
+         * @return true if f now has its control flow
+         */
+        bool slice(Function* f);
+
+        uint32_t countInstructions() { return insns.size(); }
+
+        /**
+         * Counts the instructions that belong to no function yet, e.g. code between symbols
+         */
+        uint32_t countUnclaimed();
+
+        /**
+         * Gets the range [start, end) of the first run of unclaimed code at or after a
+         *
+         * @return false if there is none
+         */
+        bool findUnclaimed(uint64_t a, uint64_t& start, uint64_t& end);
+    }; // class LinearSweep
+
+} // namespace EPAX
+
+#endif // __EPAX_LinearSweep_hpp__
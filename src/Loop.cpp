@@ -31,6 +31,10 @@
 
 namespace EPAX {
 
+    static bool compareIndex(BasicBlock* a, BasicBlock* b){
+        return a->getIndex() < b->getIndex();
+    }
+
     Loop::Loop(ControlFlow* c, uint32_t h, uint32_t t, uint32_t d, dyn_bitset* m, uint32_t i)
         : IndexBase(i),
           EPAXExport(EPAXExportClass_LOOP),
@@ -43,6 +47,7 @@ namespace EPAX {
             if (members->has(i)){
                 BasicBlock* bb = cfg->getBasicBlock(i);
                 bb->setLoop(this);
+                memberlist.push_back(bb);
             }
         }
     }
@@ -54,7 +59,7 @@ namespace EPAX {
     }
 
     BasicBlock* Loop::head(){
-        EPAXAssert(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
+        EPAXCheck(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
 
         if (!members->has(headidx)){
             EPAXOut << "bad head" << ENDL;
@@ -65,7 +70,7 @@ namespace EPAX {
     }
 
     BasicBlock* Loop::tail(){
-        EPAXAssert(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
+        EPAXCheck(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
 
         if (!members->has(tailidx)){
             EPAXOut << "bad tail" << ENDL;
@@ -84,41 +89,31 @@ namespace EPAX {
     }
 
     uint32_t Loop::countInstructions(){
-        EPAXAssert(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
+        EPAXCheck(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
 
         uint32_t icnt = 0;
-        for (uint32_t i = 0; i < members->size(); i++){
-            if (members->has(i)){
-                icnt += cfg->getBasicBlock(i)->countInstructions();
-            }
+        for (std::vector<BasicBlock*>::const_iterator it = memberlist.begin(); it != memberlist.end(); it++){
+            icnt += (*it)->countInstructions();
         }
         return icnt;
     }
 
     uint32_t Loop::countBasicBlocks(){
-        uint32_t bbcnt = 0;
-        for (uint32_t i = 0; i < members->size(); i++){
-            if (members->has(i)){
-                bbcnt++;
-            }
-        }
-        return bbcnt;
+        return memberlist.size();
     }
 
-    uint32_t Loop::getSize(){
-        EPAXAssert(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
+    uint64_t Loop::getSize(){
+        EPAXCheck(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
 
-        uint32_t lpsize = 0;
-        for (uint32_t i = 0; i < members->size(); i++){
-            if (members->has(i)){
-                lpsize += cfg->getBasicBlock(i)->getMemorySize();
-            }
+        uint64_t lpsize = 0;
+        for (std::vector<BasicBlock*>::const_iterator it = memberlist.begin(); it != memberlist.end(); it++){
+            lpsize += (*it)->getMemorySize();
         }
         return lpsize;
     }
 
     BasicBlock* Loop::findBasicBlock(uint64_t addr){
-        EPAXAssert(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
+        EPAXCheck(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
 
         BasicBlock* bb = cfg->findBasicBlock(addr);
         if (!IS_VALID_PTR(bb)){
@@ -137,7 +132,7 @@ namespace EPAX {
     }
 
     BasicBlock* Loop::getBasicBlock(uint32_t idx){
-        EPAXAssert(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
+        EPAXCheck(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
 
         if (!members->has(idx)){
             return INVALID_PTR;
@@ -147,36 +142,34 @@ namespace EPAX {
     }
     
     BasicBlock* Loop::getNextBasicBlock(uint32_t idx){
-        EPAXAssert(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
+        EPAXCheck(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
 
         if (!members->has(idx)){
             return INVALID_PTR;
         }
 
-        uint32_t n = cfg->countBasicBlocks();
-        for (uint32_t i = idx + 1; i < n; i++){
-            if (members->has(i)){
-                return cfg->getBasicBlock(i);
-            }
+        std::vector<BasicBlock*>::const_iterator it = std::upper_bound(memberlist.begin(), memberlist.end(), cfg->getBasicBlock(idx), compareIndex);
+        if (it == memberlist.end()){
+            return INVALID_PTR;
         }
-        return INVALID_PTR;
+        return (*it);
     }
 
     bool Loop::isLastBasicBlock(uint32_t idx){
-        EPAXAssert(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
+        EPAXCheck(IS_VALID_PTR(cfg), "Loop should be connected to a valid CFG");
 
         if (!members->has(idx)){
             return false;
         }
 
-        uint32_t n = cfg->countBasicBlocks();
-        for (uint32_t i = idx + 1; i < n; i++){
-            if (members->has(i)){
-                return false;
-            }
-        }
+        return memberlist.back()->getIndex() == idx;
+    }
 
-        return true;
+    BasicBlock* Loop::getFirstBasicBlock(){
+        if (memberlist.size() == 0){
+            return INVALID_PTR;
+        }
+        return memberlist.front();
     }
 
     bool Loop::isChildOf(Loop* lp){
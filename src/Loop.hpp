@@ -27,6 +27,7 @@
 
 #include "DataStruct.hpp"
 #include "BaseClass.hpp"
+#include "EPAXRange.hpp"
 
 namespace EPAX {
 
@@ -40,6 +41,9 @@ namespace EPAX {
         uint32_t tailidx;
         dyn_bitset* members;
 
+        // member blocks in block index order
+        std::vector<BasicBlock*> memberlist;
+
         uint32_t depth;
         ControlFlow* cfg;
 
@@ -50,7 +54,7 @@ namespace EPAX {
         ControlFlow* getControlFlow() { return cfg; }
         uint32_t countBasicBlocks();
         uint32_t countInstructions();
-        uint32_t getSize();
+        uint64_t getSize();
 
         BasicBlock* findBasicBlock(uint64_t addr);
 
@@ -58,6 +62,9 @@ namespace EPAX {
         BasicBlock* getBasicBlock(uint32_t idx);
         BasicBlock* getNextBasicBlock(uint32_t idx);
         bool isLastBasicBlock(uint32_t idx);
+        BasicBlock* getFirstBasicBlock();
+
+        Range<BasicBlock> blocks() { return Range<BasicBlock>(memberlist); }
 
         BasicBlock* head();
         BasicBlock* tail();
@@ -0,0 +1,277 @@
+/**
+ * @file LoopProfiler.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "BasicBlock.hpp"
+#include "Binary.hpp"
+#include "ControlFlow.hpp"
+#include "Function.hpp"
+#include "Loop.hpp"
+#include "LoopProfiler.hpp"
+
+namespace EPAX {
+
+    static bool compareIterations(const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b){
+        if (a.first != b.first){
+            return a.first > b.first;
+        }
+        return a.second < b.second;
+    }
+
+    static uint32_t tripBucket(uint64_t trip){
+        uint32_t b = 0;
+        while (trip >>= 1){
+            b++;
+        }
+        return b;
+    }
+
+    LoopProfiler::LoopProfiler(Binary* b, uint64_t n)
+        : Tracer(b, 0), maxinvocations(n)
+    {
+        EPAXAssert(maxinvocations > 0, "a loop must be profiled for at least one invocation");
+
+        Range<Function> funcs = binary->functions();
+        for (Range<Function>::iterator fit = funcs.begin(); fit != funcs.end(); fit++){
+            Range<Loop> lps = (*fit)->loops();
+            for (Range<Loop>::iterator lit = lps.begin(); lit != lps.end(); lit++){
+                Loop* lp = (*lit);
+                BasicBlock* head = lp->head();
+                if (!IS_VALID_PTR(head)){
+                    continue;
+                }
+
+                uint32_t idx = loops.size();
+                loops.push_back(LoopTrips());
+                LoopTrips& l = loops.back();
+                l.loop = lp;
+                l.retired = false;
+                l.traps = 0;
+                l.invocations = 0;
+                l.iterations = 0;
+                l.mintrip = 0;
+                l.maxtrip = 0;
+                memset(l.buckets, 0, sizeof(l.buckets));
+
+                std::set<uint64_t> targets;
+                Range<BasicBlock> bbs = lp->blocks();
+                for (Range<BasicBlock>::iterator bit = bbs.begin(); bit != bbs.end(); bit++){
+                    Range<BasicBlock> succs = (*bit)->successors();
+                    for (Range<BasicBlock>::iterator sit = succs.begin(); sit != succs.end(); sit++){
+                        if (!lp->hasBasicBlock((*sit)->getIndex())){
+                            targets.insert((*sit)->getMemoryAddress());
+                        }
+                    }
+                }
+                l.exits.assign(targets.begin(), targets.end());
+
+                heads[head->getMemoryAddress()].push_back(idx);
+                for (std::vector<uint64_t>::const_iterator it = l.exits.begin(); it != l.exits.end(); it++){
+                    exits[(*it)].push_back(idx);
+                }
+            }
+        }
+    }
+
+    LoopProfiler::~LoopProfiler(){
+    }
+
+    void LoopProfiler::started(){
+        std::set<uint64_t> addrs;
+        for (std::map<uint64_t, std::vector<uint32_t> >::const_iterator it = heads.begin(); it != heads.end(); it++){
+            addrs.insert(it->first);
+        }
+        for (std::map<uint64_t, std::vector<uint32_t> >::const_iterator it = exits.begin(); it != exits.end(); it++){
+            addrs.insert(it->first);
+        }
+
+        std::vector<uint64_t> bps(addrs.begin(), addrs.end());
+        if (!insertBreakpoints(bps)){
+            EPAXWarn << "cannot write the code of process " << DEC(pid) << "; no loops are profiled" << ENDL;
+        }
+    }
+
+    void LoopProfiler::record(uint32_t idx, uint64_t trip){
+        LoopTrips& l = loops[idx];
+        if (l.invocations == 0 || trip < l.mintrip){
+            l.mintrip = trip;
+        }
+        if (trip > l.maxtrip){
+            l.maxtrip = trip;
+        }
+        l.invocations++;
+        l.iterations += trip;
+        l.buckets[tripBucket(trip)]++;
+    }
+
+    bool LoopProfiler::isNeeded(uint64_t addr){
+        std::map<uint64_t, std::vector<uint32_t> >::const_iterator it = heads.find(addr);
+        if (it != heads.end()){
+            for (std::vector<uint32_t>::const_iterator lit = it->second.begin(); lit != it->second.end(); lit++){
+                if (!loops[(*lit)].retired){
+                    return true;
+                }
+            }
+        }
+
+        it = exits.find(addr);
+        if (it != exits.end()){
+            for (std::vector<uint32_t>::const_iterator lit = it->second.begin(); lit != it->second.end(); lit++){
+                if (!loops[(*lit)].retired){
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void LoopProfiler::retire(uint32_t idx){
+        LoopTrips& l = loops[idx];
+        l.retired = true;
+
+        // invocations in progress are left uncounted, as their ends will not be seen
+        for (std::map<pid_t, std::vector<LoopInvocation> >::iterator it = active.begin(); it != active.end(); it++){
+            it->second[idx].iterations = 0;
+        }
+
+        std::vector<uint64_t> addrs;
+        if (!isNeeded(l.loop->head()->getMemoryAddress())){
+            addrs.push_back(l.loop->head()->getMemoryAddress());
+        }
+        for (std::vector<uint64_t>::const_iterator it = l.exits.begin(); it != l.exits.end(); it++){
+            if (!isNeeded((*it))){
+                addrs.push_back((*it));
+            }
+        }
+        removeBreakpoints(addrs);
+    }
+
+    bool LoopProfiler::hit(pid_t tid, uint64_t addr){
+        std::vector<LoopInvocation>& inv = active[tid];
+        if (inv.empty()){
+            LoopInvocation none = { 0, 0 };
+            inv.resize(loops.size(), none);
+        }
+
+        std::vector<uint32_t> done;
+
+        // an exit ends the invocation of each loop it leaves
+        std::map<uint64_t, std::vector<uint32_t> >::const_iterator it = exits.find(addr);
+        if (it != exits.end()){
+            for (std::vector<uint32_t>::const_iterator lit = it->second.begin(); lit != it->second.end(); lit++){
+                uint32_t idx = (*lit);
+                if (loops[idx].retired){
+                    continue;
+                }
+                loops[idx].traps++;
+                if (inv[idx].iterations > 0){
+                    record(idx, inv[idx].iterations);
+                    inv[idx].iterations = 0;
+                }
+                if (loops[idx].invocations >= maxinvocations || loops[idx].traps >= LOOP_PROFILE_TRAPS){
+                    done.push_back(idx);
+                }
+            }
+        }
+
+        // reaching the head either begins an invocation or is the next iteration of one
+        it = heads.find(addr);
+        if (it != heads.end()){
+            uint64_t sp = 0;
+            if (!getThreadSP(tid, sp)){
+                EPAXWarn << "cannot read the registers of thread " << DEC(tid) << ENDL;
+            }
+            for (std::vector<uint32_t>::const_iterator lit = it->second.begin(); lit != it->second.end(); lit++){
+                uint32_t idx = (*lit);
+                if (loops[idx].retired){
+                    continue;
+                }
+                loops[idx].traps++;
+                LoopInvocation& i = inv[idx];
+                if (i.iterations > 0 && i.sp == sp){
+                    i.iterations++;
+                } else {
+                    // an invocation left without passing an exit, e.g. by returning from inside the loop
+                    if (i.iterations > 0){
+                        record(idx, i.iterations);
+                    }
+                    i.iterations = 1;
+                    i.sp = sp;
+                }
+                if (loops[idx].invocations >= maxinvocations || loops[idx].traps >= LOOP_PROFILE_TRAPS){
+                    done.push_back(idx);
+                }
+            }
+        }
+
+        for (std::vector<uint32_t>::const_iterator lit = done.begin(); lit != done.end(); lit++){
+            if (!loops[(*lit)].retired){
+                retire((*lit));
+            }
+        }
+        return isNeeded(addr);
+    }
+
+    void LoopProfiler::report(std::ostream& stream){
+        uint32_t ran = 0;
+        uint32_t retired = 0;
+        std::vector<std::pair<uint64_t, uint32_t> > sorted;
+        for (uint32_t i = 0; i < loops.size(); i++){
+            if (loops[i].retired){
+                retired++;
+            }
+            if (loops[i].invocations > 0){
+                ran++;
+                sorted.push_back(std::make_pair(loops[i].iterations, i));
+            }
+        }
+        std::sort(sorted.begin(), sorted.end(), compareIterations);
+
+        stream << "# binary " << getName() << ENDL;
+        stream << "# loops " << DEC(ran) << " of " << DEC(loops.size()) << " executed" << TAB
+               << "retired " << DEC(retired) << TAB
+               << "maxinvocations " << DEC(maxinvocations) << ENDL;
+        stream << "# loop <invocations> <iterations> <mean trip> <min trip> <max trip> <func> <loop> <depth> <head addr> <name>" << ENDL;
+        stream << "# trips <bucket> <invocations>, for trip counts in [2^bucket, 2^(bucket+1))" << ENDL;
+        for (std::vector<std::pair<uint64_t, uint32_t> >::const_iterator it = sorted.begin(); it != sorted.end(); it++){
+            LoopTrips& l = loops[it->second];
+            Loop* lp = l.loop;
+            Function* f = lp->getControlFlow()->getFunction();
+            stream << "loop" << TAB << DEC(l.invocations) << TAB << DEC(l.iterations) << TAB
+                   << std::fixed << std::setprecision(2) << ((double)l.iterations / (double)l.invocations) << TAB
+                   << DEC(l.mintrip) << TAB << DEC(l.maxtrip) << TAB
+                   << DEC(f->getIndex()) << TAB << DEC(lp->getIndex()) << TAB << DEC(lp->getDepth()) << TAB
+                   << HEX(lp->head()->getMemoryAddress()) << TAB << f->getName() << ENDL;
+            for (uint32_t b = 0; b < LOOP_TRIP_BUCKETS; b++){
+                if (l.buckets[b] > 0){
+                    stream << "trips" << TAB << DEC(b) << TAB << DEC(l.buckets[b]) << ENDL;
+                }
+            }
+        }
+        stream.unsetf(std::ios::floatfield);
+        stream << std::dec;
+    }
+
+} // namespace EPAX
@@ -0,0 +1,123 @@
+/**
+ * @file LoopProfiler.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_LoopProfiler_hpp__
+#define __EPAX_LoopProfiler_hpp__
+
+#include "BaseClass.hpp"
+#include "Tracer.hpp"
+
+// the default number of invocations gathered per loop
+#define LOOP_PROFILE_INVOCATIONS (1000)
+
+// the most breakpoint hits taken per loop, which bounds the cost of long-running loops
+#define LOOP_PROFILE_TRAPS (1 << 20)
+
+// trip count histograms have one bucket per power of two
+#define LOOP_TRIP_BUCKETS (64)
+
+namespace EPAX {
+
+    class Loop;
+
+    /**
+     * Trip counts gathered for one loop
+     */
+    typedef struct {
+        Loop* loop;
+        bool retired;
+        uint64_t traps;
+        uint64_t invocations;
+        uint64_t iterations;
+        uint64_t mintrip;
+        uint64_t maxtrip;
+        uint64_t buckets[LOOP_TRIP_BUCKETS];  // bucket b counts trip counts in [2^b, 2^(b+1))
+        std::vector<uint64_t> exits;          // the blocks outside the loop that its blocks branch to
+    } LoopTrips;
+
+    /**
+     * An invocation of a loop in progress in one thread; none if iterations is 0
+     */
+    typedef struct {
+        uint64_t iterations;
+        uint64_t sp;
+    } LoopInvocation;
+
+    /**
+     * Measures the trip counts of the loops of a Binary in a process, with breakpoints
+     * only on the head block of each loop and on the blocks its exit edges lead to.
+     * An invocation begins when a thread reaches the head, counts an iteration at each
+     * return to the head, and ends when the thread reaches an exit. An invocation left
+     * without passing an exit, e.g. by a return from inside the loop, ends when the head
+     * is next reached with a different stack pointer.
+     *
+     * Once a loop has gathered maxinvocations invocations, or LOOP_PROFILE_TRAPS
+     * breakpoint hits, it is retired and its breakpoints are removed, so the cost of
+     * profiling is bounded per loop rather than by how long the program runs.
+     *
+     * Every breakpoint but those of retired loops must stay in place when it is hit,
+     * so a LoopProfiler needs Tracer::canStepOver(); BIN_profileLoops refuses to run
+     * one on other hosts rather than report trip counts of 1.
+     */
+    class LoopProfiler : public Tracer {
+    private:
+        uint64_t maxinvocations;
+
+        std::vector<LoopTrips> loops;
+
+        // the loops whose head, and whose exits, are at each address
+        std::map<uint64_t, std::vector<uint32_t> > heads;
+        std::map<uint64_t, std::vector<uint32_t> > exits;
+
+        // per thread, the invocation in progress of each loop
+        std::map<pid_t, std::vector<LoopInvocation> > active;
+
+        void record(uint32_t idx, uint64_t trip);
+        void retire(uint32_t idx);
+        bool isNeeded(uint64_t addr);
+
+    protected:
+        void started();
+        bool hit(pid_t tid, uint64_t addr);
+
+    public:
+        /**
+         * @param b the binary run by the process
+         * @param n the number of invocations after which a loop is retired
+         */
+        LoopProfiler(Binary* b, uint64_t n = LOOP_PROFILE_INVOCATIONS);
+        virtual ~LoopProfiler();
+
+        /**
+         * Writes, for each loop that ran, its invocations, iterations, the mean, least
+         * and greatest trip count, and a histogram of trip counts by power of two
+         *
+         * @param stream where to write the report
+         */
+        void report(std::ostream& stream = std::cout);
+    }; // class LoopProfiler
+
+} // namespace EPAX
+
+#endif // __EPAX_LoopProfiler_hpp__
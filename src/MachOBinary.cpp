@@ -24,21 +24,51 @@
 
 #include "EPAXCommonInternal.hpp"
 
+#include "MachO/fat.h"
 #include "MachO/loader.h"
+#include "MachO/nlist.h"
 
+#include "Function.hpp"
 #include "InputFile.hpp"
 #include "MachOBinary.hpp"
 #include "BaseClass.hpp"
 
+// no real universal file has more slices; this tells one from a Java class file,
+// which shares FAT_MAGIC
+#define MACHO_FAT_MAX_ARCHS (32)
+
+// vm_prot_t bits, from <mach/vm_prot.h>
+#define MACHO_PROT_WRITE (0x2)
+
+// thread state flavors of LC_UNIXTHREAD, from <mach/*/thread_status.h>
+#define MACHO_X86_THREAD_STATE32 (1)
+#define MACHO_X86_THREAD_STATE64 (4)
+#define MACHO_ARM_THREAD_STATE (1)
+#define MACHO_ARM_THREAD_STATE64 (6)
+
 namespace EPAX {
 
     namespace MachO {
 
 #define MHDR32_ENTRY ((mach_header*)entry)
 #define MHDR64_ENTRY ((mach_header_64*)entry)
+#define LCMD_ENTRY ((load_command*)entry)
+#define SEG32_ENTRY ((segment_command*)entry)
+#define SEG64_ENTRY ((segment_command_64*)entry)
+#define NLIST32_ENTRY ((struct nlist*)entry)
+#define NLIST64_ENTRY ((struct nlist_64*)entry)
 
         MachOBinary::MachOBinary(std::string n)
-            : BaseBinary(n), machheader(INVALID_PTR)
+            : BaseBinary(n), machheader(INVALID_PTR),
+              foundcommands(false), commandbytes(INVALID_PTR), commands(INVALID_PTR),
+              foundsections(false), segments(INVALID_PTR), sections(INVALID_PTR)
+        {
+        }
+
+        MachOBinary::MachOBinary(InputFile* f, bool own)
+            : BaseBinary(f, own), machheader(INVALID_PTR),
+              foundcommands(false), commandbytes(INVALID_PTR), commands(INVALID_PTR),
+              foundsections(false), segments(INVALID_PTR), sections(INVALID_PTR)
         {
         }
 
@@ -46,14 +76,72 @@ namespace EPAX {
             if (IS_VALID_PTR(machheader)){
                 delete machheader;
             }
+
+            if (IS_VALID_PTR(sections)){
+                while (sections->size()){
+                    delete sections->back();
+                    sections->pop_back();
+                }
+                delete sections;
+            }
+
+            // the segments are among the commands
+            if (IS_VALID_PTR(segments)){
+                delete segments;
+            }
+
+            if (IS_VALID_PTR(commands)){
+                while (commands->size()){
+                    delete commands->back();
+                    commands->pop_back();
+                }
+                delete commands;
+            }
+
+            if (IS_VALID_PTR(commandbytes)){
+                delete[] commandbytes;
+            }
         }
 
         uint64_t MachOBinary::functionEndAddress(Function* f, Function* nextf){
-            __do_not_call__;
+            uint64_t addr = INVALID_ADDRESS;
+
+            for (std::vector<MachSection*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                MachSection* s = (*it);
+                if (s->isText() && s->inRange(f->getMemoryAddress())){
+                    addr = s->getFileOffset() + s->getFileSize();
+                    break;
+                }
+            }
+
+            if (IS_VALID_PTR(nextf)){
+                if (nextf->getFileOffset() < addr){
+                    addr = nextf->getFileOffset();
+                }
+            }
+
+            return addr;
         }
 
         bool MachOBinary::insideTextRange(uint64_t a){
-            __do_not_call__;
+            for (std::vector<MachSection*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                MachSection* s = (*it);
+                if (s->isText() && s->inRange(a)){
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        uint64_t MachOBinary::vaddrToFile(uint64_t v){
+            findCommands();
+            for (std::vector<SegmentCommand*>::const_iterator it = segments->begin(); it != segments->end(); it++){
+                SegmentCommand* seg = (*it);
+                if (seg->isValidVaddr(v)){
+                    return seg->vaddrToFileaddr(v);
+                }
+            }
+            return 0;
         }
 
         bool MachOBinary::is32Bit(){
@@ -65,7 +153,45 @@ namespace EPAX {
         }
 
         uint64_t MachOBinary::getStartAddr(){
-            return machheader->getStartAddr();
+            findCommands();
+
+            // LC_MAIN gives the file offset of main
+            LoadCommand* lc = findCommand(LC_MAIN);
+            if (IS_VALID_PTR(lc) && lc->getFileSize() >= sizeof(entry_point_command)){
+                uint64_t off = ((entry_point_command*)lc->getBytes())->entryoff;
+                for (std::vector<SegmentCommand*>::const_iterator it = segments->begin(); it != segments->end(); it++){
+                    SegmentCommand* seg = (*it);
+                    if (off >= seg->getFOffset() && off < seg->getFOffset() + seg->getFSize()){
+                        return seg->getVaddr() + (off - seg->getFOffset());
+                    }
+                }
+                return 0;
+            }
+
+            // older images start with the register state in LC_UNIXTHREAD
+            lc = findCommand(LC_UNIXTHREAD);
+            if (!IS_VALID_PTR(lc) || lc->getFileSize() < sizeof(thread_command) + 2 * sizeof(uint32_t)){
+                return 0;
+            }
+            uint32_t* thread = (uint32_t*)(lc->getBytes() + sizeof(thread_command));
+            uint32_t flavor = thread[0];
+            uint64_t words = (lc->getFileSize() - sizeof(thread_command)) / sizeof(uint32_t) - 2;
+            if (thread[1] < words){
+                words = thread[1];
+            }
+            uint32_t* state = thread + 2;
+
+            int32_t cpu = machheader->getCPUType();
+            if (cpu == CPU_TYPE_X86_64 && flavor == MACHO_X86_THREAD_STATE64 && words >= 2 * 17){
+                return ((uint64_t*)state)[16]; // rip
+            } else if (cpu == CPU_TYPE_X86 && flavor == MACHO_X86_THREAD_STATE32 && words >= 11){
+                return state[10]; // eip
+            } else if (cpu == CPU_TYPE_ARM64 && flavor == MACHO_ARM_THREAD_STATE64 && words >= 2 * 33){
+                return ((uint64_t*)state)[32]; // pc
+            } else if (cpu == CPU_TYPE_ARM && flavor == MACHO_ARM_THREAD_STATE && words >= 16){
+                return state[15]; // pc
+            }
+            return 0;
         }
 
         MachOBinary32::MachOBinary32(std::string n)
@@ -80,6 +206,100 @@ namespace EPAX {
             machheader = new MachHeader64(this, 0);
         }
 
+        MachOBinary32::MachOBinary32(InputFile* f, bool own)
+            : MachOBinary(f, own)
+        {
+            machheader = new MachHeader32(this, 0);
+        }
+
+        MachOBinary64::MachOBinary64(InputFile* f, bool own)
+            : MachOBinary(f, own)
+        {
+            machheader = new MachHeader64(this, 0);
+        }
+
+        // fat headers are big-endian whatever the slices are
+        static uint32_t bigEndian32(rawbyte_t* b){
+            return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | (uint32_t)b[3];
+        }
+
+        static uint64_t bigEndian64(rawbyte_t* b){
+            return ((uint64_t)bigEndian32(b) << 32) | bigEndian32(b + 4);
+        }
+
+        bool MachOBinary::findFatArchs(std::string n, std::vector<FatArch>& archs){
+            InputFile in(n);
+            rawbyte_t hdr[sizeof(fat_header)];
+            if (in.getFileSize() < sizeof(hdr)){
+                return false;
+            }
+            in.getBytes(0, sizeof(hdr), hdr);
+
+            uint32_t magic = bigEndian32(hdr);
+            uint32_t count = bigEndian32(hdr + sizeof(uint32_t));
+            if ((magic != FAT_MAGIC && magic != FAT_MAGIC_64) || count == 0 || count > MACHO_FAT_MAX_ARCHS){
+                return false;
+            }
+
+            uint32_t archsize = (magic == FAT_MAGIC_64? sizeof(fat_arch_64): sizeof(fat_arch));
+            if (sizeof(hdr) + count * archsize > in.getFileSize()){
+                return false;
+            }
+            rawbyte_t* table = new rawbyte_t[count * archsize];
+            in.getBytes(sizeof(hdr), count * archsize, table);
+
+            for (uint32_t i = 0; i < count; i++){
+                rawbyte_t* a = table + i * archsize;
+                FatArch arch;
+                arch.cputype = bigEndian32(a + offsetof(fat_arch, cputype));
+                arch.cpusubtype = bigEndian32(a + offsetof(fat_arch, cpusubtype));
+                if (magic == FAT_MAGIC_64){
+                    arch.offset = bigEndian64(a + offsetof(fat_arch_64, offset));
+                    arch.size = bigEndian64(a + offsetof(fat_arch_64, size));
+                } else {
+                    arch.offset = bigEndian32(a + offsetof(fat_arch, offset));
+                    arch.size = bigEndian32(a + offsetof(fat_arch, size));
+                }
+                if (arch.offset > in.getFileSize() || arch.size > in.getFileSize() - arch.offset){
+                    EPAXWarn << n << ": slice " << DEC(i) << " runs past the end of the file; ignoring it" << ENDL;
+                    continue;
+                }
+                archs.push_back(arch);
+            }
+
+            delete[] table;
+            return true;
+        }
+
+        bool MachOBinary::selectSlice(std::string n, int32_t cputype, FatArch& slice){
+            std::vector<FatArch> archs;
+            if (!findFatArchs(n, archs) || archs.size() == 0){
+                return false;
+            }
+
+            if (cputype != CPU_TYPE_ANY){
+                for (std::vector<FatArch>::const_iterator it = archs.begin(); it != archs.end(); it++){
+                    if ((*it).cputype == cputype){
+                        slice = (*it);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            int32_t preferred[] = { CPU_TYPE_ARM, CPU_TYPE_ARM64 };
+            for (uint32_t i = 0; i < sizeof(preferred) / sizeof(int32_t); i++){
+                for (std::vector<FatArch>::const_iterator it = archs.begin(); it != archs.end(); it++){
+                    if ((*it).cputype == preferred[i]){
+                        slice = (*it);
+                        return true;
+                    }
+                }
+            }
+            slice = archs[0];
+            return true;
+        }
+
         void MachOBinary::emit(std::string n){
             __do_not_call__;
         }
@@ -96,24 +316,291 @@ namespace EPAX {
             machheader->describe();
         }
 
+        void MachOBinary::findCommands(){
+            if (foundcommands){
+                return;
+            }
+
+            commands = new std::vector<LoadCommand*>();
+            segments = new std::vector<SegmentCommand*>();
+            foundcommands = true;
+
+            uint64_t off = (is64Bit()? sizeof(mach_header_64): sizeof(mach_header));
+            uint64_t size = machheader->getCommandSize();
+            if (off + size > getFileSize()){
+                EPAXWarn << getName() << ": load commands run past the end of the file" << ENDL;
+                size = (getFileSize() > off? getFileSize() - off: 0);
+            }
+
+            commandbytes = new rawbyte_t[size + 1];
+            getInputFile()->getBytes(off, size, commandbytes);
+
+            uint64_t cur = 0;
+            for (uint32_t i = 0; i < machheader->getCommandCount(); i++){
+                load_command* lc = (load_command*)(commandbytes + cur);
+                if (cur + sizeof(load_command) > size || lc->cmdsize < sizeof(load_command) || cur + lc->cmdsize > size){
+                    EPAXWarn << getName() << ": load command " << DEC(i) << " is malformed; ignoring it and those after it" << ENDL;
+                    break;
+                }
+
+                LoadCommand* c;
+                if (lc->cmd == LC_SEGMENT && is32Bit() && lc->cmdsize >= sizeof(segment_command)){
+                    SegmentCommand* seg = new SegmentCommand32(this, off + cur, lc->cmdsize, i, commandbytes + cur);
+                    segments->push_back(seg);
+                    c = seg;
+                } else if (lc->cmd == LC_SEGMENT_64 && is64Bit() && lc->cmdsize >= sizeof(segment_command_64)){
+                    SegmentCommand* seg = new SegmentCommand64(this, off + cur, lc->cmdsize, i, commandbytes + cur);
+                    segments->push_back(seg);
+                    c = seg;
+                } else {
+                    c = new LoadCommand(this, off + cur, lc->cmdsize, i, commandbytes + cur);
+                }
+                commands->push_back(c);
+                cur += lc->cmdsize;
+            }
+        }
+
+        LoadCommand* MachOBinary::findCommand(uint32_t type){
+            findCommands();
+            for (std::vector<LoadCommand*>::const_iterator it = commands->begin(); it != commands->end(); it++){
+                if ((*it)->getType() == type){
+                    return (*it);
+                }
+            }
+            return INVALID_PTR;
+        }
+
+        uint32_t MachOBinary::countLoadCommands(){
+            findCommands();
+            return commands->size();
+        }
+
+        LoadCommand* MachOBinary::getLoadCommand(uint32_t idx){
+            findCommands();
+            EPAXCheck(idx < commands->size(), "Invalid load command index " << DEC(idx));
+            return (*commands)[idx];
+        }
+
+        SegmentCommand* MachOBinary::findSegment(std::string n){
+            findCommands();
+            for (std::vector<SegmentCommand*>::const_iterator it = segments->begin(); it != segments->end(); it++){
+                if ((*it)->getName() == n){
+                    return (*it);
+                }
+            }
+            return INVALID_PTR;
+        }
+
+        MachSection* MachOBinary::getSection(uint32_t ordinal){
+            if (ordinal == NO_SECT || ordinal > sections->size()){
+                return INVALID_PTR;
+            }
+            return (*sections)[ordinal - 1];
+        }
+
+        // reads the function starts table: ULEB128 deltas, each from the previous
+        // function (or, for the first, from the start of __TEXT), ending with a 0.
+        // addresses of Thumb functions are also put in thumbs
+        bool MachOBinary::findFunctionStarts(std::vector<uint64_t>& starts, std::set<uint64_t>& thumbs){
+            LoadCommand* lc = findCommand(LC_FUNCTION_STARTS);
+            SegmentCommand* text = findSegment("__TEXT");
+            if (!IS_VALID_PTR(lc) || !IS_VALID_PTR(text) || lc->getFileSize() < sizeof(linkedit_data_command)){
+                return false;
+            }
+
+            linkedit_data_command* ld = (linkedit_data_command*)lc->getBytes();
+            if ((uint64_t)ld->dataoff + ld->datasize > getFileSize()){
+                EPAXWarn << getName() << ": function starts run past the end of the file" << ENDL;
+                return false;
+            }
+
+            rawbyte_t* buf = new rawbyte_t[ld->datasize];
+            getInputFile()->getBytes(ld->dataoff, ld->datasize, buf);
+
+            // the low bit marks Thumb functions
+            bool thumb = (is32Bit() && isARM());
+
+            uint64_t addr = text->getVaddr();
+            uint32_t cur = 0;
+            while (cur < ld->datasize){
+                uint64_t delta = 0;
+                uint32_t shift = 0;
+                rawbyte_t b;
+                do {
+                    b = buf[cur++];
+                    if (shift < 64){
+                        delta |= (uint64_t)(b & 0x7f) << shift;
+                    }
+                    shift += 7;
+                } while ((b & 0x80) && cur < ld->datasize);
+
+                if (delta == 0){
+                    break;
+                }
+                addr += delta;
+                if (thumb && (addr & 1)){
+                    starts.push_back(addr & ~(uint64_t)1);
+                    thumbs.insert(addr & ~(uint64_t)1);
+                } else {
+                    starts.push_back(addr);
+                }
+            }
+
+            delete[] buf;
+            return true;
+        }
+
         void MachOBinary::findFunctions(){
-            __do_not_call__;
+            EPAXAssert(!foundfunctions, "this function should only be called once per binary");
+            if (foundfunctions){
+                return;
+            }
+
+            lazySymbols();
+
+            functions = new std::vector<Function*>();
+            foundfunctions = true;
+
+            // name each function by a symbol at its address, preferring external symbols
+            std::map<uint64_t, MachSymbol*> named;
+            for (std::vector<SymbolTable*>::const_iterator it = symtabs->begin(); it != symtabs->end(); it++){
+                MachSymbolTable* symt = (MachSymbolTable*)(*it);
+                for (uint32_t i = 0; i < symt->countSymbols(); i++){
+                    MachSymbol* s = (MachSymbol*)symt->getSymbol(i);
+                    if (!s->isFunction()){
+                        continue;
+                    }
+                    std::map<uint64_t, MachSymbol*>::iterator n = named.find(s->getFunctionAddress());
+                    if (n == named.end()){
+                        named[s->getFunctionAddress()] = s;
+                    } else if (s->isExternal() && !n->second->isExternal()){
+                        n->second = s;
+                    }
+                }
+            }
+
+            std::vector<uint64_t> starts;
+            std::set<uint64_t> thumbs;
+            if (!findFunctionStarts(starts, thumbs)){
+                for (std::map<uint64_t, MachSymbol*>::const_iterator it = named.begin(); it != named.end(); it++){
+                    starts.push_back(it->first);
+                }
+            }
+            std::sort(starts.begin(), starts.end());
+            starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+            uint32_t cur = 0;
+            for (std::vector<uint64_t>::const_iterator it = starts.begin(); it != starts.end(); it++){
+                uint64_t addr = (*it);
+                if (!insideTextRange(addr)){
+                    continue;
+                }
+                std::map<uint64_t, MachSymbol*>::const_iterator n = named.find(addr);
+                Symbol* s = (n == named.end()? (Symbol*)INVALID_PTR: (Symbol*)n->second);
+                Function* f = new Function(this, vaddrToFile(addr), 0, addr, cur, s, is64Bit());
+                if (thumbs.count(addr)){
+                    f->setDisassembleMode(DisasmMode_THUMB2);
+                }
+                functions->push_back(f);
+                cur++;
+            }
+
+            for (uint32_t i = 0; i < functions->size(); i++){
+                Function* f = (*functions)[i];
+                uint64_t end_addr = functionEndAddress(f, i+1 < functions->size()? (*functions)[i+1]:INVALID_PTR);
+                if (INVALID_ADDRESS != end_addr){
+                    f->setMemorySize(end_addr - f->getFileOffset());
+                }
+            }
+
+            for (std::vector<Function*>::const_iterator it = functions->begin(); it != functions->end(); it++){
+                Function* f = (*it);
+                f->disassemble();
+            }
         }
 
         void MachOBinary::findSymbols(){
-            __do_not_call__;
+            EPAXAssert(!foundsymbols, "this function should only be called once per binary");
+            if (foundsymbols){
+                return;
+            }
+
+            symtabs = new std::vector<SymbolTable*>();
+            strtabs = new std::vector<StringTable*>();
+            foundsymbols = true;
+
+            if (!foundsections){
+                findSections();
+            }
+
+            LoadCommand* lc = findCommand(LC_SYMTAB);
+            if (!IS_VALID_PTR(lc) || lc->getFileSize() < sizeof(symtab_command)){
+                return;
+            }
+
+            symtab_command* st = (symtab_command*)lc->getBytes();
+            uint64_t symsize = (is64Bit()? sizeof(struct nlist_64): sizeof(struct nlist));
+            if ((uint64_t)st->stroff + st->strsize > getFileSize() || (uint64_t)st->symoff + st->nsyms * symsize > getFileSize()){
+                EPAXWarn << getName() << ": the symbol table runs past the end of the file" << ENDL;
+                return;
+            }
+
+            MachStringTable* strt = new MachStringTable(this, st->stroff, st->strsize, 0);
+            strtabs->push_back(strt);
+
+            MachSymbolTable* symt = new MachSymbolTable(this, st->symoff, st->nsyms, 0, strt);
+            for (uint32_t i = 0; i < symt->countSymbols(); i++){
+                MachSymbol* s = (MachSymbol*)symt->getSymbol(i);
+                MachSection* sec = getSection(s->getSectionOrdinal());
+                s->setText(IS_VALID_PTR(sec) && sec->isText());
+            }
+            symtabs->push_back(symt);
         }
 
         void MachOBinary::findSections(){
-            __do_not_call__;
+            EPAXAssert(!foundsections, "this function should only be called once per binary");
+            if (foundsections){
+                return;
+            }
+
+            findCommands();
+            sections = new std::vector<MachSection*>();
+            foundsections = true;
+
+            for (std::vector<SegmentCommand*>::const_iterator it = segments->begin(); it != segments->end(); it++){
+                SegmentCommand* seg = (*it);
+                for (uint32_t i = 0; i < seg->countSections(); i++){
+                    sections->push_back(new MachSection(this, seg, seg->getSectionBytes(i), sections->size()));
+                }
+            }
         }
 
         void MachOBinary::printSections(std::ostream& stream){
-            __do_not_call__;
+            stream << ENDL;
+            stream << "Printing all Sections in " << getName() << ENDL;
+            stream << "MACH_SECT [" << std::setw(2) << "ID" << "]"
+                   << TAB << std::setw(24) << "SEGMENT,SECTION"
+                   << TAB << "VIRTADDR"
+                   << TAB << "MEM_SIZE"
+                   << TAB << "FLOFFSET"
+                   << TAB << "FLAGS"
+                   << TAB << "SECTYP"
+                   << ENDL;
+            if (IS_VALID_PTR(sections)){
+                for (std::vector<MachSection*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                    (*it)->print(stream);
+                }
+            }
         }
 
         void MachOBinary::printFunctions(std::ostream& stream){
-            __do_not_call__;
+            stream << ENDL;
+            stream << "Printing all functions in " << getName() << ENDL;
+            Function::printHeader();
+            for (std::vector<Function*>::const_iterator it = functions->begin(); it != functions->end(); it++){
+                Function* f = (*it);
+                f->print(stream);
+            }
         }
 
         MachHeader::MachHeader(BaseBinary* b, uint64_t o, uint64_t s)
@@ -142,14 +629,30 @@ namespace EPAX {
             getInputFile()->getBytes(o, getFileSize(), entry);
         }
 
-        uint64_t MachHeader32::getStartAddr(){
+        int32_t MachHeader32::getCPUType(){
             return MHDR32_ENTRY->cputype;
         }
 
-        uint64_t MachHeader64::getStartAddr(){
+        int32_t MachHeader64::getCPUType(){
             return MHDR64_ENTRY->cputype;
         }
 
+        uint32_t MachHeader32::getCommandCount(){
+            return MHDR32_ENTRY->ncmds;
+        }
+
+        uint32_t MachHeader64::getCommandCount(){
+            return MHDR64_ENTRY->ncmds;
+        }
+
+        uint32_t MachHeader32::getCommandSize(){
+            return MHDR32_ENTRY->sizeofcmds;
+        }
+
+        uint32_t MachHeader64::getCommandSize(){
+            return MHDR64_ENTRY->sizeofcmds;
+        }
+
         bool MachHeader32::verify(){
             if (MHDR32_ENTRY->magic == MH_MAGIC){
                 return true;
@@ -172,8 +675,7 @@ namespace EPAX {
         }
 
         bool MachHeader64::isARM(){
-            // TODO: have a good idea, but not totally sure what ARM64 looks like here
-            return false;
+            return (MHDR64_ENTRY->cputype == CPU_TYPE_ARM64);
         }
 
         uint32_t MachHeader32::getFileType(){
@@ -207,6 +709,8 @@ namespace EPAX {
                 default:
                     std::cout << "isa=ARM";
                 }
+            } else if (ctype == CPU_TYPE_ARM64){
+                std::cout << "isa=ARM64";
             } else {
                 switch(ctype & 0xffff){
 #define CCASE(__typ__) case CPU_TYPE_ ## __typ__: std::cout << "isa=" << #__typ__; break
@@ -237,7 +741,351 @@ namespace EPAX {
             std::cout << "bits=64" << TAB;
             MachHeader::describeISA(MHDR64_ENTRY->cputype, MHDR64_ENTRY->cpusubtype);
         }
-        
+
+        LoadCommand::LoadCommand(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i, rawbyte_t* e)
+            : FileBase(b, o, s),
+              IndexBase(i),
+              entry(e)
+        {
+        }
+
+        uint32_t LoadCommand::getType(){
+            return LCMD_ENTRY->cmd;
+        }
+
+        static std::string fixedString(const char* s, uint32_t len){
+            uint32_t n = 0;
+            while (n < len && s[n] != '\0'){
+                n++;
+            }
+            return std::string(s, n);
+        }
+
+        SegmentCommand::SegmentCommand(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i, rawbyte_t* e)
+            : LoadCommand(b, o, s, i, e),
+              NameBase()
+        {
+        }
+
+        bool SegmentCommand::isValidVaddr(uint64_t v){
+            return (v >= getVaddr() && v < getVaddr() + getFSize());
+        }
+
+        uint64_t SegmentCommand::vaddrToFileaddr(uint64_t v){
+            EPAXAssert(isValidVaddr(v), "Address " << HEX(v) << " is not in the file part of segment " << getName());
+            return getFOffset() + (v - getVaddr());
+        }
+
+        SegmentCommand32::SegmentCommand32(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i, rawbyte_t* e)
+            : SegmentCommand(b, o, s, i, e)
+        {
+            setName(fixedString(SEG32_ENTRY->segname, sizeof(SEG32_ENTRY->segname)));
+        }
+
+        SegmentCommand64::SegmentCommand64(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i, rawbyte_t* e)
+            : SegmentCommand(b, o, s, i, e)
+        {
+            setName(fixedString(SEG64_ENTRY->segname, sizeof(SEG64_ENTRY->segname)));
+        }
+
+        uint64_t SegmentCommand32::getVaddr(){
+            return SEG32_ENTRY->vmaddr;
+        }
+
+        uint64_t SegmentCommand64::getVaddr(){
+            return SEG64_ENTRY->vmaddr;
+        }
+
+        uint64_t SegmentCommand32::getMSize(){
+            return SEG32_ENTRY->vmsize;
+        }
+
+        uint64_t SegmentCommand64::getMSize(){
+            return SEG64_ENTRY->vmsize;
+        }
+
+        uint64_t SegmentCommand32::getFOffset(){
+            return SEG32_ENTRY->fileoff;
+        }
+
+        uint64_t SegmentCommand64::getFOffset(){
+            return SEG64_ENTRY->fileoff;
+        }
+
+        uint64_t SegmentCommand32::getFSize(){
+            return SEG32_ENTRY->filesize;
+        }
+
+        uint64_t SegmentCommand64::getFSize(){
+            return SEG64_ENTRY->filesize;
+        }
+
+        uint32_t SegmentCommand32::getProtection(){
+            return SEG32_ENTRY->initprot;
+        }
+
+        uint32_t SegmentCommand64::getProtection(){
+            return SEG64_ENTRY->initprot;
+        }
+
+        uint32_t SegmentCommand32::countSections(){
+            uint32_t fit = (getFileSize() - sizeof(segment_command)) / sizeof(section);
+            return (SEG32_ENTRY->nsects < fit? SEG32_ENTRY->nsects: fit);
+        }
+
+        uint32_t SegmentCommand64::countSections(){
+            uint32_t fit = (getFileSize() - sizeof(segment_command_64)) / sizeof(section_64);
+            return (SEG64_ENTRY->nsects < fit? SEG64_ENTRY->nsects: fit);
+        }
+
+        rawbyte_t* SegmentCommand32::getSectionBytes(uint32_t idx){
+            return entry + sizeof(segment_command) + idx * sizeof(section);
+        }
+
+        rawbyte_t* SegmentCommand64::getSectionBytes(uint32_t idx){
+            return entry + sizeof(segment_command_64) + idx * sizeof(section_64);
+        }
+
+        // the fields of a section or section_64, for MachSection's base
+        static uint64_t sectionAddr(BaseBinary* b, rawbyte_t* e){
+            return (b->is64Bit()? ((section_64*)e)->addr: ((section*)e)->addr);
+        }
+
+        static uint64_t sectionSize(BaseBinary* b, rawbyte_t* e){
+            return (b->is64Bit()? ((section_64*)e)->size: ((section*)e)->size);
+        }
+
+        static uint32_t sectionFlags(BaseBinary* b, rawbyte_t* e){
+            return (b->is64Bit()? ((section_64*)e)->flags: ((section*)e)->flags);
+        }
+
+        static bool sectionIsZerofill(BaseBinary* b, rawbyte_t* e){
+            uint32_t t = sectionFlags(b, e) & SECTION_TYPE;
+            return (t == S_ZEROFILL || t == S_GB_ZEROFILL || t == S_THREAD_LOCAL_ZEROFILL);
+        }
+
+        static uint64_t sectionOffset(BaseBinary* b, rawbyte_t* e){
+            return (b->is64Bit()? ((section_64*)e)->offset: ((section*)e)->offset);
+        }
+
+        // sections are named segment,section, e.g. __TEXT,__text
+        static std::string sectionName(rawbyte_t* e){
+            section* s = (section*)e;
+            return fixedString(s->segname, sizeof(s->segname)) + "," + fixedString(s->sectname, sizeof(s->sectname));
+        }
+
+        MachSection::MachSection(BaseBinary* b, SegmentCommand* seg, rawbyte_t* e, uint32_t i)
+            : Section(b, sectionOffset(b, e), (sectionIsZerofill(b, e)? 0: sectionSize(b, e)), sectionAddr(b, e), sectionSize(b, e), i, sectionName(e)),
+              segment(seg),
+              flags(sectionFlags(b, e))
+        {
+        }
+
+        uint32_t MachSection::getType(){
+            return (flags & SECTION_TYPE);
+        }
+
+        bool MachSection::isText(){
+            return ((flags & (S_ATTR_PURE_INSTRUCTIONS | S_ATTR_SOME_INSTRUCTIONS)) != 0);
+        }
+
+        bool MachSection::isData(){
+            return (!isText() && !isBSS() && (segment->getProtection() & MACHO_PROT_WRITE) != 0);
+        }
+
+        bool MachSection::isBSS(){
+            return (getType() == S_ZEROFILL || getType() == S_GB_ZEROFILL || getType() == S_THREAD_LOCAL_ZEROFILL);
+        }
+
+        bool MachSection::isDebug(){
+            return ((flags & S_ATTR_DEBUG) != 0);
+        }
+
+        void MachSection::print(std::ostream& stream){
+            stream << "MACH_SECT [" << std::setw(2) << DEC(getIndex()) << "]"
+                   << TAB << std::setw(24) << getName()
+                   << TAB << HEX(getMemoryAddress())
+                   << TAB << HEX(getMemorySize())
+                   << TAB << HEX(getFileOffset())
+                   << TAB << HEX(flags)
+                   << TAB << (isText()? "T":" ") << (isData()? "D":" ") << (isBSS()? "B":" ") << (isDebug()? "D":" ")
+                   << ENDL;
+        }
+
+        MachSymbol::MachSymbol(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i, rawbyte_t* e)
+            : Symbol(b, o, s, i),
+              entry(e),
+              text(false)
+        {
+        }
+
+        MachSymbol32::MachSymbol32(BaseBinary* b, uint64_t o, uint32_t i, rawbyte_t* e)
+            : MachSymbol(b, o, sizeof(struct nlist), i, e)
+        {
+        }
+
+        MachSymbol64::MachSymbol64(BaseBinary* b, uint64_t o, uint32_t i, rawbyte_t* e)
+            : MachSymbol(b, o, sizeof(struct nlist_64), i, e)
+        {
+        }
+
+        uint32_t MachSymbol32::getNameIndex(){
+            return NLIST32_ENTRY->n_un.n_strx;
+        }
+
+        uint32_t MachSymbol64::getNameIndex(){
+            return NLIST64_ENTRY->n_un.n_strx;
+        }
+
+        uint64_t MachSymbol32::getValue(){
+            return NLIST32_ENTRY->n_value;
+        }
+
+        uint64_t MachSymbol64::getValue(){
+            return NLIST64_ENTRY->n_value;
+        }
+
+        uint32_t MachSymbol32::getType(){
+            return NLIST32_ENTRY->n_type;
+        }
+
+        uint32_t MachSymbol64::getType(){
+            return NLIST64_ENTRY->n_type;
+        }
+
+        uint32_t MachSymbol32::getSectionOrdinal(){
+            return NLIST32_ENTRY->n_sect;
+        }
+
+        uint32_t MachSymbol64::getSectionOrdinal(){
+            return NLIST64_ENTRY->n_sect;
+        }
+
+        uint32_t MachSymbol32::getDescription(){
+            return (uint16_t)NLIST32_ENTRY->n_desc;
+        }
+
+        uint32_t MachSymbol64::getDescription(){
+            return NLIST64_ENTRY->n_desc;
+        }
+
+        bool MachSymbol::isDefined(){
+            return ((getType() & N_STAB) == 0 && (getType() & N_TYPE) == N_SECT);
+        }
+
+        bool MachSymbol::isExternal(){
+            return ((getType() & N_EXT) != 0);
+        }
+
+        bool MachSymbol::isFunction(){
+            return (isDefined() && text);
+        }
+
+        bool MachSymbol::isThumbFunction(){
+            return (isFunction() && (getDescription() & N_ARM_THUMB_DEF) != 0);
+        }
+
+        uint64_t MachSymbol::getFunctionAddress(){
+            EPAXAssert(isFunction(), "This may only call this for function symbols");
+            return getValue();
+        }
+
+        void MachSymbol::print(std::ostream& stream){
+            stream << TAB "[" << DEC(getIndex()) << "]";
+            if (isFunction()){
+                if (isThumbFunction()){
+                    stream << "*T";
+                } else {
+                    stream << "*A";
+                }
+            }
+            stream << TAB "val=" << HEX(getValue())
+                   << TAB "type=" << HEX(getType())
+                   << TAB "sect=" << DEC(getSectionOrdinal())
+                   << TAB "name=" << getName()
+                   << ENDL;
+        }
+
+        MachStringTable::MachStringTable(BaseBinary* b, uint64_t o, uint64_t fs, uint32_t i)
+            : StringTable(b, o, fs, 0, 0, i, "string table"),
+              entry(INVALID_PTR)
+        {
+            // a terminator past the end, for a last string that has none
+            entry = new rawbyte_t[getFileSize() + 1];
+            bzero(entry, getFileSize() + 1);
+            getInputFile()->getBytes(getFileOffset(), getFileSize(), entry);
+        }
+
+        MachStringTable::~MachStringTable(){
+            if (IS_VALID_PTR(entry)){
+                delete[] entry;
+            }
+        }
+
+        char* MachStringTable::getStringAt(uint32_t i){
+            EPAXAssert(i < getFileSize() || i == 0, "StringTable index (" << DEC(i) << ") out of bounds (" << DEC(getFileSize()) << ")");
+            return (char*)&(entry[i]);
+        }
+
+        void MachStringTable::print(std::ostream& stream){
+            stream << "MachStringTable size=" << DEC(getFileSize()) << ENDL;
+            uint32_t cur = 1;
+            while (cur < getFileSize()){
+                char* t = getStringAt(cur);
+                stream << TAB << "[" << DEC(cur) << "]" << TAB << t << ENDL;
+                cur += strlen(t) + 1;
+            }
+        }
+
+        MachSymbolTable::MachSymbolTable(BaseBinary* b, uint64_t o, uint32_t n, uint32_t i, MachStringTable* st)
+            : SymbolTable(b, o, n * (b->is64Bit()? sizeof(struct nlist_64): sizeof(struct nlist)), 0, 0, i, "symbol table"),
+              entry(INVALID_PTR),
+              stringtab(st)
+        {
+            EPAXAssert(IS_VALID_PTR(stringtab), "A symbol table in Mach-O requires a valid string table");
+
+            entry = new rawbyte_t[getFileSize()];
+            getInputFile()->getBytes(getFileOffset(), getFileSize(), entry);
+
+            uint32_t symsize = getFileSize() / (n? n: 1);
+            symbols = new std::vector<Symbol*>();
+            for (uint32_t cur = 0; cur < n; cur++){
+                MachSymbol* s;
+                if (getBinary()->is64Bit()){
+                    s = new MachSymbol64(getBinary(), getFileOffset() + cur * symsize, cur, entry + cur * symsize);
+                } else {
+                    s = new MachSymbol32(getBinary(), getFileOffset() + cur * symsize, cur, entry + cur * symsize);
+                }
+                if (s->getNameIndex() < stringtab->getFileSize()){
+                    s->setName(stringtab->getStringAt(s->getNameIndex()));
+                }
+                symbols->push_back(s);
+            }
+        }
+
+        MachSymbolTable::~MachSymbolTable(){
+            // the symbols are views into entry
+            if (IS_VALID_PTR(symbols)){
+                while (symbols->size()){
+                    delete symbols->back();
+                    symbols->pop_back();
+                }
+                delete symbols;
+                symbols = INVALID_PTR;
+            }
+            if (IS_VALID_PTR(entry)){
+                delete[] entry;
+            }
+        }
+
+        void MachSymbolTable::print(std::ostream& stream){
+            stream << "MachSymbolTable count=" << DEC(countSymbols()) << ENDL;
+            for (std::vector<Symbol*>::const_iterator it = symbols->begin(); it != symbols->end(); it++){
+                MachSymbol* sym = (MachSymbol*)(*it);
+                sym->print(stream);
+            }
+        }
+
     } // namespace MachO
 
 } // namespace EPAX
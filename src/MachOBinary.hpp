@@ -27,21 +27,86 @@
 #define __EPAX_MachOBinary_hpp__
 
 #include "BaseClass.hpp"
+#include "Section.hpp"
+#include "Symbol.hpp"
 
 namespace EPAX {
 
     namespace MachO {
 
+        class LoadCommand;
         class MachHeader;
+        class MachSection;
+        class MachStringTable;
+        class SegmentCommand;
 
+        /**
+         * One slice of a universal (fat) file
+         */
+        typedef struct {
+            int32_t cputype;
+            int32_t cpusubtype;
+            uint64_t offset;
+            uint64_t size;
+        } FatArch;
+
+        /**
+         * A Mach-O image. The load commands are read with one read of the region that
+         * follows the header, and each LoadCommand is a view into that region, so no
+         * command is copied. Segments and sections come from LC_SEGMENT(_64), symbols
+         * from LC_SYMTAB, the entry point from LC_MAIN (or LC_UNIXTHREAD in older
+         * images), and function boundaries from the ULEB128-encoded LC_FUNCTION_STARTS
+         * table when the image has one, or from its symbols when it does not.
+         */
         class MachOBinary : public BaseBinary {
         protected:
             MachHeader* machheader;
+
+            bool foundcommands;
+            rawbyte_t* commandbytes;
+            std::vector<LoadCommand*>* commands;
+
+            bool foundsections;
+            std::vector<SegmentCommand*>* segments;
+
+            // in the order of the load commands; a symbol's n_sect is an index here plus 1
+            std::vector<MachSection*>* sections;
+
+            void findCommands();
+            LoadCommand* findCommand(uint32_t type);
+            bool findFunctionStarts(std::vector<uint64_t>& starts, std::set<uint64_t>& thumbs);
         
         public:
             MachOBinary(std::string n);
+
+            /**
+             * Constructs an image from bytes other than a whole file, e.g. one slice of
+             * a universal file. Every read is relative to f, and nothing outside it is read.
+             */
+            MachOBinary(InputFile* f, bool own);
             virtual ~MachOBinary();
 
+            /**
+             * Reads the architecture table of a universal (fat) file. Only the fat
+             * header and the table are read.
+             *
+             * @param n the name of a file
+             * @param archs (out) the slices of the file
+             * @return false if n is not a universal file
+             */
+            static bool findFatArchs(std::string n, std::vector<FatArch>& archs);
+
+            /**
+             * Picks a slice of a universal file
+             *
+             * @param n the name of a file
+             * @param cputype a CPU_TYPE_* value, or CPU_TYPE_ANY for the ARM slice (or
+             *     failing that the ARM64 slice, or failing that the first)
+             * @param slice (out) the selected slice
+             * @return false if n is not a universal file or has no slice for cputype
+             */
+            static bool selectSlice(std::string n, int32_t cputype, FatArch& slice);
+
             virtual BinaryFormat getFormat() = 0;
             uint64_t getStartAddr();
             void emit(std::string n);
@@ -58,7 +123,13 @@ namespace EPAX {
             void findSymbols();
             void findSections();
 
+            uint32_t countLoadCommands();
+            LoadCommand* getLoadCommand(uint32_t idx);
+            SegmentCommand* findSegment(std::string n);
+            MachSection* getSection(uint32_t ordinal);
+
             bool insideTextRange(uint64_t a);
+            uint64_t vaddrToFile(uint64_t v);
             uint64_t functionEndAddress(Function* f, Function* nextf);
 
             void printSections(std::ostream& stream = std::cout);
@@ -69,6 +140,7 @@ namespace EPAX {
         class MachOBinary32 : public MachOBinary {
         public:
             MachOBinary32(std::string n);
+            MachOBinary32(InputFile* f, bool own);
             virtual ~MachOBinary32() {}
 
             BinaryFormat getFormat() { return BinaryFormat_MachO32; }
@@ -77,6 +149,7 @@ namespace EPAX {
         class MachOBinary64 : public MachOBinary {
         public:
             MachOBinary64(std::string n);
+            MachOBinary64(InputFile* f, bool own);
             virtual ~MachOBinary64() {}
 
             BinaryFormat getFormat() { return BinaryFormat_MachO64; }
@@ -92,11 +165,13 @@ namespace EPAX {
             MachHeader(BaseBinary* b, uint64_t o, uint64_t s);
             virtual ~MachHeader();
 
-            virtual uint64_t getStartAddr() = 0;
             virtual bool verify() = 0;
             virtual bool isARM() = 0;
             virtual void describe() = 0;
             virtual uint32_t getFileType() = 0;
+            virtual int32_t getCPUType() = 0;
+            virtual uint32_t getCommandCount() = 0;
+            virtual uint32_t getCommandSize() = 0;
         }; // class MachHeader
 
         class MachHeader32 : public MachHeader {
@@ -105,11 +180,13 @@ namespace EPAX {
             MachHeader32(BaseBinary* b, uint64_t o);
             virtual ~MachHeader32() {}
 
-            uint64_t getStartAddr();
             bool verify();
             bool isARM();
             void describe();
             uint32_t getFileType();
+            int32_t getCPUType();
+            uint32_t getCommandCount();
+            uint32_t getCommandSize();
         }; // class MachHeader32
 
         class MachHeader64 : public MachHeader {
@@ -117,16 +194,181 @@ namespace EPAX {
             MachHeader64(BaseBinary* b, uint64_t o);
             virtual ~MachHeader64() {}
 
-            uint64_t getStartAddr();
             bool verify();
             bool isARM();
             void describe();
             uint32_t getFileType();
+            int32_t getCPUType();
+            uint32_t getCommandCount();
+            uint32_t getCommandSize();
         }; // class MachHeader64
 
+        /**
+         * A load command, viewed in place in the binary's copy of the command region
+         */
+        class LoadCommand : public FileBase, public IndexBase {
+        protected:
+            rawbyte_t* entry;
+
+        public:
+            LoadCommand(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i, rawbyte_t* e);
+            virtual ~LoadCommand() {}
+
+            uint32_t getType();
+            rawbyte_t* getBytes() { return entry; }
+        }; // class LoadCommand
+
+        class SegmentCommand : public LoadCommand, public NameBase {
+        public:
+            SegmentCommand(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i, rawbyte_t* e);
+            virtual ~SegmentCommand() {}
+
+            bool isValidVaddr(uint64_t v);
+            uint64_t vaddrToFileaddr(uint64_t v);
+
+            virtual uint64_t getVaddr() = 0;
+            virtual uint64_t getMSize() = 0;
+            virtual uint64_t getFOffset() = 0;
+            virtual uint64_t getFSize() = 0;
+            virtual uint32_t getProtection() = 0;
+            virtual uint32_t countSections() = 0;
+
+            // the section structures follow the segment command
+            virtual rawbyte_t* getSectionBytes(uint32_t idx) = 0;
+        }; // class SegmentCommand
+
+        class SegmentCommand32 : public SegmentCommand {
+        public:
+            SegmentCommand32(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i, rawbyte_t* e);
+            virtual ~SegmentCommand32() {}
+
+            uint64_t getVaddr();
+            uint64_t getMSize();
+            uint64_t getFOffset();
+            uint64_t getFSize();
+            uint32_t getProtection();
+            uint32_t countSections();
+            rawbyte_t* getSectionBytes(uint32_t idx);
+        }; // class SegmentCommand32
+
+        class SegmentCommand64 : public SegmentCommand {
+        public:
+            SegmentCommand64(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i, rawbyte_t* e);
+            virtual ~SegmentCommand64() {}
+
+            uint64_t getVaddr();
+            uint64_t getMSize();
+            uint64_t getFOffset();
+            uint64_t getFSize();
+            uint32_t getProtection();
+            uint32_t countSections();
+            rawbyte_t* getSectionBytes(uint32_t idx);
+        }; // class SegmentCommand64
+
+        /**
+         * A section of a segment; its file and memory ranges are those of the section's contents
+         */
+        class MachSection : public Section {
+        private:
+            SegmentCommand* segment;
+            uint32_t flags;
+
+        public:
+            MachSection(BaseBinary* b, SegmentCommand* seg, rawbyte_t* e, uint32_t i);
+            virtual ~MachSection() {}
+
+            void print(std::ostream& stream = std::cout);
+
+            SegmentCommand* getSegment() { return segment; }
+            uint32_t getFlags() { return flags; }
+            uint32_t getType();
+
+            bool isText();
+            bool isData();
+            bool isBSS();
+            bool isDebug();
+        }; // class MachSection
+
+        class MachSymbol : public Symbol {
+        protected:
+            rawbyte_t* entry;
+            bool text;
+
+        public:
+            MachSymbol(BaseBinary* b, uint64_t o, uint64_t s, uint32_t i, rawbyte_t* e);
+            virtual ~MachSymbol() {}
+
+            void print(std::ostream& stream = std::cout);
+
+            virtual uint32_t getNameIndex() = 0;
+            virtual uint64_t getValue() = 0;
+            virtual uint32_t getType() = 0;
+            virtual uint32_t getSectionOrdinal() = 0;
+            virtual uint32_t getDescription() = 0;
+
+            void setText(bool t) { text = t; }
+
+            bool isDefined();
+            bool isExternal();
+            bool isFunction();
+            bool isThumbFunction();
+            uint64_t getFunctionAddress();
+        }; // class MachSymbol
+
+        class MachSymbol32 : public MachSymbol {
+        public:
+            MachSymbol32(BaseBinary* b, uint64_t o, uint32_t i, rawbyte_t* e);
+            virtual ~MachSymbol32() {}
+
+            uint32_t getNameIndex();
+            uint64_t getValue();
+            uint32_t getType();
+            uint32_t getSectionOrdinal();
+            uint32_t getDescription();
+        }; // class MachSymbol32
+
+        class MachSymbol64 : public MachSymbol {
+        public:
+            MachSymbol64(BaseBinary* b, uint64_t o, uint32_t i, rawbyte_t* e);
+            virtual ~MachSymbol64() {}
+
+            uint32_t getNameIndex();
+            uint64_t getValue();
+            uint32_t getType();
+            uint32_t getSectionOrdinal();
+            uint32_t getDescription();
+        }; // class MachSymbol64
+
+        class MachStringTable : public StringTable {
+        private:
+            rawbyte_t* entry;
+
+        public:
+            MachStringTable(BaseBinary* b, uint64_t o, uint64_t fs, uint32_t i);
+            ~MachStringTable();
+
+            char* getStringAt(uint32_t i);
+
+            void print(std::ostream& stream = std::cout);
+        }; // class MachStringTable
+
+        /**
+         * The nlist entries named by LC_SYMTAB, read with one read; each symbol is a view into them
+         */
+        class MachSymbolTable : public SymbolTable {
+        private:
+            rawbyte_t* entry;
+            MachStringTable* stringtab;
+
+        public:
+            MachSymbolTable(BaseBinary* b, uint64_t o, uint32_t n, uint32_t i, MachStringTable* st);
+            ~MachSymbolTable();
+
+            void print(std::ostream& stream = std::cout);
+        }; // class MachSymbolTable
+
     } // namespace MachO    
 
 } // namespace EPAX
 
 #endif // __EPAX_MachOBinary_hpp__
-
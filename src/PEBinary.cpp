@@ -0,0 +1,689 @@
+/**
+ * @file PEBinary.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "PE/pe.h"
+
+#include "Function.hpp"
+#include "InputFile.hpp"
+#include "PEBinary.hpp"
+
+#include <sstream>
+
+// the largest section table a PE loader accepts
+#define PE_MAX_SECTIONS (96)
+
+namespace EPAX {
+
+    namespace PE {
+
+#define FHDR ((IMAGE_FILE_HEADER*)fileheader)
+#define OHDR32 ((IMAGE_OPTIONAL_HEADER32*)optionalheader)
+#define OHDR64 ((IMAGE_OPTIONAL_HEADER64*)optionalheader)
+#define SHDR_ENTRY ((IMAGE_SECTION_HEADER*)entry)
+
+        PEBinary::PEBinary(std::string n)
+            : BaseBinary(n),
+              valid(false), headerbytes(INVALID_PTR), headersize(0),
+              fileheader(INVALID_PTR), optionalheader(INVALID_PTR),
+              foundsections(false), sections(INVALID_PTR)
+        {
+            valid = readHeaders();
+        }
+
+        PEBinary::PEBinary(InputFile* f, bool own)
+            : BaseBinary(f, own),
+              valid(false), headerbytes(INVALID_PTR), headersize(0),
+              fileheader(INVALID_PTR), optionalheader(INVALID_PTR),
+              foundsections(false), sections(INVALID_PTR)
+        {
+            valid = readHeaders();
+        }
+
+        PEBinary::~PEBinary(){
+            if (IS_VALID_PTR(sections)){
+                while (sections->size()){
+                    delete sections->back();
+                    sections->pop_back();
+                }
+                delete sections;
+            }
+
+            if (IS_VALID_PTR(headerbytes)){
+                delete[] headerbytes;
+            }
+        }
+
+        // reads the NT headers and the section table, from the signature through the
+        // last section header, in one read; any file may be handed to verify, so
+        // nothing here asserts
+        bool PEBinary::readHeaders(){
+            IMAGE_DOS_HEADER dos;
+            if (getFileSize() < sizeof(dos)){
+                return false;
+            }
+            getInputFile()->getBytes(0, sizeof(dos), (rawbyte_t*)&dos);
+            if (dos.e_magic != IMAGE_DOS_SIGNATURE){
+                return false;
+            }
+
+            uint64_t off = dos.e_lfanew;
+            uint64_t fixed = sizeof(uint32_t) + sizeof(IMAGE_FILE_HEADER);
+            if (off + fixed > getFileSize()){
+                return false;
+            }
+
+            rawbyte_t nt[sizeof(uint32_t) + sizeof(IMAGE_FILE_HEADER)];
+            getInputFile()->getBytes(off, fixed, nt);
+            IMAGE_FILE_HEADER* fh = (IMAGE_FILE_HEADER*)(nt + sizeof(uint32_t));
+            if (*(uint32_t*)nt != IMAGE_NT_SIGNATURE || fh->NumberOfSections > PE_MAX_SECTIONS
+                || fh->SizeOfOptionalHeader < sizeof(uint16_t)){
+                return false;
+            }
+
+            headersize = fixed + fh->SizeOfOptionalHeader + fh->NumberOfSections * sizeof(IMAGE_SECTION_HEADER);
+            if (off + headersize > getFileSize()){
+                return false;
+            }
+            headerbytes = new rawbyte_t[headersize];
+            getInputFile()->getBytes(off, headersize, headerbytes);
+            fileheader = headerbytes + sizeof(uint32_t);
+            optionalheader = headerbytes + fixed;
+
+            uint16_t magic = *(uint16_t*)optionalheader;
+            if (magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC){
+                return (FHDR->SizeOfOptionalHeader >= offsetof(IMAGE_OPTIONAL_HEADER32, DataDirectory));
+            } else if (magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC){
+                return (FHDR->SizeOfOptionalHeader >= offsetof(IMAGE_OPTIONAL_HEADER64, DataDirectory));
+            }
+            return false;
+        }
+
+        bool PEBinary::verify(){
+            return valid;
+        }
+
+        bool PEBinary::is64Bit(){
+            return (*(uint16_t*)optionalheader == IMAGE_NT_OPTIONAL_HDR64_MAGIC);
+        }
+
+        bool PEBinary::is32Bit(){
+            return !is64Bit();
+        }
+
+        uint32_t PEBinary::getMachine(){
+            return FHDR->Machine;
+        }
+
+        bool PEBinary::isARM(){
+            switch (getMachine()){
+            case IMAGE_FILE_MACHINE_ARM:
+            case IMAGE_FILE_MACHINE_THUMB:
+            case IMAGE_FILE_MACHINE_ARMNT:
+            case IMAGE_FILE_MACHINE_ARM64:
+                return true;
+            }
+            return false;
+        }
+
+        bool PEBinary::isExecutable(){
+            return ((FHDR->Characteristics & IMAGE_FILE_EXECUTABLE_IMAGE) && !(FHDR->Characteristics & IMAGE_FILE_DLL));
+        }
+
+        uint64_t PEBinary::getImageBase(){
+            if (is64Bit()){
+                return OHDR64->ImageBase;
+            }
+            return OHDR32->ImageBase;
+        }
+
+        uint64_t PEBinary::getStartAddr(){
+            uint32_t rva = (is64Bit()? OHDR64->AddressOfEntryPoint: OHDR32->AddressOfEntryPoint);
+            if (rva == 0){
+                return 0;
+            }
+            // ARMNT entry points carry the Thumb bit
+            if (getMachine() == IMAGE_FILE_MACHINE_ARMNT){
+                rva &= ~1;
+            }
+            return getImageBase() + rva;
+        }
+
+        bool PEBinary::getDataDirectory(uint32_t idx, uint32_t& rva, uint32_t& size){
+            uint64_t dirs = (is64Bit()? offsetof(IMAGE_OPTIONAL_HEADER64, DataDirectory): offsetof(IMAGE_OPTIONAL_HEADER32, DataDirectory));
+            uint32_t count = (is64Bit()? OHDR64->NumberOfRvaAndSizes: OHDR32->NumberOfRvaAndSizes);
+            if (idx >= count || dirs + (idx + 1) * sizeof(IMAGE_DATA_DIRECTORY) > FHDR->SizeOfOptionalHeader){
+                return false;
+            }
+            IMAGE_DATA_DIRECTORY* d = (IMAGE_DATA_DIRECTORY*)(optionalheader + dirs) + idx;
+            rva = d->VirtualAddress;
+            size = d->Size;
+            return (rva != 0 && size != 0);
+        }
+
+        void PEBinary::emit(std::string n){
+            __do_not_call__;
+        }
+
+        void PEBinary::describe(){
+            EPAXOut << "format=pe" << TAB;
+            std::cout << "bits=" << (is64Bit()? "64": "32") << TAB;
+            switch (getMachine()){
+#define CASE(__typ__) case IMAGE_FILE_MACHINE_ ## __typ__: std::cout << "isa=" << #__typ__; break
+                CASE(I386);
+                CASE(ARM);
+                CASE(THUMB);
+                CASE(ARMNT);
+                CASE(AMD64);
+                CASE(ARM64);
+            default:
+                std::cout << "isa=unknown";
+            }
+            std::cout << ENDL;
+        }
+
+        void PEBinary::findSections(){
+            EPAXAssert(!foundsections, "this function should only be called once per binary");
+            if (foundsections){
+                return;
+            }
+
+            sections = new std::vector<PESection*>();
+            foundsections = true;
+
+            rawbyte_t* table = optionalheader + FHDR->SizeOfOptionalHeader;
+            for (uint32_t i = 0; i < FHDR->NumberOfSections; i++){
+                sections->push_back(new PESection(this, table + i * sizeof(IMAGE_SECTION_HEADER), i, getImageBase()));
+            }
+        }
+
+        uint32_t PEBinary::countSections(){
+            return sections->size();
+        }
+
+        PESection* PEBinary::getSection(uint32_t idx){
+            EPAXCheck(idx < sections->size(), "Invalid section index " << DEC(idx));
+            return (*sections)[idx];
+        }
+
+        PESection* PEBinary::findSectionRVA(uint32_t rva){
+            for (std::vector<PESection*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                if ((*it)->inRVA(rva)){
+                    return (*it);
+                }
+            }
+            return INVALID_PTR;
+        }
+
+        // whether [rva, rva + size) lies within the file data of one section
+        bool PEBinary::inRVAData(uint32_t rva, uint32_t size){
+            PESection* s = findSectionRVA(rva);
+            return (IS_VALID_PTR(s) && (uint64_t)rva + size <= (uint64_t)s->getVirtualAddress() + s->getFileSize());
+        }
+
+        // reads [rva, rva + size), which must lie within the file data of one section
+        bool PEBinary::readRVA(uint32_t rva, uint32_t size, rawbyte_t* buf){
+            if (!inRVAData(rva, size)){
+                return false;
+            }
+            getInputFile()->getBytes(findSectionRVA(rva)->rvaToFile(rva), size, buf);
+            return true;
+        }
+
+        bool PEBinary::insideTextRange(uint64_t a){
+            for (std::vector<PESection*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                PESection* s = (*it);
+                if (s->isText() && s->inRange(a)){
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        uint64_t PEBinary::vaddrToFile(uint64_t v){
+            if (v < getImageBase() || v - getImageBase() > 0xffffffff){
+                return 0;
+            }
+            uint32_t rva = v - getImageBase();
+            PESection* s = findSectionRVA(rva);
+            if (!IS_VALID_PTR(s) || rva - s->getVirtualAddress() >= s->getFileSize()){
+                return 0;
+            }
+            return s->rvaToFile(rva);
+        }
+
+        uint64_t PEBinary::functionEndAddress(Function* f, Function* nextf){
+            uint64_t addr = INVALID_ADDRESS;
+
+            for (std::vector<PESection*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                PESection* s = (*it);
+                if (s->isText() && s->inRange(f->getMemoryAddress())){
+                    addr = s->getFileOffset() + s->getFileSize();
+                    break;
+                }
+            }
+
+            PESymbol* sym = (PESymbol*)f->getSymbol();
+            if (IS_VALID_PTR(sym) && sym->getLength() > 0 && f->getFileOffset() + sym->getLength() < addr){
+                addr = f->getFileOffset() + sym->getLength();
+            }
+
+            if (IS_VALID_PTR(nextf)){
+                if (nextf->getFileOffset() < addr){
+                    addr = nextf->getFileOffset();
+                }
+            }
+
+            return addr;
+        }
+
+        // the export table is read with one read of the section holding it
+        void PEBinary::findExports(std::vector<PESymbol*>& syms){
+            uint32_t dirrva, dirsize;
+            if (!getDataDirectory(IMAGE_DIRECTORY_ENTRY_EXPORT, dirrva, dirsize)){
+                return;
+            }
+            PESection* s = findSectionRVA(dirrva);
+            if (!IS_VALID_PTR(s) || s->getFileSize() == 0){
+                return;
+            }
+
+            uint32_t base = s->getVirtualAddress();
+            uint32_t size = s->getFileSize();
+            rawbyte_t* buf = new rawbyte_t[size + 1];
+            getInputFile()->getBytes(s->getFileOffset(), size, buf);
+            buf[size] = '\0';
+
+            // an RVA range within buf, or NULL
+#define EXPORT_AT(__rva__, __len__) ((uint64_t)(__rva__) >= base && (uint64_t)(__rva__) - base + (__len__) <= size? buf + ((__rva__) - base): NULL)
+
+            IMAGE_EXPORT_DIRECTORY* dir = (IMAGE_EXPORT_DIRECTORY*)EXPORT_AT(dirrva, sizeof(IMAGE_EXPORT_DIRECTORY));
+            uint32_t* funcs = INVALID_PTR;
+            uint32_t* names = INVALID_PTR;
+            uint16_t* ordinals = INVALID_PTR;
+            if (dir != NULL){
+                funcs = (uint32_t*)EXPORT_AT(dir->AddressOfFunctions, (uint64_t)dir->NumberOfFunctions * sizeof(uint32_t));
+                names = (uint32_t*)EXPORT_AT(dir->AddressOfNames, (uint64_t)dir->NumberOfNames * sizeof(uint32_t));
+                ordinals = (uint16_t*)EXPORT_AT(dir->AddressOfNameOrdinals, (uint64_t)dir->NumberOfNames * sizeof(uint16_t));
+            }
+            if (!IS_VALID_PTR(funcs)){
+                if (dir != NULL){
+                    EPAXWarn << getName() << ": malformed export table; ignoring it" << ENDL;
+                }
+                delete[] buf;
+                return;
+            }
+
+            bool thumb = (getMachine() == IMAGE_FILE_MACHINE_ARMNT);
+            std::vector<PESymbol*> byindex(dir->NumberOfFunctions, (PESymbol*)INVALID_PTR);
+
+            // named exports, in name order, then exports known only by ordinal
+            for (uint32_t i = 0; i < dir->NumberOfNames && IS_VALID_PTR(names) && IS_VALID_PTR(ordinals); i++){
+                uint16_t idx = ordinals[i];
+                if (idx >= dir->NumberOfFunctions || funcs[idx] == 0){
+                    continue;
+                }
+                uint32_t rva = funcs[idx];
+                // an RVA inside the export directory names a forwarder, not code
+                bool forward = (rva >= dirrva && rva < dirrva + dirsize);
+                uint64_t addr = getImageBase() + (thumb? (rva & ~1): rva);
+
+                PESymbol* sym = new PESymbol(this, addr, syms.size(), thumb && (rva & 1), true, !forward && insideTextRange(addr));
+                char* name = (char*)EXPORT_AT(names[i], 1);
+                sym->setName(name != NULL? std::string(name): std::string(NAME_UNKNOWN));
+                syms.push_back(sym);
+                byindex[idx] = sym;
+            }
+            for (uint32_t idx = 0; idx < dir->NumberOfFunctions; idx++){
+                uint32_t rva = funcs[idx];
+                if (IS_VALID_PTR(byindex[idx]) || rva == 0){
+                    continue;
+                }
+                bool forward = (rva >= dirrva && rva < dirrva + dirsize);
+                uint64_t addr = getImageBase() + (thumb? (rva & ~1): rva);
+
+                PESymbol* sym = new PESymbol(this, addr, syms.size(), thumb && (rva & 1), true, !forward && insideTextRange(addr));
+                std::stringstream ss;
+                ss << "ordinal_" << std::dec << (dir->Base + idx);
+                sym->setName(ss.str());
+                syms.push_back(sym);
+            }
+
+            delete[] buf;
+        }
+
+        // the length recorded in the first word of an ARM or ARM64 .xdata record
+        uint64_t PEBinary::xdataFunctionLength(uint32_t rva){
+            uint32_t word;
+            if (!readRVA(rva, sizeof(word), (rawbyte_t*)&word)){
+                return 0;
+            }
+            return (word & 0x3ffff) * (getMachine() == IMAGE_FILE_MACHINE_ARM64? 4: 2);
+        }
+
+        // maps the start of each .pdata entry to its length (0 if unknown)
+        void PEBinary::findRuntimeFunctions(std::map<uint64_t, uint64_t>& lengths){
+            uint32_t rva, size;
+            if (!getDataDirectory(IMAGE_DIRECTORY_ENTRY_EXCEPTION, rva, size)){
+                return;
+            }
+
+            uint32_t machine = getMachine();
+            bool arm = (machine == IMAGE_FILE_MACHINE_ARMNT || machine == IMAGE_FILE_MACHINE_ARM64);
+            if (!arm && machine != IMAGE_FILE_MACHINE_AMD64){
+                return;
+            }
+
+            uint32_t entsize = (arm? sizeof(IMAGE_ARM_RUNTIME_FUNCTION_ENTRY): sizeof(IMAGE_AMD64_RUNTIME_FUNCTION_ENTRY));
+            uint32_t count = size / entsize;
+
+            // the size is untrusted, so check it against the section before allocating
+            if (!inRVAData(rva, count * entsize)){
+                EPAXWarn << getName() << ": .pdata lies outside the file; ignoring it" << ENDL;
+                return;
+            }
+            rawbyte_t* buf = new rawbyte_t[count * entsize];
+            readRVA(rva, count * entsize, buf);
+
+            for (uint32_t i = 0; i < count; i++){
+                uint64_t start, length;
+                if (arm){
+                    IMAGE_ARM_RUNTIME_FUNCTION_ENTRY* e = (IMAGE_ARM_RUNTIME_FUNCTION_ENTRY*)(buf + i * entsize);
+                    start = (machine == IMAGE_FILE_MACHINE_ARMNT? (e->BeginAddress & ~1): e->BeginAddress);
+                    if (e->UnwindData & 3){
+                        length = ((e->UnwindData >> 2) & 0x7ff) * (machine == IMAGE_FILE_MACHINE_ARM64? 4: 2);
+                    } else {
+                        length = xdataFunctionLength(e->UnwindData);
+                    }
+                } else {
+                    IMAGE_AMD64_RUNTIME_FUNCTION_ENTRY* e = (IMAGE_AMD64_RUNTIME_FUNCTION_ENTRY*)(buf + i * entsize);
+                    start = e->BeginAddress;
+                    length = (e->EndAddress > e->BeginAddress? e->EndAddress - e->BeginAddress: 0);
+                }
+                lengths[getImageBase() + start] = length;
+            }
+
+            delete[] buf;
+        }
+
+        void PEBinary::findSymbols(){
+            EPAXAssert(!foundsymbols, "this function should only be called once per binary");
+            if (foundsymbols){
+                return;
+            }
+
+            symtabs = new std::vector<SymbolTable*>();
+            strtabs = new std::vector<StringTable*>();
+            foundsymbols = true;
+
+            if (!foundsections){
+                findSections();
+            }
+
+            std::vector<PESymbol*> syms;
+            findExports(syms);
+
+            std::map<uint64_t, PESymbol*> exported;
+            for (std::vector<PESymbol*>::const_iterator it = syms.begin(); it != syms.end(); it++){
+                PESymbol* s = (*it);
+                if (s->isFunction() && exported.count(s->getFunctionAddress()) == 0){
+                    exported[s->getFunctionAddress()] = s;
+                }
+            }
+
+            // every .pdata entry is a function; it takes the name of an export at its start
+            std::map<uint64_t, uint64_t> lengths;
+            findRuntimeFunctions(lengths);
+            bool thumb = (getMachine() == IMAGE_FILE_MACHINE_ARMNT);
+            for (std::map<uint64_t, uint64_t>::const_iterator it = lengths.begin(); it != lengths.end(); it++){
+                std::map<uint64_t, PESymbol*>::iterator x = exported.find(it->first);
+                if (x != exported.end()){
+                    x->second->setLength(it->second);
+                    continue;
+                }
+                PESymbol* s = new PESymbol(this, it->first, syms.size(), thumb, false, true);
+                s->setName(NAME_UNKNOWN);
+                s->setLength(it->second);
+                syms.push_back(s);
+            }
+
+            symtabs->push_back(new PESymbolTable(this, 0, syms));
+        }
+
+        void PEBinary::findFunctions(){
+            EPAXAssert(!foundfunctions, "this function should only be called once per binary");
+            if (foundfunctions){
+                return;
+            }
+
+            lazySymbols();
+
+            functions = new std::vector<Function*>();
+            foundfunctions = true;
+
+            // one function per start, preferring an exported symbol
+            std::map<uint64_t, PESymbol*> starts;
+            for (std::vector<SymbolTable*>::const_iterator it = symtabs->begin(); it != symtabs->end(); it++){
+                SymbolTable* symt = (*it);
+                for (uint32_t i = 0; i < symt->countSymbols(); i++){
+                    PESymbol* s = (PESymbol*)symt->getSymbol(i);
+                    if (!s->isFunction() || !insideTextRange(s->getFunctionAddress())){
+                        continue;
+                    }
+                    std::map<uint64_t, PESymbol*>::iterator x = starts.find(s->getFunctionAddress());
+                    if (x == starts.end()){
+                        starts[s->getFunctionAddress()] = s;
+                    } else if (s->isExported() && !x->second->isExported()){
+                        x->second = s;
+                    }
+                }
+            }
+
+            uint32_t cur = 0;
+            bool v8 = (getMachine() == IMAGE_FILE_MACHINE_ARM64);
+            for (std::map<uint64_t, PESymbol*>::const_iterator it = starts.begin(); it != starts.end(); it++){
+                functions->push_back(new Function(this, vaddrToFile(it->first), 0, it->first, cur, it->second, v8));
+                cur++;
+            }
+
+            for (uint32_t i = 0; i < functions->size(); i++){
+                Function* f = (*functions)[i];
+                uint64_t end_addr = functionEndAddress(f, i+1 < functions->size()? (*functions)[i+1]:INVALID_PTR);
+                if (INVALID_ADDRESS != end_addr){
+                    f->setMemorySize(end_addr - f->getFileOffset());
+                }
+            }
+
+            for (std::vector<Function*>::const_iterator it = functions->begin(); it != functions->end(); it++){
+                Function* f = (*it);
+                f->disassemble();
+            }
+        }
+
+        void PEBinary::printSections(std::ostream& stream){
+            stream << ENDL;
+            stream << "Printing all Section Headers in " << getName() << ENDL;
+            stream << "PE_SHDR [" << std::setw(2) << "ID" << "]"
+                   << TAB << std::setw(8) << "NAME"
+                   << TAB << "VIRTADDR"
+                   << TAB << "MEM_SIZE"
+                   << TAB << "FLOFFSET"
+                   << TAB << "FLAGS"
+                   << TAB << "SECTYP"
+                   << ENDL;
+            if (IS_VALID_PTR(sections)){
+                for (std::vector<PESection*>::const_iterator it = sections->begin(); it != sections->end(); it++){
+                    (*it)->print(stream);
+                }
+            }
+        }
+
+        void PEBinary::printFunctions(std::ostream& stream){
+            stream << ENDL;
+            stream << "Printing all functions in " << getName() << ENDL;
+            Function::printHeader();
+            for (std::vector<Function*>::const_iterator it = functions->begin(); it != functions->end(); it++){
+                Function* f = (*it);
+                f->print(stream);
+            }
+        }
+
+        // the fields of a section header, for PESection's base
+        static uint64_t sectionFileSize(rawbyte_t* e){
+            IMAGE_SECTION_HEADER* h = (IMAGE_SECTION_HEADER*)e;
+            if (h->VirtualSize != 0 && h->VirtualSize < h->SizeOfRawData){
+                return h->VirtualSize;
+            }
+            return h->SizeOfRawData;
+        }
+
+        static uint64_t sectionMemorySize(rawbyte_t* e){
+            IMAGE_SECTION_HEADER* h = (IMAGE_SECTION_HEADER*)e;
+            return (h->VirtualSize != 0? h->VirtualSize: h->SizeOfRawData);
+        }
+
+        static std::string sectionName(rawbyte_t* e){
+            IMAGE_SECTION_HEADER* h = (IMAGE_SECTION_HEADER*)e;
+            uint32_t n = 0;
+            while (n < IMAGE_SIZEOF_SHORT_NAME && h->Name[n] != '\0'){
+                n++;
+            }
+            return std::string((char*)h->Name, n);
+        }
+
+        PESection::PESection(BaseBinary* b, rawbyte_t* e, uint32_t i, uint64_t base)
+            : Section(b, ((IMAGE_SECTION_HEADER*)e)->PointerToRawData, sectionFileSize(e), base + ((IMAGE_SECTION_HEADER*)e)->VirtualAddress, sectionMemorySize(e), i, sectionName(e)),
+              entry(e),
+              imagebase(base)
+        {
+            // raw data may be cut short by the end of the file
+            if (getFileOffset() > b->getFileSize()){
+                setFileSize(0);
+            } else if (getFileSize() > b->getFileSize() - getFileOffset()){
+                setFileSize(b->getFileSize() - getFileOffset());
+            }
+        }
+
+        uint32_t PESection::getVirtualAddress(){
+            return SHDR_ENTRY->VirtualAddress;
+        }
+
+        uint32_t PESection::getVirtualSize(){
+            return SHDR_ENTRY->VirtualSize;
+        }
+
+        uint32_t PESection::getRawSize(){
+            return SHDR_ENTRY->SizeOfRawData;
+        }
+
+        uint32_t PESection::getRawOffset(){
+            return SHDR_ENTRY->PointerToRawData;
+        }
+
+        uint32_t PESection::getCharacteristics(){
+            return SHDR_ENTRY->Characteristics;
+        }
+
+        bool PESection::inRVA(uint32_t rva){
+            return (rva >= getVirtualAddress() && rva - getVirtualAddress() < getMemorySize());
+        }
+
+        uint64_t PESection::rvaToFile(uint32_t rva){
+            EPAXAssert(inRVA(rva), "RVA " << HEX(rva) << " is not in section " << getName());
+            return getFileOffset() + (rva - getVirtualAddress());
+        }
+
+        bool PESection::isText(){
+            return ((getCharacteristics() & (IMAGE_SCN_CNT_CODE | IMAGE_SCN_MEM_EXECUTE)) != 0);
+        }
+
+        bool PESection::isData(){
+            return (!isText() && (getCharacteristics() & IMAGE_SCN_CNT_INITIALIZED_DATA) && (getCharacteristics() & IMAGE_SCN_MEM_WRITE));
+        }
+
+        bool PESection::isBSS(){
+            return ((getCharacteristics() & IMAGE_SCN_CNT_UNINITIALIZED_DATA) != 0);
+        }
+
+        bool PESection::isDebug(){
+            return (getName().compare(0, 6, ".debug") == 0);
+        }
+
+        void PESection::print(std::ostream& stream){
+            stream << "PE_SHDR [" << std::setw(2) << DEC(getIndex()) << "]"
+                   << TAB << std::setw(8) << getName()
+                   << TAB << HEX(getMemoryAddress())
+                   << TAB << HEX(getMemorySize())
+                   << TAB << HEX(getFileOffset())
+                   << TAB << HEX(getCharacteristics())
+                   << TAB << (isText()? "T":" ") << (isData()? "D":" ") << (isBSS()? "B":" ") << (isDebug()? "D":" ")
+                   << ENDL;
+        }
+
+        PESymbol::PESymbol(BaseBinary* b, uint64_t a, uint32_t i, bool t, bool x, bool c)
+            : Symbol(b, 0, 0, i),
+              address(a), length(0),
+              thumb(t), exported(x), code(c)
+        {
+        }
+
+        uint64_t PESymbol::getFunctionAddress(){
+            EPAXAssert(isFunction(), "This may only call this for function symbols");
+            return address;
+        }
+
+        void PESymbol::print(std::ostream& stream){
+            stream << TAB "[" << DEC(getIndex()) << "]";
+            if (isFunction()){
+                if (isThumbFunction()){
+                    stream << "*T";
+                } else {
+                    stream << "*A";
+                }
+            }
+            stream << TAB "addr=" << HEX(address)
+                   << TAB "len=" << DEC(length)
+                   << TAB << (exported? "export": "pdata")
+                   << TAB "name=" << getName()
+                   << ENDL;
+        }
+
+        PESymbolTable::PESymbolTable(BaseBinary* b, uint32_t i, std::vector<PESymbol*>& syms)
+            : SymbolTable(b, 0, 0, 0, 0, i, "exports and .pdata")
+        {
+            symbols = new std::vector<Symbol*>(syms.begin(), syms.end());
+        }
+
+        void PESymbolTable::print(std::ostream& stream){
+            stream << "PESymbolTable count=" << DEC(countSymbols()) << ENDL;
+            for (std::vector<Symbol*>::const_iterator it = symbols->begin(); it != symbols->end(); it++){
+                PESymbol* sym = (PESymbol*)(*it);
+                sym->print(stream);
+            }
+        }
+
+    } // namespace PE
+
+} // namespace EPAX
@@ -0,0 +1,184 @@
+/**
+ * @file PEBinary.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_PEBinary_hpp__
+#define __EPAX_PEBinary_hpp__
+
+#include "BaseClass.hpp"
+#include "Section.hpp"
+#include "Symbol.hpp"
+
+namespace EPAX {
+
+    namespace PE {
+
+        class PESection;
+        class PESymbol;
+
+        /**
+         * A PE/COFF image (PE32 or PE32+). The NT headers and the section table are
+         * read with one read, and each PESection is a view into that buffer. Function
+         * starts and lengths come from the .pdata RUNTIME_FUNCTION entries, and names
+         * from the export table; exported functions that have no .pdata entry (leaf
+         * functions need none) are found too. On ARM (ARMNT) every function is Thumb-2.
+         */
+        class PEBinary : public BaseBinary {
+        protected:
+            bool valid;
+            rawbyte_t* headerbytes;
+            uint64_t headersize;
+
+            // views into headerbytes
+            rawbyte_t* fileheader;
+            rawbyte_t* optionalheader;
+
+            bool foundsections;
+            std::vector<PESection*>* sections;
+
+            bool readHeaders();
+            bool inRVAData(uint32_t rva, uint32_t size);
+            bool readRVA(uint32_t rva, uint32_t size, rawbyte_t* buf);
+            void findExports(std::vector<PESymbol*>& syms);
+            void findRuntimeFunctions(std::map<uint64_t, uint64_t>& lengths);
+            uint64_t xdataFunctionLength(uint32_t rva);
+
+        public:
+            PEBinary(std::string n);
+
+            /**
+             * Constructs an image from bytes other than a file on disk, e.g. an image
+             * held in memory. Every read is relative to f.
+             */
+            PEBinary(InputFile* f, bool own);
+            virtual ~PEBinary();
+
+            BinaryFormat getFormat() { return BinaryFormat_PE; }
+            uint64_t getStartAddr();
+            void emit(std::string n);
+
+            bool verify();
+            bool isARM();
+            void describe();
+
+            bool is32Bit();
+            bool is64Bit();
+            bool isExecutable();
+
+            void findFunctions();
+            void findSymbols();
+            void findSections();
+
+            uint32_t getMachine();
+            uint64_t getImageBase();
+
+            /**
+             * Gets an entry of the optional header's data directory
+             *
+             * @param idx an IMAGE_DIRECTORY_ENTRY_* value
+             * @param rva (out) the directory's RVA
+             * @param size (out) the directory's size
+             * @return false if the image has no such directory
+             */
+            bool getDataDirectory(uint32_t idx, uint32_t& rva, uint32_t& size);
+
+            uint32_t countSections();
+            PESection* getSection(uint32_t idx);
+            PESection* findSectionRVA(uint32_t rva);
+
+            bool insideTextRange(uint64_t a);
+            uint64_t vaddrToFile(uint64_t v);
+            uint64_t functionEndAddress(Function* f, Function* nextf);
+
+            void printSections(std::ostream& stream = std::cout);
+            void printFunctions(std::ostream& stream = std::cout);
+        }; // class PEBinary
+
+        class PESection : public Section {
+        private:
+            rawbyte_t* entry;
+            uint64_t imagebase;
+
+        public:
+            PESection(BaseBinary* b, rawbyte_t* e, uint32_t i, uint64_t base);
+            virtual ~PESection() {}
+
+            uint32_t getVirtualAddress();
+            uint32_t getVirtualSize();
+            uint32_t getRawSize();
+            uint32_t getRawOffset();
+            uint32_t getCharacteristics();
+
+            bool inRVA(uint32_t rva);
+            uint64_t rvaToFile(uint32_t rva);
+
+            bool isText();
+            bool isData();
+            bool isBSS();
+            bool isDebug();
+
+            void print(std::ostream& stream = std::cout);
+        }; // class PESection
+
+        /**
+         * A function found in the export table or in .pdata. Unlike ELF and Mach-O
+         * symbols these are not views of one table entry: an export is assembled from
+         * three arrays, and a .pdata entry has no name.
+         */
+        class PESymbol : public Symbol {
+        private:
+            uint64_t address;
+            uint64_t length;
+            bool thumb;
+            bool exported;
+            bool code;
+
+        public:
+            PESymbol(BaseBinary* b, uint64_t a, uint32_t i, bool t, bool x, bool c);
+            virtual ~PESymbol() {}
+
+            bool isFunction() { return code; }
+            bool isThumbFunction() { return (code && thumb); }
+            bool isExported() { return exported; }
+            uint64_t getFunctionAddress();
+
+            // the length given by .pdata, or 0 if unknown
+            uint64_t getLength() { return length; }
+            void setLength(uint64_t l) { length = l; }
+
+            void print(std::ostream& stream = std::cout);
+        }; // class PESymbol
+
+        class PESymbolTable : public SymbolTable {
+        public:
+            PESymbolTable(BaseBinary* b, uint32_t i, std::vector<PESymbol*>& syms);
+            ~PESymbolTable() {}
+
+            void print(std::ostream& stream = std::cout);
+        }; // class PESymbolTable
+
+    } // namespace PE
+
+} // namespace EPAX
+
+#endif // __EPAX_PEBinary_hpp__
@@ -0,0 +1,582 @@
+/**
+ * @file ProcessImage.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "Binary.hpp"
+#include "ProcessImage.hpp"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sstream>
+
+// r_debug.r_state when the link map is not being changed
+#define RT_CONSISTENT (0)
+
+namespace EPAX {
+
+    // the fields of a program header used here, from either ELF class
+    static void decodeSegment(const char* p, uint32_t wordsize, uint32_t& type, uint64_t& offset, uint64_t& vaddr, uint64_t& filesz){
+        if (wordsize == 8){
+            Elf64_Phdr ph;
+            memcpy(&ph, p, sizeof(ph));
+            type = ph.p_type;
+            offset = ph.p_offset;
+            vaddr = ph.p_vaddr;
+            filesz = ph.p_filesz;
+        } else {
+            Elf32_Phdr ph;
+            memcpy(&ph, p, sizeof(ph));
+            type = ph.p_type;
+            offset = ph.p_offset;
+            vaddr = ph.p_vaddr;
+            filesz = ph.p_filesz;
+        }
+    }
+
+    static uint32_t segmentSize(uint32_t wordsize){
+        return (wordsize == 8? sizeof(Elf64_Phdr): sizeof(Elf32_Phdr));
+    }
+
+    // the fields of a section header used here, from either ELF class
+    static void decodeSection(const char* p, uint32_t wordsize, uint32_t& type, uint32_t& link, uint64_t& offset, uint64_t& size){
+        if (wordsize == 8){
+            Elf64_Shdr sh;
+            memcpy(&sh, p, sizeof(sh));
+            type = sh.sh_type;
+            link = sh.sh_link;
+            offset = sh.sh_offset;
+            size = sh.sh_size;
+        } else {
+            Elf32_Shdr sh;
+            memcpy(&sh, p, sizeof(sh));
+            type = sh.sh_type;
+            link = sh.sh_link;
+            offset = sh.sh_offset;
+            size = sh.sh_size;
+        }
+    }
+
+    // the name (an offset into the string table) and value of a symbol, from either ELF class
+    static void decodeSymbol(const char* p, uint32_t wordsize, uint32_t& name, uint64_t& value){
+        if (wordsize == 8){
+            Elf64_Sym sym;
+            memcpy(&sym, p, sizeof(sym));
+            name = sym.st_name;
+            value = sym.st_value;
+        } else {
+            Elf32_Sym sym;
+            memcpy(&sym, p, sizeof(sym));
+            name = sym.st_name;
+            value = sym.st_value;
+        }
+    }
+
+    ProcessImage::ProcessImage(pid_t p, std::string c)
+        : pid(p), cachedir(c), wordsize(sizeof(void*)), entry(0), interpreter(0), rendezvous(0), updater(0), memfd(-1)
+    {
+        std::stringstream ss;
+        ss << "/proc/" << DEC(pid);
+        setName(ss.str());
+
+        // the process may not be of the same class as this one
+        std::ifstream exe((ss.str() + "/exe").c_str(), std::ios::binary);
+        char ident[EI_NIDENT];
+        if (exe.read(ident, sizeof(ident)) && memcmp(ident, ELFMAG, SELFMAG) == 0){
+            wordsize = (ident[EI_CLASS] == ELFCLASS64? 8: 4);
+        }
+
+        std::map<uint64_t, uint64_t> aux;
+        readAuxv(aux);
+        entry = aux[AT_ENTRY];
+        interpreter = aux[AT_BASE];
+
+        memfd = open((ss.str() + "/mem").c_str(), O_RDONLY | O_CLOEXEC);
+        refresh();
+    }
+
+    ProcessImage::~ProcessImage(){
+        for (std::map<std::string, Binary*>::iterator it = binaries.begin(); it != binaries.end(); it++){
+            if (IS_VALID_PTR(it->second)){
+                delete it->second;
+            }
+        }
+        for (std::vector<ImageObject*>::iterator it = objects.begin(); it != objects.end(); it++){
+            delete (*it);
+        }
+        if (memfd >= 0){
+            close(memfd);
+        }
+    }
+
+    bool ProcessImage::readMemory(uint64_t addr, void* buf, uint64_t size){
+        if (memfd < 0){
+            return false;
+        }
+        return (pread(memfd, buf, size, addr) == (ssize_t)size);
+    }
+
+    bool ProcessImage::readWord(uint64_t addr, uint64_t& word){
+        if (wordsize == 8){
+            return readMemory(addr, &word, sizeof(word));
+        }
+        uint32_t w;
+        if (!readMemory(addr, &w, sizeof(w))){
+            return false;
+        }
+        word = w;
+        return true;
+    }
+
+    bool ProcessImage::readMappings(){
+        std::ifstream maps((getName() + "/maps").c_str());
+        if (!maps.is_open()){
+            return false;
+        }
+
+        mappings.clear();
+        std::string line;
+        while (std::getline(maps, line)){
+            unsigned long long start, end, offset;
+            char perms[5];
+            int pathidx = 0;
+            if (sscanf(line.c_str(), "%llx-%llx %4s %llx %*s %*s %n", &start, &end, perms, &offset, &pathidx) < 4 || pathidx == 0){
+                continue;
+            }
+
+            // anonymous memory and the kernel's pseudo-files ([stack], [vdso], ...)
+            if (line[pathidx] != '/'){
+                continue;
+            }
+
+            ImageMapping m;
+            m.start = start;
+            m.end = end;
+            m.offset = offset;
+            m.exec = (perms[2] == 'x');
+            m.path = line.substr(pathidx);
+            mappings.push_back(m);
+        }
+        return true;
+    }
+
+    ImageMapping* ProcessImage::findMapping(uint64_t addr){
+        for (std::vector<ImageMapping>::iterator it = mappings.begin(); it != mappings.end(); it++){
+            if (addr >= it->start && addr < it->end){
+                return &(*it);
+            }
+        }
+        return INVALID_PTR;
+    }
+
+    void ProcessImage::readAuxv(std::map<uint64_t, uint64_t>& aux){
+        std::ifstream auxv((getName() + "/auxv").c_str(), std::ios::binary);
+        while (auxv.good()){
+            uint64_t entry[2] = { 0, 0 };
+            if (wordsize == 8){
+                auxv.read((char*)entry, sizeof(entry));
+            } else {
+                uint32_t e[2];
+                auxv.read((char*)e, sizeof(e));
+                entry[0] = e[0];
+                entry[1] = e[1];
+            }
+            if (!auxv.good() || entry[0] == AT_NULL){
+                break;
+            }
+            aux[entry[0]] = entry[1];
+        }
+    }
+
+    // the address of r_debug, found through the DT_DEBUG entry of the executable's
+    // dynamic section, or 0 if the executable has none or the dynamic linker has not set it
+    uint64_t ProcessImage::findRendezvous(){
+        std::map<uint64_t, uint64_t> aux;
+        readAuxv(aux);
+        if (aux.count(AT_PHDR) == 0 || aux.count(AT_PHNUM) == 0){
+            return 0;
+        }
+
+        uint32_t phsize = segmentSize(wordsize);
+        std::vector<char> phdrs(phsize * aux[AT_PHNUM]);
+        if (phdrs.empty() || !readMemory(aux[AT_PHDR], &phdrs[0], phdrs.size())){
+            return 0;
+        }
+
+        uint64_t phdrvaddr = 0;
+        uint64_t dynvaddr = 0;
+        bool hasphdr = false;
+        bool hasdyn = false;
+        for (uint32_t i = 0; i < aux[AT_PHNUM]; i++){
+            uint32_t type;
+            uint64_t offset, vaddr, filesz;
+            decodeSegment(&phdrs[i * phsize], wordsize, type, offset, vaddr, filesz);
+            if (type == PT_PHDR){
+                phdrvaddr = vaddr;
+                hasphdr = true;
+            } else if (type == PT_DYNAMIC){
+                dynvaddr = vaddr;
+                hasdyn = true;
+            }
+        }
+        if (!hasdyn){
+            return 0;
+        }
+
+        uint64_t bias;
+        if (hasphdr){
+            bias = aux[AT_PHDR] - phdrvaddr;
+        } else {
+            ImageMapping* m = findMapping(aux[AT_PHDR]);
+            if (!IS_VALID_PTR(m) || !findFileBias(*m, bias)){
+                return 0;
+            }
+        }
+
+        uint64_t dyn = bias + dynvaddr;
+        for (uint32_t i = 0; i < PROCESS_IMAGE_MAX_ENTRIES; i++){
+            uint64_t tag, val;
+            if (!readWord(dyn + (2 * i) * wordsize, tag) || !readWord(dyn + (2 * i + 1) * wordsize, val) || tag == DT_NULL){
+                break;
+            }
+            if (tag == DT_DEBUG){
+                return val;
+            }
+        }
+        return 0;
+    }
+
+    // collects the bias of each object in the dynamic linker's link map, by the run
+    // time address of its dynamic section
+    bool ProcessImage::readLinkMap(std::map<uint64_t, uint64_t>& biases){
+        if (rendezvous == 0){
+            rendezvous = findRendezvous();
+        }
+        if (rendezvous == 0){
+            return false;
+        }
+
+        // struct r_debug: int r_version; struct link_map* r_map; ElfW(Addr) r_brk; int r_state; ...
+        int32_t version;
+        int32_t state;
+        uint64_t lm, brk;
+        if (!readMemory(rendezvous, &version, sizeof(version)) || version < 1 ||
+            !readWord(rendezvous + wordsize, lm) ||
+            !readWord(rendezvous + 2 * wordsize, brk) ||
+            !readMemory(rendezvous + 3 * wordsize, &state, sizeof(state))){
+            return false;
+        }
+
+        if (brk != 0){
+            updater = brk;
+        }
+
+        // the list is being changed; the mappings are used until the next refresh
+        if (state != RT_CONSISTENT){
+            return false;
+        }
+
+        // struct link_map: ElfW(Addr) l_addr; char* l_name; ElfW(Dyn)* l_ld; struct link_map* l_next; ...
+        // the object is identified by the mapping holding its dynamic section, as
+        // l_name may be relative, empty (for the executable) or name no file (the vdso)
+        for (uint32_t i = 0; lm != 0 && i < PROCESS_IMAGE_MAX_ENTRIES; i++){
+            uint64_t addr, ld;
+            if (!readWord(lm, addr) || !readWord(lm + 2 * wordsize, ld)){
+                return false;
+            }
+            biases[ld] = addr;
+            if (!readWord(lm + 3 * wordsize, lm)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the bias implied by where a mapping of a file is, from the loadable segment
+    // holding the mapped file offset
+    bool ProcessImage::findFileBias(const ImageMapping& m, uint64_t& bias){
+        std::ifstream file(m.path.c_str(), std::ios::binary);
+        char ident[EI_NIDENT];
+        if (!file.read(ident, sizeof(ident)) || memcmp(ident, ELFMAG, SELFMAG) != 0){
+            return false;
+        }
+
+        uint32_t ws = (ident[EI_CLASS] == ELFCLASS64? 8: 4);
+        uint64_t phoff;
+        uint32_t phnum;
+        file.seekg(0);
+        if (ws == 8){
+            Elf64_Ehdr eh;
+            if (!file.read((char*)&eh, sizeof(eh))){
+                return false;
+            }
+            phoff = eh.e_phoff;
+            phnum = eh.e_phnum;
+        } else {
+            Elf32_Ehdr eh;
+            if (!file.read((char*)&eh, sizeof(eh))){
+                return false;
+            }
+            phoff = eh.e_phoff;
+            phnum = eh.e_phnum;
+        }
+
+        uint32_t phsize = segmentSize(ws);
+        std::vector<char> phdrs(phsize * phnum);
+        file.seekg(phoff);
+        if (phdrs.empty() || !file.read(&phdrs[0], phdrs.size())){
+            return false;
+        }
+
+        uint64_t page = sysconf(_SC_PAGESIZE);
+        for (uint32_t i = 0; i < phnum; i++){
+            uint32_t type;
+            uint64_t offset, vaddr, filesz;
+            decodeSegment(&phdrs[i * phsize], ws, type, offset, vaddr, filesz);
+            uint64_t first = (offset & ~(page - 1));
+            if (type != PT_LOAD || m.offset < first || m.offset >= offset + (filesz? filesz: 1)){
+                continue;
+            }
+            bias = m.start - (vaddr & ~(page - 1)) - (m.offset - first);
+            return true;
+        }
+        return false;
+    }
+
+    // the value of a symbol in the dynamic symbol table of a file
+    bool ProcessImage::findFileSymbol(std::string path, std::string name, uint64_t& value){
+        std::ifstream file(path.c_str(), std::ios::binary);
+        char ident[EI_NIDENT];
+        if (!file.read(ident, sizeof(ident)) || memcmp(ident, ELFMAG, SELFMAG) != 0){
+            return false;
+        }
+
+        uint32_t ws = (ident[EI_CLASS] == ELFCLASS64? 8: 4);
+        uint64_t shoff;
+        uint32_t shnum;
+        file.seekg(0);
+        if (ws == 8){
+            Elf64_Ehdr eh;
+            if (!file.read((char*)&eh, sizeof(eh))){
+                return false;
+            }
+            shoff = eh.e_shoff;
+            shnum = eh.e_shnum;
+        } else {
+            Elf32_Ehdr eh;
+            if (!file.read((char*)&eh, sizeof(eh))){
+                return false;
+            }
+            shoff = eh.e_shoff;
+            shnum = eh.e_shnum;
+        }
+
+        uint32_t shsize = (ws == 8? sizeof(Elf64_Shdr): sizeof(Elf32_Shdr));
+        std::vector<char> shdrs(shsize * shnum);
+        file.seekg(shoff);
+        if (shdrs.empty() || !file.read(&shdrs[0], shdrs.size())){
+            return false;
+        }
+
+        for (uint32_t i = 0; i < shnum; i++){
+            uint32_t type, link;
+            uint64_t offset, size;
+            decodeSection(&shdrs[i * shsize], ws, type, link, offset, size);
+            if (type != SHT_DYNSYM || link >= shnum){
+                continue;
+            }
+
+            uint32_t symsize = (ws == 8? sizeof(Elf64_Sym): sizeof(Elf32_Sym));
+            uint32_t strtype, strlink;
+            uint64_t stroffset, strsize;
+            decodeSection(&shdrs[link * shsize], ws, strtype, strlink, stroffset, strsize);
+            if (size / symsize > PROCESS_IMAGE_MAX_ENTRIES || strsize > PROCESS_IMAGE_MAX_ENTRIES * symsize){
+                return false;
+            }
+
+            std::vector<char> syms(size);
+            std::vector<char> strs(strsize + 1, 0);
+            file.seekg(offset);
+            if (syms.empty() || !file.read(&syms[0], syms.size())){
+                return false;
+            }
+            file.seekg(stroffset);
+            if (strsize && !file.read(&strs[0], strsize)){
+                return false;
+            }
+
+            for (uint64_t j = 0; j + symsize <= size; j += symsize){
+                uint32_t n;
+                uint64_t v;
+                decodeSymbol(&syms[j], ws, n, v);
+                if (n < strsize && name == &strs[n]){
+                    value = v;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool ProcessImage::refresh(){
+        if (!readMappings()){
+            EPAXWarn << "cannot read the mappings of process " << DEC(pid) << ENDL;
+            return false;
+        }
+
+        std::map<uint64_t, uint64_t> linked;
+        readLinkMap(linked);
+
+        std::vector<bool> wasmapped(objects.size());
+        for (uint32_t i = 0; i < objects.size(); i++){
+            wasmapped[i] = objects[i]->mapped;
+            objects[i]->mapped = false;
+        }
+
+        // a load of a file begins with the mapping of its offset 0, and its later
+        // mappings follow it, so each mapping belongs to the last load of its file
+        // begun below it
+        std::vector<uint32_t> loadof(mappings.size());
+        std::vector<uint32_t> loads;
+        std::map<std::string, uint32_t> lastload;
+        for (uint32_t i = 0; i < mappings.size(); i++){
+            std::map<std::string, uint32_t>::const_iterator l = lastload.find(mappings[i].path);
+            if (mappings[i].offset == 0 || l == lastload.end()){
+                lastload[mappings[i].path] = loads.size();
+                loadof[i] = loads.size();
+                loads.push_back(i);
+            } else {
+                loadof[i] = l->second;
+            }
+        }
+
+        std::map<uint32_t, uint64_t> loadbias;
+        for (std::map<uint64_t, uint64_t>::const_iterator it = linked.begin(); it != linked.end(); it++){
+            for (uint32_t i = 0; i < mappings.size(); i++){
+                if (it->first >= mappings[i].start && it->first < mappings[i].end){
+                    loadbias[loadof[i]] = it->second;
+                    break;
+                }
+            }
+        }
+
+        bool changed = false;
+        std::vector<ImageObject*> loadobjs(loads.size(), INVALID_PTR);
+        for (uint32_t l = 0; l < loads.size(); l++){
+            const ImageMapping& m = mappings[loads[l]];
+
+            uint64_t bias;
+            bool inlinkmap = (loadbias.count(l) > 0);
+            if (inlinkmap){
+                bias = loadbias[l];
+            } else if (!findFileBias(m, bias)){
+                // not an ELF file, e.g. a mapped data file
+                continue;
+            }
+
+            std::map<uint64_t, ImageObject*>::const_iterator it = objectmap.find(m.start);
+            ImageObject* obj;
+            if (it != objectmap.end() && it->second->path == m.path && it->second->bias == bias){
+                obj = it->second;
+            } else {
+                // a base that held another object before holds a new one now
+                obj = new ImageObject();
+                obj->path = m.path;
+                obj->base = m.start;
+                obj->bias = bias;
+                objects.push_back(obj);
+                objectmap[m.start] = obj;
+                changed = true;
+            }
+            obj->mapped = true;
+            obj->linked = inlinkmap;
+            loadobjs[l] = obj;
+        }
+
+        for (uint32_t i = 0; i < wasmapped.size(); i++){
+            if (wasmapped[i] && !objects[i]->mapped){
+                changed = true;
+            }
+        }
+
+        objectindex = AddressIndex<ImageObject>();
+        for (uint32_t i = 0; i < mappings.size(); i++){
+            ImageObject* obj = loadobjs[loadof[i]];
+            if (IS_VALID_PTR(obj)){
+                objectindex.add(mappings[i].start, mappings[i].end, obj);
+            }
+        }
+        objectindex.build();
+
+        return changed;
+    }
+
+    Binary* ProcessImage::getBinary(ImageObject* obj){
+        std::map<std::string, Binary*>::const_iterator it = binaries.find(obj->path);
+        if (it != binaries.end()){
+            return it->second;
+        }
+
+        Binary* bin = INVALID_PTR;
+        if (access(obj->path.c_str(), R_OK) == 0 && Binary::detectFormat(obj->path) != BinaryFormat_undefined){
+            bin = new Binary(obj->path, cachedir);
+        } else {
+            EPAXWarn << "cannot analyze " << obj->path << ", which is mapped into process " << DEC(pid) << ENDL;
+        }
+        binaries[obj->path] = bin;
+        return bin;
+    }
+
+    Binary* ProcessImage::resolve(uint64_t addr, uint64_t& vaddr){
+        ImageObject* obj = findObject(addr);
+        if (!IS_VALID_PTR(obj)){
+            return INVALID_PTR;
+        }
+        vaddr = addr - obj->bias;
+        return getBinary(obj);
+    }
+
+    uint64_t ProcessImage::getUpdateAddress(){
+        if (updater != 0){
+            return updater;
+        }
+
+        // r_brk, once the dynamic linker has set up r_debug
+        std::map<uint64_t, uint64_t> linked;
+        readLinkMap(linked);
+        if (updater != 0){
+            return updater;
+        }
+
+        // before then, e.g. at the exec, the function r_brk will name is found in the
+        // dynamic linker's symbols
+        ImageObject* interp = (interpreter? findObject(interpreter): INVALID_PTR);
+        uint64_t value;
+        if (IS_VALID_PTR(interp) && findFileSymbol(interp->path, "_dl_debug_state", value)){
+            updater = value + interp->bias;
+        }
+        return updater;
+    }
+
+} // namespace EPAX
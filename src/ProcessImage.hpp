@@ -0,0 +1,177 @@
+/**
+ * @file ProcessImage.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_ProcessImage_hpp__
+#define __EPAX_ProcessImage_hpp__
+
+#include "BaseClass.hpp"
+#include "DataStruct.hpp"
+
+// the most entries read from a link map or a dynamic section, in case either is corrupt
+#define PROCESS_IMAGE_MAX_ENTRIES (1 << 16)
+
+namespace EPAX {
+
+    class Binary;
+
+    /**
+     * A file mapped into a process that is loaded at a fixed bias: an executable or
+     * shared object. Objects are keyed by their load base, so the same file loaded
+     * twice at different addresses (e.g. after a dlclose and a second dlopen, or by
+     * dlmopen) is two objects.
+     */
+    typedef struct {
+        std::string path;
+        uint64_t base;       // run time address of its first mapping
+        uint64_t bias;       // run time address minus link time address
+        bool mapped;         // mapped as of the last refresh
+        bool linked;         // found in the dynamic linker's link map, rather than only in the mappings
+    } ImageObject;
+
+    /**
+     * One mapping of a file into a process, from /proc/<pid>/maps
+     */
+    typedef struct {
+        uint64_t start;
+        uint64_t end;
+        uint64_t offset;
+        bool exec;
+        std::string path;
+    } ImageMapping;
+
+    /**
+     * The executables and shared objects mapped into a running process, and the load
+     * bias of each, so that run time addresses can be taken back to the virtual
+     * addresses of the files they came from. Objects are found in /proc/<pid>/maps,
+     * where the mappings of one load of a file start with the mapping of its file
+     * offset 0, and their biases in the dynamic linker's link map (r_debug, through
+     * DT_DEBUG in the executable's dynamic section located with the auxiliary
+     * vector). Each link map entry is matched to the object whose mappings hold its
+     * dynamic section. Objects missing from the link map, e.g. in static executables
+     * or before the dynamic linker has run, get the bias implied by where their first
+     * loadable segment is mapped.
+     *
+     * The mappings of every object are kept in an interval index, so that a run time
+     * address resolves to (binary, file vaddr). Binaries are analyzed only when an
+     * address in them is first resolved, and are shared by every object loaded from
+     * the same file. The image is a snapshot; refresh() takes it forward after the
+     * process loads or unloads objects. Tracers refresh it each time the dynamic
+     * linker reports a change to its link map (see getUpdateAddress()), and when an
+     * address falls in no known object. Reading the link map requires that the
+     * process can be traced by the caller.
+     */
+    class ProcessImage : public NameBase {
+    private:
+        pid_t pid;
+        std::string cachedir;
+        uint32_t wordsize;
+        uint64_t entry;
+        uint64_t interpreter;
+        uint64_t rendezvous;
+        uint64_t updater;
+        int memfd;
+
+        std::vector<ImageObject*> objects;
+        std::map<uint64_t, ImageObject*> objectmap;
+        std::map<std::string, Binary*> binaries;
+
+        std::vector<ImageMapping> mappings;
+        AddressIndex<ImageObject> objectindex;
+
+        bool readMemory(uint64_t addr, void* buf, uint64_t size);
+        bool readWord(uint64_t addr, uint64_t& word);
+        bool readMappings();
+        void readAuxv(std::map<uint64_t, uint64_t>& aux);
+        uint64_t findRendezvous();
+        bool readLinkMap(std::map<uint64_t, uint64_t>& biases);
+        bool findFileBias(const ImageMapping& m, uint64_t& bias);
+        ImageMapping* findMapping(uint64_t addr);
+
+        static bool findFileSymbol(std::string path, std::string name, uint64_t& value);
+
+    public:
+        /**
+         * @param p a running process
+         * @param c the analysis cache directory for binaries loaded on demand, or empty for none
+         */
+        ProcessImage(pid_t p, std::string c = std::string());
+        virtual ~ProcessImage();
+
+        /**
+         * Reads the mappings and link map of the process again. Objects that are no
+         * longer mapped, e.g. after a dlclose, stop resolving addresses but stay valid,
+         * as do the binaries loaded for them.
+         *
+         * @return true if objects were loaded or unloaded since the last refresh
+         */
+        bool refresh();
+
+        /**
+         * @param addr a run time address
+         * @return the object mapped at addr, or INVALID_PTR
+         */
+        ImageObject* findObject(uint64_t addr) const { return objectindex.find(addr); }
+
+        /**
+         * @return the object holding the entry point of the process (AT_ENTRY), which
+         * is its executable, or INVALID_PTR if the entry point is not mapped
+         */
+        ImageObject* getExecutable() const { return findObject(entry); }
+
+        /**
+         * Takes a run time address back to the binary it is in and the corresponding
+         * virtual address in that binary's file, analyzing the file if this is the first
+         * address resolved in it
+         *
+         * @param addr a run time address
+         * @param vaddr (out) the link time address of addr in the binary
+         * @return the binary mapped at addr, or INVALID_PTR if no object is mapped there
+         * or its file cannot be analyzed
+         */
+        Binary* resolve(uint64_t addr, uint64_t& vaddr);
+
+        /**
+         * @param obj an object of this image
+         * @return the binary analyzed from the object's file, or INVALID_PTR if it cannot be analyzed
+         */
+        Binary* getBinary(ImageObject* obj);
+
+        /**
+         * The dynamic linker calls an empty function before and after each change to its
+         * link map, so that a debugger can stop there: r_debug.r_brk once the linker has
+         * set up r_debug, and before that its _dl_debug_state symbol. A tracer stops the
+         * process there to refresh the image at each dlopen and dlclose.
+         *
+         * @return the run time address of that function (with the low bit set if it is
+         * Thumb code), or 0 if the process has no dynamic linker
+         */
+        uint64_t getUpdateAddress();
+
+        uint32_t countObjects() { return objects.size(); }
+        ImageObject* getObject(uint32_t idx) { return objects[idx]; }
+    }; // class ProcessImage
+
+} // namespace EPAX
+
+#endif // __EPAX_ProcessImage_hpp__
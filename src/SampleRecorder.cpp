@@ -0,0 +1,441 @@
+/**
+ * @file SampleRecorder.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * libepaxsample.so: an in-process program counter sampler, meant for LD_PRELOAD.
+ * It does not use libepax and avoids allocating or locking in the signal handler.
+ * See EPAXSamples.h for its use and the format of what it writes.
+ */
+
+#include "EPAXSamples.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+// per thread; drained every SAMPLE_FLUSH_MSEC, so at 1 kHz there is ample headroom
+#define SAMPLE_RING_SIZE (8192)
+#define SAMPLE_FLUSH_MSEC (100)
+
+// MAPS is written once this many flushes in, after most libraries are loaded
+#define SAMPLE_MAPS_FLUSHES (10)
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+typedef enum {
+    SampleRing_free = 0,   // drained, and may be claimed by a new thread
+    SampleRing_used,       // owned by a live thread
+    SampleRing_retired     // its thread has ended, but it may hold samples
+} SampleRingState;
+
+// written only by the signal handler of its thread (head, dropped) and by the flusher (tail)
+typedef struct SampleRing {
+    uint64_t pcs[SAMPLE_RING_SIZE];
+    uint64_t head;
+    uint64_t tail;
+    uint64_t dropped;
+    uint32_t state;
+    uint32_t tid;
+    timer_t timer;
+    struct SampleRing* next;
+} SampleRing;
+
+typedef struct {
+    void* (*start)(void*);
+    void* arg;
+} SampleStart;
+
+typedef int (*pthread_create_t)(pthread_t*, const pthread_attr_t*, void* (*)(void*), void*);
+
+static pthread_create_t realCreate = NULL;
+
+static bool active = false;
+static pid_t owner = 0;
+static int outfd = -1;
+static uint32_t frequency = EPAX_SAMPLES_DEFAULT_HZ;
+
+// rings are only ever pushed on the head of this list, and never unlinked
+static SampleRing* rings = NULL;
+static pthread_key_t ringkey;
+
+static uint64_t written = 0;
+static uint64_t threads = 0;
+
+static pthread_t flusher;
+static pthread_mutex_t flushlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flushcond = PTHREAD_COND_INITIALIZER;
+static bool stopping = false;
+
+static __thread SampleRing* myring __attribute__((tls_model("initial-exec"))) = NULL;
+
+static uint64_t contextPC(void* ctx){
+    ucontext_t* uc = (ucontext_t*)ctx;
+#if defined(__x86_64__)
+    return uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+    return uc->uc_mcontext.gregs[REG_EIP];
+#elif defined(__aarch64__)
+    return uc->uc_mcontext.pc;
+#elif defined(__arm__)
+    return uc->uc_mcontext.arm_pc;
+#else
+#error "cannot find the program counter in a ucontext_t on this architecture"
+#endif
+}
+
+static void sampleSignal(int sig, siginfo_t* info, void* ctx){
+    SampleRing* r = myring;
+    if (r == NULL){
+        return;
+    }
+
+    uint64_t head = r->head;
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= SAMPLE_RING_SIZE){
+        r->dropped++;
+        return;
+    }
+    r->pcs[head % SAMPLE_RING_SIZE] = contextPC(ctx);
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static bool writeAll(const void* buf, uint64_t size){
+    uint64_t done = 0;
+    while (done < size){
+        ssize_t w = write(outfd, (const char*)buf + done, size - done);
+        if (w < 0 && errno == EINTR){
+            continue;
+        }
+        if (w <= 0){
+            return false;
+        }
+        done += w;
+    }
+    return true;
+}
+
+static bool writeRecord(uint32_t type, uint32_t tid, const void* buf, uint64_t size){
+    EPAX_samples_record rec;
+    rec.type = type;
+    rec.tid = tid;
+    rec.size = size;
+    return writeAll(&rec, sizeof(rec)) && writeAll(buf, size);
+}
+
+static void writeMaps(){
+    int fd = open("/proc/self/maps", O_RDONLY);
+    if (fd < 0){
+        return;
+    }
+
+    // the file has no size until read, so it is read whole before the record is written
+    uint64_t size = 0, cap = 65536;
+    char* buf = (char*)malloc(cap);
+    while (buf != NULL){
+        if (size == cap){
+            cap *= 2;
+            char* b = (char*)realloc(buf, cap);
+            if (b == NULL){
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = b;
+        }
+        ssize_t r = read(fd, buf + size, cap - size);
+        if (r < 0 && errno == EINTR){
+            continue;
+        }
+        if (r <= 0){
+            break;
+        }
+        size += r;
+    }
+    close(fd);
+
+    if (buf != NULL){
+        writeRecord(EPAX_SAMPLES_MAPS, 0, buf, size);
+        free(buf);
+    }
+}
+
+// writes out the samples held by every ring, and frees the rings of ended threads
+static void drainRings(){
+    for (SampleRing* r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r != NULL; r = r->next){
+        uint32_t state = __atomic_load_n(&r->state, __ATOMIC_ACQUIRE);
+        if (state == SampleRing_free){
+            continue;
+        }
+
+        uint64_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        uint64_t tail = r->tail;
+        if (head != tail){
+            // the live part of the ring may wrap around its end
+            uint64_t first = tail % SAMPLE_RING_SIZE;
+            uint64_t n = head - tail;
+            uint64_t m = (first + n > SAMPLE_RING_SIZE? SAMPLE_RING_SIZE - first: n);
+            writeRecord(EPAX_SAMPLES_PCS, r->tid, &r->pcs[first], m * sizeof(uint64_t));
+            if (m < n){
+                writeRecord(EPAX_SAMPLES_PCS, r->tid, &r->pcs[0], (n - m) * sizeof(uint64_t));
+            }
+            written += n;
+            __atomic_store_n(&r->tail, head, __ATOMIC_RELEASE);
+        }
+
+        if (state == SampleRing_retired){
+            __atomic_store_n(&r->state, SampleRing_free, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+static void* flushThread(void* arg){
+    uint32_t flushes = 0;
+
+    pthread_mutex_lock(&flushlock);
+    while (!stopping){
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += SAMPLE_FLUSH_MSEC * 1000000L;
+        if (ts.tv_nsec >= 1000000000L){
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&flushcond, &flushlock, &ts);
+        if (stopping){
+            break;
+        }
+
+        pthread_mutex_unlock(&flushlock);
+        drainRings();
+        if (++flushes == SAMPLE_MAPS_FLUSHES){
+            writeMaps();
+        }
+        pthread_mutex_lock(&flushlock);
+    }
+    pthread_mutex_unlock(&flushlock);
+    return NULL;
+}
+
+static SampleRing* claimRing(){
+    for (SampleRing* r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r != NULL; r = r->next){
+        uint32_t expect = SampleRing_free;
+        if (__atomic_compare_exchange_n(&r->state, &expect, SampleRing_used, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+            return r;
+        }
+    }
+
+    SampleRing* r = (SampleRing*)calloc(1, sizeof(SampleRing));
+    if (r == NULL){
+        return NULL;
+    }
+    r->state = SampleRing_used;
+    r->next = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+    while (!__atomic_compare_exchange_n(&rings, &r->next, r, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    return r;
+}
+
+static void stopSampling(void* arg){
+    SampleRing* r = (SampleRing*)arg;
+    timer_delete(r->timer);
+    myring = NULL;
+    __atomic_store_n(&r->state, SampleRing_retired, __ATOMIC_RELEASE);
+}
+
+// starts sampling the calling thread
+static void startSampling(){
+    SampleRing* r = claimRing();
+    if (r == NULL){
+        return;
+    }
+    r->tid = (uint32_t)syscall(SYS_gettid);
+
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGPROF;
+    sev.sigev_notify_thread_id = r->tid;
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &r->timer) != 0){
+        __atomic_store_n(&r->state, SampleRing_retired, __ATOMIC_RELEASE);
+        return;
+    }
+
+    myring = r;
+    pthread_setspecific(ringkey, r);
+    __atomic_add_fetch(&threads, 1, __ATOMIC_RELAXED);
+
+    struct itimerspec its;
+    its.it_interval.tv_sec = 0;
+    its.it_interval.tv_nsec = 1000000000L / frequency;
+    if (frequency == 1){
+        its.it_interval.tv_sec = 1;
+        its.it_interval.tv_nsec = 0;
+    }
+    its.it_value = its.it_interval;
+    timer_settime(r->timer, 0, &its, NULL);
+}
+
+static void* sampleThreadStart(void* arg){
+    SampleStart s = *(SampleStart*)arg;
+    free(arg);
+
+    startSampling();
+    return s.start(s.arg);
+}
+
+// threads are sampled from their start by wrapping the function they run
+extern "C" int pthread_create(pthread_t* thread, const pthread_attr_t* attr, void* (*start)(void*), void* arg){
+    if (realCreate == NULL){
+        realCreate = (pthread_create_t)dlsym(RTLD_NEXT, "pthread_create");
+    }
+    if (!active){
+        return realCreate(thread, attr, start, arg);
+    }
+
+    SampleStart* s = (SampleStart*)malloc(sizeof(SampleStart));
+    if (s == NULL){
+        return realCreate(thread, attr, start, arg);
+    }
+    s->start = start;
+    s->arg = arg;
+
+    int ret = realCreate(thread, attr, sampleThreadStart, s);
+    if (ret != 0){
+        free(s);
+    }
+    return ret;
+}
+
+// a forked child gets none of our timers or the flusher, so it is left unsampled
+static void forkChild(){
+    active = false;
+    myring = NULL;
+}
+
+__attribute__((constructor)) static void sampleInit(){
+    realCreate = (pthread_create_t)dlsym(RTLD_NEXT, "pthread_create");
+    if (realCreate == NULL){
+        return;
+    }
+
+    const char* hz = getenv("EPAX_SAMPLE_HZ");
+    if (hz != NULL){
+        frequency = strtoul(hz, NULL, 0);
+        if (frequency == 0 || frequency > 1000000){
+            fprintf(stderr, "libepaxsample: EPAX_SAMPLE_HZ must be between 1 and 1000000\n");
+            return;
+        }
+    }
+
+    owner = getpid();
+    char path[4096];
+    const char* fname = getenv("EPAX_SAMPLE_FILE");
+    if (fname == NULL){
+        snprintf(path, sizeof(path), "epax.%d.samples", (int)owner);
+        fname = path;
+    } else if (getenv("EPAX_SAMPLE_ROOT") != NULL){
+        // a program exec'd by the sampled one inherits EPAX_SAMPLE_FILE, and must not
+        // truncate the file its ancestor is writing
+        snprintf(path, sizeof(path), "%s.%d", fname, (int)owner);
+        fname = path;
+    } else {
+        snprintf(path, sizeof(path), "%d", (int)owner);
+        setenv("EPAX_SAMPLE_ROOT", path, 1);
+    }
+    outfd = open(fname, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (outfd < 0){
+        fprintf(stderr, "libepaxsample: cannot open %s: %s\n", fname, strerror(errno));
+        return;
+    }
+
+    EPAX_samples_header hdr;
+    hdr.magic = EPAX_SAMPLES_MAGIC;
+    hdr.version = EPAX_SAMPLES_VERSION;
+    hdr.pid = (uint32_t)owner;
+    hdr.hz = frequency;
+    writeAll(&hdr, sizeof(hdr));
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = sampleSignal;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, NULL);
+
+    pthread_key_create(&ringkey, stopSampling);
+    pthread_atfork(NULL, NULL, forkChild);
+
+    if (realCreate(&flusher, NULL, flushThread, NULL) != 0){
+        close(outfd);
+        outfd = -1;
+        return;
+    }
+
+    active = true;
+    startSampling();
+}
+
+__attribute__((destructor)) static void sampleFini(){
+    if (!active || getpid() != owner){
+        return;
+    }
+    active = false;
+
+    SampleRing* r = myring;
+    if (r != NULL){
+        pthread_setspecific(ringkey, NULL);
+        stopSampling(r);
+    }
+
+    pthread_mutex_lock(&flushlock);
+    stopping = true;
+    pthread_cond_signal(&flushcond);
+    pthread_mutex_unlock(&flushlock);
+    pthread_join(flusher, NULL);
+
+    // threads still running may add a few samples after this; they are not written
+    drainRings();
+    writeMaps();
+
+    EPAX_samples_stats st;
+    memset(&st, 0, sizeof(st));
+    st.samples = written;
+    st.threads = threads;
+    for (SampleRing* r = rings; r != NULL; r = r->next){
+        st.dropped += __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+    }
+    writeRecord(EPAX_SAMPLES_STATS, 0, &st, sizeof(st));
+
+    close(outfd);
+    outfd = -1;
+}
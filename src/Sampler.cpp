@@ -0,0 +1,196 @@
+/**
+ * @file Sampler.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "BasicBlock.hpp"
+#include "Binary.hpp"
+#include "ControlFlow.hpp"
+#include "Function.hpp"
+#include "Loop.hpp"
+#include "ProcessImage.hpp"
+#include "Sampler.hpp"
+
+namespace EPAX {
+
+    static bool compareSamples(const std::pair<uint64_t, uint64_t>& a, const std::pair<uint64_t, uint64_t>& b){
+        if (a.first != b.first){
+            return a.first > b.first;
+        }
+        return a.second < b.second;
+    }
+
+    Sampler::Sampler(Binary* b, uint32_t hz)
+        : Tracer(b, hz), samples(0), elsewhere(0), refreshed(0)
+    {
+        EPAXAssert(frequency > 0, "sampling frequency must be at least 1 Hz");
+
+        Range<Function> funcs = binary->functions();
+        for (Range<Function>::iterator it = funcs.begin(); it != funcs.end(); it++){
+            Range<BasicBlock> bbs = (*it)->blocks();
+            for (Range<BasicBlock>::iterator bit = bbs.begin(); bit != bbs.end(); bit++){
+                BasicBlock* bb = (*bit);
+                blockindex.add(bb->getMemoryAddress(), bb->getMemoryAddress() + bb->getMemorySize(), bb);
+            }
+        }
+        blockindex.build();
+    }
+
+    Sampler::~Sampler(){
+    }
+
+    void Sampler::interrupted(pid_t tid){
+        uint64_t pc;
+        if (!getThreadPC(tid, pc)){
+            return;
+        }
+        samples++;
+
+        uint64_t addr = pc - bias;
+        BasicBlock* bb = blockindex.find(addr);
+        if (IS_VALID_PTR(bb)){
+            blocksamples[bb]++;
+            return;
+        }
+
+        Function* f = binary->findFunctionAt(addr);
+        if (IS_VALID_PTR(f)){
+            gapsamples[f]++;
+            return;
+        }
+
+        // in a shared object, or outside any function of the binary. a miss may be in an
+        // object loaded since the image was last read, which is read again at most once a second
+        if (IS_VALID_PTR(image)){
+            ImageObject* obj = image->findObject(pc);
+            if (!IS_VALID_PTR(obj) && samples - refreshed >= frequency){
+                refreshed = samples;
+                image->refresh();
+                obj = image->findObject(pc);
+            }
+            if (IS_VALID_PTR(obj)){
+                objectsamples[std::make_pair(obj->path, obj->bias)]++;
+                return;
+            }
+        }
+
+        // in code mapped from no file, e.g. generated at run time
+        elsewhere++;
+    }
+
+    void Sampler::report(std::ostream& stream){
+        std::map<Function*, uint64_t> funcsamples(gapsamples);
+        std::map<Loop*, uint64_t> loopsamples;
+        for (std::map<BasicBlock*, uint64_t>::const_iterator it = blocksamples.begin(); it != blocksamples.end(); it++){
+            BasicBlock* bb = it->first;
+            funcsamples[bb->getFunction()] += it->second;
+        }
+
+        // a loop's members include the blocks of its inner loops
+        for (std::map<Function*, uint64_t>::const_iterator it = funcsamples.begin(); it != funcsamples.end(); it++){
+            Range<Loop> loops = it->first->loops();
+            for (Range<Loop>::iterator lit = loops.begin(); lit != loops.end(); lit++){
+                uint64_t n = 0;
+                Range<BasicBlock> bbs = (*lit)->blocks();
+                for (Range<BasicBlock>::iterator bit = bbs.begin(); bit != bbs.end(); bit++){
+                    std::map<BasicBlock*, uint64_t>::const_iterator s = blocksamples.find(*bit);
+                    if (s != blocksamples.end()){
+                        n += s->second;
+                    }
+                }
+                if (n > 0){
+                    loopsamples[*lit] = n;
+                }
+            }
+        }
+
+        stream << "# binary " << getName() << ENDL;
+        stream << "# samples " << DEC(samples) << TAB << "elsewhere " << DEC(elsewhere) << TAB << "rate " << DEC(frequency) << "Hz" << TAB << "bias " << HEX(bias) << ENDL;
+
+        double total = (samples? (double)samples: 1.0);
+        stream << std::fixed << std::setprecision(2);
+
+        std::vector<std::pair<uint64_t, uint64_t> > sorted;
+        std::vector<Loop*> loopvec;
+        for (std::map<Loop*, uint64_t>::const_iterator it = loopsamples.begin(); it != loopsamples.end(); it++){
+            sorted.push_back(std::make_pair(it->second, loopvec.size()));
+            loopvec.push_back(it->first);
+        }
+        std::sort(sorted.begin(), sorted.end(), compareSamples);
+        stream << "# loop <share%> <samples> <func> <loop> <depth> <head> <name>" << ENDL;
+        for (std::vector<std::pair<uint64_t, uint64_t> >::const_iterator it = sorted.begin(); it != sorted.end(); it++){
+            Loop* lp = loopvec[it->second];
+            Function* f = lp->getControlFlow()->getFunction();
+            stream << "loop" << TAB << (100.0 * it->first / total) << TAB << DEC(it->first) << TAB << DEC(f->getIndex()) << TAB
+                   << DEC(lp->getIndex()) << TAB << DEC(lp->getDepth()) << TAB << HEX(lp->head()->getMemoryAddress()) << TAB
+                   << f->getName() << ENDL;
+        }
+
+        sorted.clear();
+        std::vector<Function*> funcvec;
+        for (std::map<Function*, uint64_t>::const_iterator it = funcsamples.begin(); it != funcsamples.end(); it++){
+            sorted.push_back(std::make_pair(it->second, funcvec.size()));
+            funcvec.push_back(it->first);
+        }
+        std::sort(sorted.begin(), sorted.end(), compareSamples);
+        stream << "# func <share%> <samples> <func> <addr> <name>" << ENDL;
+        for (std::vector<std::pair<uint64_t, uint64_t> >::const_iterator it = sorted.begin(); it != sorted.end(); it++){
+            Function* f = funcvec[it->second];
+            stream << "func" << TAB << (100.0 * it->first / total) << TAB << DEC(it->first) << TAB << DEC(f->getIndex()) << TAB
+                   << HEX(f->getMemoryAddress()) << TAB << f->getName() << ENDL;
+        }
+
+        sorted.clear();
+        std::vector<std::pair<std::string, uint64_t> > objvec;
+        for (std::map<std::pair<std::string, uint64_t>, uint64_t>::const_iterator it = objectsamples.begin(); it != objectsamples.end(); it++){
+            sorted.push_back(std::make_pair(it->second, objvec.size()));
+            objvec.push_back(it->first);
+        }
+        std::sort(sorted.begin(), sorted.end(), compareSamples);
+        stream << "# object <share%> <samples> <bias> <path>" << ENDL;
+        for (std::vector<std::pair<uint64_t, uint64_t> >::const_iterator it = sorted.begin(); it != sorted.end(); it++){
+            const std::pair<std::string, uint64_t>& obj = objvec[it->second];
+            stream << "object" << TAB << (100.0 * it->first / total) << TAB << DEC(it->first) << TAB << HEX(obj.second) << TAB
+                   << obj.first << ENDL;
+        }
+
+        sorted.clear();
+        std::vector<BasicBlock*> bbvec;
+        for (std::map<BasicBlock*, uint64_t>::const_iterator it = blocksamples.begin(); it != blocksamples.end(); it++){
+            sorted.push_back(std::make_pair(it->second, bbvec.size()));
+            bbvec.push_back(it->first);
+        }
+        std::sort(sorted.begin(), sorted.end(), compareSamples);
+        stream << "# bbl <share%> <samples> <func> <bbl> <addr>" << ENDL;
+        for (std::vector<std::pair<uint64_t, uint64_t> >::const_iterator it = sorted.begin(); it != sorted.end(); it++){
+            BasicBlock* bb = bbvec[it->second];
+            stream << "bbl" << TAB << (100.0 * it->first / total) << TAB << DEC(it->first) << TAB << DEC(bb->getFunction()->getIndex()) << TAB
+                   << DEC(bb->getIndex()) << TAB << HEX(bb->getMemoryAddress()) << ENDL;
+        }
+
+        stream.unsetf(std::ios::floatfield);
+        stream << std::dec;
+    }
+
+} // namespace EPAX
@@ -0,0 +1,91 @@
+/**
+ * @file Sampler.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_Sampler_hpp__
+#define __EPAX_Sampler_hpp__
+
+#include "BaseClass.hpp"
+#include "DataStruct.hpp"
+#include "ProcessImage.hpp"
+#include "Tracer.hpp"
+
+// a prime, so that sampling does not fall into lockstep with periodic work in the target
+#define SAMPLER_DEFAULT_HZ (997)
+
+namespace EPAX {
+
+    class BasicBlock;
+    class Function;
+
+    /**
+     * Statistical profiler for a process running a Binary. On every tick of a timer
+     * each thread of the process is briefly interrupted and its program counter is
+     * read. Samples are attributed to blocks through an address index built once up
+     * front, so the cost of a sample is a few system calls and a binary search.
+     * Functions and loops are credited with the samples of their blocks when the
+     * report is written. Samples outside the binary's functions are credited to the
+     * shared object, or other mapped file, they fall in.
+     */
+    class Sampler : public Tracer {
+    private:
+        AddressIndex<BasicBlock> blockindex;
+        std::map<BasicBlock*, uint64_t> blocksamples;
+
+        // samples inside a function but outside its blocks, e.g. in alignment padding
+        std::map<Function*, uint64_t> gapsamples;
+
+        // samples outside the functions of the binary, by the path and bias of the object
+        // they fall in. the image, and its objects, are replaced when the process execs
+        std::map<std::pair<std::string, uint64_t>, uint64_t> objectsamples;
+
+        uint64_t samples;
+        uint64_t elsewhere;
+        uint64_t refreshed;
+
+    protected:
+        void interrupted(pid_t tid);
+
+    public:
+        /**
+         * @param b the binary run by the processes to be sampled
+         * @param hz the number of samples taken per second from each thread
+         */
+        Sampler(Binary* b, uint32_t hz = SAMPLER_DEFAULT_HZ);
+        virtual ~Sampler();
+
+        uint64_t countSamples() { return samples; }
+
+        /**
+         * Writes the sample counts of the loops, functions and blocks of the binary and of
+         * the other objects mapped into the process, each sorted by decreasing count. A
+         * loop's count includes the samples of its inner loops.
+         *
+         * @param stream where to write the report
+         */
+        void report(std::ostream& stream = std::cout);
+    }; // class Sampler
+
+} // namespace EPAX
+
+#endif // __EPAX_Sampler_hpp__
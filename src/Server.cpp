@@ -0,0 +1,745 @@
+/**
+ * @file Server.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+#include "EPAXServer.h"
+
+#include "BasicBlock.hpp"
+#include "Binary.hpp"
+#include "ControlFlow.hpp"
+#include "DataStruct.hpp"
+#include "Function.hpp"
+#include "Loop.hpp"
+#include "Server.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// estimated resident bytes per analyzed instruction and block, on top of the file itself
+#define SERVED_INSN_FOOTPRINT (256)
+#define SERVED_BBL_FOOTPRINT (192)
+
+// the smallest file that can hold an Elf64 file header
+#define SERVED_MIN_FILE_SIZE (64)
+
+#define CONNECTION_BUFFER_SIZE (64 * 1024)
+
+namespace EPAX {
+
+    typedef struct {
+        BasicBlock* bb;
+        Function* func;
+    } ServedBlock;
+
+    /**
+     * A resident binary along with an index from addresses to its blocks
+     */
+    class ServedBinary {
+    public:
+        Binary* binary;
+        std::vector<ServedBlock> blocks;
+        AddressIndex<ServedBlock> blockindex;
+        bool lineinfo;
+
+        // the line information lookup is not known to be safe for concurrent use
+        pthread_mutex_t linelock;
+
+        uint32_t handle;
+        uint64_t footprint;
+        uint64_t lastuse;
+        uint32_t refs;
+
+        // the analysis is restored from the entry that the probe left in cachedir
+        ServedBinary(std::string path, uint32_t h, std::string cachedir)
+            : binary(INVALID_PTR), lineinfo(false), handle(h), footprint(0), lastuse(0), refs(0)
+        {
+            pthread_mutex_init(&linelock, NULL);
+
+            binary = new Binary(path, cachedir);
+            lineinfo = binary->hasDebugLineInfo();
+
+            uint64_t ninsns = 0;
+            Range<Function> funcs = binary->functions();
+            for (Range<Function>::iterator it = funcs.begin(); it != funcs.end(); it++){
+                Function* f = (*it);
+                Range<BasicBlock> bbs = f->blocks();
+                for (Range<BasicBlock>::iterator bit = bbs.begin(); bit != bbs.end(); bit++){
+                    ServedBlock sb;
+                    sb.bb = (*bit);
+                    sb.func = f;
+                    blocks.push_back(sb);
+                    ninsns += sb.bb->countInstructions();
+                }
+            }
+
+            // blocks is complete, so pointers into it are stable
+            for (std::vector<ServedBlock>::iterator it = blocks.begin(); it != blocks.end(); it++){
+                BasicBlock* bb = (*it).bb;
+                blockindex.add(bb->getMemoryAddress(), bb->getMemoryAddress() + bb->getMemorySize(), &(*it));
+            }
+            blockindex.build();
+
+            footprint = binary->getFileSize() + ninsns * SERVED_INSN_FOOTPRINT + blocks.size() * SERVED_BBL_FOOTPRINT;
+        }
+
+        ~ServedBinary(){
+            pthread_mutex_destroy(&linelock);
+            if (IS_VALID_PTR(binary)){
+                delete binary;
+            }
+        }
+    }; // class ServedBinary
+
+    /**
+     * Buffered reads and writes on a client socket. Responses are held until the
+     * client's pipelined requests have been consumed, so that a batch of requests is
+     * answered with few writes.
+     */
+    class ServerConnection {
+    private:
+        int fd;
+        char* inbuf;
+        uint32_t inpos;
+        uint32_t inend;
+        std::string outbuf;
+
+    public:
+        ServerConnection(int f) : fd(f), inpos(0), inend(0) { inbuf = new char[CONNECTION_BUFFER_SIZE]; }
+        ~ServerConnection() { delete[] inbuf; }
+
+        bool flush(){
+            uint64_t done = 0;
+            while (done < outbuf.size()){
+                ssize_t r = send(fd, outbuf.data() + done, outbuf.size() - done, MSG_NOSIGNAL);
+                if (r < 0 && errno == EINTR){
+                    continue;
+                }
+                if (r <= 0){
+                    return false;
+                }
+                done += r;
+            }
+            outbuf.clear();
+            return true;
+        }
+
+        bool read(void* buf, uint64_t size){
+            char* dst = (char*)buf;
+            while (size > 0){
+                if (inpos == inend){
+                    // about to wait for the client, so send what it is waiting for first
+                    if (!flush()){
+                        return false;
+                    }
+                    ssize_t r = recv(fd, inbuf, CONNECTION_BUFFER_SIZE, 0);
+                    if (r < 0 && errno == EINTR){
+                        continue;
+                    }
+                    if (r <= 0){
+                        return false;
+                    }
+                    inpos = 0;
+                    inend = r;
+                }
+                uint64_t n = inend - inpos;
+                if (n > size){
+                    n = size;
+                }
+                memcpy(dst, inbuf + inpos, n);
+                inpos += n;
+                dst += n;
+                size -= n;
+            }
+            return true;
+        }
+
+        void write(const void* buf, uint64_t size){
+            outbuf.append((const char*)buf, size);
+        }
+
+        // the payload of the request being handled
+        std::string payload;
+    }; // class ServerConnection
+
+    template <typename T> static void put(std::string& out, const T& v){
+        out.append((const char*)&v, sizeof(T));
+    }
+
+    template <typename T> static T get(const std::string& in, uint64_t off){
+        T v;
+        memcpy(&v, in.data() + off, sizeof(T));
+        return v;
+    }
+
+    // analysis exits on a binary it cannot make sense of, which would take the server
+    // down with it. so a new binary is first analyzed by a separate epax process, which
+    // leaves its analysis in the server's cache directory, and is served only if that
+    // succeeds. the child only execs, since other threads may hold locks at the fork
+    bool Server::probeBinary(std::string path){
+        std::string prog = (probeprogram.size() > 0? probeprogram: std::string("epax"));
+        const char* argv[] = { prog.c_str(), "-k", "-c", cachedir.c_str(), path.c_str(), NULL };
+        int devnull = open("/dev/null", O_WRONLY);
+
+        pid_t pid = fork();
+        if (pid == 0){
+            if (devnull >= 0){
+                dup2(devnull, STDOUT_FILENO);
+            }
+            execvp(argv[0], (char* const*)argv);
+            _exit(127);
+        }
+        if (devnull >= 0){
+            close(devnull);
+        }
+        if (pid < 0){
+            return false;
+        }
+
+        int status;
+        while (waitpid(pid, &status, 0) < 0){
+            if (errno != EINTR){
+                return false;
+            }
+        }
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 127){
+            EPAXWarn << "cannot run " << prog << " to check binaries" << ENDL;
+        }
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    Server::Server(std::string n, uint64_t b, std::string p)
+        : NameBase(n), budget(b), resident(0), clock(0), listenfd(-1), probeprogram(p)
+    {
+        pthread_mutex_init(&cachelock, NULL);
+        pthread_mutex_init(&loadlock, NULL);
+    }
+
+    Server::~Server(){
+        if (listenfd >= 0){
+            close(listenfd);
+            unlink(getName().c_str());
+        }
+        for (std::vector<ServedBinary*>::const_iterator it = binaries.begin(); it != binaries.end(); it++){
+            if (IS_VALID_PTR(*it)){
+                delete (*it);
+            }
+        }
+        if (cachedir.size() > 0){
+            DIR* d = opendir(cachedir.c_str());
+            if (d != NULL){
+                struct dirent* e;
+                while ((e = readdir(d)) != NULL){
+                    if (strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0){
+                        unlink((cachedir + "/" + e->d_name).c_str());
+                    }
+                }
+                closedir(d);
+            }
+            rmdir(cachedir.c_str());
+        }
+        pthread_mutex_destroy(&cachelock);
+        pthread_mutex_destroy(&loadlock);
+    }
+
+    uint32_t Server::getHandle(std::string path, uint32_t& status){
+        char real[PATH_MAX];
+        if (realpath(path.c_str(), real) == NULL || access(real, R_OK) != 0){
+            status = EPAX_SRV_ELOAD;
+            return EPAX_SRV_NONE;
+        }
+        path = std::string(real);
+
+        pthread_mutex_lock(&cachelock);
+        std::map<std::string, uint32_t>::const_iterator it = handles.find(path);
+        if (it != handles.end()){
+            uint32_t h = it->second;
+            pthread_mutex_unlock(&cachelock);
+            status = EPAX_SRV_OK;
+            return h;
+        }
+        pthread_mutex_unlock(&cachelock);
+
+        // reject anything that is clearly not a binary before paying for a probe. ELF,
+        // Mach-O (the ARM slice of a universal file) and PE are served
+        struct stat st;
+        if (stat(real, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < SERVED_MIN_FILE_SIZE){
+            status = EPAX_SRV_ELOAD;
+            return EPAX_SRV_NONE;
+        }
+        if (Binary::detectFormat(path) == BinaryFormat_undefined){
+            status = EPAX_SRV_ELOAD;
+            return EPAX_SRV_NONE;
+        }
+
+        pthread_mutex_lock(&loadlock);
+        pthread_mutex_lock(&cachelock);
+        it = handles.find(path);
+        bool known = (it != handles.end());
+        pthread_mutex_unlock(&cachelock);
+        if (!known && !probeBinary(path)){
+            pthread_mutex_unlock(&loadlock);
+            EPAXWarn << "cannot analyze " << path << ", not serving it" << ENDL;
+            status = EPAX_SRV_ELOAD;
+            return EPAX_SRV_NONE;
+        }
+
+        pthread_mutex_lock(&cachelock);
+        uint32_t h;
+        it = handles.find(path);
+        if (it != handles.end()){
+            h = it->second;
+        } else {
+            h = paths.size();
+            paths.push_back(path);
+            binaries.push_back(INVALID_PTR);
+            handles[path] = h;
+        }
+        pthread_mutex_unlock(&cachelock);
+        pthread_mutex_unlock(&loadlock);
+
+        status = EPAX_SRV_OK;
+        return h;
+    }
+
+    ServedBinary* Server::acquire(uint32_t handle){
+        pthread_mutex_lock(&cachelock);
+        if (handle >= paths.size()){
+            pthread_mutex_unlock(&cachelock);
+            return INVALID_PTR;
+        }
+        ServedBinary* b = binaries[handle];
+        if (IS_VALID_PTR(b)){
+            b->refs++;
+            b->lastuse = ++clock;
+            pthread_mutex_unlock(&cachelock);
+            return b;
+        }
+        std::string path = paths[handle];
+        pthread_mutex_unlock(&cachelock);
+
+        // another thread may have loaded it while this one waited for loadlock
+        pthread_mutex_lock(&loadlock);
+        pthread_mutex_lock(&cachelock);
+        b = binaries[handle];
+        if (IS_VALID_PTR(b)){
+            b->refs++;
+            b->lastuse = ++clock;
+            pthread_mutex_unlock(&cachelock);
+            pthread_mutex_unlock(&loadlock);
+            return b;
+        }
+        pthread_mutex_unlock(&cachelock);
+
+        b = new ServedBinary(path, handle, cachedir);
+        EPAXOut << "serving " << path << " as handle " << DEC(handle) << ", about " << DEC(b->footprint >> 20) << "MB" << ENDL;
+
+        std::vector<ServedBinary*> victims;
+        pthread_mutex_lock(&cachelock);
+        b->refs = 1;
+        b->lastuse = ++clock;
+        binaries[handle] = b;
+        resident += b->footprint;
+        evict(victims);
+        pthread_mutex_unlock(&cachelock);
+        pthread_mutex_unlock(&loadlock);
+
+        for (std::vector<ServedBinary*>::const_iterator it = victims.begin(); it != victims.end(); it++){
+            delete (*it);
+        }
+        return b;
+    }
+
+    void Server::release(ServedBinary* b){
+        std::vector<ServedBinary*> victims;
+        pthread_mutex_lock(&cachelock);
+        b->refs--;
+        evict(victims);
+        pthread_mutex_unlock(&cachelock);
+
+        for (std::vector<ServedBinary*>::const_iterator it = victims.begin(); it != victims.end(); it++){
+            delete (*it);
+        }
+    }
+
+    // called with cachelock held. victims are deleted by the caller once it is released
+    void Server::evict(std::vector<ServedBinary*>& victims){
+        while (budget > 0 && resident > budget){
+            ServedBinary* lru = INVALID_PTR;
+            for (std::vector<ServedBinary*>::const_iterator it = binaries.begin(); it != binaries.end(); it++){
+                ServedBinary* b = (*it);
+                if (IS_VALID_PTR(b) && b->refs == 0 && (!IS_VALID_PTR(lru) || b->lastuse < lru->lastuse)){
+                    lru = b;
+                }
+            }
+            if (!IS_VALID_PTR(lru)){
+                return;
+            }
+
+            EPAXOut << "evicting " << paths[lru->handle] << ENDL;
+            binaries[lru->handle] = INVALID_PTR;
+            resident -= lru->footprint;
+            victims.push_back(lru);
+        }
+    }
+
+    uint32_t Server::load(ServerConnection* c, std::string& out){
+        uint32_t status;
+        uint32_t h = getHandle(c->payload, status);
+        if (status != EPAX_SRV_OK){
+            return status;
+        }
+
+        ServedBinary* b = acquire(h);
+        EPAX_srv_binary r;
+        r.handle = h;
+        r.format = b->binary->getFormat();
+        r.funccount = b->binary->countFunctions();
+        r.reserved = 0;
+        r.filesize = b->binary->getFileSize();
+        release(b);
+
+        put(out, r);
+        return EPAX_SRV_OK;
+    }
+
+    uint32_t Server::resolve(ServerConnection* c, std::string& out){
+        const std::string& in = c->payload;
+        if (in.size() < 2 * sizeof(uint32_t)){
+            return EPAX_SRV_EBADREQ;
+        }
+        uint32_t h = get<uint32_t>(in, 0);
+        uint32_t count = get<uint32_t>(in, sizeof(uint32_t));
+        if (in.size() != 2 * sizeof(uint32_t) + (uint64_t)count * sizeof(uint64_t)){
+            return EPAX_SRV_EBADREQ;
+        }
+
+        ServedBinary* b = acquire(h);
+        if (!IS_VALID_PTR(b)){
+            return EPAX_SRV_EHANDLE;
+        }
+
+        StringPool strings;
+        std::vector<EPAX_srv_loc> locs(count);
+        const uint64_t* addrs = (const uint64_t*)(in.data() + 2 * sizeof(uint32_t));
+        for (uint32_t i = 0; i < count; i++){
+            uint64_t addr;
+            memcpy(&addr, addrs + i, sizeof(uint64_t));
+
+            EPAX_srv_loc& l = locs[i];
+            memset(&l, 0, sizeof(EPAX_srv_loc));
+            l.func = EPAX_SRV_NONE;
+            l.bbl = EPAX_SRV_NONE;
+            l.loop = EPAX_SRV_NONE;
+
+            // addresses between blocks (alignment padding, data) still resolve to a function
+            Function* f = INVALID_PTR;
+            ServedBlock* sb = b->blockindex.find(addr);
+            if (IS_VALID_PTR(sb)){
+                f = sb->func;
+                l.bbl = sb->bb->getIndex();
+                l.bbladdr = sb->bb->getMemoryAddress();
+                Loop* lp = sb->bb->getLoop();
+                if (IS_VALID_PTR(lp)){
+                    l.loop = lp->getIndex();
+                    l.loopdepth = lp->getDepth();
+                }
+            } else {
+                f = b->binary->findFunctionAt(addr);
+            }
+
+            if (IS_VALID_PTR(f)){
+                l.func = f->getIndex();
+                l.funcaddr = f->getMemoryAddress();
+                l.name = strings.add(f->getName());
+            }
+
+            if (b->lineinfo){
+                pthread_mutex_lock(&b->linelock);
+                l.line = b->binary->getDebugLineNumber(addr);
+                l.file = strings.add(b->binary->getDebugLineFile(addr));
+                pthread_mutex_unlock(&b->linelock);
+            }
+        }
+        release(b);
+
+        EPAX_srv_table t;
+        t.count = count;
+        t.strsize = strings.table.size();
+        put(out, t);
+        if (count > 0){
+            out.append((const char*)&locs[0], count * sizeof(EPAX_srv_loc));
+        }
+        out.append(strings.table);
+        return EPAX_SRV_OK;
+    }
+
+    uint32_t Server::listFunctions(ServerConnection* c, std::string& out){
+        const std::string& in = c->payload;
+        if (in.size() != sizeof(uint32_t)){
+            return EPAX_SRV_EBADREQ;
+        }
+
+        ServedBinary* b = acquire(get<uint32_t>(in, 0));
+        if (!IS_VALID_PTR(b)){
+            return EPAX_SRV_EHANDLE;
+        }
+
+        StringPool strings;
+        std::vector<EPAX_srv_func> funcs;
+        Range<Function> fr = b->binary->functions();
+        for (Range<Function>::iterator it = fr.begin(); it != fr.end(); it++){
+            Function* f = (*it);
+            EPAX_srv_func r;
+            r.addr = f->getMemoryAddress();
+            r.size = f->getMemorySize();
+            r.name = strings.add(f->getName());
+            r.bblcount = f->countBasicBlocks();
+            r.insncount = f->countInstructions();
+            r.loopcount = f->loops().size();
+            funcs.push_back(r);
+        }
+        release(b);
+
+        EPAX_srv_table t;
+        t.count = funcs.size();
+        t.strsize = strings.table.size();
+        put(out, t);
+        if (funcs.size() > 0){
+            out.append((const char*)&funcs[0], funcs.size() * sizeof(EPAX_srv_func));
+        }
+        out.append(strings.table);
+        return EPAX_SRV_OK;
+    }
+
+    uint32_t Server::dumpControlFlow(ServerConnection* c, std::string& out){
+        const std::string& in = c->payload;
+        if (in.size() != 2 * sizeof(uint32_t)){
+            return EPAX_SRV_EBADREQ;
+        }
+
+        ServedBinary* b = acquire(get<uint32_t>(in, 0));
+        if (!IS_VALID_PTR(b)){
+            return EPAX_SRV_EHANDLE;
+        }
+        uint32_t fidx = get<uint32_t>(in, sizeof(uint32_t));
+        if (fidx >= b->binary->countFunctions()){
+            release(b);
+            return EPAX_SRV_EHANDLE;
+        }
+        Function* f = b->binary->getFunction(fidx);
+
+        std::vector<EPAX_srv_bbl> bbls;
+        std::vector<uint32_t> edges;
+        Range<BasicBlock> br = f->blocks();
+        for (Range<BasicBlock>::iterator it = br.begin(); it != br.end(); it++){
+            BasicBlock* bb = (*it);
+            EPAX_srv_bbl r;
+            r.addr = bb->getMemoryAddress();
+            r.size = bb->getMemorySize();
+            r.insncount = bb->countInstructions();
+            r.firstedge = edges.size();
+            r.loop = (IS_VALID_PTR(bb->getLoop())? bb->getLoop()->getIndex(): EPAX_SRV_NONE);
+            r.reserved = 0;
+
+            Range<BasicBlock> succ = bb->successors();
+            for (Range<BasicBlock>::iterator sit = succ.begin(); sit != succ.end(); sit++){
+                edges.push_back((*sit)->getIndex());
+            }
+            r.edgecount = edges.size() - r.firstedge;
+            bbls.push_back(r);
+        }
+
+        std::vector<EPAX_srv_loop> loops;
+        std::vector<uint32_t> members;
+        Range<Loop> lr = f->loops();
+        for (Range<Loop>::iterator it = lr.begin(); it != lr.end(); it++){
+            Loop* lp = (*it);
+            EPAX_srv_loop r;
+            r.head = lp->head()->getIndex();
+            r.tail = lp->tail()->getIndex();
+            r.depth = lp->getDepth();
+            r.reserved = 0;
+            r.firstmember = members.size();
+
+            Range<BasicBlock> mr = lp->blocks();
+            for (Range<BasicBlock>::iterator mit = mr.begin(); mit != mr.end(); mit++){
+                members.push_back((*mit)->getIndex());
+            }
+            r.membercount = members.size() - r.firstmember;
+            loops.push_back(r);
+        }
+        release(b);
+
+        EPAX_srv_cfg h;
+        h.bblcount = bbls.size();
+        h.edgecount = edges.size();
+        h.loopcount = loops.size();
+        h.membercount = members.size();
+        put(out, h);
+        if (bbls.size()){
+            out.append((const char*)&bbls[0], bbls.size() * sizeof(EPAX_srv_bbl));
+        }
+        if (edges.size()){
+            out.append((const char*)&edges[0], edges.size() * sizeof(uint32_t));
+        }
+        if (loops.size()){
+            out.append((const char*)&loops[0], loops.size() * sizeof(EPAX_srv_loop));
+        }
+        if (members.size()){
+            out.append((const char*)&members[0], members.size() * sizeof(uint32_t));
+        }
+        return EPAX_SRV_OK;
+    }
+
+    void Server::serve(int fd){
+        ServerConnection c(fd);
+        std::string out;
+
+        EPAX_srv_request req;
+        while (c.read(&req, sizeof(req))){
+            if (req.magic != EPAX_SRV_MAGIC || req.size > EPAX_SRV_MAX_PAYLOAD){
+                EPAXWarn << "dropping client after a malformed request header" << ENDL;
+                break;
+            }
+
+            c.payload.resize(req.size);
+            if (req.size > 0 && !c.read(&c.payload[0], req.size)){
+                break;
+            }
+
+            out.clear();
+            uint32_t status;
+            switch (req.op){
+            case EPAX_SRV_LOAD:
+                status = load(&c, out);
+                break;
+            case EPAX_SRV_RESOLVE:
+                status = resolve(&c, out);
+                break;
+            case EPAX_SRV_FUNCS:
+                status = listFunctions(&c, out);
+                break;
+            case EPAX_SRV_CFG:
+                status = dumpControlFlow(&c, out);
+                break;
+            default:
+                status = EPAX_SRV_EOP;
+            }
+
+            if (status != EPAX_SRV_OK){
+                out.clear();
+            }
+
+            EPAX_srv_response res;
+            res.magic = EPAX_SRV_MAGIC;
+            res.status = status;
+            res.tag = req.tag;
+            res.size = out.size();
+            c.write(&res, sizeof(res));
+            c.write(out.data(), out.size());
+        }
+        c.flush();
+        close(fd);
+    }
+
+    typedef struct {
+        Server* server;
+        int fd;
+    } ServerThreadArgs;
+
+    void* Server::connectionThread(void* arg){
+        ServerThreadArgs* a = (ServerThreadArgs*)arg;
+        a->server->serve(a->fd);
+        delete a;
+        return NULL;
+    }
+
+    bool Server::run(){
+        struct sockaddr_un sa;
+        if (getName().size() >= sizeof(sa.sun_path)){
+            EPAXErr << "socket path too long: " << getName() << ENDL;
+            return false;
+        }
+
+        listenfd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenfd < 0){
+            EPAXErr << "cannot create socket: " << strerror(errno) << ENDL;
+            return false;
+        }
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sun_family = AF_UNIX;
+        strcpy(sa.sun_path, getName().c_str());
+        unlink(sa.sun_path);
+        if (bind(listenfd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(listenfd, SOMAXCONN) != 0){
+            EPAXErr << "cannot listen on " << getName() << ": " << strerror(errno) << ENDL;
+            close(listenfd);
+            listenfd = -1;
+            return false;
+        }
+
+        // probes leave their analysis here, for the server to restore instead of redoing it
+        const char* tmp = getenv("TMPDIR");
+        std::string tmpl = std::string((tmp != NULL && tmp[0] != '\0')? tmp: "/tmp") + "/epax-serve-XXXXXX";
+        std::vector<char> dir(tmpl.begin(), tmpl.end());
+        dir.push_back('\0');
+        if (mkdtemp(&dir[0]) == NULL){
+            EPAXErr << "cannot create a cache directory " << tmpl << ": " << strerror(errno) << ENDL;
+            close(listenfd);
+            listenfd = -1;
+            return false;
+        }
+        cachedir = std::string(&dir[0]);
+
+        EPAXOut << "listening on " << getName() << ENDL;
+        while (true){
+            int fd = accept(listenfd, NULL, NULL);
+            if (fd < 0){
+                if (errno != EINTR){
+                    EPAXWarn << "accept failed: " << strerror(errno) << ENDL;
+                }
+                continue;
+            }
+
+            ServerThreadArgs* a = new ServerThreadArgs();
+            a->server = this;
+            a->fd = fd;
+
+            pthread_t t;
+            if (pthread_create(&t, NULL, connectionThread, a) != 0){
+                EPAXWarn << "cannot start a thread for a new client" << ENDL;
+                close(fd);
+                delete a;
+                continue;
+            }
+            pthread_detach(t);
+        }
+        return true;
+    }
+
+} // namespace EPAX
@@ -0,0 +1,98 @@
+/**
+ * @file Server.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_Server_hpp__
+#define __EPAX_Server_hpp__
+
+#include "BaseClass.hpp"
+
+namespace EPAX {
+
+    class ServedBinary;
+    class ServerConnection;
+
+    /**
+     * Keeps analyzed binaries resident and answers queries about them over a
+     * Unix-domain socket, using the protocol in EPAXServer.h. Each connection is
+     * served by its own thread. When the estimated footprint of the resident binaries
+     * exceeds the memory budget, the least recently used binaries that no request is
+     * using are evicted.
+     */
+    class Server : public NameBase {
+    private:
+        uint64_t budget;
+        uint64_t resident;
+        uint64_t clock;
+        int listenfd;
+
+        // guards paths, handles, binaries, resident and clock
+        pthread_mutex_t cachelock;
+
+        // serializes analysis and load probes, so that a binary wanted by several clients
+        // is analyzed once
+        pthread_mutex_t loadlock;
+
+        std::vector<std::string> paths;
+        std::map<std::string, uint32_t> handles;
+        std::vector<ServedBinary*> binaries;
+
+        // the epax program that checks a new binary, and where it leaves its analysis
+        std::string probeprogram;
+        std::string cachedir;
+
+        bool probeBinary(std::string path);
+        uint32_t getHandle(std::string path, uint32_t& status);
+        ServedBinary* acquire(uint32_t handle);
+        void release(ServedBinary* b);
+        void evict(std::vector<ServedBinary*>& victims);
+
+        uint32_t load(ServerConnection* c, std::string& out);
+        uint32_t resolve(ServerConnection* c, std::string& out);
+        uint32_t listFunctions(ServerConnection* c, std::string& out);
+        uint32_t dumpControlFlow(ServerConnection* c, std::string& out);
+
+        void serve(int fd);
+        static void* connectionThread(void* arg);
+
+    public:
+        /**
+         * @param n the path of the socket to listen on
+         * @param b the memory budget in bytes for resident binaries, or 0 for no limit
+         * @param p the epax program, run as `p -k -c <dir> <binary>` to check each new
+         * binary before it is served, or empty to find epax on $PATH
+         */
+        Server(std::string n, uint64_t b, std::string p);
+        virtual ~Server();
+
+        /**
+         * Accepts and serves connections
+         *
+         * @return only if the socket cannot be set up, in which case false
+         */
+        bool run();
+    }; // class Server
+
+} // namespace EPAX
+
+#endif // __EPAX_Server_hpp__
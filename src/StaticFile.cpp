@@ -0,0 +1,461 @@
+/**
+ * @file StaticFile.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "StaticFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace EPAX {
+
+// chunks smaller than this are not worth a thread of their own
+#define STATIC_MIN_CHUNK (1 << 20)
+
+    /**
+     * A range of the file, starting and ending on instruction-record boundaries,
+     * handled by one parser thread
+     */
+    class StaticChunk {
+    public:
+        StaticFile* file;
+        uint64_t start;
+        uint64_t end;
+        uint64_t first;
+        uint64_t records;
+        std::vector<uint64_t> targets;
+
+        StaticChunk(StaticFile* f, uint64_t s, uint64_t e)
+            : file(f), start(s), end(e), first(0), records(0) {}
+    }; // class StaticChunk
+
+    static inline const char* endOfLine(const char* p, const char* e){
+        const char* n = (const char*)memchr(p, '\n', e - p);
+        return (n? n: e);
+    }
+
+    static inline bool isRecordStart(const char* p, const char* e){
+        return (p < e && *p != '\t' && *p != '\n' && *p != '#');
+    }
+
+    static inline void skipTab(const char*& p, const char* e){
+        while (p < e && (*p == '\t' || *p == ' ')){
+            p++;
+        }
+    }
+
+    static inline uint64_t parseDec(const char*& p, const char* e){
+        uint64_t v = 0;
+        skipTab(p, e);
+        while (p < e && *p >= '0' && *p <= '9'){
+            v = v * 10 + (*p - '0');
+            p++;
+        }
+        return v;
+    }
+
+    static inline uint64_t parseHex(const char*& p, const char* e){
+        uint64_t v = 0;
+        skipTab(p, e);
+        if (p + 1 < e && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')){
+            p += 2;
+        }
+        while (p < e){
+            char c = *p;
+            if (c >= '0' && c <= '9'){
+                v = (v << 4) | (c - '0');
+            } else if (c >= 'a' && c <= 'f'){
+                v = (v << 4) | (c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F'){
+                v = (v << 4) | (c - 'A' + 10);
+            } else {
+                break;
+            }
+            p++;
+        }
+        return v;
+    }
+
+    // the next tab-separated field, or the rest of the line if last is set
+    static inline StaticString parseString(const char* base, const char*& p, const char* e, bool last){
+        skipTab(p, e);
+        const char* s = p;
+        if (last){
+            p = e;
+        } else {
+            while (p < e && *p != '\t'){
+                p++;
+            }
+        }
+        StaticString r;
+        r.offset = s - base;
+        r.size = p - s;
+        return r;
+    }
+
+    StaticFile::StaticFile(std::string n, uint32_t f, uint32_t threads)
+        : NameBase(n), EPAXExport(EPAXExportClass_SFILE), data(INVALID_PTR), size(0), fields(f), count(0)
+    {
+        int fd = open(n.c_str(), O_RDONLY);
+        EPAXAssert(fd >= 0, "Cannot open static file " << n);
+
+        struct stat st;
+        EPAXAssert(fstat(fd, &st) == 0, "Cannot stat static file " << n);
+        size = st.st_size;
+
+        if (size > 0){
+            void* m = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            EPAXAssert(m != MAP_FAILED, "Cannot map static file " << n);
+            data = (char*)m;
+            madvise(m, size, MADV_SEQUENTIAL);
+        }
+        close(fd);
+
+        if (size == 0){
+            return;
+        }
+
+        uint64_t body = parseHeader();
+
+        if (threads == 0){
+            long c = sysconf(_SC_NPROCESSORS_ONLN);
+            threads = (c > 0? (uint32_t)c: 1);
+        }
+        if ((size - body) / threads < STATIC_MIN_CHUNK){
+            threads = (size - body) / STATIC_MIN_CHUNK + 1;
+        }
+
+        // split at instruction-record boundaries
+        std::vector<StaticChunk*> chunks;
+        uint64_t start = body;
+        for (uint32_t i = 1; i <= threads && start < size; i++){
+            uint64_t end = size;
+            if (i < threads){
+                const char* p = endOfLine(data + body + (size - body) / threads * i, data + size);
+                while (p < data + size && !isRecordStart(p + 1, data + size)){
+                    p = endOfLine(p + 1, data + size);
+                }
+                end = (p < data + size? p + 1 - data: size);
+            }
+            if (end > start){
+                chunks.push_back(new StaticChunk(this, start, end));
+                start = end;
+            }
+        }
+
+        // count records in each chunk, then parse each chunk into its slice of the columns
+        std::vector<pthread_t> tids(chunks.size());
+        for (uint32_t i = 0; i < chunks.size(); i++){
+            EPAXAssert(pthread_create(&tids[i], NULL, countChunkThread, chunks[i]) == 0, "Cannot start static file reader thread");
+        }
+        for (uint32_t i = 0; i < chunks.size(); i++){
+            pthread_join(tids[i], NULL);
+            chunks[i]->first = count;
+            count += chunks[i]->records;
+        }
+
+        allocate();
+
+        for (uint32_t i = 0; i < chunks.size(); i++){
+            EPAXAssert(pthread_create(&tids[i], NULL, parseChunkThread, chunks[i]) == 0, "Cannot start static file reader thread");
+        }
+        for (uint32_t i = 0; i < chunks.size(); i++){
+            pthread_join(tids[i], NULL);
+        }
+
+        // join the per-chunk target lists
+        if (hasField(StaticField_flw)){
+            for (uint32_t i = 0; i < chunks.size(); i++){
+                StaticChunk* c = chunks[i];
+                uint64_t base = targets.size();
+                for (uint64_t j = c->first; j < c->first + c->records; j++){
+                    targetstart[j] += base;
+                }
+                targets.insert(targets.end(), c->targets.begin(), c->targets.end());
+            }
+        }
+
+        for (uint32_t i = 0; i < chunks.size(); i++){
+            delete chunks[i];
+        }
+    }
+
+    StaticFile::~StaticFile(){
+        if (IS_VALID_PTR(data)){
+            munmap(data, size);
+        }
+    }
+
+    uint64_t StaticFile::parseHeader(){
+        const char* p = data;
+        const char* e = data + size;
+        while (p < e && !isRecordStart(p, e)){
+            const char* n = endOfLine(p, e);
+            if (*p == '#'){
+                const char* eq = (const char*)memchr(p, '=', n - p);
+                if (eq){
+                    const char* k = p + 1;
+                    while (k < eq && *k == ' ') k++;
+                    const char* ke = eq;
+                    while (ke > k && ke[-1] == ' ') ke--;
+                    const char* v = eq + 1;
+                    while (v < n && *v == ' ') v++;
+                    header[std::string(k, ke - k)] = std::string(v, n - v);
+                }
+            }
+            p = (n < e? n + 1: e);
+        }
+        return p - data;
+    }
+
+    uint32_t StaticFile::parseFields(std::string tags){
+        static const char* names[] = { "str", "isa", "prd", "flw", "lpi", "lpc", "cnt", "srg", "ipa" };
+
+        if (tags.size() == 0){
+            return StaticField_all;
+        }
+
+        uint32_t f = 0;
+        std::string::size_type pos = 0;
+        while (pos <= tags.size()){
+            std::string::size_type comma = tags.find(',', pos);
+            if (comma == std::string::npos){
+                comma = tags.size();
+            }
+            std::string t = tags.substr(pos, comma - pos);
+            if (t.size() > 0 && t[0] == '+'){
+                t = t.substr(1);
+            }
+
+            bool found = false;
+            for (uint32_t i = 0; i < sizeof(names) / sizeof(char*); i++){
+                if (t == names[i]){
+                    f |= (1 << i);
+                    found = true;
+                }
+            }
+            EPAXAssert(found || t.size() == 0, "Unknown static file record " << t);
+            pos = comma + 1;
+        }
+        return f;
+    }
+
+    std::string StaticFile::getHeader(std::string key){
+        if (header.count(key) == 0){
+            return std::string();
+        }
+        return header[key];
+    }
+
+    void StaticFile::allocate(){
+        StaticString empty;
+        empty.offset = 0;
+        empty.size = 0;
+
+        addresses.resize(count, 0);
+        funcnames.resize(count, empty);
+        funcids.resize(count, 0);
+        bblids.resize(count, 0);
+        linefiles.resize(count, empty);
+        lines.resize(count, 0);
+
+        if (hasField(StaticField_str)){
+            strs.resize(count, empty);
+        }
+        if (hasField(StaticField_isa)){
+            groups.resize(count, empty);
+            sizes.resize(count, 0);
+        }
+        if (hasField(StaticField_prd)){
+            conditions.resize(count, empty);
+        }
+        if (hasField(StaticField_flw)){
+            targetstart.resize(count, 0);
+            targetcount.resize(count, 0);
+        }
+        if (hasField(StaticField_lpi)){
+            loopcounts.resize(count, 0);
+            loopids.resize(count, STATIC_NONE);
+            loopdepths.resize(count, 0);
+            loopheads.resize(count, 0);
+            looptails.resize(count, 0);
+        }
+        if (hasField(StaticField_lpc)){
+            parentheads.resize(count, 0);
+            parenttails.resize(count, 0);
+        }
+        if (hasField(StaticField_cnt)){
+            counts.resize(count, 0);
+        }
+        if (hasField(StaticField_srg)){
+            srgelements.resize(count, 0);
+            srgbits.resize(count, 0);
+            srgfp.resize(count, 0);
+        }
+        if (hasField(StaticField_ipa)){
+            calltargets.resize(count, 0);
+            calltargetnames.resize(count, empty);
+        }
+    }
+
+    void* StaticFile::countChunkThread(void* arg){
+        StaticChunk* c = (StaticChunk*)arg;
+        c->file->countChunk(c);
+        return NULL;
+    }
+
+    void* StaticFile::parseChunkThread(void* arg){
+        StaticChunk* c = (StaticChunk*)arg;
+        c->file->parseChunk(c);
+        return NULL;
+    }
+
+    void StaticFile::countChunk(StaticChunk* c){
+        const char* p = data + c->start;
+        const char* e = data + c->end;
+        while (p < e){
+            if (isRecordStart(p, e)){
+                c->records++;
+            }
+            p = endOfLine(p, e) + 1;
+        }
+    }
+
+    void StaticFile::parseChunk(StaticChunk* c){
+        const char* p = data + c->start;
+        const char* e = data + c->end;
+        uint64_t idx = c->first;
+        bool started = false;
+
+        while (p < e){
+            const char* n = endOfLine(p, e);
+
+            if (isRecordStart(p, e)){
+                if (started){
+                    idx++;
+                }
+                started = true;
+
+                // <sequence> <vaddr> <funcname> <funcid> <bbid> <file>:<line>
+                parseDec(p, n);
+                addresses[idx] = parseHex(p, n);
+                funcnames[idx] = parseString(data, p, n, false);
+                funcids[idx] = parseDec(p, n);
+                bblids[idx] = parseDec(p, n);
+
+                StaticString fl = parseString(data, p, n, true);
+                const char* colon = data + fl.offset + fl.size;
+                while (colon > data + fl.offset && colon[-1] != ':'){
+                    colon--;
+                }
+                if (colon > data + fl.offset){
+                    const char* l = colon;
+                    lines[idx] = parseDec(l, n);
+                    fl.size = colon - 1 - (data + fl.offset);
+                }
+                linefiles[idx] = fl;
+
+            } else if (started && n - p > 5 && p[0] == '\t' && p[1] == '+'){
+                const char* t = p + 2;
+                p += 5;
+
+                // unselected records are skipped before any tokenizing
+                if (t[0] == 's' && t[1] == 't' && t[2] == 'r'){
+                    if (hasField(StaticField_str)){
+                        strs[idx] = parseString(data, p, n, true);
+                    }
+                } else if (t[0] == 'i' && t[1] == 's' && t[2] == 'a'){
+                    if (hasField(StaticField_isa)){
+                        groups[idx] = parseString(data, p, n, false);
+                        sizes[idx] = parseDec(p, n);
+                    }
+                } else if (t[0] == 'p' && t[1] == 'r' && t[2] == 'd'){
+                    if (hasField(StaticField_prd)){
+                        conditions[idx] = parseString(data, p, n, false);
+                    }
+                } else if (t[0] == 'f' && t[1] == 'l' && t[2] == 'w'){
+                    if (hasField(StaticField_flw)){
+                        targetstart[idx] = c->targets.size();
+                        skipTab(p, n);
+                        while (p < n){
+                            c->targets.push_back(parseHex(p, n));
+                            targetcount[idx]++;
+                            skipTab(p, n);
+                        }
+                    }
+                } else if (t[0] == 'l' && t[1] == 'p' && t[2] == 'i'){
+                    if (hasField(StaticField_lpi)){
+                        loopcounts[idx] = parseDec(p, n);
+                        loopids[idx] = parseDec(p, n);
+                        loopdepths[idx] = parseDec(p, n);
+                        loopheads[idx] = parseHex(p, n);
+                        looptails[idx] = parseHex(p, n);
+                    }
+                } else if (t[0] == 'l' && t[1] == 'p' && t[2] == 'c'){
+                    if (hasField(StaticField_lpc)){
+                        parentheads[idx] = parseHex(p, n);
+                        parenttails[idx] = parseHex(p, n);
+                    }
+                } else if (t[0] == 'c' && t[1] == 'n' && t[2] == 't'){
+                    if (hasField(StaticField_cnt)){
+                        uint8_t v = 0;
+                        if (parseDec(p, n)) v |= StaticCount_branch;
+                        if (parseDec(p, n)) v |= StaticCount_fpop;
+                        if (parseDec(p, n)) v |= StaticCount_load;
+                        if (parseDec(p, n)) v |= StaticCount_store;
+                        counts[idx] = v;
+                    }
+                } else if (t[0] == 's' && t[1] == 'r' && t[2] == 'g'){
+                    // <elements>x<bits>:<fp>:<int>
+                    if (hasField(StaticField_srg)){
+                        srgelements[idx] = parseDec(p, n);
+                        if (p < n) p++;
+                        srgbits[idx] = parseDec(p, n);
+                        if (p < n) p++;
+                        srgfp[idx] = parseDec(p, n);
+                    }
+                } else if (t[0] == 'i' && t[1] == 'p' && t[2] == 'a'){
+                    if (hasField(StaticField_ipa)){
+                        calltargets[idx] = parseHex(p, n);
+                        calltargetnames[idx] = parseString(data, p, n, true);
+                    }
+                }
+            }
+
+            p = n + 1;
+        }
+    }
+
+    uint32_t StaticFile::getTargets(uint64_t idx, std::vector<uint64_t>& tgts){
+        EPAXAssert(hasField(StaticField_flw), "+flw records were not read from " << getName());
+        EPAXCheck(idx < count, "Invalid instruction index " << DEC(idx));
+        for (uint32_t i = 0; i < targetcount[idx]; i++){
+            tgts.push_back(targets[targetstart[idx] + i]);
+        }
+        return targetcount[idx];
+    }
+
+} // namespace EPAX
@@ -0,0 +1,214 @@
+/**
+ * @file StaticFile.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_StaticFile_hpp__
+#define __EPAX_StaticFile_hpp__
+
+#include "BaseClass.hpp"
+
+namespace EPAX {
+
+    /**
+     * Optional per-instruction records of a .static file. The instruction line itself
+     * (address, function, block and source line) is always read.
+     */
+    typedef enum {
+        StaticField_str = 0x001,
+        StaticField_isa = 0x002,
+        StaticField_prd = 0x004,
+        StaticField_flw = 0x008,
+        StaticField_lpi = 0x010,
+        StaticField_lpc = 0x020,
+        StaticField_cnt = 0x040,
+        StaticField_srg = 0x080,
+        StaticField_ipa = 0x100,
+        StaticField_all = 0x1ff
+    } StaticField;
+
+    /**
+     * Flags held in the +cnt column
+     */
+    typedef enum {
+        StaticCount_branch = 0x1,
+        StaticCount_fpop   = 0x2,
+        StaticCount_load   = 0x4,
+        StaticCount_store  = 0x8
+    } StaticCount;
+
+    /**
+     * A string held in the mapped file, given as its offset and length
+     */
+    typedef struct {
+        uint64_t offset;
+        uint32_t size;
+    } StaticString;
+
+#define STATIC_NONE (0xffffffff)
+
+    class StaticChunk;
+
+    /**
+     * Reader for the text files written by BIN_printStaticFile. The file is mapped,
+     * split at instruction-record boundaries and parsed in parallel into one array
+     * per column. Records for fields that were not selected are skipped without
+     * being tokenized, and their columns are left empty. String columns refer into
+     * the mapping, which lives as long as the StaticFile.
+     */
+    class StaticFile : public NameBase, public EPAXExport {
+    private:
+        char* data;
+        uint64_t size;
+        uint32_t fields;
+        uint64_t count;
+
+        std::map<std::string, std::string> header;
+
+        // instruction lines
+        std::vector<uint64_t> addresses;
+        std::vector<StaticString> funcnames;
+        std::vector<uint32_t> funcids;
+        std::vector<uint32_t> bblids;
+        std::vector<StaticString> linefiles;
+        std::vector<uint32_t> lines;
+
+        // +str
+        std::vector<StaticString> strs;
+
+        // +isa
+        std::vector<StaticString> groups;
+        std::vector<uint32_t> sizes;
+
+        // +prd
+        std::vector<StaticString> conditions;
+
+        // +flw, as ranges of a flat list of targets
+        std::vector<uint64_t> targetstart;
+        std::vector<uint32_t> targetcount;
+        std::vector<uint64_t> targets;
+
+        // +lpi and +lpc; loopids is STATIC_NONE outside of loops
+        std::vector<uint32_t> loopcounts;
+        std::vector<uint32_t> loopids;
+        std::vector<uint32_t> loopdepths;
+        std::vector<uint64_t> loopheads;
+        std::vector<uint64_t> looptails;
+        std::vector<uint64_t> parentheads;
+        std::vector<uint64_t> parenttails;
+
+        // +cnt
+        std::vector<uint8_t> counts;
+
+        // +srg
+        std::vector<uint32_t> srgelements;
+        std::vector<uint32_t> srgbits;
+        std::vector<uint8_t> srgfp;
+
+        // +ipa
+        std::vector<uint64_t> calltargets;
+        std::vector<StaticString> calltargetnames;
+
+        uint64_t parseHeader();
+        void allocate();
+        void countChunk(StaticChunk* c);
+        void parseChunk(StaticChunk* c);
+
+        static void* countChunkThread(void* arg);
+        static void* parseChunkThread(void* arg);
+
+    public:
+        /**
+         * Maps and parses a .static file
+         *
+         * @param n the name of the file
+         * @param f the StaticField values to read, or'ed together
+         * @param threads the number of parser threads, or 0 to use one per online cpu
+         */
+        StaticFile(std::string n, uint32_t f = StaticField_all, uint32_t threads = 0);
+        virtual ~StaticFile();
+
+        uint64_t countInstructions() { return count; }
+        bool hasField(StaticField f) { return (fields & f) != 0; }
+
+        /**
+         * Gets a value from the "# key = value" header of the file
+         *
+         * @param key a header key, such as appname or sha1sum
+         * @return the value of key, or an empty string if the file has no such key
+         */
+        std::string getHeader(std::string key);
+
+        std::string getString(StaticString s) { return std::string(data + s.offset, s.size); }
+
+        /**
+         * Converts a list of record tags such as "str,flw,lpi" to StaticField values
+         *
+         * @param tags comma-separated record names; empty selects every record
+         * @return the StaticField values named in tags, or'ed together
+         */
+        static uint32_t parseFields(std::string tags);
+
+        const std::vector<uint64_t>& getAddresses() { return addresses; }
+        const std::vector<StaticString>& getFunctionNames() { return funcnames; }
+        const std::vector<uint32_t>& getFunctionIds() { return funcids; }
+        const std::vector<uint32_t>& getBlockIds() { return bblids; }
+        const std::vector<StaticString>& getLineFiles() { return linefiles; }
+        const std::vector<uint32_t>& getLines() { return lines; }
+
+        const std::vector<StaticString>& getStrings() { return strs; }
+
+        const std::vector<StaticString>& getGroups() { return groups; }
+        const std::vector<uint32_t>& getSizes() { return sizes; }
+
+        const std::vector<StaticString>& getConditions() { return conditions; }
+
+        /**
+         * Gets the control targets of one instruction
+         *
+         * @param idx an instruction index
+         * @param tgts (out) the +flw targets of instruction idx
+         * @return the number of targets
+         */
+        uint32_t getTargets(uint64_t idx, std::vector<uint64_t>& tgts);
+
+        const std::vector<uint32_t>& getLoopCounts() { return loopcounts; }
+        const std::vector<uint32_t>& getLoopIds() { return loopids; }
+        const std::vector<uint32_t>& getLoopDepths() { return loopdepths; }
+        const std::vector<uint64_t>& getLoopHeads() { return loopheads; }
+        const std::vector<uint64_t>& getLoopTails() { return looptails; }
+        const std::vector<uint64_t>& getParentLoopHeads() { return parentheads; }
+        const std::vector<uint64_t>& getParentLoopTails() { return parenttails; }
+
+        const std::vector<uint8_t>& getCounts() { return counts; }
+
+        const std::vector<uint32_t>& getRegisterElements() { return srgelements; }
+        const std::vector<uint32_t>& getRegisterElementBits() { return srgbits; }
+        const std::vector<uint8_t>& getRegisterIsFp() { return srgfp; }
+
+        const std::vector<uint64_t>& getCallTargets() { return calltargets; }
+        const std::vector<StaticString>& getCallTargetNames() { return calltargetnames; }
+    }; // class StaticFile
+
+} // namespace EPAX
+
+#endif // __EPAX_StaticFile_hpp__
@@ -54,8 +54,8 @@ namespace EPAX {
     }
 
     Symbol* SymbolTable::getSymbol(uint32_t i){
-        EPAXAssert(i < countSymbols(), "Symbol table index out of range");
-        return symbols->at(i);
+        EPAXCheck(i < countSymbols(), "Symbol table index out of range");
+        return (*symbols)[i];
     }
 
     StringTable::StringTable(BaseBinary* b, uint64_t o, uint64_t fs, uint64_t ma, uint64_t ms, uint32_t i, std::string n)
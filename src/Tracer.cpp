@@ -0,0 +1,882 @@
+/**
+ * @file Tracer.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EPAXCommonInternal.hpp"
+
+#include "Binary.hpp"
+#include "Function.hpp"
+#include "ProcessImage.hpp"
+#include "Tracer.hpp"
+
+#include <dirent.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sstream>
+#include <sys/ptrace.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/user.h>
+
+#define TRACER_OPTIONS (PTRACE_O_TRACECLONE | PTRACE_O_TRACEEXEC | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK | PTRACE_O_TRACEVFORKDONE)
+
+// what is known of a process forked by the traced one
+#define NEWPROC_STOPPED  (0x1) // it has reported its first stop
+#define NEWPROC_REPORTED (0x2) // its parent has reported the fork
+#define NEWPROC_SHARED   (0x4) // it is a vfork child, running in the memory of its parent
+
+// the breakpoint instruction, and how far past it the program counter is when it traps
+#if defined(__x86_64__) || defined(__i386__)
+static const uint8_t breakinsn[] = { 0xcc };
+#define BREAK_PC_OFFSET (1)
+#define TRACER_CAN_STEP
+#elif defined(__aarch64__)
+static const uint8_t breakinsn[] = { 0x00, 0x00, 0x20, 0xd4 }; // brk #0
+#define BREAK_PC_OFFSET (0)
+#define TRACER_CAN_STEP
+#elif defined(__arm__)
+static const uint8_t breakinsn[] = { 0xf0, 0x01, 0xf0, 0xe7 }; // the kernel's ARM breakpoint
+static const uint8_t thumbbreakinsn[] = { 0x01, 0xde };        // and its Thumb breakpoint
+#define BREAK_PC_OFFSET (0)
+#define TRACER_THUMB
+#else
+static const uint8_t breakinsn[] = { 0x00 };
+#define BREAK_PC_OFFSET (0)
+#define TRACER_NO_BREAKPOINTS
+#endif
+
+#define BREAK_SIZE (sizeof(breakinsn))
+
+namespace EPAX {
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+    typedef struct user_regs_struct TraceRegs;
+#elif defined(__arm__)
+    typedef struct user_regs TraceRegs;
+#else
+    typedef uint32_t TraceRegs;
+#endif
+
+    static volatile sig_atomic_t tracetick = 0;
+
+    static void traceAlarm(int sig){
+        tracetick = 1;
+    }
+
+    // reads or writes the program counter in a register set; a 32-bit tracee of a
+    // 64-bit tracer has the 32-bit register set
+    static bool accessPC(TraceRegs& regs, uint64_t len, uint64_t& pc, bool set){
+#if defined(__x86_64__)
+        if (len == 17 * sizeof(uint32_t)){
+            uint32_t* r = (uint32_t*)&regs;
+            if (set) r[12] = (uint32_t)pc; else pc = r[12];
+            return true;
+        }
+        if (set) regs.rip = pc; else pc = regs.rip;
+#elif defined(__aarch64__)
+        if (len == 18 * sizeof(uint32_t)){
+            uint32_t* r = (uint32_t*)&regs;
+            if (set) r[15] = (uint32_t)pc; else pc = r[15];
+            return true;
+        }
+        if (set) regs.pc = pc; else pc = regs.pc;
+#elif defined(__i386__)
+        if (set) regs.eip = pc; else pc = regs.eip;
+#elif defined(__arm__)
+        if (set) regs.uregs[15] = pc; else pc = regs.uregs[15];
+#else
+        return false;
+#endif
+        return true;
+    }
+
+    static bool readSP(TraceRegs& regs, uint64_t len, uint64_t& sp){
+#if defined(__x86_64__)
+        if (len == 17 * sizeof(uint32_t)){
+            sp = ((uint32_t*)&regs)[15];
+            return true;
+        }
+        sp = regs.rsp;
+#elif defined(__aarch64__)
+        if (len == 18 * sizeof(uint32_t)){
+            sp = ((uint32_t*)&regs)[13];
+            return true;
+        }
+        sp = regs.sp;
+#elif defined(__i386__)
+        sp = regs.esp;
+#elif defined(__arm__)
+        sp = regs.uregs[13];
+#else
+        return false;
+#endif
+        return true;
+    }
+
+    bool Tracer::getThreadPC(pid_t tid, uint64_t& pc){
+        TraceRegs regs;
+        struct iovec iov;
+        iov.iov_base = &regs;
+        iov.iov_len = sizeof(regs);
+        if (ptrace(PTRACE_GETREGSET, tid, (void*)NT_PRSTATUS, &iov) != 0){
+            return false;
+        }
+        return accessPC(regs, iov.iov_len, pc, false);
+    }
+
+    bool Tracer::getThreadSP(pid_t tid, uint64_t& sp){
+        TraceRegs regs;
+        struct iovec iov;
+        iov.iov_base = &regs;
+        iov.iov_len = sizeof(regs);
+        if (ptrace(PTRACE_GETREGSET, tid, (void*)NT_PRSTATUS, &iov) != 0){
+            return false;
+        }
+        return readSP(regs, iov.iov_len, sp);
+    }
+
+    bool Tracer::setThreadPC(pid_t tid, uint64_t pc){
+        TraceRegs regs;
+        struct iovec iov;
+        iov.iov_base = &regs;
+        iov.iov_len = sizeof(regs);
+        if (ptrace(PTRACE_GETREGSET, tid, (void*)NT_PRSTATUS, &iov) != 0){
+            return false;
+        }
+        if (!accessPC(regs, iov.iov_len, pc, true)){
+            return false;
+        }
+        return (ptrace(PTRACE_SETREGSET, tid, (void*)NT_PRSTATUS, &iov) == 0);
+    }
+
+    Tracer::Tracer(Binary* b, uint32_t hz)
+        : NameBase(b->getName()), detaching(false), interrupting(0), status(-1), memfd(-1),
+          stepper(0), stepaddr(0), steplaunched(false), vforks(0), binary(b), frequency(hz), pid(0), bias(0), image(INVALID_PTR)
+    {
+        EPAXAssert(frequency <= 1000000, "tick frequency must be at most 1 MHz");
+    }
+
+    Tracer::~Tracer(){
+        if (memfd >= 0){
+            close(memfd);
+        }
+        if (IS_VALID_PTR(image)){
+            delete image;
+        }
+    }
+
+    bool Tracer::canStepOver(){
+#ifdef TRACER_CAN_STEP
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool Tracer::seize(pid_t tid){
+        if (ptrace(PTRACE_SEIZE, tid, NULL, (void*)(long)TRACER_OPTIONS) != 0){
+            return false;
+        }
+        threads[tid].interrupting = false;
+        threads[tid].stepping = 0;
+        return true;
+    }
+
+    // run time addresses of a position-independent executable are offset from its
+    // link time addresses by the bias of the executable in the process image
+    void Tracer::findLoadBias(){
+        ImageObject* exe = image->getExecutable();
+        if (IS_VALID_PTR(exe)){
+            bias = exe->bias;
+            return;
+        }
+        bias = 0;
+        EPAXWarn << "cannot find the executable of process " << DEC(pid) << "; assuming " << getName() << " is not relocated" << ENDL;
+    }
+
+    // stops the process each time the dynamic linker changes its link map, so that the
+    // image follows dlopen and dlclose. hosts that cannot step over a breakpoint see only
+    // the first change
+    void Tracer::watchLinkMap(){
+        uint64_t r = image->getUpdateAddress();
+        uint8_t size = BREAK_SIZE;
+#ifdef TRACER_THUMB
+        if (r & 1){
+            r &= ~(uint64_t)1;
+            size = sizeof(thumbbreakinsn);
+        }
+#endif
+        if (r == 0 || breakpoints.count(r)){
+            return;
+        }
+
+        TraceBreakpoint& b = breakpoints[r];
+        b.addr = r - bias;
+        b.armed = false;
+        b.size = size;
+        b.linker = true;
+
+        std::vector<uint64_t> raddrs(1, r);
+        if (!writeBreakpoints(memfd, raddrs, true)){
+            EPAXWarn << "cannot watch the link map of process " << DEC(pid) << "; objects it loads later are found only when sampled" << ENDL;
+            return;
+        }
+        b.armed = true;
+    }
+
+    bool Tracer::launch(char* argv[]){
+        EPAXAssert(pid == 0, "a Tracer traces one process");
+        if (!binary->isHostCode()){
+            EPAXErr << getName() << " does not hold code for this host; it cannot be traced" << ENDL;
+            return false;
+        }
+
+        pid_t child = fork();
+        if (child < 0){
+            return false;
+        }
+        if (child == 0){
+            // wait to be seized, so that the exec is traced
+            raise(SIGSTOP);
+            execvp(argv[0], argv);
+            EPAXErr << "cannot run " << argv[0] << ": " << strerror(errno) << ENDL;
+            _exit(127);
+        }
+
+        int st;
+        if (waitpid(child, &st, WUNTRACED) != child || !WIFSTOPPED(st)){
+            return false;
+        }
+
+        // kill the child if we die before it is detached
+        if (ptrace(PTRACE_SEIZE, child, NULL, (void*)(long)(TRACER_OPTIONS | PTRACE_O_EXITKILL)) != 0){
+            kill(child, SIGKILL);
+            return false;
+        }
+        threads[child].interrupting = false;
+        threads[child].stepping = 0;
+        pid = child;
+
+        // started() is called at the exec
+        kill(child, SIGCONT);
+        return true;
+    }
+
+    bool Tracer::attach(pid_t p){
+        EPAXAssert(pid == 0, "a Tracer traces one process");
+        if (!binary->isHostCode()){
+            EPAXErr << getName() << " does not hold code for this host; it cannot be traced" << ENDL;
+            return false;
+        }
+
+        std::stringstream ss;
+        ss << "/proc/" << DEC(p) << "/task";
+
+        // threads may be created while we attach, so rescan until no new ones appear
+        bool found = true;
+        while (found){
+            found = false;
+
+            DIR* d = opendir(ss.str().c_str());
+            if (d == NULL){
+                break;
+            }
+            struct dirent* e;
+            while ((e = readdir(d)) != NULL){
+                pid_t tid = (pid_t)strtol(e->d_name, NULL, 10);
+                if (tid <= 0 || threads.count(tid)){
+                    continue;
+                }
+                if (seize(tid)){
+                    found = true;
+                }
+            }
+            closedir(d);
+        }
+
+        if (threads.count(p) == 0){
+            EPAXErr << "cannot trace process " << DEC(p) << ": " << strerror(errno) << ENDL;
+            for (std::map<pid_t, TraceThread>::const_iterator it = threads.begin(); it != threads.end(); it++){
+                ptrace(PTRACE_DETACH, it->first, NULL, NULL);
+            }
+            threads.clear();
+            return false;
+        }
+
+        pid = p;
+
+        std::stringstream ms;
+        ms << "/proc/" << DEC(pid) << "/mem";
+        memfd = open(ms.str().c_str(), O_RDWR | O_CLOEXEC);
+        image = new ProcessImage(pid);
+        findLoadBias();
+        watchLinkMap();
+
+        // the threads are running, so breakpoints are placed one instruction at a time
+        // and only in code, which no thread writes
+        started();
+        return true;
+    }
+
+    void Tracer::interrupt(){
+        for (std::map<pid_t, TraceThread>::iterator it = threads.begin(); it != threads.end(); it++){
+            if (!it->second.interrupting && ptrace(PTRACE_INTERRUPT, it->first, NULL, NULL) == 0){
+                it->second.interrupting = true;
+                interrupting++;
+            }
+        }
+    }
+
+    // the size of the breakpoint instruction for a link time address. Thumb, the only
+    // second instruction set of a host, takes a 2-byte one
+    uint8_t Tracer::breakSize(uint64_t addr){
+#ifdef TRACER_THUMB
+        Function* f = binary->findFunctionAt(addr);
+        if (IS_VALID_PTR(f) && f->disassembleMode() != DisasmMode_ARM){
+            return sizeof(thumbbreakinsn);
+        }
+#endif
+        return BREAK_SIZE;
+    }
+
+    // writes the breakpoint instruction (arm) or the bytes it replaced (!arm) at each of
+    // addrs, run time addresses of entries of breakpoints, with one write per page. fd is
+    // the memory of the traced process, or of a fork child being released
+    bool Tracer::writeBreakpoints(int fd, std::vector<uint64_t>& addrs, bool arm){
+#ifdef TRACER_NO_BREAKPOINTS
+        return addrs.empty();
+#endif
+        if (fd < 0){
+            return addrs.empty();
+        }
+        // the memory holds none of the breakpoints while a vfork child runs in it;
+        // armAll() writes back those still armed once the child is gone
+        if (fd == memfd && vforks){
+            return true;
+        }
+        std::sort(addrs.begin(), addrs.end());
+
+        uint64_t pagemask = ~((uint64_t)sysconf(_SC_PAGESIZE) - 1);
+        std::vector<uint8_t> buf;
+        for (uint32_t i = 0; i < addrs.size(); ){
+            uint32_t j = i;
+            while (j < addrs.size() && (addrs[j] & pagemask) == (addrs[i] & pagemask)){
+                j++;
+            }
+
+            uint64_t first = addrs[i];
+            uint64_t last = addrs[j - 1];
+            buf.resize(last + breakpoints[last].size - first);
+            if (pread(fd, &buf[0], buf.size(), first) != (ssize_t)buf.size()){
+                return false;
+            }
+            for (uint32_t k = i; k < j; k++){
+                TraceBreakpoint& b = breakpoints[addrs[k]];
+                uint8_t* p = &buf[addrs[k] - first];
+                if (arm){
+                    const uint8_t* insn = breakinsn;
+#ifdef TRACER_THUMB
+                    if (b.size == sizeof(thumbbreakinsn)){
+                        insn = thumbbreakinsn;
+                    }
+#endif
+                    memcpy(b.saved, p, b.size);
+                    memcpy(p, insn, b.size);
+                } else {
+                    memcpy(p, b.saved, b.size);
+                }
+            }
+            if (pwrite(fd, &buf[0], buf.size(), first) != (ssize_t)buf.size()){
+                return false;
+            }
+            i = j;
+        }
+        return true;
+    }
+
+    bool Tracer::insertBreakpoints(std::vector<uint64_t>& addrs){
+        std::vector<uint64_t> raddrs;
+        for (std::vector<uint64_t>::const_iterator it = addrs.begin(); it != addrs.end(); it++){
+            uint64_t r = (*it) + bias;
+            std::map<uint64_t, TraceBreakpoint>::iterator b = breakpoints.find(r);
+            if (b != breakpoints.end() && b->second.armed){
+                continue;
+            }
+            breakpoints[r].addr = (*it);
+            breakpoints[r].armed = false;
+            breakpoints[r].size = breakSize(*it);
+            breakpoints[r].linker = false;
+            raddrs.push_back(r);
+        }
+
+        if (!writeBreakpoints(memfd, raddrs, true)){
+            return false;
+        }
+        for (std::vector<uint64_t>::const_iterator it = raddrs.begin(); it != raddrs.end(); it++){
+            breakpoints[(*it)].armed = true;
+        }
+        return true;
+    }
+
+    void Tracer::removeBreakpoints(std::vector<uint64_t>& addrs){
+        // removed breakpoints are kept, so that a thread that reached one before its
+        // removal is still recognized
+        std::vector<uint64_t> raddrs;
+        for (std::vector<uint64_t>::const_iterator it = addrs.begin(); it != addrs.end(); it++){
+            std::map<uint64_t, TraceBreakpoint>::iterator b = breakpoints.find((*it) + bias);
+            if (b != breakpoints.end() && b->second.armed){
+                b->second.armed = false;
+                raddrs.push_back(b->first);
+            }
+        }
+        writeBreakpoints(memfd, raddrs, false);
+    }
+
+    // writes (arm) or lifts (!arm) every armed breakpoint, which all stay armed. the
+    // breakpoint being stepped over is left lifted until its step is done
+    void Tracer::armAll(bool arm){
+        std::vector<uint64_t> raddrs;
+        for (std::map<uint64_t, TraceBreakpoint>::const_iterator it = breakpoints.begin(); it != breakpoints.end(); it++){
+            if (it->second.armed && !(arm && steplaunched && it->first == stepaddr)){
+                raddrs.push_back(it->first);
+            }
+        }
+        writeBreakpoints(memfd, raddrs, arm);
+    }
+
+    // a stop of an unknown thread is either from a new thread, which can report before
+    // the clone event of its parent, or from a process forked by the traced one
+    bool Tracer::isNewProcess(pid_t tid){
+        if (forks.count(tid)){
+            return true;
+        }
+        if (threads.count(tid)){
+            return false;
+        }
+
+        std::stringstream ss;
+        ss << "/proc/" << DEC(tid) << "/status";
+        std::ifstream in(ss.str().c_str());
+        std::string line;
+        while (std::getline(in, line)){
+            if (line.compare(0, 5, "Tgid:") == 0){
+                return ((pid_t)strtol(line.c_str() + 5, NULL, 10) != pid);
+            }
+        }
+        return false;
+    }
+
+    // a thread of the traced process reported a fork or vfork
+    void Tracer::forkReported(pid_t tid, int event){
+        if (event == PTRACE_EVENT_VFORK){
+            // the child runs in this memory until it execs or exits
+            armAll(false);
+            vforks++;
+        }
+
+        unsigned long child;
+        if (ptrace(PTRACE_GETEVENTMSG, tid, NULL, &child) != 0){
+            return;
+        }
+        uint32_t& f = forks[(pid_t)child];
+        f |= NEWPROC_REPORTED | (event == PTRACE_EVENT_VFORK? NEWPROC_SHARED: 0);
+        if (f & NEWPROC_STOPPED){
+            releaseProcess((pid_t)child);
+        }
+    }
+
+    // a forked process reported its first stop. it is held until its parent reports the
+    // fork, which tells whether it shares the memory of the traced process
+    void Tracer::forkStopped(pid_t child){
+        uint32_t& f = forks[child];
+        f |= NEWPROC_STOPPED;
+        if (f & NEWPROC_REPORTED){
+            releaseProcess(child);
+        }
+    }
+
+    // removes the breakpoints from a fork child's copy of the code and detaches it. a
+    // vfork child has no copy: its parent's breakpoints are already lifted
+    void Tracer::releaseProcess(pid_t child){
+        uint32_t f = forks[child];
+        forks.erase(child);
+
+        if (!(f & NEWPROC_SHARED)){
+            std::vector<uint64_t> raddrs;
+            for (std::map<uint64_t, TraceBreakpoint>::const_iterator it = breakpoints.begin(); it != breakpoints.end(); it++){
+                if (it->second.armed){
+                    raddrs.push_back(it->first);
+                }
+            }
+
+            std::stringstream ms;
+            ms << "/proc/" << DEC(child) << "/mem";
+            int fd = open(ms.str().c_str(), O_RDWR | O_CLOEXEC);
+            if (!writeBreakpoints(fd, raddrs, false)){
+                EPAXWarn << "cannot remove the breakpoints from process " << DEC(child) << ", forked by " << DEC(pid) << ENDL;
+            }
+            if (fd >= 0){
+                close(fd);
+            }
+        }
+        ptrace(PTRACE_DETACH, child, NULL, NULL);
+    }
+
+    // a SIGTRAP is ours if it ends a step over a breakpoint or comes from a breakpoint;
+    // req is set to how the thread should be resumed, or -1 to hold it
+    bool Tracer::handleTrap(pid_t tid, TraceThread& t, int& req){
+        if (t.stepping){
+            uint64_t r = t.stepping;
+            t.stepping = 0;
+
+            std::map<uint64_t, TraceBreakpoint>::iterator b = breakpoints.find(r);
+            if (b != breakpoints.end() && b->second.armed){
+                std::vector<uint64_t> raddrs(1, r);
+                writeBreakpoints(memfd, raddrs, true);
+            }
+            if (tid == stepper){
+                stepper = 0;
+                steplaunched = false;
+            }
+            req = PTRACE_CONT;
+            return true;
+        }
+
+        uint64_t pc;
+        if (!getThreadPC(tid, pc)){
+            return false;
+        }
+        std::map<uint64_t, TraceBreakpoint>::iterator b = breakpoints.find(pc - BREAK_PC_OFFSET);
+        if (b == breakpoints.end()){
+            return false;
+        }
+        setThreadPC(tid, b->first);
+        req = PTRACE_CONT;
+        if (detaching){
+            return true;
+        }
+
+        bool keep = true;
+        if (b->second.linker){
+            image->refresh();
+        } else {
+            keep = hit(tid, b->second.addr);
+        }
+        if (!b->second.armed){
+            return true;
+        }
+
+#ifdef TRACER_CAN_STEP
+        if (keep){
+            // the breakpoint is lifted for one instruction; first stop every other thread,
+            // so that none passes it uncounted. stepOver() steps once they are held
+            stepper = tid;
+            stepaddr = b->first;
+            steplaunched = false;
+            for (std::map<pid_t, TraceThread>::iterator it = threads.begin(); it != threads.end(); it++){
+                if (it->first != tid && !it->second.interrupting && ptrace(PTRACE_INTERRUPT, it->first, NULL, NULL) == 0){
+                    it->second.interrupting = true;
+                    interrupting++;
+                }
+            }
+            req = -1;
+            return true;
+        }
+#endif
+        std::vector<uint64_t> raddrs(1, b->first);
+        b->second.armed = false;
+        writeBreakpoints(memfd, raddrs, false);
+        return true;
+    }
+
+    // steps over a breakpoint once every other thread is held, and resumes the held
+    // threads once the step is done
+    void Tracer::stepOver(){
+        if (stepper){
+            if (!steplaunched && held.size() + 1 >= threads.size()){
+                std::vector<uint64_t> raddrs(1, stepaddr);
+                writeBreakpoints(memfd, raddrs, false);
+                threads[stepper].stepping = stepaddr;
+                ptrace(PTRACE_SINGLESTEP, stepper, NULL, NULL);
+                steplaunched = true;
+            }
+            return;
+        }
+
+        // a held stop can begin another step, which holds the stops after it
+        while (!stepper && held.size()){
+            std::pair<pid_t, int> h = held.front();
+            held.erase(held.begin());
+            handleStop(h.first, h.second);
+        }
+    }
+
+    void Tracer::handleStop(pid_t tid, int st){
+        int sig = WSTOPSIG(st);
+        int event = (st >> 16);
+
+        if (isNewProcess(tid)){
+            forkStopped(tid);
+            return;
+        }
+
+        std::map<pid_t, TraceThread>::iterator it = threads.find(tid);
+        if (it == threads.end()){
+            // a new thread can report before the clone event of its parent
+            threads[tid].interrupting = false;
+            threads[tid].stepping = 0;
+            it = threads.find(tid);
+        }
+        TraceThread& t = it->second;
+
+        bool wanted = t.interrupting;
+        if (wanted){
+            t.interrupting = false;
+            interrupting--;
+        }
+
+        // a thread stepping over a breakpoint must finish the step before it runs on
+        int req = (t.stepping? PTRACE_SINGLESTEP: PTRACE_CONT);
+
+        if (event == PTRACE_EVENT_CLONE){
+            unsigned long newtid;
+            if (ptrace(PTRACE_GETEVENTMSG, tid, NULL, &newtid) == 0 && threads.count((pid_t)newtid) == 0){
+                threads[(pid_t)newtid].interrupting = false;
+                threads[(pid_t)newtid].stepping = 0;
+            }
+            sig = 0;
+        } else if (event == PTRACE_EVENT_FORK || event == PTRACE_EVENT_VFORK){
+            forkReported(tid, event);
+            sig = 0;
+        } else if (event == PTRACE_EVENT_VFORK_DONE){
+            if (vforks && --vforks == 0){
+                armAll(true);
+            }
+            sig = 0;
+        } else if (event == PTRACE_EVENT_EXEC){
+            // the new image has none of the old breakpoints
+            bool first = (memfd < 0);
+            breakpoints.clear();
+            vforks = 0;
+            t.stepping = 0;
+            req = PTRACE_CONT;
+
+            if (memfd >= 0){
+                close(memfd);
+            }
+            std::stringstream ms;
+            ms << "/proc/" << DEC(pid) << "/mem";
+            memfd = open(ms.str().c_str(), O_RDWR | O_CLOEXEC);
+
+            // only the executable and the dynamic linker are mapped yet
+            if (IS_VALID_PTR(image)){
+                delete image;
+            }
+            image = new ProcessImage(pid);
+
+            findLoadBias();
+            watchLinkMap();
+            if (first){
+                started();
+            } else {
+                EPAXWarn << "process " << DEC(pid) << " ran exec again; its new image is not " << getName() << ENDL;
+            }
+            sig = 0;
+        } else if (event == PTRACE_EVENT_STOP){
+            if (sig != SIGTRAP){
+                // group-stop: the thread is stopped by a signal, so it is not running
+                if (detaching){
+                    ptrace(PTRACE_DETACH, tid, NULL, NULL);
+                    threads.erase(it);
+                } else {
+                    ptrace(PTRACE_LISTEN, tid, NULL, NULL);
+                }
+                return;
+            }
+            if (wanted && !detaching){
+                interrupted(tid);
+            }
+            sig = 0;
+        } else if (sig == SIGTRAP && handleTrap(tid, t, req)){
+            sig = 0;
+        }
+        // otherwise a signal is being delivered to the thread, and is passed on
+
+        if (req < 0){
+            return;
+        }
+        if (detaching){
+            ptrace(PTRACE_DETACH, tid, NULL, (void*)(long)sig);
+            threads.erase(it);
+            return;
+        }
+        ptrace((enum __ptrace_request)req, tid, NULL, (void*)(long)sig);
+    }
+
+    void Tracer::handleExit(pid_t tid, int st){
+        forks.erase(tid);
+
+        std::map<pid_t, TraceThread>::iterator it = threads.find(tid);
+        if (it != threads.end()){
+            if (it->second.interrupting){
+                interrupting--;
+            }
+            threads.erase(it);
+        }
+
+        for (uint32_t i = 0; i < held.size(); ){
+            if (held[i].first == tid){
+                held.erase(held.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        if (tid == stepper){
+            // killed while holding the others; put back the breakpoint it lifted
+            std::map<uint64_t, TraceBreakpoint>::iterator b = breakpoints.find(stepaddr);
+            if (steplaunched && b != breakpoints.end() && b->second.armed){
+                std::vector<uint64_t> raddrs(1, stepaddr);
+                writeBreakpoints(memfd, raddrs, true);
+            }
+            stepper = 0;
+            steplaunched = false;
+        }
+
+        if (tid == pid){
+            status = (WIFEXITED(st)? WEXITSTATUS(st): 128 + WTERMSIG(st));
+        }
+    }
+
+    // removes every breakpoint, then detaches each thread as it stops
+    void Tracer::detach(){
+        detaching = true;
+
+        std::vector<uint64_t> raddrs;
+        for (std::map<uint64_t, TraceBreakpoint>::iterator it = breakpoints.begin(); it != breakpoints.end(); it++){
+            if (it->second.armed){
+                it->second.armed = false;
+                raddrs.push_back(it->first);
+            }
+        }
+        writeBreakpoints(memfd, raddrs, false);
+
+        // a thread waiting to step over a breakpoint can go now that there are none
+        if (stepper && !steplaunched){
+            ptrace(PTRACE_DETACH, stepper, NULL, NULL);
+            threads.erase(stepper);
+            stepper = 0;
+        }
+
+        interrupt();
+    }
+
+    int32_t Tracer::run(uint32_t seconds){
+        EPAXAssert(pid != 0, "launch or attach to a process before running the Tracer");
+
+        // the timer serves the ticks, and the time limit if there are no ticks
+        uint32_t hz = (frequency? frequency: (seconds? 1: 0));
+        uint64_t limit = (uint64_t)seconds * hz;
+
+        struct sigaction sa, oldsa;
+        struct itimerval timer, oldtimer;
+        if (hz){
+            memset(&sa, 0, sizeof(sa));
+            sa.sa_handler = traceAlarm;
+            sigemptyset(&sa.sa_mask);
+            // no SA_RESTART, so that a tick interrupts waitpid
+            sigaction(SIGALRM, &sa, &oldsa);
+
+            timer.it_interval.tv_sec = 0;
+            timer.it_interval.tv_usec = 1000000 / hz;
+            if (hz == 1){
+                timer.it_interval.tv_sec = 1;
+                timer.it_interval.tv_usec = 0;
+            }
+            timer.it_value = timer.it_interval;
+            setitimer(ITIMER_REAL, &timer, &oldtimer);
+        }
+
+        uint64_t ticks = 0;
+        while (threads.size()){
+            if (tracetick){
+                tracetick = 0;
+                ticks++;
+
+                if (limit && ticks >= limit && !detaching){
+                    detach();
+                } else if (frequency && !interrupting && !detaching){
+                    // a tick is dropped if the last one has not been served yet
+                    tick();
+                }
+            }
+
+            // a tick arriving just before waitpid blocks is only seen at the next event
+            int st;
+            pid_t tid = waitpid(-1, &st, __WALL);
+            if (tid < 0){
+                if (errno == EINTR){
+                    continue;
+                }
+                break;
+            }
+
+            if (WIFSTOPPED(st)){
+                if (stepper && tid != stepper && !isNewProcess(tid)){
+                    if (threads.count(tid) == 0){
+                        threads[tid].interrupting = false;
+                        threads[tid].stepping = 0;
+                    }
+                    held.push_back(std::make_pair(tid, st));
+                } else {
+                    handleStop(tid, st);
+                }
+            } else if (WIFEXITED(st) || WIFSIGNALED(st)){
+                handleExit(tid, st);
+            }
+            stepOver();
+        }
+
+        if (hz){
+            setitimer(ITIMER_REAL, &oldtimer, NULL);
+            sigaction(SIGALRM, &oldsa, NULL);
+        }
+        tracetick = 0;
+
+        // forked processes whose first stop came after the last thread was gone
+        while (forks.size()){
+            pid_t child = forks.begin()->first;
+            int st;
+            if (!(forks.begin()->second & NEWPROC_STOPPED)){
+                waitpid(child, &st, __WALL);
+            }
+            releaseProcess(child);
+        }
+
+        if (detaching){
+            return -1;
+        }
+        return status;
+    }
+
+} // namespace EPAX
@@ -0,0 +1,220 @@
+/**
+ * @file Tracer.hpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ * 
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __EPAX_Tracer_hpp__
+#define __EPAX_Tracer_hpp__
+
+#include "BaseClass.hpp"
+
+namespace EPAX {
+
+    class Binary;
+    class ProcessImage;
+
+    /**
+     * State of one thread of a traced process
+     */
+    typedef struct {
+        bool interrupting;  // a PTRACE_INTERRUPT has been sent and not yet reported
+        uint64_t stepping;  // the breakpoint being stepped over, or 0
+    } TraceThread;
+
+    /**
+     * A software breakpoint, keyed by its address in the process
+     */
+    typedef struct {
+        uint64_t addr;      // link time address
+        bool armed;
+        uint8_t size;       // of the breakpoint instruction; Thumb code takes a 2-byte one
+        uint8_t saved[4];   // the bytes the breakpoint instruction replaced
+        bool linker;        // on the dynamic linker's update function; refreshes the image rather than reaching hit()
+    } TraceBreakpoint;
+
+    /**
+     * Runs or attaches to a process running a Binary under ptrace, and drives it
+     * from a single event loop. Clone, exec, group-stop and signal-delivery stops
+     * are handled here, so that the traced program behaves as it would untraced.
+     * Processes forked by the traced one are not traced: a fork child has the
+     * breakpoints removed from its copy of the code and is detached, and the
+     * breakpoints are lifted while a vfork child shares the memory of its parent.
+     * Only binaries holding code for the host can be traced. The process image is
+     * refreshed each time the dynamic linker reports a dlopen or dlclose, through a
+     * breakpoint of the tracer's own on the linker's update function (r_debug.r_brk).
+     * Subclasses act on the process through a periodic tick, interrupts of its
+     * threads and software breakpoints. Addresses passed to and from subclasses are
+     * link time addresses; the load bias of position-independent executables is
+     * applied here.
+     */
+    class Tracer : public NameBase {
+    private:
+        bool detaching;
+        uint32_t interrupting;
+        int32_t status;
+        int memfd;
+
+        // the thread stepping over a breakpoint, while every other thread is held
+        pid_t stepper;
+        uint64_t stepaddr;
+        bool steplaunched;
+        std::vector<std::pair<pid_t, int> > held;
+
+        // processes forked by the traced one that are not yet detached, and the number
+        // of vfork children sharing its memory, during which its breakpoints are lifted
+        std::map<pid_t, uint32_t> forks;
+        uint32_t vforks;
+
+        void findLoadBias();
+        void watchLinkMap();
+        bool seize(pid_t tid);
+        uint8_t breakSize(uint64_t addr);
+        bool writeBreakpoints(int fd, std::vector<uint64_t>& addrs, bool arm);
+        void armAll(bool arm);
+        bool isNewProcess(pid_t tid);
+        void forkReported(pid_t tid, int event);
+        void forkStopped(pid_t child);
+        void releaseProcess(pid_t child);
+        bool handleTrap(pid_t tid, TraceThread& t, int& req);
+        void handleStop(pid_t tid, int st);
+        void handleExit(pid_t tid, int st);
+        void detach();
+        void stepOver();
+
+        static bool setThreadPC(pid_t tid, uint64_t pc);
+
+    protected:
+        Binary* binary;
+        uint32_t frequency;
+        pid_t pid;
+        uint64_t bias;
+
+        // the objects mapped into the process, refreshed at each dlopen and dlclose
+        ProcessImage* image;
+
+        std::map<pid_t, TraceThread> threads;
+        std::map<uint64_t, TraceBreakpoint> breakpoints;
+
+        /**
+         * Reads the program counter of a thread in a ptrace-stop
+         *
+         * @param tid the thread
+         * @param pc (out) its program counter, a run time address
+         * @return false if the registers of the thread cannot be read
+         */
+        static bool getThreadPC(pid_t tid, uint64_t& pc);
+
+        /**
+         * Reads the stack pointer of a thread in a ptrace-stop
+         *
+         * @param tid the thread
+         * @param sp (out) its stack pointer
+         * @return false if the registers of the thread cannot be read
+         */
+        static bool getThreadSP(pid_t tid, uint64_t& sp);
+
+        /**
+         * Stops every thread that is not already being stopped; each is passed to
+         * interrupted() when it reports the stop
+         */
+        void interrupt();
+
+        /**
+         * Sets breakpoints; each is passed to hit() when a thread reaches it
+         *
+         * @param addrs link time addresses of instructions
+         * @return false if the memory of the process cannot be written
+         */
+        bool insertBreakpoints(std::vector<uint64_t>& addrs);
+
+        /**
+         * Removes breakpoints. A removed breakpoint that has already been reached
+         * by a thread may still be passed to hit().
+         *
+         * @param addrs link time addresses of breakpoints
+         */
+        void removeBreakpoints(std::vector<uint64_t>& addrs);
+
+        // the process image is loaded: after the exec of a launched program, or on attach
+        virtual void started() {}
+
+        // a tick of the timer, if the frequency is not 0
+        virtual void tick() { interrupt(); }
+
+        // a thread stopped by interrupt()
+        virtual void interrupted(pid_t tid) {}
+
+        /**
+         * A thread reached a breakpoint
+         *
+         * @param tid the thread
+         * @param addr the link time address of the breakpoint
+         * @return true to leave the breakpoint in place, false to remove it
+         */
+        virtual bool hit(pid_t tid, uint64_t addr) { return false; }
+
+    public:
+        /**
+         * @param b the binary run by the process
+         * @param hz ticks per second, or 0 for no timer
+         */
+        Tracer(Binary* b, uint32_t hz);
+        virtual ~Tracer();
+
+        /**
+         * Checks whether a breakpoint can be kept in place when it is reached. Hosts
+         * without hardware single-step (32-bit ARM) remove a breakpoint at its first hit,
+         * whatever hit() returns.
+         *
+         * @return true if the host can step over a breakpoint
+         */
+        static bool canStepOver();
+
+        /**
+         * Starts a program under the tracer. It runs once run() is called.
+         *
+         * @param argv the program (found in $PATH) and its arguments, NULL-terminated
+         * @return false if the program cannot be started or traced
+         */
+        bool launch(char* argv[]);
+
+        /**
+         * Attaches to every thread of a running process
+         *
+         * @param p a process running the binary
+         * @return false if the process cannot be traced
+         */
+        bool attach(pid_t p);
+
+        /**
+         * Traces the process until it exits or until a time limit, after which its
+         * breakpoints are removed and it is detached and left running
+         *
+         * @param seconds the time limit, or 0 for none
+         * @return the exit status of the process (128 + the signal if it was killed), or -1 if it was detached
+         */
+        int32_t run(uint32_t seconds = 0);
+    }; // class Tracer
+
+} // namespace EPAX
+
+#endif // __EPAX_Tracer_hpp__
@@ -5,7 +5,7 @@ import sys
 import os
 import string
 
-objs = ['BIN', 'SECT', 'FUNC', 'CFG', 'LOOP', 'BBL', 'INSN', 'SYM', 'FLOW']
+objs = ['BIN', 'SECT', 'FUNC', 'CFG', 'LOOP', 'BBL', 'INSN', 'SYM', 'FLOW', 'SFILE']
 other = {}
 other['std::vector<std::string>&'] = 'char**'
 other['std::vector<const char*>&'] = 'char**'
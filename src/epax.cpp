@@ -23,35 +23,935 @@
  */
 
 #include "EPAX.hpp"
+#include "EPAXSamples.h"
 #include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
 #include <assert.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
 
 void error_out(char* prg, const char* msg){
     std::cerr << "error: " << msg << std::endl << std::endl;
     std::cerr << "usage: " << prg << " <path_to_executable> [<arg1> [<arg2>] ...]" << std::endl;
+    std::cerr << "       " << prg << " [-a <cputype>] [-c <cachedir>] [-d] [-k] [-l] [-q] [-j <jobs>] [-m <megabytes>] <path1> [<path2> ...]     (-k: only check that each can be analyzed)" << std::endl;
+    std::cerr << "       " << prg << " [-a <cputype>] [-c <cachedir>] [-d] [-k] [-l] [-q] [-j <jobs>] [-m <megabytes>] -     (read paths from stdin, one per line)" << std::endl;
+    std::cerr << "       " << prg << " -s <socket> [-m <megabytes>]     (serve queries; -m bounds resident binaries)" << std::endl;
+    std::cerr << "       " << prg << " profile [-f <hz>] [-t <seconds>] [-o <outfile>] <executable> [<arg1> ...]     (sample a run)" << std::endl;
+    std::cerr << "       " << prg << " profile [-f <hz>] [-t <seconds>] [-o <outfile>] -p <pid> <path_to_executable>     (sample a running process)" << std::endl;
+    std::cerr << "       " << prg << " resolve [-o <outfile>] [<samplefile>|-]     (histogram \"<binary> <address>\" samples)" << std::endl;
+    std::cerr << "       " << prg << " count [-n <maxhits>] [-t <seconds>] [-o <outfile>] <executable> [<arg1> ...]     (count block executions; -n 1 for coverage)" << std::endl;
+    std::cerr << "       " << prg << " count [-n <maxhits>] [-t <seconds>] [-o <outfile>] -p <pid> <path_to_executable>" << std::endl;
+    std::cerr << "       " << prg << " loops [-n <invocations>] [-t <seconds>] [-o <outfile>] <executable> [<arg1> ...]     (measure loop trip counts)" << std::endl;
+    std::cerr << "       " << prg << " loops [-n <invocations>] [-t <seconds>] [-o <outfile>] -p <pid> <path_to_executable>" << std::endl;
+    std::cerr << "       " << prg << " samples [-o <outfile>] <samplefile>     (histogram a file from LD_PRELOAD=libepaxsample.so)" << std::endl;
     exit(1);
 }
 
-int main(int argc, char** argv){
+// directory of the persistent analysis cache, or empty to use $EPAX_CACHE_DIR
+std::string cachedir;
+
+// Mach-O cpu type of the slice to analyze in universal files
+uint32_t slicecpu = EPAX_SLICE_DEFAULT;
+
+// also write <fname>.epaxdb, the memory-mappable analysis database
+bool writedb = false;
+
+// only check that the file can be analyzed (filling the cache, if any), writing no output
+bool checkonly = false;
+
+// decode whole text sections in one sweep
+bool linearsweep = false;
+
+// classify AArch64 instructions without the full disassembler; leaves out +str
+bool fastdecode = false;
 
-    const char* fname;
-    
-    if (argc != 2){
-        error_out(argv[0], "exactly one argument (a path to an executable/library) is required");
+// analyze a single file, or one member of an archive, writing <fname>.static
+void analyze(const char* fname, int32_t member){
+
+    // create a BIN
+    EPAX::BIN mybin;
+    if (member >= 0){
+        mybin = EPAX::BIN_createMember(fname, member, cachedir);
+    } else if (slicecpu != EPAX_SLICE_DEFAULT){
+        mybin = EPAX::BIN_createSlice(fname, slicecpu, cachedir);
+    } else if (cachedir.size() > 0){
+        mybin = EPAX::BIN_createCached(fname, cachedir);
     } else {
-        fname = argv[1];
+        mybin = EPAX::BIN_create(fname);
+    }
+    if (linearsweep){
+        EPAX::BIN_setLinearSweep(mybin, true);
+    }
+    if (fastdecode){
+        EPAX::BIN_setFastDecode(mybin, true);
     }
 
-    // create a BIN
-    EPAX::BIN mybin = EPAX::BIN_create(fname);
+    if (checkonly){
+        EPAX::BIN_countBbl(mybin);
+        EPAX::BIN_destroy(mybin);
+        return;
+    }
 
-    // print out static analysis of the BIN to a file
-    std::string sfname(fname);
+    // print out static analysis of the BIN to a file; a member's BIN is named archive(member)
+    std::string sfname(EPAX::BIN_getName(mybin));
     sfname.append(".static");
     EPAX::BIN_printStaticFile(mybin, sfname.c_str());
 
+    if (writedb){
+        std::string dfname(EPAX::BIN_getName(mybin));
+        dfname.append(".epaxdb");
+        EPAX::BIN_printDatabaseFile(mybin, dfname.c_str());
+    }
+
     // destroy the BIN
     EPAX::BIN_destroy(mybin);
 }
+
+/**
+ * Supplies the inputs for a batch, either from the command line or from
+ * stdin. Paths are handed out one at a time so that a long list on stdin
+ * is never held in memory all at once. A static archive is handed out as
+ * its members, one at a time, so that they are analyzed concurrently.
+ */
+class BatchInput {
+private:
+    std::vector<std::string> paths;
+    uint32_t next;
+    bool fromstdin;
+
+    std::string archive;
+    std::vector<std::string> members;
+    uint32_t nextmember;
+
+    bool getNextPath(std::string& p){
+        if (!fromstdin){
+            if (next < paths.size()){
+                p = paths[next++];
+                return true;
+            }
+            return false;
+        }
+
+        while (std::getline(std::cin, p)){
+            if (p.size() > 0){
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    BatchInput(bool s) : next(0), fromstdin(s), nextmember(0) {}
+
+    void add(std::string p) { paths.push_back(p); }
+
+    // member is the index of an archive member in p, or -1 if p is not an archive,
+    // and name is that member's name. An archive's member list is read once
+    bool getNext(std::string& p, int32_t& member, std::string& name){
+        while (nextmember == members.size()){
+            if (!getNextPath(p)){
+                return false;
+            }
+
+            // an unreadable path, or one that is not a regular file, is left for its worker to report
+            members.clear();
+            struct stat st;
+            if (stat(p.c_str(), &st) == 0 && S_ISREG(st.st_mode) && access(p.c_str(), R_OK) == 0){
+                EPAX::BIN_listMembers(p, members);
+            }
+            nextmember = 0;
+            if (members.size() == 0){
+                member = -1;
+                name.clear();
+                return true;
+            }
+            archive = p;
+        }
+
+        p = archive;
+        name = members[nextmember];
+        member = nextmember++;
+        return true;
+    }
+}; // class BatchInput
+
+/**
+ * Analyzes many binaries concurrently. Each input is handled by a forked worker so
+ * that a failure in one file (which terminates the worker via EPAXAssert) is reported
+ * and the rest of the batch continues. At most `jobs` workers run at once, and each
+ * worker's address space is capped at memlimit/jobs so that the batch as a whole
+ * stays under memlimit.
+ */
+int run_batch(BatchInput& input, uint32_t jobs, uint64_t memlimit){
+    std::map<pid_t, std::string> running;
+    uint32_t done = 0, failed = 0;
+    bool more = true;
+
+    rlim_t wlimit = RLIM_INFINITY;
+    if (memlimit > 0){
+        wlimit = (rlim_t)(memlimit / jobs);
+    }
+
+    while (more || running.size() > 0){
+
+        // keep every worker slot busy
+        while (more && running.size() < jobs){
+            std::string path, name;
+            int32_t member;
+            if (!input.getNext(path, member, name)){
+                more = false;
+                break;
+            }
+            std::string label = path;
+            if (member >= 0){
+                label = path + "(" + name + ")";
+            }
+
+            std::cout.flush();
+            std::cerr.flush();
+
+            pid_t pid = fork();
+            if (pid == 0){
+                if (wlimit != RLIM_INFINITY){
+                    struct rlimit rl;
+                    rl.rlim_cur = wlimit;
+                    rl.rlim_max = wlimit;
+                    setrlimit(RLIMIT_AS, &rl);
+                }
+                analyze(path.c_str(), member);
+                exit(0);
+            }
+
+            if (pid < 0){
+                std::cerr << "epax: [FAILED] " << label << " (cannot fork worker)" << std::endl;
+                failed++;
+                done++;
+                continue;
+            }
+            running[pid] = label;
+        }
+
+        if (running.size() == 0){
+            continue;
+        }
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0 || running.count(pid) == 0){
+            continue;
+        }
+
+        std::string path = running[pid];
+        running.erase(pid);
+        done++;
+
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0){
+            std::cerr << "epax: [ok] " << path << std::endl;
+        } else {
+            failed++;
+            std::cerr << "epax: [FAILED] " << path;
+            if (WIFEXITED(status)){
+                std::cerr << " (exit status " << std::dec << WEXITSTATUS(status) << ")";
+            } else if (WIFSIGNALED(status)){
+                std::cerr << " (killed by signal " << std::dec << WTERMSIG(status) << ")";
+            }
+            std::cerr << std::endl;
+        }
+    }
+
+    std::cerr << "epax: batch finished, " << std::dec << done << " binaries analyzed, " << failed << " failed" << std::endl;
+    return (failed == 0? 0: 1);
+}
+
+// addresses held, over all binaries, before they are sorted and resolved
+#define RESOLVE_BATCH (1 << 22)
+
+/**
+ * Sample histograms for one binary. The binary's blocks and functions are kept as
+ * arrays sorted by address, and the BIN itself is destroyed once they are built.
+ * Samples are buffered, then sorted and resolved in one merge over those arrays,
+ * so memory is bounded by the buffer and the size of the binary, not the number
+ * of samples.
+ */
+class ResolveTable {
+private:
+    // blocks, sorted by address
+    std::vector<uint64_t> bbladdrs;
+    std::vector<uint64_t> bblends;
+    std::vector<uint32_t> bblfuncs;
+    std::vector<uint32_t> bblids;
+    std::vector<uint32_t> bblloops;
+    std::vector<uint64_t> bblhits;
+
+    // functions, in index (and address) order
+    std::vector<uint64_t> funcaddrs;
+    std::vector<uint64_t> funcends;
+    std::vector<std::string> funcnames;
+    std::vector<uint64_t> funchits;
+
+    // (file offset, function) sorted by offset, and the size of each function
+    std::vector<std::pair<uint64_t, uint32_t> > funcoffsets;
+    std::vector<uint64_t> funcsizes;
+
+    std::map<std::pair<uint32_t, uint32_t>, uint64_t> loophits;
+
+    std::vector<uint64_t> pending;
+
+public:
+    std::string path;
+    bool valid;
+    uint64_t samples;
+    uint64_t unresolved;
+
+    ResolveTable(std::string p) : path(p), valid(false), samples(0), unresolved(0) {
+        // BIN_create exits on a file it cannot open, so don't let one bad path end the run
+        if (access(p.c_str(), R_OK) != 0){
+            std::cerr << "epax: cannot read " << p << "; its samples are unresolved" << std::endl;
+            return;
+        }
+        valid = true;
+
+        EPAX::BIN bin = EPAX::BIN_create(p);
+
+        // sizes are 64-bit end to end, so a function over 4GB keeps its whole range
+        uint32_t nfuncs = EPAX::BIN_countFunc(bin);
+        funcaddrs.resize(nfuncs);
+        funcsizes.resize(nfuncs);
+        if (nfuncs > 0){
+            EPAX::BIN_funcInfo(bin, &funcaddrs[0], &funcsizes[0], NULL, NULL);
+        }
+        for (uint32_t i = 0; i < nfuncs; i++){
+            funcends.push_back(funcaddrs[i] + funcsizes[i]);
+        }
+        for (EPAX::FUNC f = EPAX::BIN_firstFunc(bin); f != NULL; f = EPAX::BIN_nextFunc(bin, f)){
+            funcoffsets.push_back(std::make_pair(EPAX::FUNC_fileOffset(f), (uint32_t)funcnames.size()));
+            funcnames.push_back(EPAX::FUNC_name(f));
+        }
+        std::sort(funcoffsets.begin(), funcoffsets.end());
+        funchits.resize(nfuncs, 0);
+
+        uint32_t nbbls = EPAX::BIN_countBbl(bin);
+        std::vector<uint64_t> addrs(nbbls);
+        std::vector<uint64_t> sizes(nbbls);
+        std::vector<uint32_t> funcs(nbbls), loops(nbbls);
+        if (nbbls > 0){
+            EPAX::BIN_bblInfo(bin, &addrs[0], &sizes[0], NULL, &funcs[0], &loops[0]);
+        }
+        EPAX::BIN_destroy(bin);
+
+        // blocks come in function order; number them within their function, then sort
+        std::vector<std::pair<uint64_t, uint32_t> > order;
+        std::vector<uint32_t> ids(nbbls);
+        for (uint32_t i = 0, f = 0, first = 0; i < nbbls; i++){
+            if (funcs[i] != f){
+                f = funcs[i];
+                first = i;
+            }
+            ids[i] = i - first;
+            order.push_back(std::make_pair(addrs[i], i));
+        }
+        std::sort(order.begin(), order.end());
+
+        for (uint32_t i = 0; i < nbbls; i++){
+            uint32_t b = order[i].second;
+            bbladdrs.push_back(addrs[b]);
+            bblends.push_back(addrs[b] + sizes[b]);
+            bblfuncs.push_back(funcs[b]);
+            bblids.push_back(ids[b]);
+            bblloops.push_back(loops[b]);
+        }
+        bblhits.resize(nbbls, 0);
+    }
+
+    // returns whether addr was buffered for the next flush
+    bool add(uint64_t addr){
+        samples++;
+        if (!valid){
+            unresolved++;
+            return false;
+        }
+        pending.push_back(addr);
+        return true;
+    }
+
+    // adds a sample given by its offset in the file, e.g. from a mapping of the file
+    bool addOffset(uint64_t off){
+        if (valid){
+            std::vector<std::pair<uint64_t, uint32_t> >::const_iterator it = std::upper_bound(funcoffsets.begin(), funcoffsets.end(), std::make_pair(off, (uint32_t)-1));
+            if (it != funcoffsets.begin()){
+                it--;
+                uint32_t f = it->second;
+                if (off - it->first < funcsizes[f] || off == it->first){
+                    return add(funcaddrs[f] + (off - it->first));
+                }
+            }
+        }
+        samples++;
+        unresolved++;
+        return false;
+    }
+
+    uint64_t countPending() { return pending.size(); }
+
+    // resolves the buffered samples with a single merge against the blocks and functions
+    void flush(){
+        std::sort(pending.begin(), pending.end());
+
+        uint32_t b = 0, f = 0;
+        uint64_t n = pending.size();
+        for (uint64_t i = 0; i < n; ){
+            uint64_t a = pending[i];
+            uint64_t cnt = 1;
+            while (i + cnt < n && pending[i + cnt] == a){
+                cnt++;
+            }
+            i += cnt;
+
+            while (b < bbladdrs.size() && bbladdrs[b] <= a){
+                b++;
+            }
+            while (f < funcaddrs.size() && funcaddrs[f] <= a){
+                f++;
+            }
+
+            if (b > 0 && a < bblends[b - 1]){
+                bblhits[b - 1] += cnt;
+                funchits[bblfuncs[b - 1]] += cnt;
+                if (bblloops[b - 1] != EPAX_ID_NONE){
+                    loophits[std::make_pair(bblfuncs[b - 1], bblloops[b - 1])] += cnt;
+                }
+            } else if (f > 0 && (a < funcends[f - 1] || a == funcaddrs[f - 1])){
+                // between the blocks of a function, e.g. alignment padding
+                funchits[f - 1] += cnt;
+            } else {
+                unresolved += cnt;
+            }
+        }
+        pending.clear();
+    }
+
+    // writes the histograms, each sorted by decreasing sample count
+    void print(std::ostream& out){
+        out << "# binary " << path << std::endl;
+        out << "# samples " << std::dec << samples << " unresolved " << unresolved << std::endl;
+
+        std::vector<std::pair<uint64_t, uint32_t> > h;
+        for (uint32_t i = 0; i < funchits.size(); i++){
+            if (funchits[i] > 0){
+                h.push_back(std::make_pair(funchits[i], i));
+            }
+        }
+        std::sort(h.rbegin(), h.rend());
+        out << "# func <count> <func> <addr> <name>" << std::endl;
+        for (std::vector<std::pair<uint64_t, uint32_t> >::const_iterator it = h.begin(); it != h.end(); it++){
+            uint32_t i = it->second;
+            out << "func\t" << std::dec << it->first << "\t" << i << "\t0x" << std::hex << funcaddrs[i] << "\t" << funcnames[i] << std::endl;
+        }
+
+        h.clear();
+        for (uint32_t i = 0; i < bblhits.size(); i++){
+            if (bblhits[i] > 0){
+                h.push_back(std::make_pair(bblhits[i], i));
+            }
+        }
+        std::sort(h.rbegin(), h.rend());
+        out << "# bbl <count> <func> <bbl> <addr>" << std::endl;
+        for (std::vector<std::pair<uint64_t, uint32_t> >::const_iterator it = h.begin(); it != h.end(); it++){
+            uint32_t i = it->second;
+            out << "bbl\t" << std::dec << it->first << "\t" << bblfuncs[i] << "\t" << bblids[i] << "\t0x" << std::hex << bbladdrs[i] << std::endl;
+        }
+
+        std::vector<std::pair<uint64_t, std::pair<uint32_t, uint32_t> > > lh;
+        for (std::map<std::pair<uint32_t, uint32_t>, uint64_t>::const_iterator it = loophits.begin(); it != loophits.end(); it++){
+            lh.push_back(std::make_pair(it->second, it->first));
+        }
+        std::sort(lh.rbegin(), lh.rend());
+        out << "# loop <count> <func> <loop> <name>" << std::endl;
+        for (std::vector<std::pair<uint64_t, std::pair<uint32_t, uint32_t> > >::const_iterator it = lh.begin(); it != lh.end(); it++){
+            out << "loop\t" << std::dec << it->first << "\t" << it->second.first << "\t" << it->second.second << "\t" << funcnames[it->second.first] << std::endl;
+        }
+    }
+}; // class ResolveTable
+
+/**
+ * Sorts samples from any number of binaries into a ResolveTable per binary, and
+ * resolves them whenever RESOLVE_BATCH samples are buffered.
+ */
+class Resolver {
+private:
+    std::map<std::string, ResolveTable*> tables;
+    std::vector<ResolveTable*> order;
+    ResolveTable* last;
+    uint64_t pending;
+
+    ResolveTable* getTable(const char* path){
+        // samples usually come in runs from one binary
+        if (last != NULL && last->path == path){
+            return last;
+        }
+        std::map<std::string, ResolveTable*>::const_iterator it = tables.find(path);
+        if (it == tables.end()){
+            last = new ResolveTable(path);
+            tables[path] = last;
+            order.push_back(last);
+        } else {
+            last = it->second;
+        }
+        return last;
+    }
+
+    void buffered(){
+        if (++pending >= RESOLVE_BATCH){
+            for (std::vector<ResolveTable*>::const_iterator it = order.begin(); it != order.end(); it++){
+                (*it)->flush();
+            }
+            pending = 0;
+        }
+    }
+
+public:
+    Resolver() : last(NULL), pending(0) {}
+
+    ~Resolver(){
+        for (std::vector<ResolveTable*>::const_iterator it = order.begin(); it != order.end(); it++){
+            delete (*it);
+        }
+    }
+
+    void add(const char* path, uint64_t addr){
+        if (getTable(path)->add(addr)){
+            buffered();
+        }
+    }
+
+    void addOffset(const char* path, uint64_t off){
+        if (getTable(path)->addOffset(off)){
+            buffered();
+        }
+    }
+
+    void print(std::ostream& out){
+        for (std::vector<ResolveTable*>::const_iterator it = order.begin(); it != order.end(); it++){
+            (*it)->flush();
+            (*it)->print(out);
+        }
+    }
+}; // class Resolver
+
+/**
+ * Aggregates "<binary> <address>" sample lines into per-binary histograms. Addresses
+ * may be hex (0x...) or decimal; blank lines and lines starting with # are skipped.
+ */
+int run_resolve(FILE* in, std::ostream& out){
+    Resolver resolver;
+    uint64_t bad = 0;
+
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &cap, in)) > 0){
+        char* p = line;
+        while (*p == ' ' || *p == '\t'){
+            p++;
+        }
+        if (*p == '\0' || *p == '\n' || *p == '#'){
+            continue;
+        }
+
+        char* name = p;
+        while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\n'){
+            p++;
+        }
+        if (*p != ' ' && *p != '\t'){
+            bad++;
+            continue;
+        }
+        *p++ = '\0';
+
+        char* end;
+        uint64_t addr = strtoull(p, &end, 0);
+        if (end == p){
+            bad++;
+            continue;
+        }
+
+        resolver.add(name, addr);
+    }
+    free(line);
+
+    resolver.print(out);
+
+    if (bad > 0){
+        std::cerr << "epax: skipped " << std::dec << bad << " malformed sample lines" << std::endl;
+    }
+    return 0;
+}
+
+// an executable file mapping, from a EPAX_SAMPLES_MAPS record
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    uint64_t offset;
+    std::string path;
+} SampleMapping;
+
+static bool read_record(std::ifstream& in, EPAX_samples_record& rec){
+    in.read((char*)&rec, sizeof(rec));
+    return in.good() && rec.type > 0 && rec.type < EPAX_SAMPLES_total;
+}
+
+static void read_maps(const std::string& text, std::map<uint64_t, SampleMapping>& maps){
+    std::stringstream ss(text);
+    std::string line;
+    while (std::getline(ss, line)){
+        unsigned long long start, end, offset;
+        char perms[8];
+        int pathpos = -1;
+        if (sscanf(line.c_str(), "%llx-%llx %7s %llx %*s %*s %n", &start, &end, perms, &offset, &pathpos) < 4 || pathpos < 0){
+            continue;
+        }
+        if (strchr(perms, 'x') == NULL || line[pathpos] != '/'){
+            continue;
+        }
+
+        SampleMapping m;
+        m.start = start;
+        m.end = end;
+        m.offset = offset;
+        m.path = line.substr(pathpos);
+        maps[m.start] = m;
+    }
+}
+
+/**
+ * Aggregates a file written by libepaxsample.so into per-binary histograms. Each
+ * sample is located in the file mapped at its address, and resolved by its offset
+ * in that file, so it does not matter where the file was loaded.
+ */
+int run_samples(const char* fname, std::ostream& out){
+    std::ifstream in(fname, std::ios::binary);
+    if (!in.is_open()){
+        std::cerr << "epax: cannot open " << fname << std::endl;
+        return 1;
+    }
+
+    EPAX_samples_header hdr;
+    in.read((char*)&hdr, sizeof(hdr));
+    if (!in.good() || hdr.magic != EPAX_SAMPLES_MAGIC || hdr.version != EPAX_SAMPLES_VERSION){
+        std::cerr << "epax: " << fname << " is not a sample file written by libepaxsample.so" << std::endl;
+        return 1;
+    }
+
+    // the mappings are written after the samples, so they are gathered first
+    std::map<uint64_t, SampleMapping> maps;
+    EPAX_samples_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    EPAX_samples_record rec;
+    while (read_record(in, rec)){
+        if (rec.type == EPAX_SAMPLES_MAPS){
+            std::string text(rec.size, '\0');
+            in.read(&text[0], rec.size);
+            read_maps(text, maps);
+        } else if (rec.type == EPAX_SAMPLES_STATS && rec.size >= sizeof(stats)){
+            in.read((char*)&stats, sizeof(stats));
+            in.seekg(rec.size - sizeof(stats), std::ios::cur);
+        } else {
+            in.seekg(rec.size, std::ios::cur);
+        }
+    }
+    if (maps.empty()){
+        std::cerr << "epax: " << fname << " has no mappings; was the program stopped before it exited?" << std::endl;
+        return 1;
+    }
+
+    in.clear();
+    in.seekg(sizeof(hdr));
+
+    Resolver resolver;
+    uint64_t unmapped = 0;
+    std::vector<uint64_t> pcs;
+    while (read_record(in, rec)){
+        if (rec.type != EPAX_SAMPLES_PCS){
+            in.seekg(rec.size, std::ios::cur);
+            continue;
+        }
+        pcs.resize(rec.size / sizeof(uint64_t));
+        if (pcs.size() > 0){
+            in.read((char*)&pcs[0], pcs.size() * sizeof(uint64_t));
+        }
+        for (std::vector<uint64_t>::const_iterator it = pcs.begin(); it != pcs.end(); it++){
+            uint64_t pc = (*it);
+            std::map<uint64_t, SampleMapping>::const_iterator m = maps.upper_bound(pc);
+            if (m == maps.begin() || pc >= (--m)->second.end){
+                unmapped++;
+                continue;
+            }
+            resolver.addOffset(m->second.path.c_str(), pc - m->second.start + m->second.offset);
+        }
+    }
+
+    out << "# pid " << std::dec << hdr.pid << " rate " << hdr.hz << "Hz threads " << stats.threads << " dropped " << stats.dropped << " unmapped " << unmapped << std::endl;
+    resolver.print(out);
+    return 0;
+}
+
+int resolve_main(int argc, char** argv, char* prg){
+    std::string outname;
+
+    int c;
+    while ((c = getopt(argc, argv, "o:")) != -1){
+        switch (c){
+        case 'o':
+            outname = optarg;
+            break;
+        default:
+            error_out(prg, "unknown option");
+        }
+    }
+
+    FILE* in = stdin;
+    if (optind < argc && std::string(argv[optind]) != "-"){
+        in = fopen(argv[optind], "r");
+        if (in == NULL){
+            error_out(prg, "cannot open the sample file");
+        }
+    }
+
+    int ret;
+    if (outname.size() > 0){
+        std::ofstream out(outname.c_str());
+        if (!out.is_open()){
+            error_out(prg, "cannot open the output file");
+        }
+        ret = run_resolve(in, out);
+    } else {
+        ret = run_resolve(in, std::cout);
+    }
+
+    if (in != stdin){
+        fclose(in);
+    }
+    return ret;
+}
+
+int samples_main(int argc, char** argv, char* prg){
+    std::string outname;
+
+    int c;
+    while ((c = getopt(argc, argv, "o:")) != -1){
+        switch (c){
+        case 'o':
+            outname = optarg;
+            break;
+        default:
+            error_out(prg, "unknown option");
+        }
+    }
+
+    if (optind + 1 != argc){
+        error_out(prg, "samples requires one sample file");
+    }
+
+    if (outname.size() > 0){
+        std::ofstream out(outname.c_str());
+        if (!out.is_open()){
+            error_out(prg, "cannot open the output file");
+        }
+        return run_samples(argv[optind], out);
+    }
+    return run_samples(argv[optind], std::cout);
+}
+
+typedef enum {
+    TraceMode_profile = 0,
+    TraceMode_count,
+    TraceMode_loops
+} TraceMode;
+
+// profile (sampling), count (block counting) or measure the loop trip counts of a process
+int trace_main(int argc, char** argv, char* prg, TraceMode mode){
+    uint32_t hz = 0;
+    uint32_t maxhits = 0;
+    uint32_t invocations = 0;
+    uint32_t seconds = 0;
+    uint32_t pid = 0;
+    std::string outname;
+
+    // stop at the first path, so that the options of the traced program are left alone
+    int c;
+    while ((c = getopt(argc, argv, (mode == TraceMode_profile? "+f:o:p:t:": "+n:o:p:t:"))) != -1){
+        switch (c){
+        case 'f':
+            hz = strtoul(optarg, NULL, 0);
+            if (hz == 0){
+                error_out(prg, "-f requires a positive sampling rate");
+            }
+            break;
+        case 'n':
+            if (mode == TraceMode_loops){
+                invocations = strtoul(optarg, NULL, 0);
+                if (invocations == 0){
+                    error_out(prg, "-n requires a positive number of invocations");
+                }
+            } else {
+                maxhits = strtoul(optarg, NULL, 0);
+            }
+            break;
+        case 'o':
+            outname = optarg;
+            break;
+        case 'p':
+            pid = strtoul(optarg, NULL, 0);
+            if (pid == 0){
+                error_out(prg, "-p requires a process id");
+            }
+            break;
+        case 't':
+            seconds = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            error_out(prg, "unknown option");
+        }
+    }
+
+    if (optind >= argc){
+        error_out(prg, "a path to an executable is required");
+    }
+    if (pid && optind + 1 != argc){
+        error_out(prg, "-p takes the path of the process's executable and no arguments");
+    }
+
+    EPAX::BIN mybin = EPAX::BIN_create(argv[optind]);
+    int32_t ret;
+    if (mode == TraceMode_count){
+        ret = EPAX::BIN_countBbls(mybin, pid, argv + optind, maxhits, seconds, outname);
+    } else if (mode == TraceMode_loops){
+        ret = EPAX::BIN_profileLoops(mybin, pid, argv + optind, invocations, seconds, outname);
+    } else {
+        ret = EPAX::BIN_profile(mybin, pid, argv + optind, hz, seconds, outname);
+    }
+    EPAX::BIN_destroy(mybin);
+
+    return (ret < 0? 1: ret);
+}
+
+int main(int argc, char** argv){
+
+    if (argc > 1 && std::string(argv[1]) == "resolve"){
+        return resolve_main(argc - 1, argv + 1, argv[0]);
+    }
+    if (argc > 1 && std::string(argv[1]) == "samples"){
+        return samples_main(argc - 1, argv + 1, argv[0]);
+    }
+    if (argc > 1 && std::string(argv[1]) == "profile"){
+        return trace_main(argc - 1, argv + 1, argv[0], TraceMode_profile);
+    }
+    if (argc > 1 && std::string(argv[1]) == "count"){
+        return trace_main(argc - 1, argv + 1, argv[0], TraceMode_count);
+    }
+    if (argc > 1 && std::string(argv[1]) == "loops"){
+        return trace_main(argc - 1, argv + 1, argv[0], TraceMode_loops);
+    }
+
+    uint32_t jobs = 0;
+    uint64_t memlimit = 0;
+    bool batch = false;
+    std::string socketpath;
+
+    int c;
+    while ((c = getopt(argc, argv, "a:c:dj:klm:qs:")) != -1){
+        switch (c){
+        case 'a':
+            slicecpu = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            cachedir = optarg;
+            break;
+        case 'd':
+            writedb = true;
+            break;
+        case 'k':
+            checkonly = true;
+            break;
+        case 'j':
+            jobs = strtoul(optarg, NULL, 0);
+            if (jobs == 0){
+                error_out(argv[0], "-j requires a positive number of jobs");
+            }
+            batch = true;
+            break;
+        case 'l':
+            linearsweep = true;
+            break;
+        case 'q':
+            fastdecode = true;
+            break;
+        case 'm':
+            memlimit = strtoull(optarg, NULL, 0) * 1024 * 1024;
+            batch = true;
+            break;
+        case 's':
+            socketpath = optarg;
+            break;
+        default:
+            error_out(argv[0], "unknown option");
+        }
+    }
+
+    if (socketpath.size() > 0){
+        if (optind != argc){
+            error_out(argv[0], "-s takes no paths; clients name binaries over the socket");
+        }
+        // new binaries are checked by running this same program with -k
+        char self[PATH_MAX];
+        ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+        std::string prog;
+        if (len > 0){
+            prog = std::string(self, len);
+        }
+        return (EPAX::EPAX_serve(socketpath, memlimit, prog)? 0: 1);
+    }
+
+    int npaths = argc - optind;
+    if (npaths < 1){
+        error_out(argv[0], "at least one argument (a path to an executable/library) is required");
+    }
+
+    bool fromstdin = (npaths == 1 && std::string(argv[optind]) == "-");
+    if (npaths > 1 || fromstdin){
+        batch = true;
+    }
+
+    // the members of an archive are analyzed as a batch
+    if (!batch && EPAX::BIN_countMembers(argv[optind]) == 0){
+        analyze(argv[optind], -1);
+        return 0;
+    }
+
+    if (jobs == 0){
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = (n > 0? (uint32_t)n: 1);
+    }
+
+    BatchInput input(fromstdin);
+    if (!fromstdin){
+        for (int i = optind; i < argc; i++){
+            input.add(argv[i]);
+        }
+    }
+
+    return run_batch(input, jobs, memlimit);
+}
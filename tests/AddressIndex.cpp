@@ -0,0 +1,121 @@
+/**
+ * @file AddressIndex.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ *
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+// builds address indices from overlapping, nested, adjacent and empty ranges, and
+// lists which range each address resolves to
+
+#include "EPAXCommonInternal.hpp"
+
+#include "DataStruct.hpp"
+
+using namespace EPAX;
+
+typedef struct {
+    const char* name;
+} Named;
+
+static Named a = { "a" };
+static Named b = { "b" };
+static Named c = { "c" };
+static Named d = { "d" };
+
+static void lookup(const AddressIndex<Named>& index, uint64_t addr){
+    Named* n = index.find(addr);
+    std::cout << TAB << HEX(addr) << TAB << (IS_VALID_PTR(n)? n->name: "-") << ENDL;
+}
+
+static void lookupAll(const char* what, const AddressIndex<Named>& index, const uint64_t* addrs, uint32_t count){
+    std::cout << what << TAB << "segments " << DEC(index.countSegments()) << ENDL;
+    for (uint32_t i = 0; i < count; i++){
+        lookup(index, addrs[i]);
+    }
+}
+
+int main(int argc, char** argv){
+    {
+        AddressIndex<Named> index;
+        index.build();
+        const uint64_t addrs[] = { 0, 0x1000 };
+        lookupAll("empty", index, addrs, 2);
+    }
+    {
+        // the ends are exclusive, and the gap between the ranges resolves to nothing
+        AddressIndex<Named> index;
+        index.add(0x2000, 0x3000, &b);
+        index.add(0x1000, 0x1800, &a);
+        index.build();
+        const uint64_t addrs[] = { 0xfff, 0x1000, 0x17ff, 0x1800, 0x1fff, 0x2000, 0x2fff, 0x3000 };
+        lookupAll("disjoint", index, addrs, 8);
+    }
+    {
+        // where ranges overlap, the one added first owns the overlap
+        AddressIndex<Named> index;
+        index.add(0x1000, 0x2000, &a);
+        index.add(0x1800, 0x2800, &b);
+        index.build();
+        const uint64_t addrs[] = { 0x17ff, 0x1800, 0x1fff, 0x2000, 0x27ff, 0x2800 };
+        lookupAll("overlap first", index, addrs, 6);
+    }
+    {
+        AddressIndex<Named> index;
+        index.add(0x1800, 0x2800, &b);
+        index.add(0x1000, 0x2000, &a);
+        index.build();
+        const uint64_t addrs[] = { 0x17ff, 0x1800, 0x1fff, 0x2000, 0x27ff, 0x2800 };
+        lookupAll("overlap second", index, addrs, 6);
+    }
+    {
+        // an inner range added before the outer one shows, and the outer one resumes
+        // after it; an inner range added after the outer one is hidden
+        AddressIndex<Named> index;
+        index.add(0x1400, 0x1800, &b);
+        index.add(0x1000, 0x2000, &a);
+        index.add(0x1100, 0x1200, &c);
+        index.build();
+        const uint64_t addrs[] = { 0x1000, 0x1100, 0x13ff, 0x1400, 0x17ff, 0x1800, 0x1fff, 0x2000 };
+        lookupAll("nested", index, addrs, 8);
+    }
+    {
+        // adjacent ranges of one object are one segment; an empty range covers its start
+        AddressIndex<Named> index;
+        index.add(0x1000, 0x1100, &a);
+        index.add(0x1100, 0x1200, &a);
+        index.add(0x1200, 0x1300, &b);
+        index.add(0x2000, 0x2000, &d);
+        index.build();
+        const uint64_t addrs[] = { 0x10ff, 0x1100, 0x11ff, 0x1200, 0x1fff, 0x2000, 0x2001 };
+        lookupAll("adjacent", index, addrs, 7);
+    }
+    {
+        // the top of the address space
+        AddressIndex<Named> index;
+        index.add(0xfffffffffffff000ULL, 0xffffffffffffffffULL, &a);
+        index.add(0, 0x10, &b);
+        index.build();
+        const uint64_t addrs[] = { 0, 0xf, 0x10, 0xfffffffffffff000ULL, 0xfffffffffffffffeULL, 0xffffffffffffffffULL };
+        lookupAll("edges", index, addrs, 6);
+    }
+    return 0;
+}
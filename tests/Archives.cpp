@@ -0,0 +1,58 @@
+/**
+ * @file Archives.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ *
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+// lists the members of the archive samples, with the contents of each
+
+#include "EPAXCommonInternal.hpp"
+
+#include "Archive.hpp"
+#include "InputFile.hpp"
+
+using namespace EPAX;
+
+static void listMembers(std::string path){
+    std::cout << path << TAB << "archive " << DEC(Archive::isArchive(path)) << ENDL;
+    if (!Archive::isArchive(path)){
+        return;
+    }
+
+    Archive ar(path);
+    InputFile in(path);
+    for (uint32_t i = 0; i < ar.countMembers(); i++){
+        ArchiveMember* m = ar.getMember(i);
+        std::string contents(m->size, '\0');
+        if (m->size > 0){
+            in.getBytes(m->offset, m->size, (rawbyte_t*)&contents[0]);
+        }
+        std::cout << "member" << TAB << m->name << TAB << DEC(m->offset) << TAB << DEC(m->size) << TAB << contents;
+    }
+}
+
+int main(int argc, char** argv){
+    for (int i = 1; i < argc; i++){
+        listMembers(argv[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file Database.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ *
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// checks that EPAX_db_validate accepts a well-formed database and rejects each
+// kind of damage that would let a reader leave a table
+
+#include "EPAXDatabase.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+// a database of two functions, with three blocks, three instructions and one loop
+typedef struct {
+    EPAX_db_header header;
+    EPAX_db_func funcs[2];
+    EPAX_db_bbl bbls[3];
+    EPAX_db_insn insns[3];
+    EPAX_db_loop loops[1];
+    uint64_t targets[1];
+    uint32_t edges[2];
+    uint32_t members[2];
+    char strings[16];
+} TestDatabase;
+
+#define EXTENT(__t__, __field__) \
+    db.header.tables[__t__].offset = offsetof(TestDatabase, __field__); \
+    db.header.tables[__t__].count = sizeof(db.__field__) / sizeof(db.__field__[0]);
+
+static void makeDatabase(TestDatabase& db){
+    memset(&db, 0, sizeof(db));
+    memcpy(db.header.magic, EPAX_DB_MAGIC, EPAX_DB_MAGIC_SIZE);
+    db.header.version = EPAX_DB_VERSION;
+    db.header.headersize = sizeof(EPAX_db_header);
+    db.header.appname = 1;
+    EXTENT(EPAX_db_table_func, funcs);
+    EXTENT(EPAX_db_table_bbl, bbls);
+    EXTENT(EPAX_db_table_insn, insns);
+    EXTENT(EPAX_db_table_loop, loops);
+    EXTENT(EPAX_db_table_target, targets);
+    EXTENT(EPAX_db_table_edge, edges);
+    EXTENT(EPAX_db_table_member, members);
+    EXTENT(EPAX_db_table_string, strings);
+    strcpy(db.strings + 1, "app");
+    strcpy(db.strings + 5, "main");
+
+    // main: a block that loops to itself, then a block that calls the second function,
+    // which is one block of one instruction
+    db.funcs[0].addr = 0x1000;
+    db.funcs[0].size = 0x10;
+    db.funcs[0].name = 5;
+    db.funcs[0].bblcount = 2;
+    db.funcs[0].insncount = 2;
+    db.funcs[0].loopcount = 1;
+    db.funcs[1].addr = 0x1010;
+    db.funcs[1].size = 0x4;
+    db.funcs[1].firstbbl = 2;
+    db.funcs[1].bblcount = 1;
+    db.funcs[1].firstinsn = 2;
+    db.funcs[1].insncount = 1;
+    db.funcs[1].firstloop = 1;
+
+    db.bbls[0].addr = 0x1000;
+    db.bbls[0].loop = 0;
+    db.bbls[0].insncount = 1;
+    db.bbls[0].edgecount = 2;
+    db.bbls[1].addr = 0x1008;
+    db.bbls[1].loop = EPAX_DB_NONE;
+    db.bbls[1].firstinsn = 1;
+    db.bbls[1].insncount = 1;
+    db.bbls[1].firstedge = 2;
+    db.bbls[2].addr = 0x1010;
+    db.bbls[2].func = 1;
+    db.bbls[2].loop = EPAX_DB_NONE;
+    db.bbls[2].firstinsn = 2;
+    db.bbls[2].insncount = 1;
+    db.bbls[2].firstedge = 2;
+
+    db.insns[0].addr = 0x1000;
+    db.insns[0].size = 8;
+    db.insns[0].targetcount = 1;
+    db.insns[1].addr = 0x1008;
+    db.insns[1].bbl = 1;
+    db.insns[1].size = 8;
+    db.insns[1].calltarget = 0x1010;
+    db.insns[1].firsttarget = 1;
+    db.insns[2].addr = 0x1010;
+    db.insns[2].bbl = 2;
+    db.insns[2].func = 1;
+    db.insns[2].size = 4;
+    db.insns[2].firsttarget = 1;
+
+    db.loops[0].membercount = 1;
+    db.loops[0].parent = EPAX_DB_NONE;
+
+    db.targets[0] = 0x1000;
+    db.edges[0] = 0;
+    db.edges[1] = 1;
+    db.members[0] = 0;
+    db.members[1] = 1;
+}
+
+static void check(const char* what, TestDatabase& db, uint64_t size = sizeof(TestDatabase)){
+    printf("%s\t%u\n", what, EPAX_db_validate((const uint8_t*)&db, size));
+}
+
+int main(int argc, char** argv){
+    TestDatabase db;
+
+    makeDatabase(db);
+    check("valid", db);
+    check("truncated header", db, sizeof(EPAX_db_header) - 1);
+    check("truncated tables", db, offsetof(TestDatabase, strings));
+
+    makeDatabase(db);
+    db.header.magic[0] = 'X';
+    check("magic", db);
+
+    makeDatabase(db);
+    db.header.version = EPAX_DB_VERSION + 1;
+    check("version", db);
+
+    makeDatabase(db);
+    db.header.headersize--;
+    check("header size", db);
+
+    makeDatabase(db);
+    db.header.tables[EPAX_db_table_insn].offset = sizeof(TestDatabase) + 1;
+    check("table offset", db);
+
+    makeDatabase(db);
+    db.strings[sizeof(db.strings) - 1] = 'x';
+    check("unterminated strings", db);
+
+    makeDatabase(db);
+    db.header.tables[EPAX_db_table_string].count = 0;
+    check("no strings", db);
+
+    makeDatabase(db);
+    db.funcs[1].bblcount = 2;
+    check("function blocks", db);
+
+    makeDatabase(db);
+    db.funcs[0].firstinsn = 0xffffffff;
+    db.funcs[0].insncount = 2;
+    check("function insns wrap", db);
+
+    makeDatabase(db);
+    db.funcs[1].addr = 0x800;
+    check("function order", db);
+
+    makeDatabase(db);
+    db.bbls[1].func = 2;
+    check("block function", db);
+
+    makeDatabase(db);
+    db.bbls[1].loop = 1;
+    check("block loop", db);
+
+    makeDatabase(db);
+    db.bbls[0].edgecount = 3;
+    check("block edges", db);
+
+    makeDatabase(db);
+    db.insns[2].bbl = 3;
+    check("insn block", db);
+
+    makeDatabase(db);
+    db.insns[0].targetcount = 2;
+    check("insn targets", db);
+
+    makeDatabase(db);
+    db.loops[0].head = 3;
+    check("loop head", db);
+
+    makeDatabase(db);
+    db.loops[0].parent = 1;
+    check("loop parent", db);
+
+    makeDatabase(db);
+    db.loops[0].membercount = 3;
+    check("loop members", db);
+
+    makeDatabase(db);
+    db.edges[1] = 3;
+    check("edge", db);
+
+    makeDatabase(db);
+    db.members[1] = EPAX_DB_NONE;
+    check("member", db);
+
+    return 0;
+}
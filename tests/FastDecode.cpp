@@ -0,0 +1,148 @@
+/**
+ * @file FastDecode.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ *
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+// classifies AArch64 instructions from the decode table, one or more for each of
+// its rows, and lists what the table gives for each
+
+#include "EPAXCommonInternal.hpp"
+
+#include "FastInstruction.hpp"
+
+using namespace EPAX;
+
+typedef struct {
+    uint32_t word;
+    const char* text;
+} FastDecodeSample;
+
+// encodings from llvm-mc -triple=aarch64 -mattr=+v8.3a,+sve,+fullfp16,+lse
+static const FastDecodeSample samples[] = {
+    { 0xa9bf7bfd, "stp x29, x30, [sp, #-16]!" },
+    { 0x29400801, "ldp w1, w2, [x0]" },
+    { 0xad400400, "ldp q0, q1, [x0]" },
+    { 0xb9400001, "ldr w1, [x0]" },
+    { 0xf9400401, "ldr x1, [x0, #8]" },
+    { 0x39400001, "ldrb w1, [x0]" },
+    { 0xb9800402, "ldrsw x2, [x0, #4]" },
+    { 0x3dc00400, "ldr q0, [x0, #16]" },
+    { 0xfd400000, "ldr d0, [x0]" },
+    { 0xbd000000, "str s0, [x0]" },
+    { 0x79000001, "strh w1, [x0]" },
+    { 0x58000089, "ldr x9, #16" },
+    { 0x5c000089, "ldr d9, #16" },
+    { 0x4c407801, "ld1 { v1.4s }, [x0]" },
+    { 0x0c007001, "st1 { v1.8b }, [x0]" },
+    { 0xc85f7c01, "ldxr x1, [x0]" },
+    { 0x889ffc01, "stlr w1, [x0]" },
+    { 0xf8210002, "ldadd x1, x2, [x0]" },
+    { 0xf9800000, "prfm pldl1keep, [x0]" },
+    { 0x4e21d402, "fadd v2.4s, v0.4s, v1.4s" },
+    { 0x4e61d402, "fadd v2.2d, v0.2d, v1.2d" },
+    { 0x1e652883, "fadd d3, d4, d5" },
+    { 0x1e252883, "fadd s3, s4, s5" },
+    { 0x1ee52883, "fadd h3, h4, h5" },
+    { 0x4e6684a4, "add v4.8h, v5.8h, v6.8h" },
+    { 0x5ee684a4, "add d4, d5, d6" },
+    { 0x8b050083, "add x3, x4, x5" },
+    { 0x11000483, "add w3, w4, #1" },
+    { 0x10000041, "adr x1, #8" },
+    { 0xb0000008, "adrp x8, #4096" },
+    { 0x17fffffe, "b #-8" },
+    { 0x94000040, "bl #256" },
+    { 0x54ffffe1, "b.ne #-4" },
+    { 0x5400002f, "b.nv #4" },
+    { 0xb4000041, "cbz x1, #8" },
+    { 0x35ffffc1, "cbnz w1, #-8" },
+    { 0x36180061, "tbz w1, #3, #12" },
+    { 0xb747ffa1, "tbnz x1, #40, #-12" },
+    { 0xd65f03c0, "ret" },
+    { 0xd65f0bff, "retaa" },
+    { 0xd69f03e0, "eret" },
+    { 0xd63f0020, "blr x1" },
+    { 0xd61f0200, "br x16" },
+    { 0xd4000001, "svc #0" },
+    { 0xd503201f, "nop" },
+    { 0x2598e3e0, "ptrue p0.s" },
+    { 0x00000000, "udf #0" },
+};
+
+#define SAMPLE_COUNT (sizeof(samples) / sizeof(samples[0]))
+#define SAMPLE_ADDR (0x10000)
+
+int main(int argc, char** argv){
+    // instructions are little-endian in memory
+    rawbyte_t buf[SAMPLE_COUNT * 4];
+    for (uint32_t i = 0; i < SAMPLE_COUNT; i++){
+        for (uint32_t j = 0; j < 4; j++){
+            buf[i * 4 + j] = (samples[i].word >> (8 * j)) & 0xff;
+        }
+    }
+
+    std::vector<Instruction*> insns;
+    fastmap<uint64_t, uint32_t>::map insn_map;
+    FastInstruction::classify(buf, SAMPLE_ADDR, sizeof(buf), insns, insn_map, INVALID_PTR);
+
+    std::cout << "# <address> <text> <flags> <targets> <register bits> <data bits> <groups>" << ENDL;
+    for (uint32_t i = 0; i < insns.size(); i++){
+        Instruction* insn = insns[i];
+        std::cout << HEX(insn->getMemoryAddress()) << TAB << samples[i].text << TAB;
+
+        std::string flags;
+        if (insn->isConditionalBranch()) flags += "cond,";
+        if (insn->isUnconditionalBranch()) flags += "uncond,";
+        if (insn->isCall()) flags += "call,";
+        if (insn->isReturn()) flags += "ret,";
+        if (insn->touchesPC()) flags += "pc,";
+        if (insn->isLoad()) flags += "load,";
+        if (insn->isStore()) flags += "store,";
+        if (insn->isFpop()) flags += "fp,";
+        if (insn->getCondition() != PredCondition_AL) flags += std::string(insn->getConditionName()) + ",";
+        std::cout << (flags.empty()? "-": flags.substr(0, flags.size() - 1)) << TAB;
+
+        // the fallthrough of an instruction that is not a branch is left out
+        std::vector<uint64_t> tgts;
+        if (insn->isBranch()){
+            insn->getControlTargets(tgts);
+        }
+        if (insn->isCall() && insn->getBranchTarget() != INVALID_ADDRESS){
+            tgts.push_back(insn->getBranchTarget());
+        }
+        for (uint32_t j = 0; j < tgts.size(); j++){
+            std::cout << (j? ",": "") << HEX(tgts[j]);
+        }
+        std::cout << (tgts.empty()? "-": "") << TAB;
+
+        std::cout << DEC(insn->getSourceRegisterSizeInBits()) << TAB << DEC(insn->getSourceDatatypeSizeInBits()) << TAB;
+
+        std::vector<std::string> groups;
+        insn->getGroupNames(groups);
+        for (uint32_t j = 0; j < groups.size(); j++){
+            std::cout << (j? ",": "") << groups[j];
+        }
+        std::cout << (groups.empty()? "-": "") << ENDL;
+        delete insn;
+    }
+    return 0;
+}
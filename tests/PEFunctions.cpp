@@ -0,0 +1,72 @@
+/**
+ * @file PEFunctions.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ *
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// lists the exports, .pdata entries and functions of the PE samples
+
+#include "EPAXCommonInternal.hpp"
+
+#include "Function.hpp"
+#include "PEBinary.hpp"
+
+using namespace EPAX;
+using namespace EPAX::PE;
+
+static void listFunctions(std::string path){
+    PEBinary bin(path);
+    if (!bin.verify()){
+        std::cout << path << ": not a PE image" << ENDL;
+        return;
+    }
+    std::cout << path << TAB << "machine " << HEX(bin.getMachine()) << TAB << "base " << HEX(bin.getImageBase())
+              << TAB << "entry " << HEX(bin.getStartAddr()) << ENDL;
+
+    for (uint32_t i = 0; i < bin.countSymbolTables(); i++){
+        SymbolTable* st = bin.getSymbolTable(i);
+        for (uint32_t j = 0; j < st->countSymbols(); j++){
+            PESymbol* s = (PESymbol*)st->getSymbol(j);
+            if (s->isExported()){
+                std::cout << "export" << TAB << s->getName() << TAB << (s->isFunction()? "code": "forward");
+                if (s->isFunction()){
+                    std::cout << TAB << HEX(s->getFunctionAddress()) << (s->isThumbFunction()? TAB "thumb": "");
+                }
+                std::cout << ENDL;
+            }
+            if (s->isFunction() && s->getLength()){
+                std::cout << "pdata" << TAB << HEX(s->getFunctionAddress()) << TAB << HEX(s->getLength()) << ENDL;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < bin.countFunctions(); i++){
+        Function* f = bin.getFunction(i);
+        std::cout << "function" << TAB << HEX(f->getMemoryAddress()) << TAB << HEX(f->getMemorySize()) << TAB << f->getName() << ENDL;
+    }
+}
+
+int main(int argc, char** argv){
+    for (int i = 1; i < argc; i++){
+        listFunctions(argv[i]);
+    }
+    return 0;
+}
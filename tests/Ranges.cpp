@@ -0,0 +1,96 @@
+/**
+ * @file Ranges.cpp
+ *
+ * @section LICENSE
+ * This file is part of the EPAX toolkit.
+ *
+ * Copyright (c) 2013, EP Analytics, Inc.
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+// iterates ranges over plain lists and over the functions of the samples, and
+// checks them against indexing and the first/next queries
+
+#include "EPAX.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace EPAX;
+
+typedef struct {
+    uint32_t value;
+} Item;
+
+static bool isOdd(Item* i){
+    return (i->value & 1) != 0;
+}
+
+static void listRange(const char* what, Range<Item> r){
+    std::cout << what << "\tsize " << r.size() << "\tempty " << r.empty() << "\tdistance " << (r.end() - r.begin()) << "\titems";
+    for (Item* i : r){
+        std::cout << " " << i->value;
+    }
+    if (!r.empty()){
+        std::cout << "\tfront " << r.front()->value << "\tback " << r.back()->value << "\t[1] " << (r.size() > 1? r[1]->value: 0)
+                  << "\todd " << std::count_if(r.begin(), r.end(), isOdd);
+    }
+    std::cout << std::endl;
+}
+
+static void listFunctions(const char* path){
+    BIN bin = BIN_create(path);
+
+    uint32_t count = 0;
+    bool agrees = true;
+    FUNC next = BIN_firstFunc(bin);
+    for (FUNC f : BIN_functions(bin)){
+        std::cout << path << "\t" << std::hex << "0x" << FUNC_addr(f) << std::dec << "\t" << FUNC_name(f) << std::endl;
+        agrees = agrees && (f == next);
+        next = BIN_nextFunc(bin, f);
+        count++;
+    }
+    std::cout << path << "\tfunctions " << count << "\tcount " << BIN_countFunc(bin) << "\tagrees with first/next " << agrees << std::endl;
+
+    BIN_destroy(bin);
+}
+
+int main(int argc, char** argv){
+    Item items[5] = { { 10 }, { 11 }, { 12 }, { 13 }, { 15 } };
+    std::vector<Item*> v;
+    for (uint32_t i = 0; i < 5; i++){
+        v.push_back(&items[i]);
+    }
+
+    listRange("default", Range<Item>());
+    listRange("empty vector", Range<Item>(std::vector<Item*>()));
+    listRange("null list", Range<Item>(NULL, 0));
+    listRange("vector", Range<Item>(v));
+    listRange("list", Range<Item>(&v[1], 3));
+
+    // iterators are pointers into the list, so the standard algorithms apply directly
+    Range<Item> r(v);
+    Range<Item>::iterator it = std::find(r.begin(), r.end(), &items[3]);
+    std::cout << "find\tindex " << (it - r.begin()) << std::endl;
+
+    for (int i = 1; i < argc; i++){
+        listFunctions(argv[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#!/usr/bin/env python
+#
+# Writes the small `ar` archives used by the tests. Every member holds one line
+# of text naming it, of odd length where the padding to an even offset matters.
+#
+#   gnu.a        System V/GNU: a symbol index (/), a long name table (//),
+#                a short name ending in '/' and two long names
+#   bsd.a        BSD: a symbol index (#1/20, __.SYMDEF SORTED), names stored
+#                after the header (#1/<len>), one padded with NULs, and a
+#                short name with no '/'
+#   truncated.a  a good member, then a member whose size runs past the end
+#                of the file; only the first is listed
+
+import sys
+import os
+
+def header(name, size):
+    h = (name.ljust(16) + "0".ljust(12) + "0".ljust(6) + "0".ljust(6) +
+         "644".ljust(8) + str(size).ljust(10) + "`\n")
+    assert len(h) == 60
+    return h.encode("ascii")
+
+def member(name, data):
+    out = header(name, len(data)) + data
+    if len(data) & 1:
+        out += b"\n"
+    return out
+
+def bsdmember(name, namelen, data):
+    stored = name.encode("ascii").ljust(namelen, b"\0")
+    return member("#1/" + str(namelen), stored + data)
+
+def gnu():
+    longnames = b"a_rather_long_member_name.o/\nanother_long_member_name.o/\n"
+    out = b"!<arch>\n"
+    out += member("/", b"\0\0\0\0")
+    out += member("//", longnames)
+    out += member("short.o/", b"contents of short.o\n")
+    out += member("/0", b"contents of a_rather_long_member_name.o\n")
+    out += member("/29", b"contents of another_long_member_name.o\n")
+    return out
+
+def bsd():
+    out = b"!<arch>\n"
+    out += bsdmember("__.SYMDEF SORTED", 20, b"\0\0\0\0\0\0\0\0")
+    out += bsdmember("long_bsd_member_name.o", 22, b"contents of long_bsd_member_name.o\n")
+    out += bsdmember("padded.o", 12, b"contents of padded.o\n")
+    out += member("plain.o", b"contents of plain.o\n")
+    return out
+
+def truncated():
+    out = b"!<arch>\n"
+    out += member("first.o/", b"contents of first.o\n")
+    out += header("second.o/", 1000) + b"contents of second.o\n"
+    return out
+
+outdir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+open(os.path.join(outdir, "gnu.a"), "wb").write(gnu())
+open(os.path.join(outdir, "bsd.a"), "wb").write(bsd())
+open(os.path.join(outdir, "truncated.a"), "wb").write(truncated())
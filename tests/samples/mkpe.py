@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+#
+# Writes the small PE images used by the tests: arm64.exe (PE32+, ARM64) and
+# armnt.exe (PE32, ARMNT, where code addresses carry the Thumb bit). Both have
+# the same layout:
+#
+#   .text   RVA 0x1000  three functions, at 0x1000, 0x1040 and 0x1100
+#   .rdata  RVA 0x2000  the export directory and one .xdata record
+#   .pdata  RVA 0x3000  two entries
+#
+# alpha (0x1000) is exported and has a packed .pdata entry of length 0x20.
+# 0x1040 is the entry point, and is known only from its .pdata entry, whose
+# length (0x30) is in its .xdata record. beta (0x1100) is exported and has no
+# .pdata entry. fwd is a forwarder to x.y, which is not code.
+
+import struct
+import sys
+import os
+
+def build(machine, pe32plus, thumb):
+    imagebase = 0x140000000 if pe32plus else 0x400000
+    text = bytearray(0x200)
+    rdata = bytearray(0x200)
+    pdata = bytearray(0x200)
+
+    # arm64 nop; the tests do not decode it
+    for i in range(0, len(text), 4):
+        text[i:i + 4] = b"\x1f\x20\x03\xd5"
+
+    # the export directory, at the start of .rdata
+    dirrva = 0x2000
+    t = 1 if thumb else 0
+    funcs = [0x1000 | t, 0x1100 | t, dirrva + 0x100]
+    funcsoff = 40
+    namesoff = funcsoff + 12
+    ordsoff = namesoff + 12
+    stroff = 0x80
+    rdata[0:40] = struct.pack("<IIHHIIIIIII", 0, 0, 0, 0, 0, 1, 3, 3,
+                              dirrva + funcsoff, dirrva + namesoff, dirrva + ordsoff)
+    rdata[funcsoff:funcsoff + 12] = struct.pack("<III", *funcs)
+    namervas = []
+    for n in [b"alpha\0", b"beta\0", b"fwd\0"]:
+        rdata[stroff:stroff + len(n)] = n
+        namervas.append(dirrva + stroff)
+        stroff += len(n)
+    rdata[namesoff:namesoff + 12] = struct.pack("<III", *namervas)
+    rdata[ordsoff:ordsoff + 6] = struct.pack("<HHH", 0, 1, 2)
+    rdata[0x100:0x104] = b"x.y\0"
+
+    # lengths are in instruction units: 4 bytes on ARM64, 2 on ARMNT
+    unit = 4 if machine == 0xaa64 else 2
+    rdata[0x180:0x184] = struct.pack("<I", 0x30 // unit)
+    pd = struct.pack("<II", 0x1000 | t, ((0x20 // unit) << 2) | 1) + struct.pack("<II", 0x1040 | t, dirrva + 0x180)
+    pdata[0:len(pd)] = pd
+
+    dos = bytearray(64)
+    dos[0:2] = b"MZ"
+    struct.pack_into("<I", dos, 60, 64)
+
+    optsize = 240 if pe32plus else 224
+    fh = struct.pack("<HHIIIHH", machine, 3, 0, 0, 0, optsize, 0x22)
+    dd = bytearray(16 * 8)
+    struct.pack_into("<II", dd, 0, dirrva, 0x110)
+    struct.pack_into("<II", dd, 24, 0x3000, len(pd))
+    if pe32plus:
+        opt = struct.pack("<HBBIIIIIQIIHHHHHHIIIIHHQQQQII", 0x20b, 0, 0, 0, 0, 0, 0x1040 | t, 0x1000,
+                          imagebase, 0x1000, 0x200, 6, 0, 0, 0, 6, 0, 0, 0x4000, 0x400, 0, 3, 0,
+                          0, 0, 0, 0, 0, 16) + bytes(dd)
+    else:
+        opt = struct.pack("<HBBIIIIIIIIIHHHHHHIIIIHHIIIIII", 0x10b, 0, 0, 0, 0, 0, 0x1040 | t, 0x1000, 0x2000,
+                          imagebase, 0x1000, 0x200, 6, 0, 0, 0, 6, 0, 0, 0x4000, 0x400, 0, 3, 0,
+                          0, 0, 0, 0, 0, 16) + bytes(dd)
+    assert len(opt) == optsize
+
+    def section(name, va, vs, raw, rs, ch):
+        return name.ljust(8, b"\0") + struct.pack("<IIIIIIHHI", vs, va, rs, raw, 0, 0, 0, 0, ch)
+    sects = (section(b".text", 0x1000, 0x180, 0x400, 0x200, 0x60000020) +
+             section(b".rdata", 0x2000, 0x200, 0x600, 0x200, 0x40000040) +
+             section(b".pdata", 0x3000, 0x10, 0x800, 0x200, 0x40000040))
+
+    hdr = bytes(dos) + b"PE\0\0" + fh + opt + sects
+    img = bytearray(0x400)
+    img[0:len(hdr)] = hdr
+    return bytes(img) + bytes(text) + bytes(rdata) + bytes(pdata)
+
+outdir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+open(os.path.join(outdir, "arm64.exe"), "wb").write(build(0xaa64, True, False))
+open(os.path.join(outdir, "armnt.exe"), "wb").write(build(0x1c4, False, True))